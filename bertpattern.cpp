@@ -0,0 +1,167 @@
+#include "bertpattern.h"
+#include <QtAlgorithms>
+#include <cstring>
+
+namespace {
+
+// Correct bytes in a row before a lock is trusted
+const int kVerifyBytes = 8;
+// Errored bytes within the slip window that mean the stream slipped. Line
+// noise at any usable error rate stays far below a quarter of all bytes.
+const int kSlipErrorBytes = BertChecker::SlipWindow / 4;
+
+} // namespace
+
+BertPattern::BertPattern(Type type)
+    : patternType(type)
+    , order(0)
+    , tap(0)
+    , mask(0)
+    , state(0)
+    , counter(0)
+{
+    switch (type) {
+    case Prbs7:  order = 7;  tap = 6;  break;
+    case Prbs15: order = 15; tap = 14; break;
+    case Prbs23: order = 23; tap = 18; break;
+    case Prbs31: order = 31; tap = 28; break;
+    case Counter: break;
+    }
+    mask = order > 0 ? (quint32(1) << order) - 1 : 0;
+    reset();
+}
+
+void BertPattern::reset()
+{
+    state = mask;
+    counter = 0;
+}
+
+quint8 BertPattern::next()
+{
+    if (patternType == Counter) {
+        return counter++;
+    }
+    quint8 out = 0;
+    for (int bit = 0; bit < 8; ++bit) {
+        const quint32 feedback = ((state >> (order - 1)) ^ (state >> (tap - 1))) & 1;
+        state = ((state << 1) | feedback) & mask;
+        out = quint8((out << 1) | feedback);
+    }
+    return out;
+}
+
+void BertPattern::fill(char *out, int size)
+{
+    for (int i = 0; i < size; ++i) {
+        out[i] = char(next());
+    }
+}
+
+int BertPattern::seedBytes() const
+{
+    return patternType == Counter ? 1 : (order + 7) / 8;
+}
+
+bool BertPattern::seed(const quint8 *history)
+{
+    if (patternType == Counter) {
+        counter = quint8(history[0] + 1);
+        return true;
+    }
+    quint32 bits = 0;
+    for (int i = 0; i < seedBytes(); ++i) {
+        bits = (bits << 8) | history[i];
+    }
+    if ((bits & mask) == 0) {
+        return false;
+    }
+    state = bits & mask;
+    return true;
+}
+
+BertChecker::BertChecker(BertPattern::Type type)
+    : reference(type)
+    , state(Hunting)
+    , verified(0)
+    , historyFill(0)
+{
+    clearRecent();
+}
+
+void BertChecker::check(const char *data, int size)
+{
+    const int need = reference.seedBytes();
+    for (int i = 0; i < size; ++i) {
+        const quint8 byte = quint8(data[i]);
+
+        if (state == Synced) {
+            const quint8 bits = quint8(qPopulationCount(quint8(byte ^ reference.next())));
+            ++totals.checkedBytes;
+            if (bits) {
+                ++totals.byteErrors;
+                totals.bitErrors += bits;
+            }
+            const quint8 old = recent[recentPos];
+            if (old) {
+                --recentErrorBytes;
+                recentErrorBits -= old;
+            }
+            recent[recentPos] = bits;
+            if (bits) {
+                ++recentErrorBytes;
+                recentErrorBits += bits;
+            }
+            recentPos = (recentPos + 1) % SlipWindow;
+
+            if (recentErrorBytes >= kSlipErrorBytes) {
+                // Misalignment, not noise: move the burst out of the counts
+                totals.byteErrors -= recentErrorBytes;
+                totals.bitErrors -= recentErrorBits;
+                totals.checkedBytes -= recentErrorBytes;
+                totals.unsyncedBytes += recentErrorBytes;
+                ++totals.slips;
+                clearRecent();
+                state = Hunting;
+            }
+        } else {
+            ++totals.unsyncedBytes;
+            if (state == Verifying) {
+                if (reference.next() == byte) {
+                    if (++verified == kVerifyBytes) {
+                        state = Synced;
+                    }
+                } else {
+                    state = Hunting;
+                }
+            }
+        }
+
+        // Keep the newest bytes so a lock can be tried right away
+        if (historyFill == need) {
+            memmove(history, history + 1, need - 1);
+            history[need - 1] = byte;
+        } else {
+            history[historyFill++] = byte;
+        }
+        if (state == Hunting && historyFill == need) {
+            relock();
+        }
+    }
+}
+
+void BertChecker::relock()
+{
+    if (reference.seed(history)) {
+        state = Verifying;
+        verified = 0;
+    }
+}
+
+void BertChecker::clearRecent()
+{
+    memset(recent, 0, sizeof(recent));
+    recentPos = 0;
+    recentErrorBytes = 0;
+    recentErrorBits = 0;
+}
@@ -0,0 +1,85 @@
+#ifndef BERTPATTERN_H
+#define BERTPATTERN_H
+
+#include <QtGlobal>
+
+// Test patterns for the bit error rate test. The PRBS sequences are the
+// ITU-T O.150 polynomials, emitted most significant bit first; Counter is
+// an incrementing byte. Every pattern can be seeded from the bytes last
+// received, which is how the checker locks onto a stream mid-way.
+class BertPattern
+{
+public:
+    enum Type { Prbs7, Prbs15, Prbs23, Prbs31, Counter };
+
+    explicit BertPattern(Type type = Prbs15);
+
+    Type type() const { return patternType; }
+    void reset();
+    quint8 next();
+    void fill(char *out, int size);
+
+    // Received bytes seed() needs to predict the rest of the stream
+    int seedBytes() const;
+    // history holds seedBytes() bytes, oldest first. Fails on an all-zero
+    // PRBS state, which would only ever predict zeros.
+    bool seed(const quint8 *history);
+
+private:
+    Type patternType;
+    int order;      // Register length in bits
+    int tap;        // Second feedback tap
+    quint32 mask;
+    quint32 state;  // Last `order` output bits, newest in bit 0
+    quint8 counter;
+};
+
+struct BertCounts {
+    qint64 checkedBytes;
+    qint64 byteErrors;
+    qint64 bitErrors;
+    qint64 slips;           // Lost and regained lock, e.g. dropped bytes
+    qint64 unsyncedBytes;   // Received while not locked
+
+    BertCounts() : checkedBytes(0), byteErrors(0), bitErrors(0), slips(0), unsyncedBytes(0) {}
+};
+
+// Streaming checker. Locks onto the pattern from the received bytes alone,
+// then compares against its own reference so a corrupted byte counts once
+// instead of throwing the prediction off. A burst of errors means the
+// stream slipped, not that the line got noisy: the burst is taken back out
+// of the error counts and the checker locks on again.
+class BertChecker
+{
+public:
+    explicit BertChecker(BertPattern::Type type);
+
+    void check(const char *data, int size);
+
+    bool isSynced() const { return state == Synced; }
+    const BertCounts &counts() const { return totals; }
+
+    static const int SlipWindow = 64;
+
+private:
+    enum State { Hunting, Verifying, Synced };
+
+    BertPattern reference;
+    State state;
+    int verified;
+    quint8 history[4];
+    int historyFill;
+
+    // Bit errors of the last SlipWindow checked bytes
+    quint8 recent[SlipWindow];
+    int recentPos;
+    int recentErrorBytes;
+    int recentErrorBits;
+
+    BertCounts totals;
+
+    void relock();
+    void clearRecent();
+};
+
+#endif // BERTPATTERN_H
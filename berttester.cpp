@@ -0,0 +1,186 @@
+#include "berttester.h"
+#include "latencymeter.h"
+#include <QMutexLocker>
+#include <QQueue>
+
+namespace {
+
+// Each write covers about this much line time, so received data is checked
+// at least that often
+const int kWriteMs = 10;
+const int kMinWriteBytes = 64;
+const int kMaxWriteBytes = 4096;
+
+// Unchecked data beyond this is dropped; the checker slips and locks again
+const qint64 kMaxReceivedBytes = 4 * 1024 * 1024;
+// Send marks kept while nothing comes back
+const int kMaxSendMarks = 65536;
+
+struct SendMark {
+    qint64 endByte;     // Total written once this write was done
+    qint64 ns;          // When the write started
+};
+
+} // namespace
+
+BertTester::BertTester(QObject *parent)
+    : QThread(parent)
+    , handle(QSerialPort::Handle())
+    , pattern(BertPattern::Prbs15)
+    , lineRate(0.0)
+    , bytesWritten(0)
+    , stopRequested(false)
+    , receivedBytes(0)
+    , latencySumUs(0.0)
+{
+}
+
+BertTester::~BertTester()
+{
+    stopTest();
+}
+
+void BertTester::startTest(QSerialPort::Handle portHandle, BertPattern::Type testPattern, double rate)
+{
+    stopTest();
+    handle = portHandle;
+    pattern = testPattern;
+    lineRate = rate;
+    {
+        QMutexLocker lock(&mutex);
+        stopRequested = false;
+        received.clear();
+        receivedBytes = 0;
+        current = BertSnapshot();
+        latencySumUs = 0.0;
+    }
+    start(QThread::TimeCriticalPriority);
+}
+
+void BertTester::stopTest()
+{
+    {
+        QMutexLocker lock(&mutex);
+        stopRequested = true;
+    }
+    wait();
+}
+
+void BertTester::feed(const QByteArray &data, qint64 ns)
+{
+    QMutexLocker lock(&mutex);
+    if (receivedBytes + data.size() > kMaxReceivedBytes) {
+        return;
+    }
+    RxChunk chunk;
+    chunk.data = data;
+    chunk.ns = ns;
+    received.append(chunk);
+    receivedBytes += data.size();
+}
+
+BertSnapshot BertTester::snapshot()
+{
+    QMutexLocker lock(&mutex);
+    BertSnapshot s = current;
+    if (s.latencyCount > 0) {
+        s.latencyAvgUs = latencySumUs / s.latencyCount;
+    }
+    current.latencyCount = 0;
+    current.latencyMinUs = 0;
+    current.latencyMaxUs = 0;
+    latencySumUs = 0.0;
+    return s;
+}
+
+qint64 BertTester::takeBytesWritten()
+{
+    return bytesWritten.fetchAndStoreRelaxed(0);
+}
+
+void BertTester::run()
+{
+    writer.begin(handle);
+
+    BertPattern generator(pattern);
+    BertChecker checker(pattern);
+    const int writeSize = qBound(kMinWriteBytes, int(lineRate * kWriteMs / 1000), kMaxWriteBytes);
+    QByteArray block(writeSize, '\0');
+
+    QQueue<SendMark> marks;
+    qint64 txTotal = 0;
+    qint64 rxTotal = 0;
+    QVector<RxChunk> chunks;
+
+    for (;;) {
+        {
+            QMutexLocker lock(&mutex);
+            if (stopRequested) {
+                break;
+            }
+            chunks.swap(received);
+            receivedBytes = 0;
+        }
+
+        // Check what came back while the previous block was written
+        int latencyCount = 0;
+        double latencySumChunk = 0.0;
+        double latencyMin = 0.0;
+        double latencyMax = 0.0;
+        for (int i = 0; i < chunks.size(); ++i) {
+            const RxChunk &chunk = chunks[i];
+            checker.check(chunk.data.constData(), chunk.data.size());
+            rxTotal += chunk.data.size();
+
+            // The newest byte of the chunk went out with the first write
+            // that reached it. Timed from the start of that write, and
+            // dropped bytes shift the count, so this reads a little high.
+            while (marks.size() > 1 && marks.head().endByte < rxTotal) {
+                marks.dequeue();
+            }
+            if (!marks.isEmpty()) {
+                const double us = qMax<qint64>(0, chunk.ns - marks.head().ns) / 1000.0;
+                latencyMin = latencyCount == 0 ? us : qMin(latencyMin, us);
+                latencyMax = qMax(latencyMax, us);
+                latencySumChunk += us;
+                ++latencyCount;
+            }
+        }
+        chunks.clear();
+
+        {
+            QMutexLocker lock(&mutex);
+            current.txBytes = txTotal;
+            current.rxBytes = rxTotal;
+            current.counts = checker.counts();
+            current.synced = checker.isSynced();
+            if (latencyCount > 0) {
+                current.latencyMinUs = current.latencyCount == 0 ? latencyMin
+                                                                 : qMin(current.latencyMinUs, latencyMin);
+                current.latencyMaxUs = qMax(current.latencyMaxUs, latencyMax);
+                current.latencyCount += latencyCount;
+                latencySumUs += latencySumChunk;
+            }
+        }
+
+        generator.fill(block.data(), block.size());
+        const qint64 writeNs = LatencyMeter::clockNs();
+        QString error;
+        if (!writer.write(block, &error)) {
+            emit failed(error);
+            break;
+        }
+        txTotal += block.size();
+        bytesWritten.fetchAndAddRelaxed(block.size());
+
+        SendMark mark;
+        mark.endByte = txTotal;
+        mark.ns = writeNs;
+        marks.enqueue(mark);
+        if (marks.size() > kMaxSendMarks) {
+            marks.dequeue();
+        }
+    }
+
+    writer.end();
+}
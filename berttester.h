@@ -0,0 +1,82 @@
+#ifndef BERTTESTER_H
+#define BERTTESTER_H
+
+#include <QThread>
+#include <QByteArray>
+#include <QMutex>
+#include <QVector>
+#include <QAtomicInteger>
+#include <QSerialPort>
+
+#include "bertpattern.h"
+#include "nativeportwriter.h"
+
+struct BertSnapshot {
+    qint64 txBytes;
+    qint64 rxBytes;
+    BertCounts counts;
+    bool synced;
+    // Loopback delay of the data received since the previous snapshot,
+    // from writing it to reading it back; count 0 when none
+    int latencyCount;
+    double latencyMinUs;
+    double latencyAvgUs;
+    double latencyMaxUs;
+
+    BertSnapshot()
+        : txBytes(0), rxBytes(0), synced(false)
+        , latencyCount(0), latencyMinUs(0), latencyAvgUs(0), latencyMaxUs(0) {}
+};
+
+// Loopback bit error rate test. Streams the pattern to the port's native
+// handle as fast as the line takes it and checks what comes back on the
+// same thread, so neither the GUI nor the plots set the pace. Received
+// data is handed over by feed() with its arrival time.
+class BertTester : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit BertTester(QObject *parent = nullptr);
+    ~BertTester();
+
+    // lineRate in bytes per second sizes the writes. The port must stay
+    // open until stopTest() returns.
+    void startTest(QSerialPort::Handle handle, BertPattern::Type pattern, double lineRate);
+    void stopTest();
+
+    // Thread-safe; pass every chunk read from the port while running
+    void feed(const QByteArray &data, qint64 ns);
+
+    // Counts are totals; the latency figures start over with each call
+    BertSnapshot snapshot();
+    // Bytes written since the previous call
+    qint64 takeBytesWritten();
+
+signals:
+    void failed(const QString &error);
+
+protected:
+    void run() override;
+
+private:
+    struct RxChunk {
+        QByteArray data;
+        qint64 ns;
+    };
+
+    QSerialPort::Handle handle;
+    NativePortWriter writer;
+    BertPattern::Type pattern;
+    double lineRate;
+    QAtomicInteger<qint64> bytesWritten;
+
+    QMutex mutex;
+    bool stopRequested;
+    QVector<RxChunk> received;
+    qint64 receivedBytes;   // Queued in received
+    BertSnapshot current;
+    double latencySumUs;
+};
+
+#endif // BERTTESTER_H
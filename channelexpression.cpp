@@ -0,0 +1,391 @@
+#include "channelexpression.h"
+#include <cmath>
+#include <limits>
+
+// Recursive-descent parser that emits postfix code as it goes:
+//   expr    := term (('+' | '-') term)*
+//   term    := unary (('*' | '/') unary)*
+//   unary   := '-' unary | power
+//   power   := primary ('^' unary)?
+//   primary := number | chN | name '(' args ')' | '(' expr ')'
+class ExpressionParser
+{
+public:
+    ExpressionParser(const QString &source, ChannelExpression *target)
+        : text(source), pos(0), depth(0), target(target) {}
+
+    bool parse(QString *error)
+    {
+        skipSpace();
+        if (!parseExpr()) {
+            *error = message;
+            return false;
+        }
+        skipSpace();
+        if (pos < text.size()) {
+            *error = QString("Unexpected '%1' at %2").arg(text[pos]).arg(pos + 1);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    QString text;
+    int pos;
+    int depth;
+    ChannelExpression *target;
+    QString message;
+
+    void skipSpace()
+    {
+        while (pos < text.size() && text[pos].isSpace()) {
+            ++pos;
+        }
+    }
+
+    bool accept(QChar c)
+    {
+        skipSpace();
+        if (pos < text.size() && text[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool fail(const QString &what)
+    {
+        if (message.isEmpty()) {
+            message = pos < text.size()
+                      ? QString("%1 at %2").arg(what).arg(pos + 1)
+                      : QString("%1 at end").arg(what);
+        }
+        return false;
+    }
+
+    void put(ChannelExpression::Op op, int arg = 0, int stackChange = 0)
+    {
+        ChannelExpression::Instruction instruction;
+        instruction.op = op;
+        instruction.arg = arg;
+        target->code.append(instruction);
+        depth += stackChange;
+        target->maxDepth = qMax(target->maxDepth, depth);
+    }
+
+    bool parseExpr()
+    {
+        if (!parseTerm()) {
+            return false;
+        }
+        for (;;) {
+            if (accept('+')) {
+                if (!parseTerm()) return false;
+                put(ChannelExpression::Add, 0, -1);
+            } else if (accept('-')) {
+                if (!parseTerm()) return false;
+                put(ChannelExpression::Sub, 0, -1);
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool parseTerm()
+    {
+        if (!parseUnary()) {
+            return false;
+        }
+        for (;;) {
+            if (accept('*')) {
+                if (!parseUnary()) return false;
+                put(ChannelExpression::Mul, 0, -1);
+            } else if (accept('/')) {
+                if (!parseUnary()) return false;
+                put(ChannelExpression::Div, 0, -1);
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool parseUnary()
+    {
+        if (accept('-')) {
+            if (!parseUnary()) return false;
+            put(ChannelExpression::Neg);
+            return true;
+        }
+        return parsePower();
+    }
+
+    bool parsePower()
+    {
+        if (!parsePrimary()) {
+            return false;
+        }
+        if (accept('^')) {
+            if (!parseUnary()) return false;
+            put(ChannelExpression::Pow, 0, -1);
+        }
+        return true;
+    }
+
+    bool parseNumber(double *value)
+    {
+        skipSpace();
+        const int start = pos;
+        while (pos < text.size() && (text[pos].isDigit() || text[pos] == '.')) {
+            ++pos;
+        }
+        if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+            ++pos;
+            if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+                ++pos;
+            }
+            while (pos < text.size() && text[pos].isDigit()) {
+                ++pos;
+            }
+        }
+        bool ok = false;
+        *value = text.mid(start, pos - start).toDouble(&ok);
+        if (!ok) {
+            pos = start;
+            return fail("Invalid number");
+        }
+        return true;
+    }
+
+    bool parsePrimary()
+    {
+        skipSpace();
+        if (pos >= text.size()) {
+            return fail("Missing operand");
+        }
+
+        if (accept('(')) {
+            if (!parseExpr()) return false;
+            return accept(')') || fail("Expected ')'");
+        }
+
+        if (text[pos].isDigit() || text[pos] == '.') {
+            double value;
+            if (!parseNumber(&value)) return false;
+            target->constants.append(value);
+            put(ChannelExpression::PushConst, target->constants.size() - 1, 1);
+            return true;
+        }
+
+        if (!text[pos].isLetter()) {
+            return fail(QString("Unexpected '%1'").arg(text[pos]));
+        }
+        const int start = pos;
+        while (pos < text.size() && text[pos].isLetterOrNumber()) {
+            ++pos;
+        }
+        const QString name = text.mid(start, pos - start).toLower();
+
+        if (name.startsWith("ch") && name.size() > 2) {
+            bool ok = false;
+            const int channel = name.mid(2).toInt(&ok);
+            if (!ok || channel < 1 || channel > ChannelExpression::Inputs) {
+                pos = start;
+                return fail(QString("Unknown channel '%1'").arg(name));
+            }
+            put(ChannelExpression::PushInput, channel - 1, 1);
+            return true;
+        }
+
+        if (!accept('(')) {
+            pos = start;
+            return fail(QString("Unknown name '%1'").arg(name));
+        }
+        return parseCall(name, start);
+    }
+
+    bool parseCall(const QString &name, int start)
+    {
+        static const struct { const char *name; ChannelExpression::Op op; } unary[] = {
+            { "abs", ChannelExpression::Abs }, { "sqrt", ChannelExpression::Sqrt },
+            { "sin", ChannelExpression::Sin }, { "cos", ChannelExpression::Cos },
+            { "tan", ChannelExpression::Tan }, { "exp", ChannelExpression::Exp },
+            { "log", ChannelExpression::Log }
+        };
+        static const struct { const char *name; ChannelExpression::Op op; } binary[] = {
+            { "min", ChannelExpression::Min }, { "max", ChannelExpression::Max },
+            { "pow", ChannelExpression::Pow }
+        };
+
+        for (const auto &f : unary) {
+            if (name == f.name) {
+                if (!parseExpr()) return false;
+                if (!accept(')')) return fail("Expected ')'");
+                put(f.op);
+                return true;
+            }
+        }
+        for (const auto &f : binary) {
+            if (name == f.name) {
+                if (!parseExpr()) return false;
+                if (!accept(',')) return fail("Expected ','");
+                if (!parseExpr()) return false;
+                if (!accept(')')) return fail("Expected ')'");
+                put(f.op, 0, -1);
+                return true;
+            }
+        }
+
+        if (name == "movavg") {
+            if (!parseExpr()) return false;
+            if (!accept(',')) return fail("Expected ','");
+            double length;
+            if (!parseNumber(&length)) return false;
+            if (length < 1 || length > 1000000 || length != std::floor(length)) {
+                return fail("Window must be a whole number of samples");
+            }
+            if (!accept(')')) return fail("Expected ')'");
+
+            // History is allocated here, at compile time
+            ChannelExpression::MovingAverage average;
+            average.ring = QVector<double>(int(length), 0.0);
+            average.position = 0;
+            average.filled = 0;
+            average.sum = 0.0;
+            target->averages.append(average);
+            put(ChannelExpression::MovAvg, target->averages.size() - 1);
+            return true;
+        }
+
+        pos = start;
+        return fail(QString("Unknown function '%1'").arg(name));
+    }
+};
+
+ChannelExpression::ChannelExpression()
+    : maxDepth(0)
+{
+}
+
+bool ChannelExpression::compile(const QString &source, QString *error)
+{
+    text = source.trimmed();
+    code.clear();
+    constants.clear();
+    averages.clear();
+    maxDepth = 0;
+
+    ExpressionParser parser(text, this);
+    if (!parser.parse(error)) {
+        code.clear();
+        return false;
+    }
+
+    scratch = QVector<double>(maxDepth * MaxBatch);
+    slotPointers = QVector<const double *>(maxDepth);
+    return true;
+}
+
+void ChannelExpression::reset()
+{
+    for (int i = 0; i < averages.size(); ++i) {
+        averages[i].ring.fill(0.0);
+        averages[i].position = 0;
+        averages[i].filled = 0;
+        averages[i].sum = 0.0;
+    }
+}
+
+void ChannelExpression::evaluate(const double *const *columns, int rows, double *out)
+{
+    if (code.isEmpty()) {
+        for (int i = 0; i < rows; ++i) {
+            out[i] = std::numeric_limits<double>::quiet_NaN();
+        }
+        return;
+    }
+
+    // Each stack slot is a column: either an input column read in place or
+    // the scratch column at that depth
+    const double **slot = slotPointers.data();
+    int sp = 0;
+
+    for (const Instruction &instruction : code) {
+        switch (instruction.op) {
+        case PushInput:
+            slot[sp++] = columns[instruction.arg];
+            continue;
+        case PushConst: {
+            double *r = scratch.data() + sp * MaxBatch;
+            const double value = constants[instruction.arg];
+            for (int i = 0; i < rows; ++i) r[i] = value;
+            slot[sp++] = r;
+            continue;
+        }
+        default:
+            break;
+        }
+
+        if (instruction.op <= Max) {
+            const double *a = slot[sp - 2];
+            const double *b = slot[sp - 1];
+            double *r = scratch.data() + (sp - 2) * MaxBatch;
+            switch (instruction.op) {
+            case Add: for (int i = 0; i < rows; ++i) r[i] = a[i] + b[i]; break;
+            case Sub: for (int i = 0; i < rows; ++i) r[i] = a[i] - b[i]; break;
+            case Mul: for (int i = 0; i < rows; ++i) r[i] = a[i] * b[i]; break;
+            case Div: for (int i = 0; i < rows; ++i) r[i] = a[i] / b[i]; break;
+            case Pow: for (int i = 0; i < rows; ++i) r[i] = std::pow(a[i], b[i]); break;
+            case Min: for (int i = 0; i < rows; ++i) r[i] = std::fmin(a[i], b[i]); break;
+            case Max: for (int i = 0; i < rows; ++i) r[i] = std::fmax(a[i], b[i]); break;
+            default: break;
+            }
+            slot[--sp - 1] = r;
+            continue;
+        }
+
+        const double *a = slot[sp - 1];
+        double *r = scratch.data() + (sp - 1) * MaxBatch;
+        switch (instruction.op) {
+        case Neg:  for (int i = 0; i < rows; ++i) r[i] = -a[i]; break;
+        case Abs:  for (int i = 0; i < rows; ++i) r[i] = std::fabs(a[i]); break;
+        case Sqrt: for (int i = 0; i < rows; ++i) r[i] = std::sqrt(a[i]); break;
+        case Sin:  for (int i = 0; i < rows; ++i) r[i] = std::sin(a[i]); break;
+        case Cos:  for (int i = 0; i < rows; ++i) r[i] = std::cos(a[i]); break;
+        case Tan:  for (int i = 0; i < rows; ++i) r[i] = std::tan(a[i]); break;
+        case Exp:  for (int i = 0; i < rows; ++i) r[i] = std::exp(a[i]); break;
+        case Log:  for (int i = 0; i < rows; ++i) r[i] = std::log(a[i]); break;
+        case MovAvg: {
+            // Running sum over a ring; missing samples do not enter the window
+            MovingAverage &m = averages[instruction.arg];
+            double *ring = m.ring.data();
+            const int length = m.ring.size();
+            for (int i = 0; i < rows; ++i) {
+                const double x = a[i];
+                if (std::isnan(x)) {
+                    r[i] = x;
+                    continue;
+                }
+                m.sum += x - ring[m.position];
+                ring[m.position] = x;
+                if (++m.position == length) {
+                    m.position = 0;
+                    // Re-sum once per lap so rounding error cannot build up
+                    m.sum = 0.0;
+                    for (int j = 0; j < length; ++j) m.sum += ring[j];
+                }
+                if (m.filled < length) ++m.filled;
+                r[i] = m.sum / m.filled;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        slot[sp - 1] = r;
+    }
+
+    const double *result = slot[0];
+    for (int i = 0; i < rows; ++i) {
+        out[i] = result[i];
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef CHANNELEXPRESSION_H
+#define CHANNELEXPRESSION_H
+
+#include <QString>
+#include <QVector>
+
+// Math expression over plot channels, compiled once into flat stack
+// bytecode and evaluated a whole batch at a time: every instruction runs
+// as a tight loop over the batch columns, so interpretation costs once per
+// instruction per batch rather than per sample, and evaluation never
+// allocates.
+//
+//   Inputs:     ch1 .. ch6
+//   Operators:  + - * / ^ and unary minus, parentheses
+//   Functions:  abs sqrt sin cos tan exp log min(a, b) max(a, b) pow(a, b)
+//               movavg(expr, N)   N-sample moving average, N a literal
+//
+// A missing input is NaN and propagates to the result.
+class ChannelExpression
+{
+public:
+    enum { Inputs = 6, MaxBatch = 256 };
+
+    ChannelExpression();
+
+    bool compile(const QString &source, QString *error);
+    QString source() const { return text; }
+
+    // columns[c][i] is input channel c in row i; rows <= MaxBatch
+    void evaluate(const double *const *columns, int rows, double *out);
+
+    // Forget moving-average history
+    void reset();
+
+private:
+    enum Op {
+        PushInput, PushConst,
+        Add, Sub, Mul, Div, Pow, Min, Max,
+        Neg, Abs, Sqrt, Sin, Cos, Tan, Exp, Log,
+        MovAvg
+    };
+
+    struct Instruction {
+        Op op;
+        int arg;  // Input column, constant index or moving-average index
+    };
+
+    struct MovingAverage {
+        QVector<double> ring;
+        int position;
+        int filled;
+        double sum;
+    };
+
+    QString text;
+    QVector<Instruction> code;
+    QVector<double> constants;
+    QVector<MovingAverage> averages;
+    int maxDepth;
+    QVector<double> scratch;    // maxDepth columns of MaxBatch
+    QVector<const double *> slotPointers;
+
+    friend class ExpressionParser;
+};
+
+#endif // CHANNELEXPRESSION_H
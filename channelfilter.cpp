@@ -0,0 +1,272 @@
+#include "channelfilter.h"
+#include "channelstore.h"
+#include <cmath>
+#include <cstring>
+
+namespace {
+const double kPi = 3.14159265358979323846;
+}
+
+ChannelFilter::ChannelFilter()
+    : kind(None)
+    , position(0)
+    , filled(0)
+    , sum(0.0)
+    , alpha(1.0)
+    , average(0.0)
+    , primed(false)
+    , b0(1.0), b1(0.0), b2(0.0), a1(0.0), a2(0.0)
+    , z1(0.0), z2(0.0)
+    , cutoff(0.0)
+{
+}
+
+ChannelFilter ChannelFilter::movingAverage(int length)
+{
+    ChannelFilter f;
+    f.kind = MovingAverage;
+    f.ring = QVector<double>(qMax(1, length), 0.0);
+    return f;
+}
+
+ChannelFilter ChannelFilter::exponential(double alpha)
+{
+    ChannelFilter f;
+    f.kind = ExponentialAverage;
+    f.alpha = qBound(0.0, alpha, 1.0);
+    return f;
+}
+
+ChannelFilter ChannelFilter::biquad(Type type, double cutoff, double q)
+{
+    ChannelFilter f;
+    f.kind = type;
+    f.cutoff = qBound(1e-6, cutoff, 0.5 - 1e-6);
+
+    // Audio EQ Cookbook (R. Bristow-Johnson) coefficients
+    const double w0 = 2.0 * kPi * f.cutoff;
+    const double cosw = std::cos(w0);
+    const double a = std::sin(w0) / (2.0 * q);
+    double n0, n1, n2;
+    switch (type) {
+    case HighPass:
+        n0 = (1.0 + cosw) / 2.0;
+        n1 = -(1.0 + cosw);
+        n2 = n0;
+        break;
+    case BandPass:
+        n0 = a;
+        n1 = 0.0;
+        n2 = -a;
+        break;
+    default:
+        f.kind = LowPass;
+        n0 = (1.0 - cosw) / 2.0;
+        n1 = 1.0 - cosw;
+        n2 = n0;
+        break;
+    }
+    const double d0 = 1.0 + a;
+    f.b0 = n0 / d0;
+    f.b1 = n1 / d0;
+    f.b2 = n2 / d0;
+    f.a1 = -2.0 * cosw / d0;
+    f.a2 = (1.0 - a) / d0;
+    return f;
+}
+
+ChannelFilter ChannelFilter::fir(const QVector<double> &taps)
+{
+    ChannelFilter f;
+    if (taps.isEmpty()) {
+        return f;
+    }
+    f.kind = Fir;
+    f.taps = taps;
+    f.work = QVector<double>(taps.size() - 1 + BlockSize, 0.0);
+    return f;
+}
+
+QString ChannelFilter::description() const
+{
+    switch (kind) {
+    case MovingAverage:      return QString("MA %1").arg(ring.size());
+    case ExponentialAverage: return QString("EMA %1").arg(alpha);
+    case LowPass:            return QString("LP %1").arg(cutoff);
+    case HighPass:           return QString("HP %1").arg(cutoff);
+    case BandPass:           return QString("BP %1").arg(cutoff);
+    case Fir:                return QString("FIR %1").arg(taps.size());
+    default:                 return QString();
+    }
+}
+
+void ChannelFilter::reset()
+{
+    ring.fill(0.0);
+    position = 0;
+    filled = 0;
+    sum = 0.0;
+    average = 0.0;
+    primed = false;
+    z1 = z2 = 0.0;
+    work.fill(0.0);
+}
+
+void ChannelFilter::process(const double *in, double *out, int count)
+{
+    switch (kind) {
+    case MovingAverage: {
+        double *r = ring.data();
+        const int length = ring.size();
+        for (int i = 0; i < count; ++i) {
+            const double x = in[i];
+            sum += x - r[position];
+            r[position] = x;
+            if (++position == length) {
+                position = 0;
+                // Re-sum once per lap so rounding error cannot build up
+                sum = 0.0;
+                for (int j = 0; j < length; ++j) sum += r[j];
+            }
+            if (filled < length) ++filled;
+            out[i] = sum / filled;
+        }
+        break;
+    }
+    case ExponentialAverage: {
+        int i = 0;
+        if (!primed && count > 0) {
+            average = in[0];
+            out[0] = average;
+            primed = true;
+            i = 1;
+        }
+        for (; i < count; ++i) {
+            average += alpha * (in[i] - average);
+            out[i] = average;
+        }
+        break;
+    }
+    case LowPass:
+    case HighPass:
+    case BandPass: {
+        double s1 = z1, s2 = z2;
+        for (int i = 0; i < count; ++i) {
+            const double x = in[i];
+            const double y = b0 * x + s1;
+            s1 = b1 * x - a1 * y + s2;
+            s2 = b2 * x - a2 * y;
+            out[i] = y;
+        }
+        z1 = s1;
+        z2 = s2;
+        break;
+    }
+    case Fir:
+        for (int done = 0; done < count; done += BlockSize) {
+            processFir(in + done, out + done, qMin(int(BlockSize), count - done));
+        }
+        break;
+    default:
+        if (out != in) {
+            std::memcpy(out, in, count * sizeof(double));
+        }
+        break;
+    }
+}
+
+void ChannelFilter::processFir(const double *in, double *out, int count)
+{
+    const int order = taps.size() - 1;
+    double *x = work.data();
+    std::memcpy(x + order, in, count * sizeof(double));
+
+    // out[i] = sum_k taps[k] * x[order + i - k], accumulated one tap at a
+    // time so each pass is a straight multiply-add over the block
+    double acc[BlockSize];
+    for (int i = 0; i < count; ++i) acc[i] = 0.0;
+    for (int k = 0; k <= order; ++k) {
+        const double h = taps[k];
+        const double *src = x + order - k;
+        for (int i = 0; i < count; ++i) {
+            acc[i] += h * src[i];
+        }
+    }
+    std::memcpy(out, acc, count * sizeof(double));
+
+    // Keep the last order inputs for the next block
+    std::memmove(x, x + count, order * sizeof(double));
+}
+
+FilterStage::FilterStage()
+    : filters(Channels)
+    , pending(Channels)
+    , output(ChannelFilter::BlockSize)
+    , full(false)
+{
+    for (int c = 0; c < Channels; ++c) {
+        pending[c].timestamps = QVector<qint64>(ChannelFilter::BlockSize);
+        pending[c].values = QVector<double>(ChannelFilter::BlockSize);
+        pending[c].count = 0;
+    }
+}
+
+void FilterStage::setFilter(int channel, const ChannelFilter &filter)
+{
+    if (channel < 0 || channel >= Channels) {
+        return;
+    }
+    filters[channel] = filter;
+    filters[channel].reset();
+    pending[channel].count = 0;
+}
+
+void FilterStage::append(int channel, qint64 timestamp, double value)
+{
+    Pending &p = pending[channel];
+    if (p.count == ChannelFilter::BlockSize) {
+        return;
+    }
+    p.timestamps[p.count] = timestamp;
+    p.values[p.count] = value;
+    if (++p.count == ChannelFilter::BlockSize) {
+        full = true;
+    }
+}
+
+bool FilterStage::hasPending() const
+{
+    for (int c = 0; c < Channels; ++c) {
+        if (pending[c].count > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FilterStage::flush(ChannelStore *store, const QVector<int> &targets)
+{
+    for (int c = 0; c < Channels; ++c) {
+        Pending &p = pending[c];
+        if (p.count == 0) {
+            continue;
+        }
+        if (isActive(c) && c < targets.size() && targets[c] >= 0) {
+            filters[c].process(p.values.constData(), output.data(), p.count);
+            for (int i = 0; i < p.count; ++i) {
+                store->append(targets[c], p.timestamps[i], output[i]);
+            }
+        }
+        p.count = 0;
+    }
+    full = false;
+}
+
+void FilterStage::reset()
+{
+    for (int c = 0; c < Channels; ++c) {
+        filters[c].reset();
+        pending[c].count = 0;
+    }
+    full = false;
+}
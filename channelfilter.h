@@ -0,0 +1,107 @@
+#ifndef CHANNELFILTER_H
+#define CHANNELFILTER_H
+
+#include <QVector>
+#include <QString>
+
+class ChannelStore;
+
+// Block filter for one channel. FIR taps run as one multiply-add sweep per
+// tap over the whole block, a shape compilers vectorize; the recursive
+// filters (moving average, EMA, biquad) carry state from sample to sample
+// and run as tight scalar loops over the block.
+class ChannelFilter
+{
+public:
+    enum Type {
+        None,
+        MovingAverage,
+        ExponentialAverage,
+        LowPass,
+        HighPass,
+        BandPass,
+        Fir
+    };
+
+    enum { BlockSize = 256 };
+
+    ChannelFilter();
+
+    static ChannelFilter movingAverage(int length);
+    static ChannelFilter exponential(double alpha);
+    // RBJ biquad; cutoff is a fraction of the sample rate (0 < cutoff < 0.5)
+    static ChannelFilter biquad(Type type, double cutoff, double q);
+    static ChannelFilter fir(const QVector<double> &taps);
+
+    Type type() const { return kind; }
+    QString description() const;
+
+    // in and out may be the same buffer
+    void process(const double *in, double *out, int count);
+    void reset();
+
+private:
+    Type kind;
+
+    // Moving average
+    QVector<double> ring;
+    int position;
+    int filled;
+    double sum;
+
+    // EMA
+    double alpha;
+    double average;
+    bool primed;
+
+    // Biquad, transposed direct form II
+    double b0, b1, b2, a1, a2;
+    double z1, z2;
+    double cutoff;
+
+    // FIR: taps, and the previous taps - 1 inputs followed by the block
+    QVector<double> taps;
+    QVector<double> work;
+
+    void processFir(const double *in, double *out, int count);
+};
+
+// Filters the parsed channels between parsing and storage. Samples are
+// buffered per channel and filtered a block at a time on flush(); the raw
+// samples are stored unchanged and the filtered series go to their own
+// store channels.
+class FilterStage
+{
+public:
+    enum { Channels = 6 };
+
+    FilterStage();
+
+    void setFilter(int channel, const ChannelFilter &filter);
+    const ChannelFilter &filter(int channel) const { return filters[channel]; }
+    bool isActive(int channel) const { return filters[channel].type() != ChannelFilter::None; }
+
+    void append(int channel, qint64 timestamp, double value);
+    bool isFull() const { return full; }
+    bool hasPending() const;
+
+    // Filter buffered samples into store channel targets[channel]
+    void flush(ChannelStore *store, const QVector<int> &targets);
+
+    // Drop buffered samples and filter state
+    void reset();
+
+private:
+    struct Pending {
+        QVector<qint64> timestamps;
+        QVector<double> values;
+        int count;
+    };
+
+    QVector<ChannelFilter> filters;
+    QVector<Pending> pending;
+    QVector<double> output;
+    bool full;
+};
+
+#endif // CHANNELFILTER_H
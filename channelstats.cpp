@@ -0,0 +1,180 @@
+#include "channelstats.h"
+#include <cmath>
+
+P2Quantile::P2Quantile(double quantile)
+    : p(quantile)
+{
+    reset();
+}
+
+void P2Quantile::reset()
+{
+    count = 0;
+    for (int i = 0; i < 5; ++i) {
+        heights[i] = 0.0;
+        positions[i] = i + 1;
+    }
+    desired[0] = 1.0;
+    desired[1] = 1.0 + 2.0 * p;
+    desired[2] = 1.0 + 4.0 * p;
+    desired[3] = 3.0 + 2.0 * p;
+    desired[4] = 5.0;
+    increments[0] = 0.0;
+    increments[1] = p / 2.0;
+    increments[2] = p;
+    increments[3] = (1.0 + p) / 2.0;
+    increments[4] = 1.0;
+}
+
+void P2Quantile::add(double x)
+{
+    // The first five samples seed the markers, kept sorted by insertion
+    if (count < 5) {
+        int i = count++;
+        while (i > 0 && heights[i - 1] > x) {
+            heights[i] = heights[i - 1];
+            --i;
+        }
+        heights[i] = x;
+        return;
+    }
+    ++count;
+
+    // Find the cell containing x, extending the extremes if needed
+    int k;
+    if (x < heights[0]) {
+        heights[0] = x;
+        k = 0;
+    } else if (x < heights[1]) {
+        k = 0;
+    } else if (x < heights[2]) {
+        k = 1;
+    } else if (x < heights[3]) {
+        k = 2;
+    } else if (x <= heights[4]) {
+        k = 3;
+    } else {
+        heights[4] = x;
+        k = 3;
+    }
+
+    for (int i = k + 1; i < 5; ++i) {
+        positions[i] += 1.0;
+    }
+    for (int i = 0; i < 5; ++i) {
+        desired[i] += increments[i];
+    }
+
+    // Nudge the three middle markers towards their desired positions
+    for (int i = 1; i <= 3; ++i) {
+        const double d = desired[i] - positions[i];
+        if ((d >= 1.0 && positions[i + 1] - positions[i] > 1.0) ||
+            (d <= -1.0 && positions[i - 1] - positions[i] < -1.0)) {
+            const int step = d >= 0.0 ? 1 : -1;
+            double candidate = parabolic(i, step);
+            if (heights[i - 1] < candidate && candidate < heights[i + 1]) {
+                heights[i] = candidate;
+            } else {
+                heights[i] = linear(i, step);
+            }
+            positions[i] += step;
+        }
+    }
+}
+
+double P2Quantile::parabolic(int i, double d) const
+{
+    return heights[i] + d / (positions[i + 1] - positions[i - 1]) *
+           ((positions[i] - positions[i - 1] + d) * (heights[i + 1] - heights[i]) /
+                (positions[i + 1] - positions[i]) +
+            (positions[i + 1] - positions[i] - d) * (heights[i] - heights[i - 1]) /
+                (positions[i] - positions[i - 1]));
+}
+
+double P2Quantile::linear(int i, int d) const
+{
+    return heights[i] + d * (heights[i + d] - heights[i]) / (positions[i + d] - positions[i]);
+}
+
+double P2Quantile::value() const
+{
+    if (count == 0) {
+        return 0.0;
+    }
+    if (count < 5) {
+        // Too few samples for markers, use the nearest rank directly
+        int index = qBound(0, (int)std::floor(p * (count - 1) + 0.5), count - 1);
+        return heights[index];
+    }
+    return heights[2];
+}
+
+ChannelStatistics::ChannelStatistics()
+    : m_p50(0.50)
+    , m_p95(0.95)
+    , m_p99(0.99)
+{
+    reset();
+}
+
+void ChannelStatistics::reset()
+{
+    m_count = 0;
+    m_last = 0.0;
+    m_mean = 0.0;
+    m_m2 = 0.0;
+    m_min = 0.0;
+    m_max = 0.0;
+    m_rate = 0.0;
+    m_rateCount = 0;
+    m_rateTimeMs = -1;
+    m_p50.reset();
+    m_p95.reset();
+    m_p99.reset();
+}
+
+void ChannelStatistics::add(double value)
+{
+    ++m_count;
+    m_last = value;
+
+    // Welford's update keeps the variance numerically stable
+    const double delta = value - m_mean;
+    m_mean += delta / m_count;
+    m_m2 += delta * (value - m_mean);
+
+    if (m_count == 1) {
+        m_min = m_max = value;
+    } else {
+        if (value < m_min) m_min = value;
+        if (value > m_max) m_max = value;
+    }
+
+    m_p50.add(value);
+    m_p95.add(value);
+    m_p99.add(value);
+}
+
+void ChannelStatistics::updateRate(qint64 nowMs)
+{
+    if (m_rateTimeMs >= 0 && nowMs > m_rateTimeMs) {
+        const double instant = (m_count - m_rateCount) * 1000.0 / (nowMs - m_rateTimeMs);
+        // Light smoothing so the display does not flicker between refreshes
+        m_rate = 0.5 * m_rate + 0.5 * instant;
+        if (instant == 0.0 && m_rate < 0.01) {
+            m_rate = 0.0;
+        }
+    }
+    m_rateCount = m_count;
+    m_rateTimeMs = nowMs;
+}
+
+double ChannelStatistics::variance() const
+{
+    return m_count > 1 ? m_m2 / (m_count - 1) : 0.0;
+}
+
+double ChannelStatistics::stddev() const
+{
+    return std::sqrt(variance());
+}
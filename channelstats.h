@@ -0,0 +1,70 @@
+#ifndef CHANNELSTATS_H
+#define CHANNELSTATS_H
+
+#include <QtGlobal>
+
+// Streaming quantile estimate using the P-square algorithm (Jain & Chlamtac):
+// five markers, O(1) time and constant memory per sample.
+class P2Quantile
+{
+public:
+    explicit P2Quantile(double quantile = 0.5);
+
+    void add(double x);
+    void reset();
+    double value() const;
+
+private:
+    double p;
+    int count;
+    double heights[5];     // Marker heights
+    double positions[5];   // Actual marker positions (1-based)
+    double desired[5];     // Desired marker positions
+    double increments[5];  // Desired position increment per sample
+
+    double parabolic(int i, double d) const;
+    double linear(int i, int d) const;
+};
+
+// Per-channel online accumulators, updated once per incoming sample
+class ChannelStatistics
+{
+public:
+    ChannelStatistics();
+
+    void add(double value);
+    void reset();
+
+    // Call periodically with a monotonic timestamp to refresh rate()
+    void updateRate(qint64 nowMs);
+
+    qint64 count() const { return m_count; }
+    double last() const { return m_last; }
+    double mean() const { return m_mean; }
+    double variance() const;
+    double stddev() const;
+    double min() const { return m_min; }
+    double max() const { return m_max; }
+    double rate() const { return m_rate; }  // Samples per second
+    double p50() const { return m_p50.value(); }
+    double p95() const { return m_p95.value(); }
+    double p99() const { return m_p99.value(); }
+
+private:
+    qint64 m_count;
+    double m_last;
+    double m_mean;
+    double m_m2;      // Sum of squared deviations (Welford)
+    double m_min;
+    double m_max;
+
+    double m_rate;
+    qint64 m_rateCount;
+    qint64 m_rateTimeMs;
+
+    P2Quantile m_p50;
+    P2Quantile m_p95;
+    P2Quantile m_p99;
+};
+
+#endif // CHANNELSTATS_H
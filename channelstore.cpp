@@ -0,0 +1,392 @@
+#include "channelstore.h"
+#include "chunkcodec.h"
+#include "historysegment.h"
+#include <QDir>
+#include <cstring>
+
+const SampleChunk *ChannelView::chunkAt(int index) const
+{
+    const StoredChunk &stored = chunks[index];
+    if (stored.raw) {
+        return stored.raw.data();
+    }
+    if (cachedIndex != index) {
+        // Always a fresh buffer: copies of this view may still share the old one
+        SampleChunkPtr decoded(new SampleChunk);
+        if (ChunkCodec::decode(stored.packed, decoded.data()) < 0) {
+            std::memset(decoded.data(), 0, sizeof(SampleChunk));
+        }
+        cached = decoded;
+        cachedIndex = index;
+    }
+    return cached.data();
+}
+
+double ChannelView::value(qint64 index) const
+{
+    const qint64 position = offset + index;
+    return chunkAt((int)(position / SampleChunk::Capacity))->values[position % SampleChunk::Capacity];
+}
+
+qint64 ChannelView::timestamp(qint64 index) const
+{
+    const qint64 position = offset + index;
+    return chunkAt((int)(position / SampleChunk::Capacity))->timestamps[position % SampleChunk::Capacity];
+}
+
+void ChannelView::read(qint64 start, int count, qint64 *timestamps, double *values) const
+{
+    qint64 position = offset + start;
+    int done = 0;
+    while (done < count) {
+        const SampleChunk *chunk = chunkAt((int)(position / SampleChunk::Capacity));
+        const int index = (int)(position % SampleChunk::Capacity);
+        const int run = qMin(SampleChunk::Capacity - index, count - done);
+        if (timestamps) {
+            std::memcpy(timestamps + done, chunk->timestamps + index, run * sizeof(qint64));
+        }
+        if (values) {
+            std::memcpy(values + done, chunk->values + index, run * sizeof(double));
+        }
+        done += run;
+        position += run;
+    }
+}
+
+ChannelView ChannelView::fromValues(const QVector<double> &values)
+{
+    ChannelView view;
+    for (int i = 0; i < values.size(); i += SampleChunk::Capacity) {
+        StoredChunk chunk;
+        chunk.raw = SampleChunkPtr(new SampleChunk);
+        const int run = qMin<int>(SampleChunk::Capacity, values.size() - i);
+        for (int j = 0; j < run; ++j) {
+            chunk.raw->timestamps[j] = i + j;
+            chunk.raw->values[j] = values[i + j];
+        }
+        view.chunks.append(chunk);
+    }
+    view.length = values.size();
+    return view;
+}
+
+ChannelStore::ChannelStore(int channelCount)
+    : retentionLimit(1000)
+    , compressSealed(false)
+{
+    setChannelCount(channelCount);
+}
+
+void ChannelStore::setChannelCount(int count)
+{
+    for (int i = count; i < series.size(); ++i) {
+        clearChannel(i);
+    }
+    const int previous = series.size();
+    series.resize(count);
+    for (int i = previous; i < count; ++i) {
+        series[i].name = QString("Graph %1").arg(i + 1);
+    }
+}
+
+void ChannelStore::setChannelName(int channel, const QString &name)
+{
+    if (channel >= 0 && channel < series.size()) {
+        series[channel].name = name;
+    }
+}
+
+void ChannelStore::setRetention(qint64 samples)
+{
+    retentionLimit = qMax<qint64>(1, samples);
+    for (int i = 0; i < series.size(); ++i) {
+        trim(series[i]);
+    }
+}
+
+void ChannelStore::setCompression(bool enabled)
+{
+    compressSealed = enabled;
+}
+
+qint64 ChannelStore::memoryUsage() const
+{
+    qint64 bytes = 0;
+    for (int i = 0; i < series.size(); ++i) {
+        const QList<StoredChunk> &chunks = series[i].chunks;
+        for (int c = 0; c < chunks.size(); ++c) {
+            if (chunks[c].raw) {
+                bytes += sizeof(SampleChunk);
+            } else if (!chunks[c].segment) {
+                bytes += chunks[c].packed.size();
+            }
+        }
+    }
+    return bytes;
+}
+
+bool ChannelStore::setSpillDirectory(const QString &path)
+{
+    if (path == spillPath) {
+        return true;
+    }
+
+    for (int i = 0; i < series.size(); ++i) {
+        series[i].segment.reset();
+    }
+    spillPath.clear();
+    if (path.isEmpty()) {
+        return true;
+    }
+
+#ifdef __EMSCRIPTEN__
+    // No file mappings in the browser sandbox
+    return false;
+#else
+    if (!QDir().mkpath(path)) {
+        return false;
+    }
+    spillPath = path;
+    // Turning spilling off and on again must not map the same files twice
+    if (!restoredPaths.contains(path)) {
+        restoredPaths.insert(path);
+        for (int i = 0; i < series.size(); ++i) {
+            restore(i);
+        }
+    }
+    return true;
+#endif
+}
+
+QString ChannelStore::segmentFileName(int channel, int sequence) const
+{
+    return QDir(spillPath).filePath(QString("ch%1-%2.sdseg")
+                                    .arg(channel, 2, 10, QChar('0'))
+                                    .arg(sequence, 6, 10, QChar('0')));
+}
+
+void ChannelStore::restore(int channel)
+{
+    Series &s = series[channel];
+    const QString pattern = QString("ch%1-*.sdseg").arg(channel, 2, 10, QChar('0'));
+    const QStringList files = QDir(spillPath).entryList(QStringList() << pattern,
+                                                        QDir::Files, QDir::Name);
+
+    QList<StoredChunk> recovered;
+    for (const QString &file : files) {
+        // "ch<channel>-<sequence>.sdseg"; the channel may have more digits
+        bool ok = false;
+        const int sequence = file.section('-', 1).section('.', 0, 0).toInt(&ok);
+        if (!ok) {
+            continue;
+        }
+        s.nextSegment = qMax(s.nextSegment, sequence + 1);
+
+        QVector<HistorySegment::Record> records;
+        HistorySegmentPtr segment = HistorySegment::open(QDir(spillPath).filePath(file),
+                                                         channel, &records);
+        if (!segment) {
+            continue;
+        }
+
+        // Only whole chunks keep the index arithmetic of views valid
+        int kept = 0;
+        for (const HistorySegment::Record &record : records) {
+            if (record.count != SampleChunk::Capacity) {
+                continue;
+            }
+            StoredChunk chunk;
+            chunk.packed = record.payload;
+            chunk.segment = segment;
+            recovered.append(chunk);
+            ++kept;
+        }
+        if (kept == 0) {
+            segment->discard();
+        }
+    }
+
+    if (recovered.isEmpty()) {
+        return;
+    }
+
+    // Recovered history predates anything in memory, so it goes first and
+    // the current samples are appended behind it
+    const ChannelView current = view(channel);
+    const qint64 appended = s.appended;
+    const qint64 restoredSamples = qint64(recovered.size()) * SampleChunk::Capacity;
+
+    s.chunks = recovered;
+    s.start = 0;
+    s.headCount = SampleChunk::Capacity;
+    s.size = restoredSamples;
+    trim(s);
+
+    current.forEachSpan([&](const qint64 *timestamps, const double *values, int count) {
+        for (int i = 0; i < count; ++i) {
+            append(channel, timestamps[i], values[i]);
+        }
+    });
+    series[channel].appended = appended + restoredSamples;
+}
+
+void ChannelStore::seal(int channel, StoredChunk &chunk)
+{
+    if (!chunk.raw || (!compressSealed && spillPath.isEmpty())) {
+        return;
+    }
+
+    QByteArray packed = ChunkCodec::encode(*chunk.raw, SampleChunk::Capacity);
+    if (!spillPath.isEmpty() && spill(channel, chunk, packed)) {
+        return;
+    }
+
+    // Noisy data can pack larger than it started; keep those chunks raw
+    if (!compressSealed || packed.size() >= int(sizeof(SampleChunk))) {
+        return;
+    }
+    // Views that already hold the raw chunk keep reading it unchanged
+    chunk.packed = packed;
+    chunk.raw.reset();
+}
+
+bool ChannelStore::spill(int channel, StoredChunk &chunk, const QByteArray &packed)
+{
+    Series &s = series[channel];
+    const qint64 first = chunk.raw->timestamps[0];
+    const qint64 last = chunk.raw->timestamps[SampleChunk::Capacity - 1];
+
+    HistorySegment::Record record;
+    if (!s.segment || !s.segment->append(packed, SampleChunk::Capacity, first, last, &record)) {
+        // Current segment full (or none yet): roll over to a new file
+        s.segment = HistorySegment::create(segmentFileName(channel, s.nextSegment++), channel);
+        if (!s.segment || !s.segment->append(packed, SampleChunk::Capacity, first, last, &record)) {
+            s.segment.reset();
+            return false;
+        }
+    }
+
+    chunk.packed = record.payload;
+    chunk.segment = s.segment;
+    chunk.raw.reset();
+    return true;
+}
+
+void ChannelStore::append(int channel, qint64 timestamp, double value)
+{
+    if (channel < 0 || channel >= series.size()) {
+        return;
+    }
+
+    Series &s = series[channel];
+    if (s.chunks.isEmpty() || s.headCount == SampleChunk::Capacity) {
+        if (!s.chunks.isEmpty()) {
+            seal(channel, s.chunks.last());
+        }
+        StoredChunk head;
+        head.raw = SampleChunkPtr(new SampleChunk);
+        s.chunks.append(head);
+        s.headCount = 0;
+    }
+
+    SampleChunk *chunk = s.chunks.last().raw.data();
+    chunk->timestamps[s.headCount] = timestamp;
+    chunk->values[s.headCount] = value;
+    ++s.headCount;
+    ++s.size;
+    ++s.appended;
+
+    trim(s);
+}
+
+void ChannelStore::trim(Series &s)
+{
+    qint64 excess = s.size - retentionLimit;
+    while (excess > 0) {
+        const int filled = (s.chunks.size() == 1) ? s.headCount : SampleChunk::Capacity;
+        const int inFirst = filled - s.start;
+        if (excess >= inFirst && s.chunks.size() > 1) {
+            // Views still holding the chunk keep it alive
+            const HistorySegmentPtr segment = s.chunks.at(0).segment;
+            s.chunks.removeFirst();
+            if (segment && s.chunks.at(0).segment != segment) {
+                // Last chunk of that segment gone: drop the file with it
+                segment->discard();
+                if (s.segment == segment) {
+                    s.segment.reset();
+                }
+            }
+            s.start = 0;
+            s.size -= inFirst;
+            excess -= inFirst;
+        } else {
+            s.start += (int)excess;
+            s.size -= excess;
+            excess = 0;
+        }
+    }
+}
+
+void ChannelStore::clear()
+{
+    for (int i = 0; i < series.size(); ++i) {
+        clearChannel(i);
+    }
+}
+
+void ChannelStore::clearChannel(int channel)
+{
+    Series &s = series[channel];
+    // Cleared history is gone from disk as well
+    for (int c = 0; c < s.chunks.size(); ++c) {
+        if (s.chunks.at(c).segment) {
+            s.chunks.at(c).segment->discard();
+        }
+    }
+    if (s.segment) {
+        s.segment->discard();
+    }
+    const int nextSegment = s.nextSegment;
+    const QString name = s.name;
+    s = Series();
+    s.nextSegment = nextSegment;
+    s.name = name;
+}
+
+qint64 ChannelStore::size(int channel) const
+{
+    return series[channel].size;
+}
+
+qint64 ChannelStore::appendedCount(int channel) const
+{
+    return series[channel].appended;
+}
+
+ChannelView ChannelStore::view(int channel) const
+{
+    const Series &s = series[channel];
+    ChannelView v;
+    v.chunks = s.chunks;
+    v.offset = s.start;
+    v.length = s.size;
+    return v;
+}
+
+ChannelView ChannelStore::tail(int channel, qint64 count) const
+{
+    const Series &s = series[channel];
+    count = qBound<qint64>(0, count, s.size);
+
+    // Share only the chunks the tail touches
+    const qint64 position = s.start + (s.size - count);
+    const int firstChunk = (int)(position / SampleChunk::Capacity);
+
+    ChannelView v;
+    if (count > 0) {
+        v.chunks = s.chunks.mid(firstChunk);
+    }
+    v.offset = (int)(position % SampleChunk::Capacity);
+    v.length = count;
+    return v;
+}
@@ -0,0 +1,160 @@
+#ifndef CHANNELSTORE_H
+#define CHANNELSTORE_H
+
+#include <QVector>
+#include <QList>
+#include <QSharedPointer>
+#include <QByteArray>
+#include <QString>
+#include <QSet>
+
+class HistorySegment;
+
+// Fixed-size block of samples. Chunks are append-only: once a slot has been
+// written it never changes, so views may read it from any thread while the
+// store keeps appending to later slots.
+struct SampleChunk {
+    enum { Capacity = 512 };
+
+    qint64 timestamps[Capacity];
+    double values[Capacity];
+};
+
+typedef QSharedPointer<SampleChunk> SampleChunkPtr;
+
+// A chunk as held by the store: the head chunk and uncompressed sealed
+// chunks keep raw samples, compressed sealed chunks only their packed form.
+// Spilled chunks pack into a memory-mapped segment that they keep alive.
+struct StoredChunk {
+    SampleChunkPtr raw;
+    QByteArray packed;  // ChunkCodec encoding, used when raw is null
+    QSharedPointer<HistorySegment> segment;
+};
+
+// Zero-copy, immutable view of a range of one channel. A view shares the
+// chunks it covers, so it stays valid after the store evicts or clears them;
+// copying a view only copies chunk pointers. Compressed chunks are decoded
+// lazily, one at a time, as they are read. That decode cache makes a single
+// view object unsafe to use from two threads at once: give each thread its
+// own copy.
+class ChannelView
+{
+public:
+    ChannelView() : offset(0), length(0), cachedIndex(-1) {}
+
+    qint64 size() const { return length; }
+    bool isEmpty() const { return length == 0; }
+
+    double value(qint64 index) const;
+    qint64 timestamp(qint64 index) const;
+
+    // Copy [start, start + count) into the caller's buffers; either buffer
+    // may be null when that column is not needed
+    void read(qint64 start, int count, qint64 *timestamps, double *values) const;
+
+    // Calls f(const qint64 *timestamps, const double *values, int count) for
+    // each contiguous run of samples, oldest first
+    template <typename Func>
+    void forEachSpan(Func f) const
+    {
+        qint64 remaining = length;
+        int index = offset;
+        for (int c = 0; c < chunks.size() && remaining > 0; ++c) {
+            const SampleChunk *chunk = chunkAt(c);
+            const int count = (int)qMin<qint64>(SampleChunk::Capacity - index, remaining);
+            f(chunk->timestamps + index, chunk->values + index, count);
+            remaining -= count;
+            index = 0;
+        }
+    }
+
+    // Standalone view over values that are not in a store (e.g. a capture)
+    static ChannelView fromValues(const QVector<double> &values);
+
+private:
+    friend class ChannelStore;
+
+    QList<StoredChunk> chunks;
+    int offset;      // First sample within chunks.first()
+    qint64 length;
+
+    mutable int cachedIndex;        // Chunk held decoded in cached
+    mutable SampleChunkPtr cached;
+
+    const SampleChunk *chunkAt(int index) const;
+};
+
+// Single owner of all plot samples. Each channel is a list of chunks with
+// exact retention: the oldest samples are dropped once a channel holds more
+// than retention() samples, and whole chunks are released as they empty.
+// With compression enabled, chunks are packed with ChunkCodec as they are
+// sealed; the head chunk always stays raw so appends remain cheap. With a
+// spill directory set, sealed chunks are always packed and written to
+// memory-mapped segment files, leaving only a small index in memory.
+class ChannelStore
+{
+public:
+    explicit ChannelStore(int channelCount = 6);
+
+    int channelCount() const { return series.size(); }
+    // New channels start empty; removed ones are cleared like clear()
+    void setChannelCount(int count);
+
+    QString channelName(int channel) const { return series[channel].name; }
+    void setChannelName(int channel, const QString &name);
+
+    void setRetention(qint64 samples);
+    qint64 retention() const { return retentionLimit; }
+
+    // Applies to chunks sealed from now on
+    void setCompression(bool enabled);
+    bool compression() const { return compressSealed; }
+
+    // Spill sealed chunks to segment files in path, first reopening any
+    // segments left there by an earlier session. Each directory is only
+    // reopened once, as later segments are already held in memory. An
+    // empty path stops spilling; chunks already on disk stay there.
+    bool setSpillDirectory(const QString &path);
+    QString spillDirectory() const { return spillPath; }
+
+    // Heap bytes held for samples; spilled chunks live in the page cache
+    qint64 memoryUsage() const;
+
+    void append(int channel, qint64 timestamp, double value);
+    void clear();
+    void clearChannel(int channel);
+
+    qint64 size(int channel) const;
+    qint64 appendedCount(int channel) const;  // Monotonic since clear()
+
+    ChannelView view(int channel) const;
+    ChannelView tail(int channel, qint64 count) const;
+
+private:
+    struct Series {
+        QList<StoredChunk> chunks;
+        int start;        // First retained sample within chunks.first()
+        int headCount;    // Samples written to chunks.last()
+        qint64 size;
+        qint64 appended;
+        QSharedPointer<HistorySegment> segment;  // Segment receiving spilled chunks
+        int nextSegment;
+        QString name;
+
+        Series() : start(0), headCount(0), size(0), appended(0), nextSegment(0) {}
+    };
+
+    QVector<Series> series;
+    qint64 retentionLimit;
+    bool compressSealed;
+    QString spillPath;
+    QSet<QString> restoredPaths;
+
+    void seal(int channel, StoredChunk &chunk);
+    bool spill(int channel, StoredChunk &chunk, const QByteArray &packed);
+    void restore(int channel);
+    void trim(Series &s);
+    QString segmentFileName(int channel, int sequence) const;
+};
+
+#endif // CHANNELSTORE_H
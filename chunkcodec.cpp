@@ -0,0 +1,236 @@
+#include "chunkcodec.h"
+#include <QtAlgorithms>
+#include <cstring>
+
+namespace {
+
+class BitWriter
+{
+public:
+    explicit BitWriter(QByteArray *out) : out(out), accumulator(0), pending(0) {}
+
+    // Appends the low count bits of value, most significant first
+    void write(quint64 value, int count)
+    {
+        while (count > 0) {
+            const int take = qMin(count, 8 - pending);
+            const quint64 bits = (value >> (count - take)) & ((1u << take) - 1);
+            accumulator = (accumulator << take) | (quint8)bits;
+            pending += take;
+            count -= take;
+            if (pending == 8) {
+                out->append(char(accumulator));
+                accumulator = 0;
+                pending = 0;
+            }
+        }
+    }
+
+    void flush()
+    {
+        if (pending > 0) {
+            out->append(char(accumulator << (8 - pending)));
+            accumulator = 0;
+            pending = 0;
+        }
+    }
+
+private:
+    QByteArray *out;
+    quint32 accumulator;
+    int pending;
+};
+
+class BitReader
+{
+public:
+    BitReader(const QByteArray &data)
+        : data(reinterpret_cast<const quint8 *>(data.constData()))
+        , totalBits(qint64(data.size()) * 8), position(0), overrun(false) {}
+
+    // Returns 0 and sets failed() once the stream runs out
+    quint64 read(int count)
+    {
+        if (position + count > totalBits) {
+            overrun = true;
+            position = totalBits;
+            return 0;
+        }
+        quint64 value = 0;
+        while (count > 0) {
+            const int offset = int(position & 7);
+            const int take = qMin(count, 8 - offset);
+            const quint8 byte = data[position >> 3];
+            value = (value << take) | ((byte >> (8 - offset - take)) & ((1u << take) - 1));
+            position += take;
+            count -= take;
+        }
+        return value;
+    }
+
+    bool failed() const { return overrun; }
+
+private:
+    const quint8 *data;
+    qint64 totalBits;
+    qint64 position;
+    bool overrun;
+};
+
+quint64 doubleBits(double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double bitsDouble(quint64 bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+qint64 signExtend(quint64 value, int bits)
+{
+    return qint64(value << (64 - bits)) >> (64 - bits);
+}
+
+bool fitsSigned(qint64 value, int bits)
+{
+    const qint64 limit = qint64(1) << (bits - 1);
+    return value >= -limit && value < limit;
+}
+
+} // namespace
+
+QByteArray ChunkCodec::encode(const SampleChunk &chunk, int count)
+{
+    QByteArray out;
+    if (count <= 0) {
+        return out;
+    }
+
+    // A chunk of steady, slowly changing samples packs to ~2 bits per sample
+    out.reserve(18 + count);
+    BitWriter writer(&out);
+    writer.write(quint64(count), 16);
+    writer.write(quint64(chunk.timestamps[0]), 64);
+    writer.write(doubleBits(chunk.values[0]), 64);
+
+    qint64 previousDelta = 0;
+    quint64 previousValue = doubleBits(chunk.values[0]);
+    int previousLeading = -1;
+    int previousTrailing = 0;
+
+    for (int i = 1; i < count; ++i) {
+        // Timestamp: delta-of-delta in the smallest bucket that holds it
+        const qint64 delta = chunk.timestamps[i] - chunk.timestamps[i - 1];
+        const qint64 dod = delta - previousDelta;
+        previousDelta = delta;
+        if (dod == 0) {
+            writer.write(0, 1);
+        } else if (fitsSigned(dod, 7)) {
+            writer.write(0x2, 2);
+            writer.write(quint64(dod), 7);
+        } else if (fitsSigned(dod, 9)) {
+            writer.write(0x6, 3);
+            writer.write(quint64(dod), 9);
+        } else if (fitsSigned(dod, 12)) {
+            writer.write(0xE, 4);
+            writer.write(quint64(dod), 12);
+        } else {
+            writer.write(0xF, 4);
+            writer.write(quint64(dod), 64);
+        }
+
+        // Value: XOR with the previous one, reusing its bit window when it fits
+        const quint64 bits = doubleBits(chunk.values[i]);
+        const quint64 x = bits ^ previousValue;
+        previousValue = bits;
+        if (x == 0) {
+            writer.write(0, 1);
+            continue;
+        }
+        writer.write(1, 1);
+
+        const int leading = qMin(31, int(qCountLeadingZeroBits(x)));
+        const int trailing = int(qCountTrailingZeroBits(x));
+        if (previousLeading >= 0 && leading >= previousLeading && trailing >= previousTrailing) {
+            writer.write(0, 1);
+            writer.write(x >> previousTrailing, 64 - previousLeading - previousTrailing);
+        } else {
+            const int meaningful = 64 - leading - trailing;
+            writer.write(1, 1);
+            writer.write(quint64(leading), 5);
+            writer.write(quint64(meaningful - 1), 6);
+            writer.write(x >> trailing, meaningful);
+            previousLeading = leading;
+            previousTrailing = trailing;
+        }
+    }
+
+    writer.flush();
+    return out;
+}
+
+int ChunkCodec::decode(const QByteArray &data, SampleChunk *chunk)
+{
+    BitReader reader(data);
+    const int count = int(reader.read(16));
+    if (reader.failed() || count > SampleChunk::Capacity) {
+        return -1;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    chunk->timestamps[0] = qint64(reader.read(64));
+    quint64 previousValue = reader.read(64);
+    chunk->values[0] = bitsDouble(previousValue);
+
+    qint64 previousDelta = 0;
+    int previousLeading = -1;
+    int previousTrailing = 0;
+
+    for (int i = 1; i < count && !reader.failed(); ++i) {
+        qint64 dod = 0;
+        if (reader.read(1) != 0) {
+            if (reader.read(1) == 0) {
+                dod = signExtend(reader.read(7), 7);
+            } else if (reader.read(1) == 0) {
+                dod = signExtend(reader.read(9), 9);
+            } else if (reader.read(1) == 0) {
+                dod = signExtend(reader.read(12), 12);
+            } else {
+                dod = qint64(reader.read(64));
+            }
+        }
+        previousDelta += dod;
+        chunk->timestamps[i] = chunk->timestamps[i - 1] + previousDelta;
+
+        if (reader.read(1) != 0) {
+            quint64 x;
+            if (reader.read(1) == 0) {
+                if (previousLeading < 0) {
+                    return -1;
+                }
+                x = reader.read(64 - previousLeading - previousTrailing) << previousTrailing;
+            } else {
+                const int leading = int(reader.read(5));
+                const int meaningful = int(reader.read(6)) + 1;
+                const int trailing = 64 - leading - meaningful;
+                if (trailing < 0) {
+                    return -1;
+                }
+                x = reader.read(meaningful) << trailing;
+                previousLeading = leading;
+                previousTrailing = trailing;
+            }
+            previousValue ^= x;
+        }
+        chunk->values[i] = bitsDouble(previousValue);
+    }
+
+    return reader.failed() ? -1 : count;
+}
@@ -0,0 +1,25 @@
+#ifndef CHUNKCODEC_H
+#define CHUNKCODEC_H
+
+#include <QByteArray>
+#include "channelstore.h"
+
+// Gorilla-style compression for sealed sample chunks (Pelkonen et al., VLDB
+// 2015). Timestamps are stored as delta-of-deltas, so a steady sample rate
+// costs one bit each; values are XORed with their predecessor, so a repeated
+// value costs one bit and a slowly changing one only its meaningful bits.
+//
+// Layout, one MSB-first bit stream padded to a whole byte:
+//   u16 count | i64 first timestamp | f64 first value | per later sample:
+//   timestamp delta-of-delta code, value XOR code
+class ChunkCodec
+{
+public:
+    static QByteArray encode(const SampleChunk &chunk, int count);
+
+    // Returns the number of samples decoded into chunk, or -1 if the data is
+    // truncated or malformed
+    static int decode(const QByteArray &data, SampleChunk *chunk);
+};
+
+#endif // CHUNKCODEC_H
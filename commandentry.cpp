@@ -0,0 +1,14 @@
+#include "commandentry.h"
+
+QByteArray CommandEntry::encode(const QString &text, bool hex, const QByteArray &lineEnding)
+{
+    if (text.isEmpty()) {
+        return QByteArray();
+    }
+    if (hex) {
+        QString digits = text;
+        digits.replace(" ", "").replace("\n", "").replace("\r", "");
+        return QByteArray::fromHex(digits.toLatin1());
+    }
+    return text.toUtf8() + lineEnding;
+}
@@ -0,0 +1,25 @@
+#ifndef COMMANDENTRY_H
+#define COMMANDENTRY_H
+
+#include <QByteArray>
+#include <QString>
+
+// A saved command. The bytes to send are encoded once when the entry is
+// made, so sending it again costs no parsing.
+struct CommandEntry {
+    QString name;
+    QString text;           // As typed, for editing
+    bool hex;
+    QByteArray payload;
+
+    CommandEntry() : hex(false) {}
+    CommandEntry(const QString &name, const QString &text, bool hex, const QByteArray &lineEnding)
+        : name(name), text(text), hex(hex), payload(encode(text, hex, lineEnding)) {}
+
+    QString displayText() const { return name + " | " + text; }
+
+    // Hex text ignores whitespace and takes no line ending
+    static QByteArray encode(const QString &text, bool hex, const QByteArray &lineEnding);
+};
+
+#endif // COMMANDENTRY_H
@@ -0,0 +1,167 @@
+#include "commandscript.h"
+#include <QMap>
+#include <QPair>
+#include <QStringList>
+
+namespace {
+
+int hexDigit(QChar c)
+{
+    if (c >= '0' && c <= '9') return c.unicode() - '0';
+    if (c >= 'a' && c <= 'f') return c.unicode() - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c.unicode() - 'A' + 10;
+    return -1;
+}
+
+// Splits a line into words and quoted strings, dropping a trailing comment.
+// Quoted strings are unescaped to bytes.
+bool tokenize(const QString &line, QVector<QByteArray> *tokens, QString *error)
+{
+    int i = 0;
+    const int n = line.size();
+    while (i < n) {
+        const QChar c = line[i];
+        if (c.isSpace()) {
+            ++i;
+            continue;
+        }
+        if (c == '#') {
+            break;
+        }
+
+        if (c != '"') {
+            const int start = i;
+            while (i < n && !line[i].isSpace() && line[i] != '"') {
+                ++i;
+            }
+            tokens->append(line.mid(start, i - start).toUtf8());
+            continue;
+        }
+
+        QByteArray token;
+        ++i;
+        while (i < n && line[i] != '"') {
+            if (line[i] != '\\') {
+                token.append(QString(line[i]).toUtf8());
+                ++i;
+                continue;
+            }
+            if (++i >= n) {
+                break;
+            }
+            const QChar e = line[i++];
+            if (e == 'r') {
+                token.append('\r');
+            } else if (e == 'n') {
+                token.append('\n');
+            } else if (e == 't') {
+                token.append('\t');
+            } else if (e == 'x' && i + 1 < n && hexDigit(line[i]) >= 0 && hexDigit(line[i + 1]) >= 0) {
+                token.append(char(hexDigit(line[i]) * 16 + hexDigit(line[i + 1])));
+                i += 2;
+            } else if (e == '\\' || e == '"') {
+                token.append(char(e.unicode()));
+            } else {
+                *error = QString("bad escape '\\%1'").arg(e);
+                return false;
+            }
+        }
+        if (i >= n) {
+            *error = QString("unterminated string");
+            return false;
+        }
+        ++i;
+        tokens->append(token);
+    }
+    return true;
+}
+
+bool toCount(const QByteArray &token, int *value)
+{
+    bool ok = false;
+    *value = token.toInt(&ok);
+    return ok && *value >= 0;
+}
+
+} // namespace
+
+bool CommandScript::parse(const QString &text, QString *error)
+{
+    program.clear();
+    QMap<QByteArray, int> labels;
+    // Steps that name a label, resolved once every label is known
+    QVector<QPair<int, QByteArray> > jumps;
+
+    const QStringList lines = text.split('\n');
+    for (int l = 0; l < lines.size(); ++l) {
+        QVector<QByteArray> tokens;
+        QString reason;
+        if (!tokenize(lines[l], &tokens, &reason)) {
+            *error = QString("Line %1: %2").arg(l + 1).arg(reason);
+            return false;
+        }
+        if (tokens.isEmpty()) {
+            continue;
+        }
+
+        const QByteArray keyword = tokens[0].toLower();
+        const int args = tokens.size() - 1;
+        ScriptStep step;
+        step.line = l + 1;
+
+        if (keyword.endsWith(':') && args == 0 && keyword.size() > 1) {
+            const QByteArray name = tokens[0].left(tokens[0].size() - 1);
+            if (labels.contains(name)) {
+                *error = QString("Line %1: duplicate label '%2'").arg(l + 1).arg(QString::fromUtf8(name));
+                return false;
+            }
+            labels.insert(name, program.size());
+            continue;
+        } else if (keyword == "send" && args == 1) {
+            step.type = ScriptStep::Send;
+            step.data = tokens[1];
+        } else if (keyword == "sendhex" && args >= 1) {
+            step.type = ScriptStep::Send;
+            QByteArray hex;
+            for (int t = 1; t < tokens.size(); ++t) {
+                hex += tokens[t];
+            }
+            step.data = QByteArray::fromHex(hex);
+            if (hex.size() % 2 != 0 || step.data.size() * 2 != hex.size()) {
+                *error = QString("Line %1: bad hex data").arg(l + 1);
+                return false;
+            }
+        } else if (keyword == "expect" && (args == 2 || args == 3) && toCount(tokens[2], &step.ms)) {
+            step.type = ScriptStep::Expect;
+            step.data = tokens[1];
+            if (args == 3) {
+                jumps.append(qMakePair(program.size(), tokens[3]));
+            }
+        } else if (keyword == "delay" && args == 1 && toCount(tokens[1], &step.ms)) {
+            step.type = ScriptStep::Delay;
+        } else if (keyword == "goto" && args == 1) {
+            step.type = ScriptStep::Goto;
+            jumps.append(qMakePair(program.size(), tokens[1]));
+        } else if (keyword == "repeat" && args == 2 && toCount(tokens[2], &step.count)) {
+            step.type = ScriptStep::Repeat;
+            jumps.append(qMakePair(program.size(), tokens[1]));
+        } else if (keyword == "stop" && args == 0) {
+            step.type = ScriptStep::Stop;
+        } else {
+            *error = QString("Line %1: cannot parse '%2'").arg(l + 1).arg(lines[l].trimmed());
+            return false;
+        }
+        program.append(step);
+    }
+
+    for (int j = 0; j < jumps.size(); ++j) {
+        ScriptStep &step = program[jumps[j].first];
+        if (!labels.contains(jumps[j].second)) {
+            *error = QString("Line %1: unknown label '%2'")
+                     .arg(step.line).arg(QString::fromUtf8(jumps[j].second));
+            return false;
+        }
+        step.target = labels.value(jumps[j].second);
+    }
+    return true;
+}
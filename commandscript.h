@@ -0,0 +1,52 @@
+#ifndef COMMANDSCRIPT_H
+#define COMMANDSCRIPT_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+struct ScriptStep {
+    enum Type {
+        Send,       // Write data
+        Expect,     // Wait up to ms for data to arrive; on timeout jump to
+                    // target, or fail when there is none
+        Delay,      // Pause for ms
+        Goto,       // Jump to target
+        Repeat,     // Jump to target count times, then fall through
+        Stop
+    };
+
+    Type type;
+    QByteArray data;
+    int ms;
+    int target;     // Step index, -1 for none
+    int count;
+    int line;       // Source line, 1-based
+
+    ScriptStep() : type(Stop), ms(0), target(-1), count(0), line(0) {}
+};
+
+// Parses a command sequence, one statement per line:
+//
+//   # comment
+//   start:                  label
+//   send "AT\r\n"           text; \r \n \t \\ \" and \xHH escapes
+//   sendhex 41 54 0D 0A     raw bytes
+//   expect "OK" 500         wait for a pattern, failing after 500 ms
+//   expect "OK" 500 retry   ... or jump to label retry instead
+//   delay 100               pause in ms
+//   goto start
+//   repeat start 3          jump back 3 more times, then continue
+//   stop
+class CommandScript
+{
+public:
+    // On failure error names the offending line
+    bool parse(const QString &text, QString *error);
+    const QVector<ScriptStep> &steps() const { return program; }
+
+private:
+    QVector<ScriptStep> program;
+};
+
+#endif // COMMANDSCRIPT_H
@@ -0,0 +1,88 @@
+#include "derivedchannels.h"
+#include "channelstore.h"
+#include <cmath>
+#include <limits>
+
+DerivedChannels::DerivedChannels()
+    : columns(ChannelExpression::Inputs * BatchRows)
+    , columnPointers(ChannelExpression::Inputs)
+    , timestamps(BatchRows)
+    , output(BatchRows)
+    , rows(0)
+{
+    for (int c = 0; c < ChannelExpression::Inputs; ++c) {
+        columnPointers[c] = columns.constData() + c * BatchRows;
+    }
+}
+
+bool DerivedChannels::setExpressions(const QStringList &sources, QStringList *errors)
+{
+    QVector<QSharedPointer<ChannelExpression>> compiled;
+    for (const QString &source : sources) {
+        if (source.trimmed().isEmpty()) {
+            continue;
+        }
+        QSharedPointer<ChannelExpression> expression(new ChannelExpression);
+        QString error;
+        if (!expression->compile(source, &error)) {
+            errors->append(QString("%1: %2").arg(source.trimmed(), error));
+            continue;
+        }
+        compiled.append(expression);
+    }
+
+    if (!errors->isEmpty()) {
+        return false;
+    }
+    if (compiled.size() > MaxChannels) {
+        errors->append(QString("At most %1 derived channels").arg(int(MaxChannels)));
+        return false;
+    }
+
+    expressions = compiled;
+    rows = 0;
+    return true;
+}
+
+void DerivedChannels::appendRow(qint64 timestamp, const QVector<double> &row)
+{
+    if (expressions.isEmpty() || rows == BatchRows) {
+        return;
+    }
+
+    double *base = columns.data();
+    const int present = qMin(row.size(), int(ChannelExpression::Inputs));
+    for (int c = 0; c < present; ++c) {
+        base[c * BatchRows + rows] = row[c];
+    }
+    for (int c = present; c < ChannelExpression::Inputs; ++c) {
+        base[c * BatchRows + rows] = std::numeric_limits<double>::quiet_NaN();
+    }
+    timestamps[rows] = timestamp;
+    ++rows;
+}
+
+void DerivedChannels::flush(ChannelStore *store, int firstChannel)
+{
+    if (rows == 0) {
+        return;
+    }
+
+    for (int e = 0; e < expressions.size(); ++e) {
+        expressions[e]->evaluate(columnPointers.constData(), rows, output.data());
+        const int channel = firstChannel + e;
+        // NaN (warm-up, missing inputs) shows as a gap in the plot
+        for (int i = 0; i < rows; ++i) {
+            store->append(channel, timestamps[i], output[i]);
+        }
+    }
+    rows = 0;
+}
+
+void DerivedChannels::reset()
+{
+    rows = 0;
+    for (int e = 0; e < expressions.size(); ++e) {
+        expressions[e]->reset();
+    }
+}
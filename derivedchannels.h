@@ -0,0 +1,51 @@
+#ifndef DERIVEDCHANNELS_H
+#define DERIVEDCHANNELS_H
+
+#include <QVector>
+#include <QStringList>
+#include <QSharedPointer>
+
+#include "channelexpression.h"
+
+class ChannelStore;
+
+// Virtual channels computed from the parsed ones. Rows are collected into
+// fixed column buffers and every expression is evaluated over the whole
+// batch on flush(), with results appended to the store after the input
+// channels.
+class DerivedChannels
+{
+public:
+    enum { MaxChannels = 32, BatchRows = ChannelExpression::MaxBatch };
+
+    DerivedChannels();
+
+    // Compiles all expressions; on failure nothing changes and errors holds
+    // one "expression: message" line per bad expression
+    bool setExpressions(const QStringList &sources, QStringList *errors);
+    int count() const { return expressions.size(); }
+    QString source(int index) const { return expressions[index]->source(); }
+
+    // Missing inputs in a short row are treated as NaN
+    void appendRow(qint64 timestamp, const QVector<double> &row);
+    int pendingRows() const { return rows; }
+    bool isFull() const { return rows == BatchRows; }
+
+    // Evaluate pending rows into store channels firstChannel onwards.
+    // Every row adds a sample to every channel, NaN included, so derived
+    // channels stay row-aligned with their sources.
+    void flush(ChannelStore *store, int firstChannel);
+
+    // Drop pending rows and moving-average history
+    void reset();
+
+private:
+    QVector<QSharedPointer<ChannelExpression>> expressions;
+    QVector<double> columns;      // Inputs columns of BatchRows
+    QVector<const double *> columnPointers;
+    QVector<qint64> timestamps;
+    QVector<double> output;
+    int rows;
+};
+
+#endif // DERIVEDCHANNELS_H
@@ -0,0 +1,210 @@
+#include "devicesimulator.h"
+#include "latencymeter.h"
+#include <QMutexLocker>
+#include <QtMath>
+#include <cerrno>
+#include <cstdio>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+
+// Longest wait between checks for input, config changes and stop requests
+const int kPollMs = 10;
+// After a stall, ticks beyond this many seconds' worth are skipped rather
+// than sent in one go
+const double kMaxCatchUpSeconds = 1.0;
+// Most values one binary frame carries; further channels are left out
+const int kMaxFrameChannels = 64;
+// Most output built per pass, about what the pty takes in at once; lines
+// and frames beyond it are counted as dropped without being formatted
+const int kMaxBatchBytes = 16 * 1024;
+// Longest "%.3f" of a sample in [-100, 100], with its separator
+const int kMaxValueChars = 9;
+const double kPi = 3.14159265358979323846;
+
+} // namespace
+
+DeviceSimulator::DeviceSimulator(QObject *parent)
+    : QThread(parent)
+    , master(-1)
+    , stopRequested(0)
+    , sentBytes(0)
+    , droppedBytes(0)
+    , configChanged(false)
+    , sequence(0)
+{
+}
+
+DeviceSimulator::~DeviceSimulator()
+{
+    stopSimulator();
+}
+
+void DeviceSimulator::startSimulator(int masterHandle, const SimulatorConfig &config)
+{
+    stopSimulator();
+    master = masterHandle;
+    sequence = 0;
+    sentBytes.storeRelease(0);
+    droppedBytes.storeRelease(0);
+    setConfig(config);
+    stopRequested.storeRelease(0);
+    start();
+}
+
+void DeviceSimulator::stopSimulator()
+{
+    stopRequested.storeRelease(1);
+    wait();
+}
+
+void DeviceSimulator::setConfig(const SimulatorConfig &config)
+{
+    QMutexLocker lock(&mutex);
+    pending = config;
+    configChanged = true;
+}
+
+qint64 DeviceSimulator::bytesSent() const
+{
+    return sentBytes.loadAcquire();
+}
+
+qint64 DeviceSimulator::bytesDropped() const
+{
+    return droppedBytes.loadAcquire();
+}
+
+void DeviceSimulator::run()
+{
+    SimulatorConfig config;
+    qint64 startNs = 0;
+    qint64 ticks = 0;       // Sent since startNs
+    char input[4096];
+    out.reserve(64 * 1024);
+
+    while (!stopRequested.loadAcquire()) {
+        {
+            QMutexLocker lock(&mutex);
+            if (configChanged) {
+                config = pending;
+                configChanged = false;
+                startNs = LatencyMeter::clockNs();
+                ticks = 0;
+            }
+        }
+
+        int waitMs = kPollMs;
+        if (config.rate > 0.0) {
+            const qint64 now = LatencyMeter::clockNs();
+            // The first tick goes out right away
+            qint64 due = qint64((now - startNs) * 1e-9 * config.rate) + 1 - ticks;
+            const qint64 maxDue = qMax<qint64>(1, qint64(config.rate * kMaxCatchUpSeconds));
+            if (due > maxDue) {
+                ticks += due - maxDue;
+                due = maxDue;
+            }
+
+            if (due > 0) {
+                // Lines or frames due, capped to the byte budget up front
+                const bool frames = config.pattern == SimulatorConfig::BinaryFrames;
+                const qint64 perTick = config.pattern == SimulatorConfig::Bursts ? config.burstSize : 1;
+                const int unitBytes = frames ? 6 + 2 * qMin(config.channels, kMaxFrameChannels)
+                                             : config.channels * kMaxValueChars + 1;
+                const qint64 units = due * perTick;
+                const qint64 built = qMin<qint64>(units, qMax(1, kMaxBatchBytes / unitBytes));
+
+                out.resize(0);
+                for (qint64 i = 0; i < built; ++i) {
+                    if (frames) {
+                        appendFrame(config);
+                    } else {
+                        appendLine(config);
+                    }
+                }
+                send(out.constData(), out.size());
+                if (units > built) {
+                    // Skipped ones still advance the waveform, as time passed
+                    droppedBytes.fetchAndAddRelaxed((units - built) * (out.size() / built));
+                    sequence += quint64(units - built);
+                }
+                ticks += due;
+            }
+
+            const qint64 nextNs = startNs + qint64(ticks * 1e9 / config.rate);
+            waitMs = int(qBound<qint64>(0, (nextNs - LatencyMeter::clockNs()) / 1000000, kPollMs));
+        }
+
+        // Whatever the app writes is drained, so its writes never block
+        pollfd pfd;
+        pfd.fd = master;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (::poll(&pfd, 1, waitMs) > 0 && (pfd.revents & POLLIN)) {
+            const ssize_t n = ::read(master, input, sizeof(input));
+            if (n > 0 && config.echo) {
+                send(input, n);
+            }
+        }
+    }
+}
+
+double DeviceSimulator::sampleValue(int channel) const
+{
+    // Amplitude 100, periods of 50, 100, 150... samples
+    const double period = 50.0 * (channel + 1);
+    return 100.0 * qSin(2.0 * kPi * double(sequence) / period);
+}
+
+void DeviceSimulator::appendLine(const SimulatorConfig &config)
+{
+    char number[32];
+    for (int channel = 0; channel < config.channels; ++channel) {
+        const int length = std::snprintf(number, sizeof(number), channel > 0 ? ",%.3f" : "%.3f",
+                                         sampleValue(channel));
+        out.append(number, length);
+    }
+    out.append('\n');
+    ++sequence;
+}
+
+void DeviceSimulator::appendFrame(const SimulatorConfig &config)
+{
+    const int count = qMin(config.channels, kMaxFrameChannels);
+    const int start = out.size();
+    out.append(char(0xAA));
+    out.append(char(0x55));
+    out.append(char(sequence & 0xFF));
+    out.append(char((sequence >> 8) & 0xFF));
+    out.append(char(count));
+    for (int channel = 0; channel < count; ++channel) {
+        const qint16 value = qint16(qRound(sampleValue(channel) * 100.0));
+        out.append(char(value & 0xFF));
+        out.append(char((value >> 8) & 0xFF));
+    }
+    quint8 sum = 0;
+    for (int i = start + 2; i < out.size(); ++i) {
+        sum += quint8(out[i]);
+    }
+    out.append(char(sum));
+    ++sequence;
+}
+
+void DeviceSimulator::send(const char *data, qint64 size)
+{
+    // Non-blocking: what does not fit now is lost, as on a real line
+    qint64 written = 0;
+    while (written < size) {
+        const ssize_t n = ::write(master, data + written, size_t(size - written));
+        if (n > 0) {
+            written += n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            break;
+        }
+    }
+    sentBytes.fetchAndAddRelaxed(written);
+    droppedBytes.fetchAndAddRelaxed(size - written);
+}
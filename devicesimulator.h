@@ -0,0 +1,78 @@
+#ifndef DEVICESIMULATOR_H
+#define DEVICESIMULATOR_H
+
+#include <QThread>
+#include <QByteArray>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+
+struct SimulatorConfig {
+    enum Pattern {
+        CsvLines,       // One line of comma-separated values per tick
+        BinaryFrames,   // One frame per tick, see DeviceSimulator
+        Bursts          // burstSize lines back to back per tick
+    };
+
+    Pattern pattern;
+    double rate;        // Ticks per second; 0 pauses the stream
+    int channels;       // Values per line or frame
+    int burstSize;
+    bool echo;          // Send back whatever the app writes
+
+    SimulatorConfig()
+        : pattern(CsvLines), rate(100.0), channels(4), burstSize(50), echo(false) {}
+};
+
+// Device on the master side of a VirtualPort. Streams test data at the
+// configured rate, paced on LatencyMeter::clockNs() and sent in batches
+// when the rate is above the 1 ms wait granularity, and drains or echoes
+// what the app sends. Output the app does not take in time is dropped and
+// counted, as a UART without flow control would lose it; so is output past
+// a fixed byte budget per pass, which is never built at all.
+//
+// Each value is a sine of its own period in samples, so the plots show a
+// clean wave whatever the rate. A binary frame is 0xAA 0x55, a 16-bit
+// little-endian sequence number, a count byte, count 16-bit little-endian
+// values scaled by 100, and the low byte of the sum of everything after
+// the sync bytes.
+class DeviceSimulator : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit DeviceSimulator(QObject *parent = nullptr);
+    ~DeviceSimulator();
+
+    void startSimulator(int masterHandle, const SimulatorConfig &config);
+    void stopSimulator();
+    // Thread-safe; the stream restarts its pacing from now
+    void setConfig(const SimulatorConfig &config);
+
+    // Totals since startSimulator()
+    qint64 bytesSent() const;
+    qint64 bytesDropped() const;
+
+protected:
+    void run() override;
+
+private:
+    int master;
+    QAtomicInt stopRequested;
+    QAtomicInteger<qint64> sentBytes;
+    QAtomicInteger<qint64> droppedBytes;
+
+    QMutex mutex;
+    SimulatorConfig pending;
+    bool configChanged;
+
+    QByteArray out;         // Reused for every batch
+    quint64 sequence;       // Lines and frames generated so far
+
+    void appendLine(const SimulatorConfig &config);
+    void appendFrame(const SimulatorConfig &config);
+    double sampleValue(int channel) const;
+    void send(const char *data, qint64 size);
+};
+
+#endif // DEVICESIMULATOR_H
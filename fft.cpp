@@ -0,0 +1,138 @@
+#include "fft.h"
+#include <cmath>
+
+namespace {
+const double kPi = 3.14159265358979323846;
+}
+
+Fft::Fft(int size)
+    : n(size)
+    , log2n(0)
+{
+    while ((1 << log2n) < n) {
+        ++log2n;
+    }
+
+    // Bit-reversal permutation
+    bitReverse.resize(n);
+    for (int i = 0; i < n; ++i) {
+        int r = 0;
+        for (int b = 0; b < log2n; ++b) {
+            if (i & (1 << b)) {
+                r |= 1 << (log2n - 1 - b);
+            }
+        }
+        bitReverse[i] = r;
+    }
+
+    // One leading radix-2 stage (half == 1) when log2n is odd, handled
+    // separately; radix-4 stages then start at span 2 or 1
+    int half = (log2n % 2) ? 2 : 1;
+    for (; half * 4 <= n; half *= 4) {
+        Stage stage;
+        stage.half = half;
+        stage.w1re.resize(half);
+        stage.w1im.resize(half);
+        stage.w2re.resize(half);
+        stage.w2im.resize(half);
+        for (int j = 0; j < half; ++j) {
+            const double a1 = -2.0 * kPi * j / (2.0 * half);
+            const double a2 = -2.0 * kPi * j / (4.0 * half);
+            stage.w1re[j] = std::cos(a1);
+            stage.w1im[j] = std::sin(a1);
+            stage.w2re[j] = std::cos(a2);
+            stage.w2im[j] = std::sin(a2);
+        }
+        stages.append(stage);
+    }
+}
+
+bool Fft::isPowerOfTwo(int value)
+{
+    return value > 0 && (value & (value - 1)) == 0;
+}
+
+QVector<double> Fft::window(Window type, int size)
+{
+    QVector<double> w(size);
+    const double denom = size > 1 ? size - 1 : 1;
+    for (int i = 0; i < size; ++i) {
+        const double x = 2.0 * kPi * i / denom;
+        switch (type) {
+        case Hann:
+            w[i] = 0.5 - 0.5 * std::cos(x);
+            break;
+        case Hamming:
+            w[i] = 0.54 - 0.46 * std::cos(x);
+            break;
+        case Blackman:
+            w[i] = 0.42 - 0.5 * std::cos(x) + 0.08 * std::cos(2.0 * x);
+            break;
+        }
+    }
+    return w;
+}
+
+void Fft::transform(double *re, double *im) const
+{
+    // Reorder input into bit-reversed order
+    for (int i = 0; i < n; ++i) {
+        const int j = bitReverse[i];
+        if (j > i) {
+            double t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    // Leading radix-2 stage with unit twiddles
+    if (log2n % 2) {
+        for (int k = 0; k < n; k += 2) {
+            const double ar = re[k], ai = im[k];
+            const double br = re[k + 1], bi = im[k + 1];
+            re[k] = ar + br;     im[k] = ai + bi;
+            re[k + 1] = ar - br; im[k + 1] = ai - bi;
+        }
+    }
+
+    // Radix-4 stages: two radix-2 DIT stages (span h, then 2h) fused so each
+    // element is loaded and stored once per pair of stages
+    for (const Stage &stage : stages) {
+        const int h = stage.half;
+        const double *w1r = stage.w1re.constData();
+        const double *w1i = stage.w1im.constData();
+        const double *w2r = stage.w2re.constData();
+        const double *w2i = stage.w2im.constData();
+
+        for (int k = 0; k < n; k += 4 * h) {
+            double *ra = re + k;
+            double *ia = im + k;
+            double *rb = ra + h, *ib = ia + h;
+            double *rc = rb + h, *ic = ib + h;
+            double *rd = rc + h, *id = ic + h;
+
+            for (int j = 0; j < h; ++j) {
+                // First stage: (a, b) and (c, d) with W(2h)^j
+                const double tbr = w1r[j] * rb[j] - w1i[j] * ib[j];
+                const double tbi = w1r[j] * ib[j] + w1i[j] * rb[j];
+                const double tdr = w1r[j] * rd[j] - w1i[j] * id[j];
+                const double tdi = w1r[j] * id[j] + w1i[j] * rd[j];
+
+                const double a1r = ra[j] + tbr, a1i = ia[j] + tbi;
+                const double b1r = ra[j] - tbr, b1i = ia[j] - tbi;
+                const double c1r = rc[j] + tdr, c1i = ic[j] + tdi;
+                const double d1r = rc[j] - tdr, d1i = ic[j] - tdi;
+
+                // Second stage: (a, c) with W(4h)^j, (b, d) with -i * W(4h)^j
+                const double tcr = w2r[j] * c1r - w2i[j] * c1i;
+                const double tci = w2r[j] * c1i + w2i[j] * c1r;
+                const double ter = w2i[j] * d1r + w2r[j] * d1i;
+                const double tei = w2i[j] * d1i - w2r[j] * d1r;
+
+                ra[j] = a1r + tcr; ia[j] = a1i + tci;
+                rc[j] = a1r - tcr; ic[j] = a1i - tci;
+                rb[j] = b1r + ter; ib[j] = b1i + tei;
+                rd[j] = b1r - ter; id[j] = b1i - tei;
+            }
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <QVector>
+
+// In-place complex FFT for power-of-two sizes, split real/imaginary arrays.
+// Twiddles for every stage are precomputed into contiguous arrays so the
+// inner butterfly loops are unit-stride and auto-vectorize; stages are
+// merged pairwise into radix-4 butterflies with one radix-2 stage first
+// when log2(size) is odd.
+class Fft
+{
+public:
+    enum Window {
+        Hann = 0,
+        Hamming = 1,
+        Blackman = 2
+    };
+
+    static const int MinSize = 64;
+    static const int MaxSize = 65536;
+
+    explicit Fft(int size);
+
+    int size() const { return n; }
+
+    // Forward transform; both arrays must hold size() values. Only reads
+    // the plan, so threads may share one Fft.
+    void transform(double *re, double *im) const;
+
+    static bool isPowerOfTwo(int value);
+    static QVector<double> window(Window type, int size);
+
+private:
+    struct Stage {
+        int half;                  // Span of the first merged radix-2 stage
+        QVector<double> w1re;      // W(2*half)^j
+        QVector<double> w1im;
+        QVector<double> w2re;      // W(4*half)^j
+        QVector<double> w2im;
+    };
+
+    int n;
+    int log2n;
+    QVector<int> bitReverse;
+    QVector<Stage> stages;
+};
+
+#endif // FFT_H
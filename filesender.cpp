@@ -0,0 +1,230 @@
+#include "filesender.h"
+#include <cstring>
+
+namespace {
+
+// Throughput is measured over windows of at least this length
+const qint64 kRateSampleMs = 250;
+const double kRateSmoothing = 0.3;
+
+} // namespace
+
+FileSender::FileSender(TransmitQueue *queue, QObject *parent)
+    : QObject(parent)
+    , queue(queue)
+    , mapped(nullptr)
+    , delayTimer(new QTimer(this))
+    , sending(false)
+    , total(0)
+    , offset(0)
+    , acknowledged(0)
+    , chunkSize(1024)
+    , chunkDelayMs(0)
+    , lineDelayMs(0)
+    , pendingDelayMs(0)
+    , rate(0.0)
+    , rateMarkBytes(0)
+    , rateMarkMs(0)
+{
+    delayTimer->setSingleShot(true);
+    connect(delayTimer, &QTimer::timeout, this, &FileSender::pump);
+    connect(queue, &TransmitQueue::bytesWritten, this, &FileSender::onBytesWritten);
+    // The queue's owner reports the error itself
+    connect(queue, &TransmitQueue::failed, this, [this]() {
+        if (sending) {
+            finish(false, QString());
+        }
+    });
+}
+
+FileSender::~FileSender()
+{
+    // The queue may already be gone here; QFile releases the mapping itself
+}
+
+bool FileSender::start(const QString &fileName, int chunk, int chunkDelay, int lineDelay,
+                       QString *error)
+{
+    cancel();
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = file.errorString();
+        return false;
+    }
+
+    total = file.size();
+    // Mapping fails for empty files and some special files; those are read
+    mapped = total > 0 ? file.map(0, total) : nullptr;
+
+    offset = 0;
+    acknowledged = 0;
+    chunkSize = qMax(1, chunk);
+    chunkDelayMs = qMax(0, chunkDelay);
+    lineDelayMs = qMax(0, lineDelay);
+    pendingDelayMs = 0;
+    rate = 0.0;
+    rateMarkBytes = 0;
+    rateMarkMs = 0;
+    clock.start();
+
+    sending = true;
+    pump();
+    return true;
+}
+
+void FileSender::cancel()
+{
+    if (!sending) {
+        return;
+    }
+    // Drop whatever is still waiting to go out
+    queue->clear();
+    finish(false, QString());
+}
+
+double FileSender::eta() const
+{
+    const double current = throughput();
+    if (!sending || current <= 0.0) {
+        return -1.0;
+    }
+    return (total - acknowledged) / current;
+}
+
+double FileSender::throughput() const
+{
+    if (!sending) {
+        return rate;
+    }
+    // A stalled port reports nothing, so let a long open window pull the
+    // smoothed rate down rather than show the last good figure
+    const qint64 elapsed = clock.elapsed() - rateMarkMs;
+    if (rate > 0.0 && elapsed > 2 * kRateSampleMs) {
+        return qMin(rate, (acknowledged - rateMarkBytes) * 1000.0 / elapsed);
+    }
+    return rate;
+}
+
+void FileSender::pump()
+{
+    if (!sending || delayTimer->isActive() || pendingDelayMs > 0) {
+        return;
+    }
+
+    while (offset < total && !queue->isFull()) {
+        QByteArray chunk;
+        bool endsLine = false;
+        if (!nextChunk(&chunk, &endsLine)) {
+            finish(false, file.errorString());
+            return;
+        }
+        queue->enqueue(chunk);
+        offset += chunk.size();
+        if (chunkDelayMs > 0 || (endsLine && lineDelayMs > 0)) {
+            waitAfterChunk(endsLine);
+            return;
+        }
+    }
+
+    if (offset >= total && queue->pendingBytes() == 0) {
+        finish(true, QString());
+    }
+}
+
+void FileSender::onBytesWritten(qint64 bytes)
+{
+    if (!sending) {
+        return;
+    }
+    // Manual sends during the transfer share the queue; never count past
+    // what this sender queued
+    bytes = qMin(bytes, offset - acknowledged);
+    acknowledged += bytes;
+    sampleRate();
+
+    // Delays run from the moment the previous chunk has left the port
+    if (pendingDelayMs > 0) {
+        if (queue->pendingBytes() == 0) {
+            delayTimer->start(pendingDelayMs);
+            pendingDelayMs = 0;
+        }
+        return;
+    }
+    pump();
+}
+
+bool FileSender::nextChunk(QByteArray *chunk, bool *endsLine)
+{
+    qint64 length = qMin<qint64>(chunkSize, total - offset);
+    const char *data = nullptr;
+
+    if (mapped) {
+        data = reinterpret_cast<const char *>(mapped) + offset;
+    } else {
+        if (!file.seek(offset)) {
+            return false;
+        }
+        chunkBuffer.resize(int(length));
+        const qint64 n = file.read(chunkBuffer.data(), length);
+        if (n <= 0) {
+            return false;
+        }
+        length = n;
+        data = chunkBuffer.constData();
+    }
+
+    // With line pacing a chunk never runs past the end of a line
+    if (lineDelayMs > 0) {
+        const void *newline = std::memchr(data, '\n', size_t(length));
+        if (newline) {
+            length = static_cast<const char *>(newline) - data + 1;
+            *endsLine = true;
+        }
+    }
+
+    // Copied, since the queue may outlive the mapping
+    *chunk = QByteArray(data, int(length));
+    return true;
+}
+
+void FileSender::waitAfterChunk(bool endsLine)
+{
+    int delay = chunkDelayMs;
+    if (endsLine) {
+        delay = qMax(delay, lineDelayMs);
+    }
+
+    if (queue->pendingBytes() == 0) {
+        delayTimer->start(delay);
+    } else {
+        pendingDelayMs = delay;
+    }
+}
+
+void FileSender::sampleRate()
+{
+    const qint64 now = clock.elapsed();
+    const qint64 elapsed = now - rateMarkMs;
+    if (elapsed < kRateSampleMs) {
+        return;
+    }
+    const double current = (acknowledged - rateMarkBytes) * 1000.0 / elapsed;
+    rate = rate > 0.0 ? rate + kRateSmoothing * (current - rate) : current;
+    rateMarkBytes = acknowledged;
+    rateMarkMs = now;
+}
+
+void FileSender::finish(bool ok, const QString &error)
+{
+    sending = false;
+    delayTimer->stop();
+    pendingDelayMs = 0;
+    if (mapped) {
+        file.unmap(const_cast<uchar *>(mapped));
+        mapped = nullptr;
+    }
+    file.close();
+    chunkBuffer.clear();
+    emit finished(ok, error);
+}
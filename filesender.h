@@ -0,0 +1,76 @@
+#ifndef FILESENDER_H
+#define FILESENDER_H
+
+#include <QObject>
+#include <QFile>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QByteArray>
+
+#include "transmitqueue.h"
+
+// Streams a file to the serial port in chunks. The file is memory-mapped
+// when possible and read piecewise otherwise, so its size does not matter.
+// New data is only queued while the transmit queue is below its high-water
+// mark; the rest follows as writes are confirmed, so a port held back by
+// RTS/CTS simply slows the transfer down. Optional delays after each chunk
+// or each line give slow receivers time to keep up.
+class FileSender : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FileSender(TransmitQueue *queue, QObject *parent = nullptr);
+    ~FileSender();
+
+    // chunkSize in bytes; delays in ms, 0 for none. A line delay splits
+    // chunks at newlines and waits after each line has left the port.
+    // The port must stay open until finished() or cancel().
+    bool start(const QString &fileName, int chunkSize, int chunkDelayMs, int lineDelayMs,
+               QString *error);
+    void cancel();
+    bool isSending() const { return sending; }
+
+    qint64 totalBytes() const { return total; }
+    qint64 bytesSent() const { return acknowledged; }
+    // Smoothed bytes per second; 0 until the first measurement
+    double throughput() const;
+    // Seconds left at the current rate, or -1 when unknown
+    double eta() const;
+
+signals:
+    // error is empty when the transfer was cancelled
+    void finished(bool ok, const QString &error);
+
+private slots:
+    void pump();
+    void onBytesWritten(qint64 bytes);
+
+private:
+    TransmitQueue *queue;
+    QFile file;
+    const uchar *mapped;
+    QByteArray chunkBuffer;
+    QTimer *delayTimer;
+    QElapsedTimer clock;
+
+    bool sending;
+    qint64 total;
+    qint64 offset;          // Next byte to queue
+    qint64 acknowledged;    // Bytes the port reports as written
+    int chunkSize;
+    int chunkDelayMs;
+    int lineDelayMs;
+    int pendingDelayMs;     // Delay to start once the port has drained
+
+    double rate;
+    qint64 rateMarkBytes;
+    qint64 rateMarkMs;
+
+    bool nextChunk(QByteArray *chunk, bool *endsLine);
+    void waitAfterChunk(bool endsLine);
+    void sampleRate();
+    void finish(bool ok, const QString &error);
+};
+
+#endif // FILESENDER_H
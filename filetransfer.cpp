@@ -0,0 +1,989 @@
+#include "filetransfer.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QMutexLocker>
+
+namespace {
+
+// Received data beyond this is dropped oldest first
+const int kMaxReceivedBytes = 64 * 1024;
+
+// Receivers poll for a sender every few seconds for about a minute
+const int kStartTimeoutMs = 60000;
+const int kReplyTimeoutMs = 10000;
+// Consecutive failures at one position before giving up
+const int kMaxRetries = 10;
+
+// XMODEM and YMODEM
+const char SOH = 0x01;
+const char STX = 0x02;
+const char EOT = 0x04;
+const char ACK = 0x06;
+const char NAK = 0x15;
+const char CAN = 0x18;
+const char CPMEOF = 0x1A;
+
+// ZMODEM framing
+const char ZPAD = '*';
+const char ZDLE = 0x18;
+const char ZBIN = 'A';
+const char ZHEX = 'B';
+const char ZBIN32 = 'C';
+const char XON = 0x11;
+
+const char ZCRCE = 'h';     // End of frame, header follows
+const char ZCRCG = 'i';     // Frame continues, no reply
+const char ZCRCQ = 'j';     // Frame continues, ZACK expected
+const char ZCRCW = 'k';     // End of frame, ZACK expected
+
+enum ZFrameType {
+    ZRQINIT, ZRINIT, ZSINIT, ZACK, ZFILE, ZSKIP, ZNAK, ZABORT, ZFIN,
+    ZRPOS, ZDATA, ZEOF, ZFERR, ZCRC, ZCHALLENGE, ZCOMPL, ZCAN, ZFREECNT, ZCOMMAND
+};
+
+// ZRINIT capability flags in ZF0
+const quint8 CANFDX = 0x01;
+const quint8 CANFC32 = 0x20;
+const quint8 ESCCTL = 0x40;
+
+// ZFILE conversion option in ZF0
+const quint8 ZCBIN = 1;
+
+const int kSubpacketSize = 1024;
+// Unacknowledged data allowed in flight while streaming
+const quint32 kWindow = 32 * 1024;
+
+void positionBytes(quint32 position, quint8 p[4])
+{
+    p[0] = quint8(position);
+    p[1] = quint8(position >> 8);
+    p[2] = quint8(position >> 16);
+    p[3] = quint8(position >> 24);
+}
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// XON/XOFF may be inserted anywhere by the line and are never data
+bool isFlowControl(quint8 c)
+{
+    return (c & 0x7F) == 0x11 || (c & 0x7F) == 0x13;
+}
+
+} // namespace
+
+quint32 FileTransfer::ZHeader::position() const
+{
+    return quint32(p[0]) | quint32(p[1]) << 8 | quint32(p[2]) << 16 | quint32(p[3]) << 24;
+}
+
+FileTransfer::FileTransfer(QObject *parent)
+    : QThread(parent)
+    , handle(QSerialPort::Handle())
+    , protocol(Xmodem)
+    , lineRate(0.0)
+    , acked(0)
+    , bytesWritten(0)
+    , retryCount(0)
+    , elapsedMs(0)
+    , stopRequested(false)
+    , fullDuplex(false)
+    , useCrc32(false)
+    , escapeControl(false)
+    , receiverBuffer(0)
+{
+}
+
+FileTransfer::~FileTransfer()
+{
+    cancel();
+}
+
+quint16 FileTransfer::crc16(const char *data, int size, quint16 crc)
+{
+    // CRC-16/XMODEM: polynomial 0x1021, no reflection
+    static quint16 table[256];
+    static bool ready = false;
+    if (!ready) {
+        for (int i = 0; i < 256; ++i) {
+            quint16 c = quint16(i << 8);
+            for (int bit = 0; bit < 8; ++bit) {
+                c = (c & 0x8000) ? quint16((c << 1) ^ 0x1021) : quint16(c << 1);
+            }
+            table[i] = c;
+        }
+        ready = true;
+    }
+    for (int i = 0; i < size; ++i) {
+        crc = quint16((crc << 8) ^ table[((crc >> 8) ^ quint8(data[i])) & 0xFF]);
+    }
+    return crc;
+}
+
+quint32 FileTransfer::crc32(const char *data, int size, quint32 crc)
+{
+    // The zlib CRC-32; pass the previous result to continue a running CRC
+    static quint32 table[256];
+    static bool ready = false;
+    if (!ready) {
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                c = (c & 1) ? (c >> 1) ^ 0xEDB88320u : c >> 1;
+            }
+            table[i] = c;
+        }
+        ready = true;
+    }
+    crc = ~crc;
+    for (int i = 0; i < size; ++i) {
+        crc = table[(crc ^ quint8(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+bool FileTransfer::startTransfer(QSerialPort::Handle portHandle, Protocol transferProtocol,
+                                 const QString &name, double rate, QString *error)
+{
+    cancel();
+
+    QFile file(name);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = file.errorString();
+        return false;
+    }
+    fileData = file.readAll();
+    file.close();
+
+    // Build the tables before two threads can race to do it
+    crc16(nullptr, 0);
+    crc32(nullptr, 0);
+
+    handle = portHandle;
+    protocol = transferProtocol;
+    fileName = name;
+    lineRate = rate;
+    acked.storeRelease(0);
+    retryCount.storeRelease(0);
+    elapsedMs.storeRelease(-1);
+    {
+        QMutexLocker lock(&mutex);
+        received.clear();
+        stopRequested = false;
+    }
+    clock.start();
+    start(QThread::TimeCriticalPriority);
+    return true;
+}
+
+void FileTransfer::cancel()
+{
+    {
+        QMutexLocker lock(&mutex);
+        stopRequested = true;
+        wake.wakeAll();
+    }
+    wait();
+}
+
+void FileTransfer::feed(const QByteArray &data)
+{
+    QMutexLocker lock(&mutex);
+    received.append(data);
+    if (received.size() > kMaxReceivedBytes) {
+        received.remove(0, received.size() - kMaxReceivedBytes);
+    }
+    wake.wakeAll();
+}
+
+double FileTransfer::throughput() const
+{
+    qint64 ms = elapsedMs.loadAcquire();
+    if (ms < 0) {
+        ms = clock.elapsed();
+    }
+    return ms > 0 ? bytesAcked() * 1000.0 / ms : 0.0;
+}
+
+double FileTransfer::efficiency() const
+{
+    return lineRate > 0 ? throughput() / lineRate : 0.0;
+}
+
+qint64 FileTransfer::takeBytesWritten()
+{
+    return bytesWritten.fetchAndStoreRelaxed(0);
+}
+
+void FileTransfer::run()
+{
+    writer.begin(handle);
+
+    QString error;
+    bool ok = false;
+    switch (protocol) {
+    case Xmodem:
+    case Xmodem1K:
+        ok = sendBlocks(false, &error);
+        break;
+    case Ymodem:
+        ok = sendBlocks(true, &error);
+        break;
+    case Zmodem:
+        ok = sendZmodem(&error);
+        break;
+    }
+
+    bool stopped;
+    {
+        QMutexLocker lock(&mutex);
+        stopped = stopRequested;
+    }
+    if (!ok) {
+        // Make sure the receiver gives up too instead of waiting it out
+        abortTransfer();
+    }
+
+    writer.end();
+    elapsedMs.storeRelease(clock.elapsed());
+    emit finished(ok && !stopped, stopped ? QString() : error);
+}
+
+bool FileTransfer::send(const QByteArray &data, QString *error)
+{
+    if (!writer.write(data, error)) {
+        return false;
+    }
+    bytesWritten.fetchAndAddRelaxed(data.size());
+    return true;
+}
+
+void FileTransfer::abortTransfer()
+{
+    QString ignored;
+    send(QByteArray(10, CAN) + QByteArray(10, '\b'), &ignored);
+}
+
+// ---------------------------------------------------------------------------
+// XMODEM and YMODEM
+
+bool FileTransfer::sendBlocks(bool batch, QString *error)
+{
+    bool crc = true;
+    if (!awaitStart(&crc, kStartTimeoutMs, "Receiver did not start", error)) {
+        return false;
+    }
+
+    if (batch) {
+        // Block 0 names the file; the receiver asks for data again after it
+        const QFileInfo info(fileName);
+        const QByteArray header = info.fileName().toUtf8() + '\0'
+            + QByteArray::number(fileData.size()) + ' '
+            + QByteArray::number(info.lastModified().toMSecsSinceEpoch() / 1000, 8) + " 100644";
+        if (!sendBlock(0, header, header.size() >= 128 ? 1024 : 128, '\0', crc, error)) {
+            return false;
+        }
+        if (!awaitStart(&crc, kReplyTimeoutMs, "Receiver did not ask for file data", error)) {
+            return false;
+        }
+    }
+
+    int number = 1;
+    int offset = 0;
+    while (offset < fileData.size()) {
+        const int remaining = fileData.size() - offset;
+        // 1K blocks, except a short tail that fits in a 128 byte one
+        const int blockSize = (protocol == Xmodem || remaining <= 128) ? 128 : 1024;
+        if (!sendBlock(number & 0xFF, fileData.mid(offset, blockSize), blockSize, CPMEOF, crc, error)) {
+            return false;
+        }
+        offset += qMin(blockSize, remaining);
+        acked.storeRelease(offset);
+        ++number;
+    }
+
+    // Some receivers NAK the first EOT to make sure it was not line noise
+    for (int attempt = 0; ; ++attempt) {
+        if (attempt == kMaxRetries) {
+            *error = "End of file not acknowledged";
+            return false;
+        }
+        {
+            QMutexLocker lock(&mutex);
+            received.clear();
+        }
+        if (!send(QByteArray(1, EOT), error)) {
+            return false;
+        }
+        int reply = 0;
+        const ReadResult result = readByte(&reply, kReplyTimeoutMs);
+        if (result == Stopped) {
+            return false;
+        }
+        if (result == Ok && reply == ACK) {
+            break;
+        }
+        retryCount.fetchAndAddRelaxed(1);
+    }
+
+    if (batch) {
+        // An empty block 0 ends the batch
+        if (!awaitStart(&crc, kReplyTimeoutMs, "Receiver did not ask for the next file", error)) {
+            return false;
+        }
+        if (!sendBlock(0, QByteArray(), 128, '\0', crc, error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FileTransfer::sendBlock(int number, const QByteArray &payload, int blockSize, char pad, bool crc,
+                             QString *error)
+{
+    QByteArray block;
+    block.reserve(blockSize + 5);
+    block.append(blockSize == 1024 ? STX : SOH);
+    block.append(char(number));
+    block.append(char(255 - number));
+    block.append(payload);
+    block.append(QByteArray(blockSize - payload.size(), pad));
+    if (crc) {
+        const quint16 value = crc16(block.constData() + 3, blockSize);
+        block.append(char(value >> 8));
+        block.append(char(value));
+    } else {
+        quint8 sum = 0;
+        for (int i = 3; i < block.size(); ++i) {
+            sum = quint8(sum + quint8(block[i]));
+        }
+        block.append(char(sum));
+    }
+
+    for (int attempt = 0; attempt < kMaxRetries; ++attempt) {
+        if (attempt > 0) {
+            retryCount.fetchAndAddRelaxed(1);
+        }
+        // Stale start characters would read as a NAK for this block
+        {
+            QMutexLocker lock(&mutex);
+            received.clear();
+        }
+        if (!send(block, error)) {
+            return false;
+        }
+        for (;;) {
+            int reply = 0;
+            const ReadResult result = readByte(&reply, kReplyTimeoutMs);
+            if (result == Stopped) {
+                return false;
+            }
+            if (result == TimedOut || reply == NAK) {
+                break;
+            }
+            if (reply == ACK) {
+                return true;
+            }
+            if (reply == CAN && readByte(&reply, 1000) == Ok && reply == CAN) {
+                *error = "Cancelled by receiver";
+                return false;
+            }
+            // Anything else is line noise
+        }
+    }
+    *error = QString("Block %1 not acknowledged").arg(number);
+    return false;
+}
+
+FileTransfer::ReadResult FileTransfer::waitForStart(bool *crc, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (;;) {
+        const qint64 remaining = timeoutMs - timer.elapsed();
+        if (remaining <= 0) {
+            return TimedOut;
+        }
+        int byte = 0;
+        const ReadResult result = readByte(&byte, int(remaining));
+        if (result != Ok) {
+            return result;
+        }
+        if (byte == 'C' || byte == NAK) {
+            *crc = byte == 'C';
+            return Ok;
+        }
+        if (byte == CAN && readByte(&byte, 1000) == Ok && byte == CAN) {
+            return Aborted;
+        }
+    }
+}
+
+bool FileTransfer::awaitStart(bool *crc, int timeoutMs, const QString &timeoutError,
+                              QString *error)
+{
+    switch (waitForStart(crc, timeoutMs)) {
+    case Ok:
+        return true;
+    case TimedOut:
+        *error = timeoutError;
+        return false;
+    case Aborted:
+        *error = "Cancelled by receiver";
+        return false;
+    case Stopped:
+        break;
+    }
+    // Stopped leaves the error empty so the transfer reads as cancelled
+    return false;
+}
+
+FileTransfer::ReadResult FileTransfer::readByte(int *byte, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QMutexLocker lock(&mutex);
+    for (;;) {
+        if (stopRequested) {
+            return Stopped;
+        }
+        if (!received.isEmpty()) {
+            *byte = quint8(received[0]);
+            received.remove(0, 1);
+            return Ok;
+        }
+        const qint64 remaining = timeoutMs - timer.elapsed();
+        if (remaining <= 0) {
+            return TimedOut;
+        }
+        wake.wait(&mutex, (unsigned long)remaining);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ZMODEM
+
+bool FileTransfer::sendZmodem(QString *error)
+{
+    const quint8 none[4] = { 0, 0, 0, 0 };
+    ZHeader header;
+
+    // Starts the receiver on hosts that run rz on demand
+    if (!send("rz\r", error) || !sendHexHeader(ZRQINIT, none, error)) {
+        return false;
+    }
+    for (int attempts = 0; ; ) {
+        const ReadResult result = readHeader(&header, kReplyTimeoutMs);
+        if (readFailed(result, error)) {
+            return false;
+        }
+        if (result == Ok && header.type == ZRINIT) {
+            break;
+        }
+        if (result == Ok && header.type == ZCHALLENGE) {
+            if (!sendHexHeader(ZACK, header.p, error)) {
+                return false;
+            }
+            continue;
+        }
+        if (++attempts == kMaxRetries) {
+            *error = "Receiver did not respond";
+            return false;
+        }
+        retryCount.fetchAndAddRelaxed(1);
+        if (!sendHexHeader(ZRQINIT, none, error)) {
+            return false;
+        }
+    }
+
+    const quint8 flags = header.p[3];
+    fullDuplex = flags & CANFDX;
+    useCrc32 = flags & CANFC32;
+    escapeControl = flags & ESCCTL;
+    receiverBuffer = header.p[0] | header.p[1] << 8;
+
+    // File name, then length, mtime and mode, files and bytes remaining
+    const QFileInfo info(fileName);
+    const QByteArray fileInfo = info.fileName().toUtf8() + '\0'
+        + QByteArray::number(fileData.size()) + ' '
+        + QByteArray::number(info.lastModified().toMSecsSinceEpoch() / 1000, 8)
+        + " 100644 0 1 " + QByteArray::number(fileData.size()) + '\0';
+    const quint8 fileOptions[4] = { 0, 0, 0, ZCBIN };
+
+    quint32 position = 0;
+    bool skipped = false;
+    bool resend = true;
+    for (int attempts = 0; ; ) {
+        if (resend) {
+            if (attempts++ == kMaxRetries) {
+                *error = "File header not accepted";
+                return false;
+            }
+            if (!sendBinaryHeader(ZFILE, fileOptions, error)
+                    || !sendSubpacket(fileInfo.constData(), fileInfo.size(), ZCRCW, error)) {
+                return false;
+            }
+            resend = false;
+        }
+        const ReadResult result = readHeader(&header, kReplyTimeoutMs);
+        if (readFailed(result, error)) {
+            return false;
+        }
+        if (result == TimedOut) {
+            retryCount.fetchAndAddRelaxed(1);
+            resend = true;
+            continue;
+        }
+        if (header.type == ZRPOS) {
+            position = header.position();
+            break;
+        }
+        if (header.type == ZSKIP) {
+            skipped = true;
+            break;
+        }
+        if (header.type == ZCRC) {
+            // The receiver has a file by this name and compares contents
+            quint8 crc[4];
+            positionBytes(crc32(fileData.constData(), fileData.size()), crc);
+            if (!sendHexHeader(ZCRC, crc, error)) {
+                return false;
+            }
+        } else if (header.type == ZFERR || header.type == ZABORT) {
+            *error = "Receiver refused the file";
+            return false;
+        } else if (header.type == ZRINIT || header.type == ZNAK) {
+            retryCount.fetchAndAddRelaxed(1);
+            resend = true;
+        }
+    }
+
+    if (!skipped && !sendZmodemData(&position, error)) {
+        return false;
+    }
+
+    // Close the session; the receiver echoes ZFIN and we end with "OO"
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        if (!sendHexHeader(ZFIN, none, error)) {
+            return false;
+        }
+        const ReadResult result = readHeader(&header, kReplyTimeoutMs);
+        if (result == Stopped) {
+            return false;
+        }
+        if (result == Ok && header.type == ZFIN) {
+            break;
+        }
+    }
+    if (!send("OO", error)) {
+        return false;
+    }
+
+    if (skipped) {
+        *error = "Receiver skipped the file";
+        return false;
+    }
+    return true;
+}
+
+bool FileTransfer::sendZmodemData(quint32 *position, QString *error)
+{
+    const quint32 size = quint32(fileData.size());
+    quint32 pos = *position;
+    quint32 ackedPos = pos;
+    quint32 failedPos = pos;
+    int failures = 0;
+    ZHeader header;
+
+    // Moves to where the receiver asked to resume, giving up when the same
+    // stretch keeps failing
+    auto reposition = [&](quint32 to) -> bool {
+        if (to > size) {
+            *error = "Receiver asked for a position past the end";
+            return false;
+        }
+        failures = to == failedPos ? failures + 1 : 1;
+        failedPos = to;
+        if (failures > kMaxRetries) {
+            *error = QString("Data at offset %1 not accepted").arg(to);
+            return false;
+        }
+        retryCount.fetchAndAddRelaxed(1);
+        pos = to;
+        ackedPos = to;
+        acked.storeRelease(to);
+        return true;
+    };
+
+    for (;;) {
+        quint8 p[4];
+        positionBytes(pos, p);
+        if (!sendBinaryHeader(ZDATA, p, error)) {
+            return false;
+        }
+
+        // One frame from pos; ZCRCW or a retransmission request ends it early
+        const quint32 frameStart = pos;
+        quint32 lastQuery = pos;
+        bool restart = false;
+        while (pos < size && !restart) {
+            const int n = int(qMin<quint32>(kSubpacketSize, size - pos));
+            char end = ZCRCG;
+            if (pos + n == size) {
+                end = ZCRCE;
+            } else if (!fullDuplex || receiverBuffer > 0) {
+                // The receiver cannot take a stream; stop at each buffer full
+                const quint32 limit = receiverBuffer > 0 ? qMin<quint32>(receiverBuffer, kWindow) : kWindow;
+                if (pos + n - frameStart >= limit) {
+                    end = ZCRCW;
+                }
+            } else if (pos + n - lastQuery >= kWindow / 4) {
+                end = ZCRCQ;
+            }
+            if (!sendSubpacket(fileData.constData() + pos, n, end, error)) {
+                return false;
+            }
+            pos += n;
+            if (end == ZCRCQ) {
+                lastQuery = pos;
+            }
+
+            // Read replies without stopping, or wait for them when the frame
+            // ended or too much is unacknowledged
+            for (;;) {
+                const bool mustWait = end == ZCRCW || (fullDuplex && pos - ackedPos > kWindow);
+                ReadResult result;
+                if (mustWait) {
+                    result = readHeader(&header, kReplyTimeoutMs);
+                } else if (fullDuplex) {
+                    result = pollHeader(&header);
+                } else {
+                    break;
+                }
+                if (readFailed(result, error)) {
+                    return false;
+                }
+                if (result == TimedOut) {
+                    if (!mustWait) {
+                        break;
+                    }
+                    // Lost acknowledgement; resend from what is confirmed
+                    if (!reposition(ackedPos)) {
+                        return false;
+                    }
+                    restart = true;
+                    break;
+                }
+                if (header.type == ZACK) {
+                    ackedPos = qBound(ackedPos, header.position(), pos);
+                    acked.storeRelease(ackedPos);
+                    if (end == ZCRCW) {
+                        restart = pos < size;
+                        break;
+                    }
+                } else if (header.type == ZRPOS) {
+                    if (!reposition(header.position())) {
+                        return false;
+                    }
+                    restart = true;
+                    break;
+                } else if (header.type == ZFERR || header.type == ZABORT) {
+                    *error = "Receiver aborted the transfer";
+                    return false;
+                }
+            }
+        }
+        if (restart) {
+            continue;
+        }
+
+        // All data sent; ZRINIT confirms the file, ZRPOS asks for more
+        positionBytes(size, p);
+        if (!sendBinaryHeader(ZEOF, p, error)) {
+            return false;
+        }
+        for (int attempts = 1; ; ) {
+            const ReadResult result = readHeader(&header, kReplyTimeoutMs);
+            if (readFailed(result, error)) {
+                return false;
+            }
+            if (result == TimedOut) {
+                if (attempts++ == kMaxRetries) {
+                    *error = "End of file not acknowledged";
+                    return false;
+                }
+                retryCount.fetchAndAddRelaxed(1);
+                if (!sendBinaryHeader(ZEOF, p, error)) {
+                    return false;
+                }
+                continue;
+            }
+            if (header.type == ZRINIT) {
+                acked.storeRelease(size);
+                *position = size;
+                return true;
+            }
+            if (header.type == ZRPOS) {
+                if (!reposition(header.position())) {
+                    return false;
+                }
+                break;
+            }
+            if (header.type == ZFERR || header.type == ZABORT) {
+                *error = "Receiver aborted the transfer";
+                return false;
+            }
+        }
+    }
+}
+
+bool FileTransfer::sendHexHeader(int type, const quint8 p[4], QString *error)
+{
+    static const char digits[] = "0123456789abcdef";
+    char raw[5] = { char(type), char(p[0]), char(p[1]), char(p[2]), char(p[3]) };
+    const quint16 crc = crc16(raw, 5);
+
+    QByteArray out;
+    out.append(ZPAD);
+    out.append(ZPAD);
+    out.append(ZDLE);
+    out.append(ZHEX);
+    const quint8 bytes[7] = { quint8(type), p[0], p[1], p[2], p[3], quint8(crc >> 8), quint8(crc) };
+    for (int i = 0; i < 7; ++i) {
+        out.append(digits[bytes[i] >> 4]);
+        out.append(digits[bytes[i] & 0x0F]);
+    }
+    out.append('\r');
+    out.append(char(0x8A));
+    // The receiver may have been stopped by a stray XOFF
+    if (type != ZFIN && type != ZACK) {
+        out.append(XON);
+    }
+    return send(out, error);
+}
+
+bool FileTransfer::sendBinaryHeader(int type, const quint8 p[4], QString *error)
+{
+    const char raw[5] = { char(type), char(p[0]), char(p[1]), char(p[2]), char(p[3]) };
+
+    QByteArray out;
+    out.append(ZPAD);
+    out.append(ZDLE);
+    out.append(useCrc32 ? ZBIN32 : ZBIN);
+    for (int i = 0; i < 5; ++i) {
+        appendEscaped(out, quint8(raw[i]));
+    }
+    if (useCrc32) {
+        const quint32 crc = crc32(raw, 5);
+        for (int i = 0; i < 4; ++i) {
+            appendEscaped(out, quint8(crc >> (8 * i)));
+        }
+    } else {
+        const quint16 crc = crc16(raw, 5);
+        appendEscaped(out, quint8(crc >> 8));
+        appendEscaped(out, quint8(crc));
+    }
+    return send(out, error);
+}
+
+bool FileTransfer::sendSubpacket(const char *data, int size, char frameEnd, QString *error)
+{
+    QByteArray out;
+    out.reserve(size + size / 8 + 16);
+    for (int i = 0; i < size; ++i) {
+        appendEscaped(out, quint8(data[i]));
+    }
+    out.append(ZDLE);
+    out.append(frameEnd);
+    // The frame end character is covered by the CRC
+    if (useCrc32) {
+        const quint32 crc = crc32(&frameEnd, 1, crc32(data, size));
+        for (int i = 0; i < 4; ++i) {
+            appendEscaped(out, quint8(crc >> (8 * i)));
+        }
+    } else {
+        const quint16 crc = crc16(&frameEnd, 1, crc16(data, size));
+        appendEscaped(out, quint8(crc >> 8));
+        appendEscaped(out, quint8(crc));
+    }
+    if (frameEnd == ZCRCW) {
+        out.append(XON);
+    }
+    return send(out, error);
+}
+
+void FileTransfer::appendEscaped(QByteArray &out, quint8 byte) const
+{
+    bool escape;
+    switch (byte) {
+    case 0x18: case 0x98:   // ZDLE
+    case 0x10: case 0x90:   // DLE
+    case 0x11: case 0x91:   // XON
+    case 0x13: case 0x93:   // XOFF
+        escape = true;
+        break;
+    case 0x0D: case 0x8D:
+        // "@<CR>" is a Telenet escape
+        escape = !out.isEmpty() && (out[out.size() - 1] & 0x7F) == '@';
+        break;
+    default:
+        escape = escapeControl && (byte & 0x60) == 0;
+        break;
+    }
+    if (escape) {
+        out.append(ZDLE);
+        out.append(char(byte ^ 0x40));
+    } else {
+        out.append(char(byte));
+    }
+}
+
+FileTransfer::ReadResult FileTransfer::readHeader(ZHeader *header, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QMutexLocker lock(&mutex);
+    for (;;) {
+        if (stopRequested) {
+            return Stopped;
+        }
+        const ReadResult result = parseHeader(header);
+        if (result != TimedOut) {
+            return result;
+        }
+        const qint64 remaining = timeoutMs - timer.elapsed();
+        if (remaining <= 0) {
+            return TimedOut;
+        }
+        wake.wait(&mutex, (unsigned long)remaining);
+    }
+}
+
+FileTransfer::ReadResult FileTransfer::pollHeader(ZHeader *header)
+{
+    QMutexLocker lock(&mutex);
+    if (stopRequested) {
+        return Stopped;
+    }
+    return parseHeader(header);
+}
+
+FileTransfer::ReadResult FileTransfer::parseHeader(ZHeader *header)
+{
+    // Called with the mutex held. TimedOut means no complete header yet;
+    // garbage and damaged headers are consumed, a partial one is kept.
+    if (received.contains(QByteArray(5, CAN))) {
+        received.clear();
+        return Aborted;
+    }
+
+    for (;;) {
+        const int start = received.indexOf(ZPAD);
+        if (start < 0) {
+            received.clear();
+            return TimedOut;
+        }
+        int i = start;
+        while (i < received.size() && received[i] == ZPAD) {
+            ++i;
+        }
+        if (i + 2 > received.size()) {
+            received.remove(0, start);
+            return TimedOut;
+        }
+        if (received[i] != ZDLE) {
+            received.remove(0, i);
+            continue;
+        }
+        const char format = received[i + 1];
+        i += 2;
+
+        quint8 bytes[9];
+        const int need = format == ZBIN32 ? 9 : 7;
+        int n = 0;
+        bool bad = false;
+        if (format == ZHEX) {
+            if (i + 14 > received.size()) {
+                received.remove(0, start);
+                return TimedOut;
+            }
+            for (; n < 7; ++n, i += 2) {
+                const int high = hexValue(received[i]);
+                const int low = hexValue(received[i + 1]);
+                if (high < 0 || low < 0) {
+                    bad = true;
+                    break;
+                }
+                bytes[n] = quint8(high << 4 | low);
+            }
+        } else if (format == ZBIN || format == ZBIN32) {
+            while (n < need && i < received.size()) {
+                quint8 c = quint8(received[i++]);
+                if (c == quint8(ZDLE)) {
+                    if (i >= received.size()) {
+                        break;
+                    }
+                    c = quint8(received[i++]);
+                    if (c == 'l') {
+                        c = 0x7F;
+                    } else if (c == 'm') {
+                        c = 0xFF;
+                    } else if ((c & 0x60) == 0x40) {
+                        c ^= 0x40;
+                    } else {
+                        bad = true;
+                        break;
+                    }
+                } else if (isFlowControl(c)) {
+                    continue;
+                }
+                bytes[n++] = c;
+            }
+            if (!bad && n < need) {
+                received.remove(0, start);
+                return TimedOut;
+            }
+        } else {
+            bad = true;
+        }
+        received.remove(0, i);
+        if (bad) {
+            continue;
+        }
+
+        const char *raw = reinterpret_cast<const char *>(bytes);
+        if (format == ZBIN32) {
+            const quint32 crc = crc32(raw, 5);
+            bad = crc != (quint32(bytes[5]) | quint32(bytes[6]) << 8
+                          | quint32(bytes[7]) << 16 | quint32(bytes[8]) << 24);
+        } else {
+            bad = crc16(raw, 5) != quint16(bytes[5] << 8 | bytes[6]);
+        }
+        if (bad) {
+            continue;
+        }
+
+        header->type = bytes[0];
+        for (int k = 0; k < 4; ++k) {
+            header->p[k] = bytes[k + 1];
+        }
+        return Ok;
+    }
+}
+
+bool FileTransfer::readFailed(ReadResult result, QString *error)
+{
+    // Stopped leaves the error empty so the transfer reads as cancelled
+    if (result == Aborted) {
+        *error = "Cancelled by receiver";
+    }
+    return result == Aborted || result == Stopped;
+}
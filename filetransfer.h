@@ -0,0 +1,121 @@
+#ifndef FILETRANSFER_H
+#define FILETRANSFER_H
+
+#include <QThread>
+#include <QByteArray>
+#include <QString>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QSerialPort>
+
+#include "nativeportwriter.h"
+
+// Sends one file with XMODEM, YMODEM or ZMODEM on its own thread, the way
+// ScriptExecutor runs scripts: blocks and subpackets are written to the
+// port's native handle and the receiver's replies come in through feed().
+// ZMODEM streams data subpackets and only stops to wait when more than a
+// window of data is unacknowledged, so the line stays busy on long cables.
+class FileTransfer : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Protocol { Xmodem, Xmodem1K, Ymodem, Zmodem };
+
+    explicit FileTransfer(QObject *parent = nullptr);
+    ~FileTransfer();
+
+    // Reads the whole file, then starts the thread. lineRate is the port's
+    // raw capacity in bytes per second, used to report efficiency. The port
+    // must stay open until cancel() returns.
+    bool startTransfer(QSerialPort::Handle handle, Protocol protocol, const QString &fileName,
+                       double lineRate, QString *error);
+    void cancel();
+
+    // Thread-safe; pass every chunk read from the port while running
+    void feed(const QByteArray &data);
+
+    qint64 totalBytes() const { return fileData.size(); }
+    // Bytes the receiver has confirmed
+    qint64 bytesAcked() const { return acked.loadAcquire(); }
+    int retries() const { return retryCount.loadAcquire(); }
+    // Confirmed bytes per second since the transfer started
+    double throughput() const;
+    // Throughput as a fraction of the line rate
+    double efficiency() const;
+    // Bytes written since the previous call
+    qint64 takeBytesWritten();
+
+    static quint16 crc16(const char *data, int size, quint16 crc = 0);
+    static quint32 crc32(const char *data, int size, quint32 crc = 0);
+
+signals:
+    // ok is false with an empty error when the transfer was cancelled
+    void finished(bool ok, const QString &error);
+
+protected:
+    void run() override;
+
+private:
+    struct ZHeader {
+        int type;
+        quint8 p[4];    // ZP0..ZP3; ZF0 is p[3]
+
+        quint32 position() const;
+    };
+    enum ReadResult { Ok, TimedOut, Aborted, Stopped };
+
+    QSerialPort::Handle handle;
+    NativePortWriter writer;
+    Protocol protocol;
+    QString fileName;
+    QByteArray fileData;
+    double lineRate;
+
+    QAtomicInteger<qint64> acked;
+    QAtomicInteger<qint64> bytesWritten;
+    QAtomicInt retryCount;
+    QElapsedTimer clock;
+    QAtomicInteger<qint64> elapsedMs;   // Frozen when the transfer ends
+
+    QMutex mutex;
+    QWaitCondition wake;
+    QByteArray received;
+    bool stopRequested;
+
+    // Receiver options from ZRINIT
+    bool fullDuplex;
+    bool useCrc32;
+    bool escapeControl;
+    int receiverBuffer;
+
+    bool send(const QByteArray &data, QString *error);
+
+    // XMODEM and YMODEM
+    bool sendBlocks(bool batch, QString *error);
+    bool sendBlock(int number, const QByteArray &payload, int blockSize, char pad, bool crc,
+                   QString *error);
+    ReadResult waitForStart(bool *crc, int timeoutMs);
+    // waitForStart() that fails with timeoutError when nothing arrives
+    bool awaitStart(bool *crc, int timeoutMs, const QString &timeoutError, QString *error);
+    ReadResult readByte(int *byte, int timeoutMs);
+
+    // ZMODEM
+    bool sendZmodem(QString *error);
+    bool sendZmodemData(quint32 *position, QString *error);
+    bool sendHexHeader(int type, const quint8 p[4], QString *error);
+    bool sendBinaryHeader(int type, const quint8 p[4], QString *error);
+    bool sendSubpacket(const char *data, int size, char frameEnd, QString *error);
+    void appendEscaped(QByteArray &out, quint8 byte) const;
+    ReadResult readHeader(ZHeader *header, int timeoutMs);
+    ReadResult pollHeader(ZHeader *header);
+    ReadResult parseHeader(ZHeader *header);
+    static bool readFailed(ReadResult result, QString *error);
+
+    void abortTransfer();
+};
+
+#endif // FILETRANSFER_H
@@ -0,0 +1,219 @@
+#include "histogramwidget.h"
+#include <QPainter>
+#include <QPaintEvent>
+
+namespace {
+// Repaint at most this often, and only when samples arrived
+const int kRefreshIntervalMs = 100;
+}
+
+HistogramWidget::HistogramWidget(QWidget *parent)
+    : QWidget(parent)
+    , refreshTimer(new QTimer(this))
+    , dirty(false)
+    , plotTitle("Histogram")
+    , yAxisLabel("Count")
+    , xAxisLabel("Value")
+    , waitingMessage("Waiting for data...")
+{
+    setMinimumSize(400, 300);
+    setBackgroundRole(QPalette::Base);
+    setAutoFillBackground(true);
+
+    // Same channel colors as PlotWidget
+    QVector<QColor> colors;
+    colors << QColor(255, 0, 0)      // Red
+           << QColor(0, 0, 255)      // Blue
+           << QColor(0, 128, 0)      // Green
+           << QColor(255, 165, 0)    // Orange
+           << QColor(128, 0, 128)    // Purple
+           << QColor(0, 128, 128);   // Teal
+
+    for (int i = 0; i < 6; ++i) {
+        HistogramChannel channel;
+        channel.color = colors[i];
+        channel.name = QString("Graph %1").arg(i + 1);
+        channel.enabled = (i == 0);
+        channels.append(channel);
+    }
+
+    connect(refreshTimer, &QTimer::timeout, this, &HistogramWidget::refresh);
+    refreshTimer->start(kRefreshIntervalMs);
+}
+
+HistogramWidget::~HistogramWidget()
+{
+}
+
+void HistogramWidget::addSample(int channel, double value)
+{
+    if (channel < 0 || channel >= channels.size() || !channels[channel].enabled) {
+        return;
+    }
+    channels[channel].histogram.add(value);
+    dirty = true;
+}
+
+void HistogramWidget::clearData()
+{
+    for (int i = 0; i < channels.size(); ++i) {
+        channels[i].histogram.clear();
+    }
+    update();
+}
+
+void HistogramWidget::setChannelEnabled(int channel, bool enabled)
+{
+    if (channel >= 0 && channel < channels.size() && channels[channel].enabled != enabled) {
+        // A disabled channel is not fed, so it starts over when re-enabled
+        channels[channel].enabled = enabled;
+        channels[channel].histogram.clear();
+        update();
+    }
+}
+
+void HistogramWidget::configure(int bins, int window, bool autoRange, double minimum, double maximum)
+{
+    for (int i = 0; i < channels.size(); ++i) {
+        channels[i].histogram.configure(bins, window, autoRange, minimum, maximum);
+    }
+    update();
+}
+
+void HistogramWidget::refresh()
+{
+    // Bins are always current; only the repaint is deferred
+    if (dirty && isVisible()) {
+        dirty = false;
+        update();
+    }
+}
+
+void HistogramWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+
+    const int leftMargin = 60;
+    const int rightMargin = 20;
+    const int topMargin = 30;
+    const int bottomMargin = 40;
+    const int panelGap = 24;
+
+    int plotWidth = width() - leftMargin - rightMargin;
+    int plotHeight = height() - topMargin - bottomMargin;
+
+    // Background, matching PlotWidget
+    QLinearGradient bgGradient(0, 0, 0, height());
+    bgGradient.setColorAt(0, QColor(250, 250, 250));
+    bgGradient.setColorAt(1, QColor(240, 240, 240));
+    painter.fillRect(rect(), bgGradient);
+
+    // Title and axis labels
+    painter.setPen(QColor(52, 152, 219));
+    painter.setFont(QFont("Microsoft YaHei UI", 11, QFont::Bold));
+    painter.drawText(QRect(leftMargin, 5, plotWidth, 20), Qt::AlignCenter, plotTitle);
+
+    painter.setPen(QColor(44, 62, 80));
+    painter.setFont(QFont("Microsoft YaHei UI", 9, QFont::Bold));
+    painter.drawText(leftMargin, height() - 22, plotWidth, 20, Qt::AlignCenter, xAxisLabel);
+
+    painter.save();
+    painter.translate(12, topMargin + plotHeight / 2);
+    painter.rotate(-90);
+    painter.drawText(-60, 0, 120, 20, Qt::AlignCenter, yAxisLabel);
+    painter.restore();
+
+    QVector<int> shown;
+    for (int ch = 0; ch < channels.size(); ++ch) {
+        if (channels[ch].enabled && channels[ch].histogram.count() > 0 &&
+            channels[ch].histogram.hasRange()) {
+            shown.append(ch);
+        }
+    }
+
+    if (shown.isEmpty()) {
+        painter.fillRect(leftMargin, topMargin, plotWidth, plotHeight, Qt::white);
+        painter.setPen(QPen(QColor(52, 152, 219), 2));
+        painter.drawRect(leftMargin, topMargin, plotWidth, plotHeight);
+        painter.setPen(QColor(149, 165, 166));
+        painter.setFont(QFont("Microsoft YaHei UI", 11, QFont::Bold));
+        painter.drawText(leftMargin, topMargin, plotWidth, plotHeight,
+                         Qt::AlignCenter, waitingMessage);
+        return;
+    }
+
+    // One panel per channel, stacked, each with its own value range
+    const int panelHeight = (plotHeight - panelGap * (shown.size() - 1)) / shown.size();
+    for (int p = 0; p < shown.size(); ++p) {
+        const HistogramChannel &c = channels[shown[p]];
+        const SlidingHistogram &h = c.histogram;
+        const int top = topMargin + p * (panelHeight + panelGap);
+
+        painter.fillRect(leftMargin, top, plotWidth, panelHeight, Qt::white);
+
+        quint32 peak = 1;
+        for (int i = 0; i < h.binCount(); ++i) {
+            peak = qMax(peak, h.binValue(i));
+        }
+
+        // Grid and count labels
+        painter.setFont(QFont("Microsoft YaHei UI", 8));
+        for (int i = 0; i <= 2; ++i) {
+            int y = top + i * panelHeight / 2;
+            painter.setPen(QPen(QColor(220, 220, 220), 1, Qt::DotLine));
+            painter.drawLine(leftMargin, y, leftMargin + plotWidth, y);
+            painter.setPen(QColor(44, 62, 80));
+            painter.drawText(QRect(8, y - 10, 47, 20), Qt::AlignRight | Qt::AlignVCenter,
+                             QString::number(qRound(peak * (2 - i) / 2.0)));
+        }
+
+        // Bars; adjacent bins share pixel edges so nothing overlaps or gaps
+        const int bins = h.binCount();
+        QColor fill = c.color;
+        fill.setAlpha(160);
+        for (int i = 0; i < bins; ++i) {
+            const quint32 value = h.binValue(i);
+            if (value == 0) {
+                continue;
+            }
+            const int x0 = leftMargin + i * plotWidth / bins;
+            const int x1 = leftMargin + (i + 1) * plotWidth / bins;
+            const int barHeight = qMax(1, int(double(value) / peak * panelHeight));
+            painter.fillRect(x0, top + panelHeight - barHeight, qMax(1, x1 - x0), barHeight, fill);
+        }
+
+        painter.setPen(QPen(QColor(52, 152, 219), 2));
+        painter.drawRect(leftMargin, top, plotWidth, panelHeight);
+
+        // Value labels under the panel
+        painter.setFont(QFont("Microsoft YaHei UI", 8));
+        painter.setPen(QColor(44, 62, 80));
+        for (int i = 0; i <= 4; ++i) {
+            int x = leftMargin + i * plotWidth / 4;
+            double value = h.lower() + (h.upper() - h.lower()) * i / 4;
+            painter.drawText(x - 30, top + panelHeight + 3, 60, 15, Qt::AlignCenter,
+                             QString::number(value, 'g', 4));
+        }
+
+        // Legend: samples in the window and anything outside a fixed range
+        QString label = QString("%1: %2 / %3").arg(c.name).arg(h.count()).arg(h.windowSize());
+        if (h.underflow() > 0 || h.overflow() > 0) {
+            label += QString("  < %1  > %2").arg(h.underflow()).arg(h.overflow());
+        }
+        painter.setFont(QFont("Microsoft YaHei UI", 8, QFont::Bold));
+        painter.fillRect(leftMargin + 10, top + 8, 15, 12, c.color);
+        painter.drawText(leftMargin + 30, top + 19, label);
+    }
+}
+
+void HistogramWidget::setPlotTexts(const QString &title, const QString &yLabel,
+                                   const QString &xLabel, const QString &waitingText)
+{
+    plotTitle = title;
+    yAxisLabel = yLabel;
+    xAxisLabel = xLabel;
+    waitingMessage = waitingText;
+    update();
+}
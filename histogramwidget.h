@@ -0,0 +1,56 @@
+#ifndef HISTOGRAMWIDGET_H
+#define HISTOGRAMWIDGET_H
+
+#include <QWidget>
+#include <QVector>
+#include <QColor>
+#include <QTimer>
+
+#include "slidinghistogram.h"
+
+struct HistogramChannel {
+    SlidingHistogram histogram;
+    QColor color;
+    QString name;
+    bool enabled;
+
+    HistogramChannel() : enabled(false) {}
+};
+
+// Live histograms of the parsed channels, one panel per enabled channel.
+// Samples are binned as they arrive and the view repaints on a timer, so
+// the cost per sample is constant however fast data comes in.
+class HistogramWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit HistogramWidget(QWidget *parent = nullptr);
+    ~HistogramWidget();
+
+    void addSample(int channel, double value);
+    void clearData();
+    void setChannelEnabled(int channel, bool enabled);
+    // Restarts every histogram with the new layout
+    void configure(int bins, int window, bool autoRange, double minimum, double maximum);
+    void setPlotTexts(const QString &title, const QString &yLabel,
+                      const QString &xLabel, const QString &waitingText);
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private slots:
+    void refresh();
+
+private:
+    QVector<HistogramChannel> channels;
+    QTimer *refreshTimer;
+    bool dirty;
+
+    QString plotTitle;
+    QString yAxisLabel;
+    QString xAxisLabel;
+    QString waitingMessage;
+};
+
+#endif // HISTOGRAMWIDGET_H
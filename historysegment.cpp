@@ -0,0 +1,162 @@
+#include "historysegment.h"
+#include <QtEndian>
+#include <atomic>
+#include <cstring>
+
+namespace {
+
+const char kSegmentMagic[4] = { 'S', 'D', 'S', 'G' };
+const quint32 kRecordMagic = 0x4B434453;  // "SDCK" read little-endian
+const quint32 kVersion = 1;
+const int kFileHeaderSize = 16;
+const int kRecordHeaderSize = 32;
+
+void putLittleEndian(uchar *dest, quint32 value)
+{
+    value = qToLittleEndian(value);
+    std::memcpy(dest, &value, sizeof(value));
+}
+
+void putLittleEndian(uchar *dest, quint64 value)
+{
+    value = qToLittleEndian(value);
+    std::memcpy(dest, &value, sizeof(value));
+}
+
+quint32 getLittleEndian32(const uchar *src)
+{
+    quint32 value;
+    std::memcpy(&value, src, sizeof(value));
+    return qFromLittleEndian(value);
+}
+
+quint64 getLittleEndian64(const uchar *src)
+{
+    quint64 value;
+    std::memcpy(&value, src, sizeof(value));
+    return qFromLittleEndian(value);
+}
+
+qint64 alignRecord(qint64 size)
+{
+    return (size + 7) & ~qint64(7);
+}
+
+} // namespace
+
+HistorySegment::HistorySegment(const QString &fileName, int channel)
+    : file(fileName)
+    , map(nullptr)
+    , mapSize(0)
+    , used(0)
+    , channel(channel)
+    , discarded(false)
+{
+}
+
+HistorySegment::~HistorySegment()
+{
+    if (map) {
+        file.unmap(map);
+    }
+    file.close();
+    if (discarded) {
+        file.remove();
+    }
+}
+
+bool HistorySegment::mapFile()
+{
+    mapSize = file.size();
+    map = file.map(0, mapSize);
+    return map != nullptr;
+}
+
+QSharedPointer<HistorySegment> HistorySegment::create(const QString &fileName, int channel, qint64 size)
+{
+    QSharedPointer<HistorySegment> segment(new HistorySegment(fileName, channel));
+    // Sized up front and sparse on disk; unused space reads back as zeros
+    if (!segment->file.open(QIODevice::ReadWrite | QIODevice::Truncate) ||
+        !segment->file.resize(size) || !segment->mapFile()) {
+        segment->discard();
+        return QSharedPointer<HistorySegment>();
+    }
+
+    std::memcpy(segment->map, kSegmentMagic, 4);
+    putLittleEndian(segment->map + 4, kVersion);
+    putLittleEndian(segment->map + 8, quint32(channel));
+    putLittleEndian(segment->map + 12, quint32(0));
+    segment->used = kFileHeaderSize;
+    return segment;
+}
+
+QSharedPointer<HistorySegment> HistorySegment::open(const QString &fileName, int channel,
+                                                    QVector<Record> *records)
+{
+    QSharedPointer<HistorySegment> segment(new HistorySegment(fileName, channel));
+    if (!segment->file.open(QIODevice::ReadOnly) || segment->file.size() < kFileHeaderSize ||
+        !segment->mapFile()) {
+        return QSharedPointer<HistorySegment>();
+    }
+
+    const uchar *base = segment->map;
+    if (std::memcmp(base, kSegmentMagic, 4) != 0 || getLittleEndian32(base + 4) != kVersion ||
+        getLittleEndian32(base + 8) != quint32(channel)) {
+        return QSharedPointer<HistorySegment>();
+    }
+
+    // Walk the records until the first one that was never completed
+    qint64 offset = kFileHeaderSize;
+    while (offset + kRecordHeaderSize <= segment->mapSize) {
+        const uchar *header = base + offset;
+        if (getLittleEndian32(header) != kRecordMagic) {
+            break;
+        }
+        const quint32 payloadSize = getLittleEndian32(header + 4);
+        if (offset + kRecordHeaderSize + qint64(payloadSize) > segment->mapSize) {
+            break;
+        }
+
+        Record record;
+        record.count = int(getLittleEndian32(header + 8));
+        record.firstTimestamp = qint64(getLittleEndian64(header + 16));
+        record.lastTimestamp = qint64(getLittleEndian64(header + 24));
+        record.payload = QByteArray::fromRawData(
+            reinterpret_cast<const char *>(header + kRecordHeaderSize), int(payloadSize));
+        records->append(record);
+
+        offset += alignRecord(kRecordHeaderSize + payloadSize);
+    }
+
+    // Reopened segments are read-only; new chunks go to a fresh segment
+    segment->used = segment->mapSize;
+    return segment;
+}
+
+bool HistorySegment::append(const QByteArray &payload, int count, qint64 firstTimestamp,
+                            qint64 lastTimestamp, Record *record)
+{
+    const qint64 size = alignRecord(kRecordHeaderSize + payload.size());
+    if (!map || used + size > mapSize) {
+        return false;
+    }
+
+    uchar *header = map + used;
+    uchar *data = header + kRecordHeaderSize;
+    std::memcpy(data, payload.constData(), payload.size());
+    putLittleEndian(header + 4, quint32(payload.size()));
+    putLittleEndian(header + 8, quint32(count));
+    putLittleEndian(header + 12, quint32(channel));
+    putLittleEndian(header + 16, quint64(firstTimestamp));
+    putLittleEndian(header + 24, quint64(lastTimestamp));
+    // Commit the record only once its contents are in place
+    std::atomic_thread_fence(std::memory_order_release);
+    putLittleEndian(header, kRecordMagic);
+    used += size;
+
+    record->payload = QByteArray::fromRawData(reinterpret_cast<const char *>(data), payload.size());
+    record->count = count;
+    record->firstTimestamp = firstTimestamp;
+    record->lastTimestamp = lastTimestamp;
+    return true;
+}
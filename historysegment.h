@@ -0,0 +1,65 @@
+#ifndef HISTORYSEGMENT_H
+#define HISTORYSEGMENT_H
+
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QSharedPointer>
+
+// Memory-mapped file holding sealed, packed chunks of one plot channel.
+// Chunks are written straight into the mapping, so the kernel pages them
+// out under memory pressure and back in only when a view reads them, and
+// they survive an application crash.
+//
+// Layout (integers little-endian, records 8-byte aligned):
+//   "SDSG" | u32 version | u32 channel | u32 reserved
+//   per record: u32 magic "SDCK" | u32 payloadSize | u32 count | u32 channel
+//               i64 firstTimestamp | i64 lastTimestamp | payload
+// The record magic is written last, so a record torn by a crash is ignored.
+class HistorySegment
+{
+public:
+    enum { DefaultSize = 32 * 1024 * 1024 };
+
+    struct Record {
+        QByteArray payload;    // Points into the mapping, valid while the segment lives
+        int count;
+        qint64 firstTimestamp;
+        qint64 lastTimestamp;
+    };
+
+    ~HistorySegment();
+
+    // Creates and maps a new, empty segment file
+    static QSharedPointer<HistorySegment> create(const QString &fileName, int channel,
+                                                 qint64 size = DefaultSize);
+    // Maps an existing segment and returns its intact records in order
+    static QSharedPointer<HistorySegment> open(const QString &fileName, int channel,
+                                               QVector<Record> *records);
+
+    // Copies payload into the mapping; returns false when the segment is full
+    bool append(const QByteArray &payload, int count, qint64 firstTimestamp,
+                qint64 lastTimestamp, Record *record);
+
+    // Delete the file once the last chunk referring to it is released
+    void discard() { discarded = true; }
+
+    QString fileName() const { return file.fileName(); }
+
+private:
+    HistorySegment(const QString &fileName, int channel);
+
+    QFile file;
+    uchar *map;
+    qint64 mapSize;
+    qint64 used;
+    int channel;
+    bool discarded;
+
+    bool mapFile();
+};
+
+typedef QSharedPointer<HistorySegment> HistorySegmentPtr;
+
+#endif // HISTORYSEGMENT_H
@@ -0,0 +1,177 @@
+#include "latencymeter.h"
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <cmath>
+
+namespace {
+
+// Raw round trips kept for export; the histogram keeps counting past this
+const int kMaxRawSamples = 1 << 20;
+
+QElapsedTimer startedClock()
+{
+    QElapsedTimer clock;
+    clock.start();
+    return clock;
+}
+
+} // namespace
+
+LatencyMeter::LatencyMeter()
+    : enabled(false)
+    , mode(AnyBytes)
+    , timeoutNs(0)
+    , sentNs(-1)
+    , count(0)
+    , unanswered(0)
+    , minNs(0)
+    , maxNs(0)
+    , sumNs(0.0)
+    , buckets(BucketCount, 0)
+{
+}
+
+qint64 LatencyMeter::clockNs()
+{
+    static const QElapsedTimer clock = startedClock();
+    return clock.nsecsElapsed();
+}
+
+void LatencyMeter::setEnabled(bool on)
+{
+    QMutexLocker lock(&mutex);
+    enabled = on;
+    sentNs = -1;
+}
+
+bool LatencyMeter::isEnabled() const
+{
+    QMutexLocker lock(&mutex);
+    return enabled;
+}
+
+void LatencyMeter::configure(Mode newMode, const QByteArray &pattern, int timeoutMs)
+{
+    {
+        QMutexLocker lock(&mutex);
+        mode = newMode;
+        matcher.setPattern(pattern);
+        timeoutNs = qint64(qMax(0, timeoutMs)) * 1000000;
+    }
+    clear();
+}
+
+void LatencyMeter::clear()
+{
+    QMutexLocker lock(&mutex);
+    sentNs = -1;
+    count = 0;
+    unanswered = 0;
+    minNs = 0;
+    maxNs = 0;
+    sumNs = 0.0;
+    buckets.fill(0);
+    raw.clear();
+}
+
+void LatencyMeter::markSent(qint64 ns)
+{
+    QMutexLocker lock(&mutex);
+    if (!enabled) {
+        return;
+    }
+    if (sentNs >= 0) {
+        ++unanswered;
+    }
+    sentNs = ns;
+    matcher.reset();
+}
+
+void LatencyMeter::feed(const QByteArray &data, qint64 ns)
+{
+    QMutexLocker lock(&mutex);
+    if (!enabled || sentNs < 0 || data.isEmpty()) {
+        return;
+    }
+    expire(ns);
+    if (sentNs < 0) {
+        return;
+    }
+    // The whole chunk arrived at ns, so a match anywhere in it closes the
+    // measurement at the same time
+    if (mode == AnyBytes || matcher.feed(data) >= 0) {
+        record(ns - sentNs);
+        sentNs = -1;
+    }
+}
+
+LatencySnapshot LatencyMeter::snapshot() const
+{
+    QMutexLocker lock(&mutex);
+    LatencySnapshot s;
+    s.count = count;
+    s.unanswered = unanswered;
+    s.buckets = buckets;
+    if (count > 0) {
+        s.minUs = minNs / 1000.0;
+        s.maxUs = maxNs / 1000.0;
+        s.meanUs = sumNs / count / 1000.0;
+        s.p50Us = percentile(0.5);
+        s.p90Us = percentile(0.9);
+        s.p99Us = percentile(0.99);
+        s.p999Us = percentile(0.999);
+    }
+    return s;
+}
+
+QVector<qint64> LatencyMeter::samples() const
+{
+    QMutexLocker lock(&mutex);
+    return raw;
+}
+
+double LatencyMeter::bucketLowerUs(int bucket)
+{
+    return bucket == 0 ? 0.0 : std::pow(2.0, double(bucket) / BucketsPerOctave);
+}
+
+void LatencyMeter::expire(qint64 ns)
+{
+    if (sentNs >= 0 && timeoutNs > 0 && ns - sentNs > timeoutNs) {
+        ++unanswered;
+        sentNs = -1;
+    }
+}
+
+void LatencyMeter::record(qint64 rttNs)
+{
+    rttNs = qMax<qint64>(0, rttNs);
+    if (count == 0 || rttNs < minNs) minNs = rttNs;
+    if (rttNs > maxNs) maxNs = rttNs;
+    sumNs += rttNs;
+    ++count;
+
+    const double us = rttNs / 1000.0;
+    const int bucket = us < 1.0 ? 0 : int(std::log2(us) * BucketsPerOctave);
+    ++buckets[qMin(bucket, BucketCount - 1)];
+
+    if (raw.size() < kMaxRawSamples) {
+        raw.append(rttNs);
+    }
+}
+
+double LatencyMeter::percentile(double q) const
+{
+    // Rank of the wanted sample, then the geometric middle of its bucket
+    const qint64 rank = qMax<qint64>(1, qint64(std::ceil(q * count)));
+    qint64 seen = 0;
+    for (int b = 0; b < BucketCount; ++b) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            const double lower = qMax(1.0, bucketLowerUs(b));
+            const double middle = b == 0 ? 0.5 : lower * std::pow(2.0, 0.5 / BucketsPerOctave);
+            return qBound(minNs / 1000.0, middle, maxNs / 1000.0);
+        }
+    }
+    return maxNs / 1000.0;
+}
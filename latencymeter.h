@@ -0,0 +1,89 @@
+#ifndef LATENCYMETER_H
+#define LATENCYMETER_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QVector>
+
+#include "streammatcher.h"
+
+// Latencies and their distribution at one point in time
+struct LatencySnapshot {
+    qint64 count;
+    qint64 unanswered;      // Sends replaced or timed out without a response
+    double minUs;
+    double meanUs;
+    double maxUs;
+    double p50Us;
+    double p90Us;
+    double p99Us;
+    double p999Us;
+    QVector<quint32> buckets;
+
+    LatencySnapshot()
+        : count(0), unanswered(0), minUs(0.0), meanUs(0.0), maxUs(0.0)
+        , p50Us(0.0), p90Us(0.0), p99Us(0.0), p999Us(0.0) {}
+};
+
+// Measures request/response round trips. A send opens a measurement and
+// the first response that satisfies the mode closes it; one measurement is
+// outstanding at a time, so a send while another is open counts the older
+// one as unanswered. Round trips go into logarithmic buckets (eight per
+// octave of microseconds), which keep every percentile within about 5%
+// at a fixed size, and the raw values are kept for export up to a limit.
+// Thread-safe: sends may be marked from a worker thread.
+class LatencyMeter
+{
+public:
+    enum Mode {
+        AnyBytes,   // The first received byte
+        Pattern     // The end of the first occurrence of a byte pattern,
+                    // such as a line delimiter
+    };
+
+    static const int BucketsPerOctave = 8;
+    static const int BucketCount = 27 * BucketsPerOctave;   // Up to ~134 s
+
+    LatencyMeter();
+
+    // Monotonic timestamp shared by every thread
+    static qint64 clockNs();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+    // Starts over with the new criteria
+    void configure(Mode mode, const QByteArray &pattern, int timeoutMs);
+    void clear();
+
+    void markSent(qint64 ns);
+    void feed(const QByteArray &data, qint64 ns);
+
+    LatencySnapshot snapshot() const;
+    // Raw round trips in ns, oldest first
+    QVector<qint64> samples() const;
+
+    // Lower edge of a bucket in us
+    static double bucketLowerUs(int bucket);
+
+private:
+    mutable QMutex mutex;
+    bool enabled;
+    Mode mode;
+    StreamMatcher matcher;
+    qint64 timeoutNs;
+
+    qint64 sentNs;          // Open measurement, -1 for none
+    qint64 count;
+    qint64 unanswered;
+    qint64 minNs;
+    qint64 maxNs;
+    double sumNs;
+    QVector<quint32> buckets;
+    QVector<qint64> raw;
+
+    void expire(qint64 ns);
+    void record(qint64 rttNs);
+    double percentile(double q) const;
+};
+
+#endif // LATENCYMETER_H
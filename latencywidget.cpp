@@ -0,0 +1,173 @@
+#include "latencywidget.h"
+#include <QPainter>
+#include <QPaintEvent>
+
+namespace {
+
+const int kRefreshIntervalMs = 250;
+
+QString formatUs(double us)
+{
+    if (us >= 1e6) {
+        return QString("%1 s").arg(us / 1e6, 0, 'g', 3);
+    }
+    if (us >= 1e3) {
+        return QString("%1 ms").arg(us / 1e3, 0, 'g', 3);
+    }
+    return QString("%1 us").arg(us, 0, 'g', 3);
+}
+
+} // namespace
+
+LatencyWidget::LatencyWidget(const LatencyMeter *meter, QWidget *parent)
+    : QWidget(parent)
+    , meter(meter)
+    , refreshTimer(new QTimer(this))
+    , plotTitle("Round-Trip Latency")
+    , yAxisLabel("Count")
+    , xAxisLabel("Latency")
+    , waitingMessage("Waiting for data...")
+{
+    setMinimumSize(400, 300);
+    setBackgroundRole(QPalette::Base);
+    setAutoFillBackground(true);
+
+    connect(refreshTimer, &QTimer::timeout, this, &LatencyWidget::refresh);
+    refreshTimer->start(kRefreshIntervalMs);
+}
+
+void LatencyWidget::refresh()
+{
+    if (!isVisible()) {
+        return;
+    }
+    const LatencySnapshot snapshot = meter->snapshot();
+    if (snapshot.count != shown.count || snapshot.unanswered != shown.unanswered) {
+        shown = snapshot;
+        update();
+    }
+}
+
+void LatencyWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+
+    const int leftMargin = 60;
+    const int rightMargin = 20;
+    const int topMargin = 50;
+    const int bottomMargin = 40;
+
+    int plotWidth = width() - leftMargin - rightMargin;
+    int plotHeight = height() - topMargin - bottomMargin;
+
+    // Background, matching PlotWidget
+    QLinearGradient bgGradient(0, 0, 0, height());
+    bgGradient.setColorAt(0, QColor(250, 250, 250));
+    bgGradient.setColorAt(1, QColor(240, 240, 240));
+    painter.fillRect(rect(), bgGradient);
+
+    painter.setPen(QColor(52, 152, 219));
+    painter.setFont(QFont("Microsoft YaHei UI", 11, QFont::Bold));
+    painter.drawText(QRect(leftMargin, 5, plotWidth, 20), Qt::AlignCenter, plotTitle);
+
+    painter.setPen(QColor(44, 62, 80));
+    painter.setFont(QFont("Microsoft YaHei UI", 9, QFont::Bold));
+    painter.drawText(leftMargin, height() - 22, plotWidth, 20, Qt::AlignCenter, xAxisLabel);
+
+    painter.save();
+    painter.translate(12, topMargin + plotHeight / 2);
+    painter.rotate(-90);
+    painter.drawText(-60, 0, 120, 20, Qt::AlignCenter, yAxisLabel);
+    painter.restore();
+
+    painter.fillRect(leftMargin, topMargin, plotWidth, plotHeight, Qt::white);
+
+    if (shown.count == 0) {
+        painter.setPen(QPen(QColor(52, 152, 219), 2));
+        painter.drawRect(leftMargin, topMargin, plotWidth, plotHeight);
+        painter.setPen(QColor(149, 165, 166));
+        painter.setFont(QFont("Microsoft YaHei UI", 11, QFont::Bold));
+        painter.drawText(leftMargin, topMargin, plotWidth, plotHeight,
+                         Qt::AlignCenter, waitingMessage);
+        return;
+    }
+
+    // Percentiles above the plot
+    painter.setPen(QColor(44, 62, 80));
+    painter.setFont(QFont("Microsoft YaHei UI", 8, QFont::Bold));
+    painter.drawText(QRect(leftMargin, 26, plotWidth, 18), Qt::AlignCenter,
+                     QString("n=%1  unanswered=%2  min=%3  mean=%4  p50=%5  p90=%6  p99=%7  p99.9=%8  max=%9")
+                     .arg(shown.count).arg(shown.unanswered)
+                     .arg(formatUs(shown.minUs)).arg(formatUs(shown.meanUs))
+                     .arg(formatUs(shown.p50Us)).arg(formatUs(shown.p90Us))
+                     .arg(formatUs(shown.p99Us)).arg(formatUs(shown.p999Us))
+                     .arg(formatUs(shown.maxUs)));
+
+    // Whole octaves around the occupied buckets
+    const int perOctave = LatencyMeter::BucketsPerOctave;
+    int first = 0;
+    while (first < shown.buckets.size() - 1 && shown.buckets[first] == 0) {
+        ++first;
+    }
+    int last = shown.buckets.size() - 1;
+    while (last > first && shown.buckets[last] == 0) {
+        --last;
+    }
+    first = first / perOctave * perOctave;
+    last = qMin(int(shown.buckets.size()), (last / perOctave + 1) * perOctave) - 1;
+    const int bins = last - first + 1;
+
+    quint32 peak = 1;
+    for (int b = first; b <= last; ++b) {
+        peak = qMax(peak, shown.buckets[b]);
+    }
+
+    painter.setFont(QFont("Microsoft YaHei UI", 8));
+    for (int i = 0; i <= 2; ++i) {
+        int y = topMargin + i * plotHeight / 2;
+        painter.setPen(QPen(QColor(220, 220, 220), 1, Qt::DotLine));
+        painter.drawLine(leftMargin, y, leftMargin + plotWidth, y);
+        painter.setPen(QColor(44, 62, 80));
+        painter.drawText(QRect(8, y - 10, 47, 20), Qt::AlignRight | Qt::AlignVCenter,
+                         QString::number(qRound(peak * (2 - i) / 2.0)));
+    }
+
+    QColor fill(52, 152, 219);
+    fill.setAlpha(180);
+    for (int b = first; b <= last; ++b) {
+        const quint32 value = shown.buckets[b];
+        if (value == 0) {
+            continue;
+        }
+        const int x0 = leftMargin + (b - first) * plotWidth / bins;
+        const int x1 = leftMargin + (b - first + 1) * plotWidth / bins;
+        const int barHeight = qMax(1, int(double(value) / peak * plotHeight));
+        painter.fillRect(x0, topMargin + plotHeight - barHeight, qMax(1, x1 - x0), barHeight, fill);
+    }
+
+    painter.setPen(QPen(QColor(52, 152, 219), 2));
+    painter.drawRect(leftMargin, topMargin, plotWidth, plotHeight);
+
+    // Octave boundaries on the time axis
+    painter.setFont(QFont("Microsoft YaHei UI", 8));
+    painter.setPen(QColor(44, 62, 80));
+    const int octaves = bins / perOctave;
+    const int step = qMax(1, octaves / 8);
+    for (int o = 0; o <= octaves; o += step) {
+        const int x = leftMargin + o * perOctave * plotWidth / bins;
+        painter.drawText(x - 30, topMargin + plotHeight + 3, 60, 15, Qt::AlignCenter,
+                         formatUs(qMax(1.0, LatencyMeter::bucketLowerUs(first + o * perOctave))));
+    }
+}
+
+void LatencyWidget::setPlotTexts(const QString &title, const QString &yLabel,
+                                 const QString &xLabel, const QString &waitingText)
+{
+    plotTitle = title;
+    yAxisLabel = yLabel;
+    xAxisLabel = xLabel;
+    waitingMessage = waitingText;
+    update();
+}
@@ -0,0 +1,39 @@
+#ifndef LATENCYWIDGET_H
+#define LATENCYWIDGET_H
+
+#include <QWidget>
+#include <QTimer>
+
+#include "latencymeter.h"
+
+// Live round-trip histogram of a LatencyMeter on a logarithmic time axis,
+// with the running percentiles above it. Polls the meter on a timer and
+// repaints only when new measurements arrived.
+class LatencyWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit LatencyWidget(const LatencyMeter *meter, QWidget *parent = nullptr);
+
+    void setPlotTexts(const QString &title, const QString &yLabel,
+                      const QString &xLabel, const QString &waitingText);
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private slots:
+    void refresh();
+
+private:
+    const LatencyMeter *meter;
+    QTimer *refreshTimer;
+    LatencySnapshot shown;
+
+    QString plotTitle;
+    QString yAxisLabel;
+    QString xAxisLabel;
+    QString waitingMessage;
+};
+
+#endif // LATENCYWIDGET_H
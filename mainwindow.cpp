@@ -2,6 +2,10 @@
 #include "ui_mainwindow.h"
 #include "translations.h"
 #include "plotwidget.h"
+#include "spectrumwidget.h"
+#include "histogramwidget.h"
+#include "plotexporter.h"
+#include "sparklinewidget.h"
 #include <QMessageBox>
 #include <QDateTime>
 #include <QLabel>
@@ -23,14 +27,107 @@
 #include <QGroupBox>
 #include <QCheckBox>
 #include <QComboBox>
+#include <QStandardPaths>
+#include <QSettings>
+#include <QTableWidget>
+#include <QHeaderView>
+
+namespace {
+
+// Channels filled by parsePlotLine(); derived and then filtered
+// channels follow them
+const int kParsedChannels = 6;
+// Longest plot line kept while waiting for its line end
+const int kMaxPlotLineBytes = 4096;
+// Longest a parsed row waits before derived and filtered channels are
+// computed
+const int kBatchFlushMs = 10;
+// Port sessions open at once, and plot channels in the sessions tab
+const int kMaxPortSessions = 8;
+#ifdef HAVE_VIRTUAL_PORT
+// Port combo entry that opens a VirtualPort instead of a device
+const char kVirtualPortName[] = "VIRTUAL";
+#endif
+#ifndef __EMSCRIPTEN__
+// Port combo entries for network links; the address box says where to
+const char kTcpClientName[] = "TCP";
+const char kTcpServerName[] = "TCP-SERVER";
+const char kUdpName[] = "UDP";
+#endif
+// Most received bytes taken from the transport per read
+const int kReadChunkBytes = 64 * 1024;
+// Pipeline metrics snapshot period; the trend spans HistorySize of them
+const int kMetricsIntervalMs = 500;
+// Translation keys of the metrics table rows: rates, then one per
+// PipelineSnapshot::Stage, then one per PipelineSnapshot::Queue
+const char *const kMetricRowKeys[] = {
+    "metric_rx_bytes", "metric_rx_lines", "metric_tx_bytes", "metric_tx_lines",
+    "metric_read", "metric_decode", "metric_parse", "metric_plot_ingest", "metric_paint",
+    "metric_rx_backlog", "metric_tx_queued", "metric_tx_in_flight", "metric_batched_rows"
+};
+const int kMetricRowCount = int(sizeof(kMetricRowKeys) / sizeof(kMetricRowKeys[0]));
+// Biquad Q for maximally flat low- and high-pass response
+const double kButterworthQ = 0.70710678118654752;
+
+// Retention with compressed history enabled: 24 h at 100 Hz per channel
+const qint64 kCompressedHistorySamples = 24LL * 3600 * 100;
+// Retention with history spilled to disk: 7 days at 100 Hz per channel
+const qint64 kSpilledHistorySamples = 7LL * 24 * 3600 * 100;
+
+// Tooltip naming the Ctrl+1..9 hotkey of a command list row
+QString commandHotkeyTip(int row)
+{
+    return row < 9 ? QKeySequence(QString("Ctrl+%1").arg(row + 1)).toString(QKeySequence::NativeText)
+                   : QString();
+}
+
+#ifndef __EMSCRIPTEN__
+// Options kept across sessions
+QString settingsFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation) + "/settings.ini";
+}
+#endif
+
+// Export view of the channel store. The views share the store's chunks, so
+// the export thread reads a stable snapshot while the GUI keeps appending.
+class ChannelStoreExportSource : public ExportSource
+{
+public:
+    explicit ChannelStoreExportSource(const ChannelStore &store)
+    {
+        for (int i = 0; i < store.channelCount(); ++i) {
+            views.append(store.view(i));
+            names.append(store.channelName(i));
+        }
+    }
+    
+    int channelCount() const override { return views.size(); }
+    QString channelName(int channel) const override { return names[channel]; }
+    qint64 sampleCount(int channel) const override { return views[channel].size(); }
+    
+    void read(int channel, qint64 start, int count,
+              qint64 *timestamps, double *values) const override
+    {
+        views[channel].read(start, count, timestamps, values);
+    }
+    
+private:
+    QVector<ChannelView> views;
+    QStringList names;
+};
+
+} // namespace
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
-#ifdef __EMSCRIPTEN__
-    , serialPort(new WebSerialPort(this))
-#else
-    , serialPort(new QSerialPort(this))
+    , transport(Transport::create(TransportConfig().kind, this))
+    , txQueue(new TransmitQueue(transport, this))
+    , readBuffer(kReadChunkBytes, Qt::Uninitialized)
+#ifndef __EMSCRIPTEN__
+    , addressLabel(nullptr)
+    , addressEdit(nullptr)
 #endif
     , statusTimer(new QTimer(this))
     , rxBytes(0)
@@ -38,7 +135,22 @@ MainWindow::MainWindow(QWidget *parent)
     , translator(new QTranslator(this))
     , currentLanguage("zh")
     , autoSendTimer(new QTimer(this))
+#ifndef __EMSCRIPTEN__
+    , sendScheduler(new SendScheduler(this))
+    , autoSendJitterLabel(nullptr)
+#endif
+    , fileSender(new FileSender(txQueue, this))
+    , fileSendButton(nullptr)
+#ifndef __EMSCRIPTEN__
+    , fileTransfer(new FileTransfer(this))
+    , scriptExecutor(new ScriptExecutor(this))
+#endif
     , maxDataPoints(1000)
+    , actionCompressHistory(nullptr)
+    , actionSpillHistory(nullptr)
+    , batchTimer(new QTimer(this))
+    , statsTimer(new QTimer(this))
+    , statsDirty(false)
 {
     ui->setupUi(this);
     
@@ -249,12 +361,15 @@ MainWindow::MainWindow(QWidget *parent)
         fileMenu->setStyleSheet(menu.styleSheet());
         fileMenu->addAction(ui->actionSaveReceive);
         fileMenu->addAction(ui->actionSaveSend);
+        fileMenu->addAction(actionExportPlot);
         fileMenu->addSeparator();
         fileMenu->addAction(ui->actionExit);
         
         QMenu* viewMenu = menu.addMenu("👁 View");
         viewMenu->setStyleSheet(menu.styleSheet());
         viewMenu->addAction(ui->actionClearAll);
+        viewMenu->addAction(actionCompressHistory);
+        viewMenu->addAction(actionSpillHistory);
         
         QMenu* langMenu = menu.addMenu("🌐 Language");
         langMenu->setStyleSheet(menu.styleSheet());
@@ -295,21 +410,24 @@ MainWindow::MainWindow(QWidget *parent)
     languageGroup->addAction(ui->actionFrench);
     ui->actionChinese->setChecked(true);
     
-    // Initialize plot data with 6 channels
-    plotData.resize(6);
+    // Plot channels are retained at least as long as the plot window
+    channelStore.setRetention(maxDataPoints);
+    channelStats.resize(6);
     
     initUI();
     setupAdvancedUI();
     
-#ifdef __EMSCRIPTEN__
-    connect(serialPort, &WebSerialPort::readyRead, this, &MainWindow::readData);
-#else
-    connect(serialPort, &QSerialPort::readyRead, this, &MainWindow::readData);
-#endif
+    connect(transport, &Transport::readyRead, this, &MainWindow::readData);
+    connect(transport, &Transport::errorOccurred, this, &MainWindow::onTransportError);
     connect(statusTimer, &QTimer::timeout, this, &MainWindow::updateStatus);
     connect(autoSendTimer, &QTimer::timeout, this, &MainWindow::on_autoSendTimer_timeout);
+    connect(txQueue, &TransmitQueue::failed, this, &MainWindow::onTransmitFailed);
+    
+    connect(statsTimer, &QTimer::timeout, this, &MainWindow::updatePlotDisplay);
     
     statusTimer->start(100);
+    statsTimer->start(250);
+    statsClock.start();
     
     // Apply default language (Chinese)
     retranslateUI();
@@ -317,9 +435,33 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
-    if (serialPort->isOpen()) {
-        serialPort->close();
+    // Stop a running export before the window goes away
+    if (exportThread) {
+        if (plotExporter) {
+            plotExporter->cancel();
+        }
+        exportThread->quit();
+        exportThread->wait();
+    }
+    
+#ifndef __EMSCRIPTEN__
+    // These threads write to the port's handle; stop them before closing
+    sendScheduler->stopSending();
+    scriptExecutor->stopScript();
+    fileTransfer->cancel();
+    bertTester->stopTest();
+    // Sessions write into sessionEventLog, which goes before the children do
+    stopPortSessions();
+    portBridge->stopBridge();
+#endif
+    fileSender->cancel();
+    if (transport->isOpen()) {
+        transport->close();
     }
+#ifdef HAVE_VIRTUAL_PORT
+    // Writes to the master side, which closes with virtualPort
+    deviceSimulator->stopSimulator();
+#endif
     delete ui;
 }
 
@@ -373,6 +515,12 @@ void MainWindow::refreshPortList()
         int index = ui->portCombo->count() - 1;
         ui->portCombo->setItemData(index, itemText, Qt::ToolTipRole);
     }
+#ifdef HAVE_VIRTUAL_PORT
+    ui->portCombo->addItem(QString(kVirtualPortName) + " - Simulated device");
+#endif
+    ui->portCombo->addItem(QString(kTcpClientName) + " - Connect to host:port");
+    ui->portCombo->addItem(QString(kTcpServerName) + " - Listen on port");
+    ui->portCombo->addItem(QString(kUdpName) + " - Send to host:port or listen on :port");
 #else
     // WebAssembly: User will select port through browser dialog
     ui->portCombo->addItem("Click 'Open Port' to select...");
@@ -382,167 +530,280 @@ void MainWindow::refreshPortList()
 void MainWindow::on_refreshButton_clicked()
 {
     refreshPortList();
+#ifndef __EMSCRIPTEN__
+    refreshExtraPortLists();
+#endif
 }
 
 void MainWindow::on_openButton_clicked()
 {
     QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
     
-    if (serialPort->isOpen()) {
-        serialPort->close();
-        ui->openButton->setText(trans["open_port"]);
-        statusLabel->setText(trans["status_disconnected"]);
-        ui->portCombo->setEnabled(true);
-        ui->baudRateCombo->setEnabled(true);
-        ui->dataBitsCombo->setEnabled(true);
-        ui->stopBitsCombo->setEnabled(true);
-        ui->parityCombo->setEnabled(true);
+    if (transport->isOpen()) {
+        closePort();
     } else {
-        QString portName = ui->portCombo->currentText().split(" - ").first();
-        serialPort->setPortName(portName);
-        serialPort->setBaudRate(ui->baudRateCombo->currentText().toInt());
-        
-        // Set data bits
-        switch (ui->dataBitsCombo->currentText().toInt()) {
-#ifdef __EMSCRIPTEN__
-            case 5: serialPort->setDataBits(WebSerialPort::Data5); break;
-            case 6: serialPort->setDataBits(WebSerialPort::Data6); break;
-            case 7: serialPort->setDataBits(WebSerialPort::Data7); break;
-            case 8: serialPort->setDataBits(WebSerialPort::Data8); break;
-#else
-            case 5: serialPort->setDataBits(QSerialPort::Data5); break;
-            case 6: serialPort->setDataBits(QSerialPort::Data6); break;
-            case 7: serialPort->setDataBits(QSerialPort::Data7); break;
-            case 8: serialPort->setDataBits(QSerialPort::Data8); break;
-#endif
-        }
-        
-        // Set stop bits
-        if (ui->stopBitsCombo->currentText() == "1") {
-#ifdef __EMSCRIPTEN__
-            serialPort->setStopBits(WebSerialPort::OneStop);
-        } else if (ui->stopBitsCombo->currentText() == "1.5") {
-            // WebAssembly doesn't support 1.5 stop bits, use 1
-            serialPort->setStopBits(WebSerialPort::OneStop);
-#else
-            serialPort->setStopBits(QSerialPort::OneStop);
-        } else if (ui->stopBitsCombo->currentText() == "1.5") {
-            serialPort->setStopBits(QSerialPort::OneAndHalfStop);
-#endif
-        } else {
-#ifdef __EMSCRIPTEN__
-            serialPort->setStopBits(WebSerialPort::TwoStop);
-#else
-            serialPort->setStopBits(QSerialPort::TwoStop);
-#endif
+        TransportConfig config = transportConfig();
+#ifndef __EMSCRIPTEN__
+        if (config.kind != TransportConfig::Serial && config.port == 0) {
+            QMessageBox::warning(this, trans["warning"], trans["transport_bad_address"]);
+            return;
         }
-        
-        // Set parity based on index
-        int parityIndex = ui->parityCombo->currentIndex();
-        if (parityIndex == 0) {
-#ifdef __EMSCRIPTEN__
-            serialPort->setParity(WebSerialPort::NoParity);
-        } else if (parityIndex == 1) {
-            serialPort->setParity(WebSerialPort::OddParity);
-        } else {
-            serialPort->setParity(WebSerialPort::EvenParity);
-#else
-            serialPort->setParity(QSerialPort::NoParity);
-        } else if (parityIndex == 1) {
-            serialPort->setParity(QSerialPort::OddParity);
-        } else {
-            serialPort->setParity(QSerialPort::EvenParity);
 #endif
+#ifdef HAVE_VIRTUAL_PORT
+        // The simulator sits on the master side; the port opens the slave
+        if (config.portName == kVirtualPortName) {
+            QString error;
+            if (!virtualPort.open(&error)) {
+                QMessageBox::critical(this, trans["error"], trans["failed_to_open"] + error);
+                return;
+            }
+            config.portName = virtualPort.slavePath();
+            deviceSimulator->startSimulator(virtualPort.masterHandle(), simulatorConfig());
         }
-        
-#ifdef __EMSCRIPTEN__
-        serialPort->setFlowControl(WebSerialPort::NoFlowControl);
-#else
-        serialPort->setFlowControl(QSerialPort::NoFlowControl);
 #endif
+        setTransport(config.kind);
         
-        if (serialPort->open(QIODevice::ReadWrite)) {
+        if (transport->open(config)) {
             ui->openButton->setText(trans["close_port"]);
-            statusLabel->setText(trans["status_connected"] + portName);
+            statusLabel->setText(trans["status_connected"] + transport->config().displayName());
             ui->portCombo->setEnabled(false);
             ui->baudRateCombo->setEnabled(false);
             ui->dataBitsCombo->setEnabled(false);
             ui->stopBitsCombo->setEnabled(false);
             ui->parityCombo->setEnabled(false);
+#ifndef __EMSCRIPTEN__
+            addressEdit->setEnabled(false);
+#endif
             rxBytes = 0;
             txBytes = 0;
+            txQueue->reset();
+            updateAutoSend();
         } else {
-            QMessageBox::critical(this, trans["error"], trans["failed_to_open"] + serialPort->errorString());
+#ifdef HAVE_VIRTUAL_PORT
+            deviceSimulator->stopSimulator();
+            virtualPort.close();
+#endif
+            QMessageBox::critical(this, trans["error"], trans["failed_to_open"] + transport->errorString());
         }
     }
 }
 
+TransportConfig MainWindow::transportConfig() const
+{
+    TransportConfig config;
+    config.portName = ui->portCombo->currentText().split(" - ").first();
+    config.baudRate = ui->baudRateCombo->currentText().toInt();
+    config.dataBits = ui->dataBitsCombo->currentText().toInt();
+    if (ui->stopBitsCombo->currentText() == "1.5") {
+        config.stopBits = TransportConfig::OneAndHalfStop;
+    } else if (ui->stopBitsCombo->currentText() == "2") {
+        config.stopBits = TransportConfig::TwoStop;
+    }
+    if (ui->parityCombo->currentIndex() == 1) {
+        config.parity = TransportConfig::OddParity;
+    } else if (ui->parityCombo->currentIndex() == 2) {
+        config.parity = TransportConfig::EvenParity;
+    }
+    config.hardwareFlowControl = flowControlCheckBox && flowControlCheckBox->isChecked();
+    
+#ifndef __EMSCRIPTEN__
+    if (config.portName == kTcpClientName) {
+        config.kind = TransportConfig::TcpClient;
+    } else if (config.portName == kTcpServerName) {
+        config.kind = TransportConfig::TcpServer;
+    } else if (config.portName == kUdpName) {
+        config.kind = TransportConfig::Udp;
+    }
+    // A bad address leaves the port at 0; a client needs a host as well
+    if (config.kind != TransportConfig::Serial &&
+        (!config.setAddress(addressEdit->text()) ||
+         (config.kind == TransportConfig::TcpClient && config.host.isEmpty()))) {
+        config.port = 0;
+    }
+#endif
+    return config;
+}
+
+void MainWindow::setTransport(TransportConfig::Kind kind)
+{
+    if (transport->kind() == kind) {
+        return;
+    }
+    Transport *next = Transport::create(kind, this);
+    if (!next) {
+        return;
+    }
+    txQueue->reset();
+    txQueue->setTransport(next);
+    connect(next, &Transport::readyRead, this, &MainWindow::readData);
+    connect(next, &Transport::errorOccurred, this, &MainWindow::onTransportError);
+    next->setHardwareFlowControl(transport->config().hardwareFlowControl);
+    transport->disconnect(this);
+    transport->deleteLater();
+    transport = next;
+}
+
+void MainWindow::closePort()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+#ifndef __EMSCRIPTEN__
+    sendScheduler->stopSending();
+    scriptExecutor->stopScript();
+    fileTransfer->cancel();
+    stopBertTest();
+#endif
+    fileSender->cancel();
+    transport->close();
+#ifdef HAVE_VIRTUAL_PORT
+    deviceSimulator->stopSimulator();
+    virtualPort.close();
+#endif
+    txQueue->reset();
+    plotPartialLine.clear();
+    ui->openButton->setText(trans["open_port"]);
+    statusLabel->setText(trans["status_disconnected"]);
+    ui->portCombo->setEnabled(true);
+    ui->baudRateCombo->setEnabled(true);
+    ui->dataBitsCombo->setEnabled(true);
+    ui->stopBitsCombo->setEnabled(true);
+    ui->parityCombo->setEnabled(true);
+#ifndef __EMSCRIPTEN__
+    updateAddressEdit();
+#endif
+}
+
+void MainWindow::onTransportError(const QString &error)
+{
+    // Errors on a link that stays up reach the user through what they
+    // affect, such as the transmit queue. A lost link, like a device
+    // unplugged or a server gone, leaves the UI as the close button does.
+    if (transport->isOpen() || ui->portCombo->isEnabled()) {
+        return;
+    }
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    closePort();
+    QMessageBox::warning(this, trans["warning"], trans["transport_lost"] + "\n" + error);
+}
+
 void MainWindow::on_sendButton_clicked()
 {
     QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
     
-    if (!serialPort->isOpen()) {
+    if (!transport->isOpen()) {
         QMessageBox::warning(this, trans["warning"], trans["open_port_first"]);
         return;
     }
     
-    QString text = ui->sendText->toPlainText();
-    if (text.isEmpty()) {
+    QByteArray data = encodeSendText();
+    if (data.isEmpty()) {
         return;
     }
     
-    QByteArray data;
-    if (ui->hexSendCheck->isChecked()) {
-        // HEX send mode
-        text = text.replace(" ", "").replace("\n", "").replace("\r", "");
-        data = QByteArray::fromHex(text.toLatin1());
-    } else {
-        data = text.toUtf8();
-        
-        // Add line endings based on checkboxes
-        if (addCarriageReturnCheckBox && addCarriageReturnCheckBox->isChecked()) {
-            data.append("\r");
-        }
-        if (addLineBreakCheckBox && addLineBreakCheckBox->isChecked()) {
-            data.append("\n");
-        }
-        // Fallback to old checkbox
-        if (ui->sendNewLineCheck->isChecked() && 
-            (!addCarriageReturnCheckBox || !addLineBreakCheckBox)) {
-            data.append("\r\n");
-        }
+    // TX counts bytes once the port confirms them
+    if (!txQueue->enqueue(data)) {
+        QMessageBox::warning(this, trans["warning"], trans["tx_queue_full"]);
+        return;
+    }
+    markCommandSent();
+}
+
+void MainWindow::markCommandSent()
+{
+    // Stamped when queued; with a backlog the wait in the queue counts too
+    latencyMeter.markSent(LatencyMeter::clockNs());
+}
+
+QByteArray MainWindow::encodeSendText() const
+{
+    QString text = ui->sendText->toPlainText();
+    if (text.isEmpty()) {
+        return QByteArray();
     }
     
-    qint64 written = serialPort->write(data);
-    if (written != -1) {
-        txBytes += written;
+    return CommandEntry::encode(text, ui->hexSendCheck->isChecked(), sendLineEnding());
+}
+
+QByteArray MainWindow::sendLineEnding() const
+{
+    QByteArray ending;
+    
+    // Add line endings based on checkboxes
+    if (addCarriageReturnCheckBox && addCarriageReturnCheckBox->isChecked()) {
+        ending.append("\r");
     }
+    if (addLineBreakCheckBox && addLineBreakCheckBox->isChecked()) {
+        ending.append("\n");
+    }
+    // Fallback to old checkbox
+    if (ui->sendNewLineCheck->isChecked() && 
+        (!addCarriageReturnCheckBox || !addLineBreakCheckBox)) {
+        ending.append("\r\n");
+    }
+    return ending;
 }
 
 void MainWindow::readData()
 {
-    QByteArray data = serialPort->readAll();
+    // In bounded chunks, so a burst is processed as it is taken rather
+    // than gathered into one large buffer first
+    for (;;) {
+        qint64 n;
+        {
+            PipelineMetrics::StageTimer timer(&pipelineMetrics, PipelineSnapshot::Read);
+            n = transport->read(readBuffer.data(), readBuffer.size());
+        }
+        if (n <= 0) {
+            break;
+        }
+        // Copied out, as consumers may keep the data
+        processReceivedData(QByteArray(readBuffer.constData(), int(n)));
+    }
+}
+
+void MainWindow::processReceivedData(const QByteArray &data)
+{
     rxBytes += data.size();
+    pipelineMetrics.addReceived(data.size(), PipelineMetrics::countLines(data.constData(), data.size()));
+    latencyMeter.feed(data, LatencyMeter::clockNs());
+    
+#ifndef __EMSCRIPTEN__
+    // Test data is noise to the display and plots, and drawing it would
+    // hold the test back
+    if (bertTester->isRunning()) {
+        bertTester->feed(data, LatencyMeter::clockNs());
+        return;
+    }
+    if (scriptExecutor->isRunning()) {
+        scriptExecutor->feed(data);
+    }
+    if (fileTransfer->isRunning()) {
+        fileTransfer->feed(data);
+    }
+#endif
     
     // Parse data for plotting
-    parseReceivedData(data);
-    
-    QString text;
-    if (ui->hexReceiveCheck->isChecked()) {
-        // HEX display mode - Qt 5.6 compatible
-        text = data.toHex().toUpper();
-        // Add spaces between bytes
-        QString formatted;
-        for (int i = 0; i < text.length(); i += 2) {
-            if (i > 0) formatted += " ";
-            formatted += text.mid(i, 2);
-        }
-        text = formatted;
-    } else {
-        text = QString::fromUtf8(data);
+    parseReceivedData(data, &plotPartialLine);
+    
+    PipelineMetrics::StageTimer timer(&pipelineMetrics, PipelineSnapshot::Decode);
+    appendReceiveText(receiveDisplayText(data));
+}
+
+QString MainWindow::receiveDisplayText(const QByteArray &data) const
+{
+    if (!ui->hexReceiveCheck->isChecked()) {
+        return QString::fromUtf8(data);
     }
     
-    appendReceiveText(text);
+    // HEX display mode - Qt 5.6 compatible
+    QString text = data.toHex().toUpper();
+    // Add spaces between bytes
+    QString formatted;
+    for (int i = 0; i < text.length(); i += 2) {
+        if (i > 0) formatted += " ";
+        formatted += text.mid(i, 2);
+    }
+    return formatted;
 }
 
 void MainWindow::appendReceiveText(const QString &text)
@@ -573,9 +834,61 @@ void MainWindow::on_clearSendButton_clicked()
 
 void MainWindow::updateStatus()
 {
-    if (serialPort->isOpen()) {
+    const qint64 txBefore = txBytes;
+#ifndef __EMSCRIPTEN__
+    txBytes += sendScheduler->takeBytesWritten();
+    txBytes += scriptExecutor->takeBytesWritten();
+    txBytes += fileTransfer->takeBytesWritten();
+    txBytes += bertTester->takeBytesWritten();
+    if (fileTransfer->isRunning()) {
+        const qint64 total = fileTransfer->totalBytes();
+        fileSendProgressBar->setValue(total > 0 ? int(fileTransfer->bytesAcked() * 1000 / total) : 0);
+        fileSendStatusLabel->setText(
+            QString("%1 / %2 bytes  %3 KB/s  %4% of line rate  Retries=%5")
+            .arg(fileTransfer->bytesAcked()).arg(total)
+            .arg(fileTransfer->throughput() / 1024.0, 0, 'f', 1)
+            .arg(fileTransfer->efficiency() * 100.0, 0, 'f', 0)
+            .arg(fileTransfer->retries()));
+    }
+    if (scriptExecutor->isRunning() && scriptExecutor->currentLine() > 0) {
+        scriptStatusLabel->setText(QString("Line %1").arg(scriptExecutor->currentLine()));
+    }
+    if (sendScheduler->isSending()) {
+        const SendJitter jitter = sendScheduler->jitter();
+        autoSendJitterLabel->setText(
+            QString("Sent=%1  Missed=%2  Jitter min/avg/max/p99=%3/%4/%5/%6 us")
+            .arg(jitter.sent).arg(jitter.missed)
+            .arg(jitter.minUs, 0, 'f', 1).arg(jitter.avgUs, 0, 'f', 1)
+            .arg(jitter.maxUs, 0, 'f', 1).arg(jitter.p99Us, 0, 'f', 1));
+    }
+#endif
+#ifdef HAVE_VIRTUAL_PORT
+    if (deviceSimulator->isRunning()) {
+        simulatorStatsLabel->setText(QString("Sent=%1 KB  Overrun=%2 KB")
+                                     .arg(deviceSimulator->bytesSent() / 1024)
+                                     .arg(deviceSimulator->bytesDropped() / 1024));
+    }
+#endif
+    txBytes += txQueue->takeBytesWritten();
+    // Lines are only known for data sent through the queue
+    pipelineMetrics.addTransmitted(txBytes - txBefore, txQueue->takeLinesWritten());
+    if (fileSender->isSending()) {
+        const qint64 total = fileSender->totalBytes();
+        fileSendProgressBar->setValue(total > 0 ? int(fileSender->bytesSent() * 1000 / total) : 0);
+        const double eta = fileSender->eta();
+        fileSendStatusLabel->setText(
+            QString("%1 / %2 bytes  %3 KB/s  ETA %4")
+            .arg(fileSender->bytesSent()).arg(total)
+            .arg(fileSender->throughput() / 1024.0, 0, 'f', 1)
+            .arg(eta < 0 ? QString("--") : QString("%1 s").arg(qRound(eta))));
+    }
+    if (transport->isOpen()) {
         rxLabel->setText(QString("RX: %1 bytes").arg(rxBytes));
-        txLabel->setText(QString("TX: %1 bytes").arg(txBytes));
+        QString tx = QString("TX: %1 bytes").arg(txBytes);
+        if (txQueue->pendingBytes() > 0) {
+            tx += QString(" (+%1 queued)").arg(txQueue->pendingBytes());
+        }
+        txLabel->setText(tx);
     }
 }
 
@@ -638,9 +951,20 @@ void MainWindow::on_actionClearAll_triggered()
     if (plotWidget) {
         plotWidget->clearData();
     }
-    for (int i = 0; i < plotData.size(); ++i) {
-        plotData[i].clear();
+    if (spectrumWidget) {
+        spectrumWidget->clearData();
+    }
+    if (histogramWidget) {
+        histogramWidget->clearData();
     }
+    channelStore.clear();
+    derivedChannels.reset();
+    filterStage.reset();
+    for (int i = 0; i < channelStats.size(); ++i) {
+        channelStats[i].reset();
+    }
+    triggerDetector.arm();
+    statsDirty = true;
     updatePlotDisplay();
 }
 
@@ -707,6 +1031,16 @@ void MainWindow::retranslateUI()
     if (mainTabWidget) {
         mainTabWidget->setTabText(0, trans["tab_main"]);
         mainTabWidget->setTabText(1, trans["tab_plotter"]);
+        mainTabWidget->setTabText(2, trans["tab_histogram"]);
+        mainTabWidget->setTabText(3, trans["tab_spectrum"]);
+        mainTabWidget->setTabText(4, trans["tab_latency"]);
+#ifndef __EMSCRIPTEN__
+        mainTabWidget->setTabText(5, trans["tab_bert"]);
+        mainTabWidget->setTabText(6, trans["tab_sessions"]);
+        mainTabWidget->setTabText(7, trans["tab_metrics"]);
+#else
+        mainTabWidget->setTabText(5, trans["tab_metrics"]);
+#endif
         
 #ifdef Q_OS_ANDROID
         // Android: Force repaint to ensure text is visible
@@ -721,6 +1055,116 @@ void MainWindow::retranslateUI()
                                 trans["plot_points"], trans["plot_waiting"]);
     }
     
+    // Update spectrum tab
+    if (spectrumWidget) {
+        spectrumWidget->setPlotTexts(trans["spectrum_title"], trans["spectrum_magnitude"],
+                                     trans["spectrum_frequency"], trans["spectrum_waiting"]);
+        spectrumWindowLabel->setText(trans["spectrum_window"]);
+        spectrumSizeLabel->setText(trans["spectrum_size"]);
+        spectrumRateLabel->setText(trans["spectrum_rate"]);
+        
+        int windowIndex = spectrumWindowCombo->currentIndex();
+        spectrumWindowCombo->blockSignals(true);
+        spectrumWindowCombo->clear();
+        spectrumWindowCombo->addItems({trans["window_hann"], trans["window_hamming"], trans["window_blackman"]});
+        spectrumWindowCombo->setCurrentIndex(windowIndex);
+        spectrumWindowCombo->blockSignals(false);
+    }
+    
+    // Update histogram tab
+    if (histogramWidget) {
+        histogramWidget->setPlotTexts(trans["histogram_title"], trans["histogram_count"],
+                                      trans["histogram_value"], trans["spectrum_waiting"]);
+        histogramBinsLabel->setText(trans["histogram_bins"]);
+        histogramWindowLabel->setText(trans["histogram_window"]);
+        histogramApplyButton->setText(trans["histogram_apply"]);
+        
+        int rangeIndex = histogramRangeCombo->currentIndex();
+        histogramRangeCombo->blockSignals(true);
+        histogramRangeCombo->clear();
+        histogramRangeCombo->addItems({trans["histogram_auto"], trans["histogram_fixed"]});
+        histogramRangeCombo->setCurrentIndex(rangeIndex);
+        histogramRangeCombo->blockSignals(false);
+    }
+    
+    // Update latency tab
+    if (latencyWidget) {
+        latencyWidget->setPlotTexts(trans["latency_title"], trans["histogram_count"],
+                                    trans["latency_axis"], trans["latency_waiting"]);
+        latencyEnableCheckBox->setText(trans["latency_enable"]);
+        latencyTimeoutLabel->setText(trans["latency_timeout"]);
+        latencyClearButton->setText(trans["latency_clear"]);
+        latencyExportButton->setText(trans["latency_export"]);
+        
+        int modeIndex = latencyModeCombo->currentIndex();
+        latencyModeCombo->blockSignals(true);
+        latencyModeCombo->clear();
+        latencyModeCombo->addItems({trans["latency_any"], trans["latency_line"], trans["latency_pattern"]});
+        latencyModeCombo->setCurrentIndex(modeIndex);
+        latencyModeCombo->blockSignals(false);
+    }
+    
+    // Update metrics tab
+    if (metricsResetButton) {
+        metricsResetButton->setText(trans["metrics_reset"]);
+        metricsTable->setHorizontalHeaderLabels({trans["metrics_col_metric"], trans["metrics_col_current"],
+                                                 trans["metrics_col_peak"], trans["metrics_col_trend"]});
+        for (int row = 0; row < kMetricRowCount; ++row) {
+            metricsTable->item(row, 0)->setText(trans[kMetricRowKeys[row]]);
+        }
+    }
+    
+#ifndef __EMSCRIPTEN__
+    // Update BERT tab
+    if (bertStartButton) {
+        bertPatternLabel->setText(trans["bert_pattern"]);
+        bertPatternCombo->setItemText(4, trans["bert_counter"]);
+        bertStartButton->setText(bertTimer->isActive() ? trans["bert_stop"] : trans["bert_start"]);
+        bertExportButton->setText(trans["bert_export"]);
+        if (bertHistory.isEmpty()) {
+            bertSummaryLabel->setText(trans["bert_hint"]);
+        }
+    }
+    
+    // Update sessions tab
+    if (sessionAddButton) {
+        sessionPortLabel->setText(trans["port"]);
+        sessionBaudLabel->setText(trans["baud_rate"]);
+        sessionAddButton->setText(trans["session_add"]);
+        sessionRemoveButton->setText(trans["session_remove"]);
+        sessionClearButton->setText(trans["session_clear"]);
+        sessionTable->setHorizontalHeaderLabels({trans["session_col_port"], trans["session_col_status"],
+                                                 trans["session_col_rx_bytes"], trans["session_col_lines"],
+                                                 trans["session_col_values"], trans["session_col_rx_rate"]});
+        sessionPlotWidget->setPlotTexts(trans["session_plot_title"], trans["plot_value"],
+                                        trans["plot_points"], trans["plot_waiting"]);
+    }
+    
+    // Update network address
+    if (addressLabel) {
+        addressLabel->setText(trans["address"]);
+    }
+    
+    // Update bridge controls
+    if (bridgeButton) {
+        bridgePortLabel->setText(trans["bridge_to"]);
+        bridgeButton->setText(bridgeTimer->isActive() ? trans["bridge_stop"] : trans["bridge_start"]);
+    }
+#endif
+#ifdef HAVE_VIRTUAL_PORT
+    // Update simulator controls
+    if (simulatorPatternCombo) {
+        simulatorLabel->setText(trans["simulator"]);
+        simulatorPatternCombo->setItemText(SimulatorConfig::CsvLines, trans["sim_csv"]);
+        simulatorPatternCombo->setItemText(SimulatorConfig::BinaryFrames, trans["sim_frames"]);
+        simulatorPatternCombo->setItemText(SimulatorConfig::Bursts, trans["sim_bursts"]);
+        simulatorRateSpinBox->setToolTip(trans["sim_rate_tip"]);
+        simulatorChannelsSpinBox->setToolTip(trans["sim_channels_tip"]);
+        simulatorBurstSpinBox->setToolTip(trans["sim_burst_tip"]);
+        simulatorEchoCheckBox->setText(trans["sim_echo"]);
+    }
+#endif
+    
     // Group boxes
     ui->groupBox->setTitle(trans["port_settings"]);
     ui->groupBox_2->setTitle(trans["receive"]);
@@ -746,9 +1190,15 @@ void MainWindow::retranslateUI()
     ui->sendNewLineCheck->setText(trans["add_newline"]);
     
     // Open/Close button
-    if (serialPort->isOpen()) {
+    if (transport->isOpen()) {
         ui->openButton->setText(trans["close_port"]);
-        statusLabel->setText(trans["status_connected"] + serialPort->portName());
+        statusLabel->setText(trans["status_connected"] + transport->config().displayName());
+#ifndef __EMSCRIPTEN__
+    } else if (bridgeTimer->isActive()) {
+        ui->openButton->setText(trans["open_port"]);
+        statusLabel->setText(trans["status_connected"] + mainPortConfig().portName + " <-> "
+                             + bridgePortCombo->currentData().toString());
+#endif
     } else {
         ui->openButton->setText(trans["open_port"]);
         statusLabel->setText(trans["status_disconnected"]);
@@ -773,6 +1223,15 @@ void MainWindow::retranslateUI()
     ui->actionExit->setText(trans["exit"]);
     ui->actionClearAll->setText(trans["clear_all"]);
     ui->actionAbout->setText(trans["about"]);
+    if (actionExportPlot) {
+        actionExportPlot->setText(trans["export_plot"]);
+    }
+    if (actionCompressHistory) {
+        actionCompressHistory->setText(trans["compress_history"]);
+    }
+    if (actionSpillHistory) {
+        actionSpillHistory->setText(trans["spill_history"]);
+    }
     
     // Update status labels
     rxLabel->setText(QString("RX: %1 bytes").arg(rxBytes));
@@ -788,6 +1247,81 @@ void MainWindow::retranslateUI()
     if (addCarriageReturnCheckBox) {
         addCarriageReturnCheckBox->setText(trans["add_cr"]);
     }
+    if (fileSendButton) {
+        bool sending = fileSender->isSending();
+#ifndef __EMSCRIPTEN__
+        sending = sending || fileTransfer->isRunning();
+#endif
+        fileSendButton->setText(sending ? trans["file_send_cancel"] : trans["file_send"]);
+        fileProtocolLabel->setText(trans["file_protocol"]);
+        fileProtocolCombo->setItemText(0, trans["file_protocol_raw"]);
+        fileChunkLabel->setText(trans["file_chunk"]);
+        fileChunkDelayLabel->setText(trans["file_chunk_delay"]);
+        fileLineDelayLabel->setText(trans["file_line_delay"]);
+        flowControlCheckBox->setText(trans["flow_rts_cts"]);
+        txLimitLabel->setText(trans["tx_limit"]);
+    }
+    
+    if (derivedGroup) {
+        derivedGroup->setTitle(trans["derived_channels"]);
+        derivedApplyButton->setText(trans["derived_apply"]);
+    }
+    
+    if (filterGroup) {
+        filterGroup->setTitle(trans["filter_channels"]);
+        filterChannelLabel->setText(trans["filter_channel"]);
+        filterApplyButton->setText(trans["filter_apply"]);
+        int typeIndex = filterTypeCombo->currentIndex();
+        filterTypeCombo->blockSignals(true);
+        filterTypeCombo->clear();
+        filterTypeCombo->addItems({trans["filter_off"], trans["filter_ma"], trans["filter_ema"],
+                                   trans["filter_lowpass"], trans["filter_highpass"],
+                                   trans["filter_bandpass"], trans["filter_fir"]});
+        filterTypeCombo->setCurrentIndex(typeIndex);
+        filterTypeCombo->blockSignals(false);
+        updateFilterControls();
+    }
+    
+    if (xyGroup) {
+        xyGroup->setTitle(trans["xy_plot"]);
+        xyEnableCheckBox->setText(trans["xy_enable"]);
+        xyXLabel->setText(trans["xy_x"]);
+        xyYLabel->setText(trans["xy_y"]);
+        xyConnectCheckBox->setText(trans["xy_connect"]);
+        xyDepthLabel->setText(trans["xy_depth"]);
+        int pairingIndex = xyPairingCombo->currentIndex();
+        xyPairingCombo->blockSignals(true);
+        xyPairingCombo->clear();
+        xyPairingCombo->addItems({trans["xy_by_index"], trans["xy_by_time"]});
+        xyPairingCombo->setCurrentIndex(pairingIndex);
+        xyPairingCombo->blockSignals(false);
+    }
+    
+    // Update trigger controls
+    if (triggerGroup) {
+        triggerGroup->setTitle(trans["trigger"]);
+        triggerChannelLabel->setText(trans["trigger_channel"]);
+        triggerLevelLabel->setText(trans["trigger_level"]);
+        triggerPreLabel->setText(trans["trigger_pre"]);
+        triggerPostLabel->setText(trans["trigger_post"]);
+        triggerHoldoffLabel->setText(trans["trigger_holdoff"]);
+        triggerArmButton->setText(trans["trigger_arm"]);
+        
+        // Repopulate without re-arming the trigger
+        int modeIndex = triggerModeCombo->currentIndex();
+        triggerModeCombo->blockSignals(true);
+        triggerModeCombo->clear();
+        triggerModeCombo->addItems({trans["trigger_off"], trans["trigger_normal"], trans["trigger_single"]});
+        triggerModeCombo->setCurrentIndex(modeIndex);
+        triggerModeCombo->blockSignals(false);
+        
+        int edgeIndex = triggerEdgeCombo->currentIndex();
+        triggerEdgeCombo->blockSignals(true);
+        triggerEdgeCombo->clear();
+        triggerEdgeCombo->addItems({trans["trigger_rising"], trans["trigger_falling"]});
+        triggerEdgeCombo->setCurrentIndex(edgeIndex);
+        triggerEdgeCombo->blockSignals(false);
+    }
     
     // Update command list dock widget
     if (commandDock) {
@@ -799,13 +1333,23 @@ void MainWindow::retranslateUI()
     if (delCmdBtn) {
         delCmdBtn->setText(trans["delete_command"]);
     }
+    if (sendCmdBtn) {
+        sendCmdBtn->setText(trans["send_command"]);
+    }
+#ifndef __EMSCRIPTEN__
+    scriptLabel->setText(trans["script"]);
+    scriptRunButton->setText(scriptExecutor->isRunning() ? trans["script_stop"] : trans["script_run"]);
+#endif
     
     // Update example commands in the list
     if (commandListWidget && commandListWidget->count() == 3) {
         // Only update if these are still the default example commands
-        commandListWidget->item(0)->setText("CMD_1 | " + trans["example_command"] + " 1");
-        commandListWidget->item(1)->setText("CMD_2 | " + trans["example_command"] + " 2");
-        commandListWidget->item(2)->setText("CMD_3 | " + trans["example_command"] + " 3");
+        for (int i = 0; i < 3; ++i) {
+            commandEntries[i] = CommandEntry(QString("CMD_%1").arg(i + 1),
+                                             trans["example_command"] + QString(" %1").arg(i + 1),
+                                             false, QByteArray());
+            commandListWidget->item(i)->setText(commandEntries[i].displayText());
+        }
     }
     
 #ifdef Q_OS_ANDROID
@@ -837,6 +1381,8 @@ void MainWindow::setupAdvancedUI()
     // Create plot widget
     plotWidget = new PlotWidget(plotterSplitter);
     plotWidget->setMinimumHeight(200);
+    plotWidget->setMaxDataPoints(maxDataPoints);
+    plotWidget->setChannelStore(&channelStore);
     
     // Create text info area
     plotterTextEdit = new QTextEdit(plotterSplitter);
@@ -868,12 +1414,24 @@ void MainWindow::setupAdvancedUI()
         "}"
     );
     
+    setupTriggerUI(plotterTab, plotterLayout);
+    setupDerivedUI(plotterTab, plotterLayout);
+    setupFilterUI(plotterTab, plotterLayout);
+    setupXYUI(plotterTab, plotterLayout);
     plotterLayout->addWidget(plotterSplitter);
     
     // Add tabs with proper text
     QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
     mainTabWidget->addTab(currentCentral, trans["tab_main"]);
     mainTabWidget->addTab(plotterTab, trans["tab_plotter"]);
+    mainTabWidget->addTab(setupHistogramTab(), trans["tab_histogram"]);
+    mainTabWidget->addTab(setupSpectrumTab(), trans["tab_spectrum"]);
+    mainTabWidget->addTab(setupLatencyTab(), trans["tab_latency"]);
+#ifndef __EMSCRIPTEN__
+    mainTabWidget->addTab(setupBertTab(), trans["tab_bert"]);
+    mainTabWidget->addTab(setupSessionsTab(), trans["tab_sessions"]);
+#endif
+    mainTabWidget->addTab(setupMetricsTab(), trans["tab_metrics"]);
     
     // Set tab bar style and properties
     mainTabWidget->setTabPosition(QTabWidget::North);
@@ -940,17 +1498,38 @@ void MainWindow::setupAdvancedUI()
     QVBoxLayout *commandLayout = new QVBoxLayout(commandWidget);
     
     commandListWidget = new QListWidget(commandWidget);
-    commandListWidget->addItem("CMD_1 | " + trans["example_command"] + " 1");
-    commandListWidget->addItem("CMD_2 | " + trans["example_command"] + " 2");
-    commandListWidget->addItem("CMD_3 | " + trans["example_command"] + " 3");
+    for (int i = 1; i <= 3; ++i) {
+        appendCommand(CommandEntry(QString("CMD_%1").arg(i),
+                                   trans["example_command"] + QString(" %1").arg(i),
+                                   false, QByteArray()));
+    }
     
+    sendCmdBtn = new QPushButton(trans["send_command"], commandWidget);
     addCmdBtn = new QPushButton(trans["add_command"], commandWidget);
     delCmdBtn = new QPushButton(trans["delete_command"], commandWidget);
     
     commandLayout->addWidget(commandListWidget);
+    commandLayout->addWidget(sendCmdBtn);
     commandLayout->addWidget(addCmdBtn);
     commandLayout->addWidget(delCmdBtn);
     
+#ifndef __EMSCRIPTEN__
+    scriptLabel = new QLabel(trans["script"], commandWidget);
+    scriptEdit = new QPlainTextEdit(commandWidget);
+    scriptEdit->setPlaceholderText("start:\nsend \"AT\\r\\n\"\nexpect \"OK\" 500 start\ndelay 100\nrepeat start 9");
+    scriptRunButton = new QPushButton(trans["script_run"], commandWidget);
+    scriptStatusLabel = new QLabel(commandWidget);
+    scriptStatusLabel->setWordWrap(true);
+    
+    commandLayout->addWidget(scriptLabel);
+    commandLayout->addWidget(scriptEdit);
+    commandLayout->addWidget(scriptRunButton);
+    commandLayout->addWidget(scriptStatusLabel);
+    
+    connect(scriptRunButton, &QPushButton::clicked, this, &MainWindow::runScript);
+    connect(scriptExecutor, &ScriptExecutor::finished, this, &MainWindow::onScriptFinished);
+#endif
+    
     commandDock->setWidget(commandWidget);
     addDockWidget(Qt::RightDockWidgetArea, commandDock);
     
@@ -962,6 +1541,17 @@ void MainWindow::setupAdvancedUI()
             this, &MainWindow::on_commandList_itemDoubleClicked);
     connect(addCmdBtn, &QPushButton::clicked, this, &MainWindow::addCommand);
     connect(delCmdBtn, &QPushButton::clicked, this, &MainWindow::deleteCommand);
+    connect(sendCmdBtn, &QPushButton::clicked, this, [this]() {
+        sendCommand(commandListWidget->currentRow());
+    });
+    
+    // Ctrl+1 .. Ctrl+9 send the first nine commands
+    for (int i = 0; i < 9; ++i) {
+        QShortcut *shortcut = new QShortcut(QKeySequence(QString("Ctrl+%1").arg(i + 1)), this);
+        connect(shortcut, &QShortcut::activated, this, [this, i]() {
+            sendCommand(i);
+        });
+    }
     
     // Add auto-send controls to send group
     QWidget *sendWidget = ui->groupBox_3;
@@ -973,8 +1563,15 @@ void MainWindow::setupAdvancedUI()
         QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
         
         autoSendCheckBox = new QCheckBox(trans["auto_send"], sendWidget);
-        autoSendIntervalSpinBox = new QSpinBox(sendWidget);
+        autoSendIntervalSpinBox = new QDoubleSpinBox(sendWidget);
+#ifdef __EMSCRIPTEN__
         autoSendIntervalSpinBox->setRange(10, 10000);
+        autoSendIntervalSpinBox->setDecimals(0);
+#else
+        // The scheduler thread keeps sub-millisecond periods
+        autoSendIntervalSpinBox->setRange(0.1, 60000);
+        autoSendIntervalSpinBox->setDecimals(2);
+#endif
         autoSendIntervalSpinBox->setValue(1000);
         autoSendIntervalSpinBox->setSuffix(" ms");
         
@@ -985,70 +1582,2010 @@ void MainWindow::setupAdvancedUI()
         autoSendLayout->addWidget(autoSendIntervalSpinBox);
         autoSendLayout->addWidget(addLineBreakCheckBox);
         autoSendLayout->addWidget(addCarriageReturnCheckBox);
+#ifndef __EMSCRIPTEN__
+        autoSendJitterLabel = new QLabel(sendWidget);
+        autoSendLayout->addWidget(autoSendJitterLabel);
+#endif
         autoSendLayout->addStretch();
         
         sendLayout->insertLayout(sendLayout->count() - 1, autoSendLayout);
         
-        connect(autoSendCheckBox, &QCheckBox::toggled, [this](bool checked) {
-            if (checked) {
-                autoSendTimer->start(autoSendIntervalSpinBox->value());
-            } else {
-                autoSendTimer->stop();
-            }
-        });
+        connect(autoSendCheckBox, &QCheckBox::toggled, this, &MainWindow::updateAutoSend);
+        connect(autoSendIntervalSpinBox, SIGNAL(valueChanged(double)), 
+                this, SLOT(on_autoSendInterval_changed(double)));
         
-        connect(autoSendIntervalSpinBox, SIGNAL(valueChanged(int)), 
-                this, SLOT(on_autoSendInterval_changed(int)));
-    }
-}
-
-void MainWindow::on_autoSendTimer_timeout()
-{
-    if (serialPort->isOpen() && !ui->sendText->toPlainText().isEmpty()) {
-        on_sendButton_clicked();
+        // The scheduler sends a pre-encoded payload; re-encode on edits
+        connect(ui->sendText, &QTextEdit::textChanged, this, &MainWindow::refreshAutoSendPayload);
+        connect(ui->hexSendCheck, &QCheckBox::toggled, this, &MainWindow::refreshAutoSendPayload);
+        connect(ui->sendNewLineCheck, &QCheckBox::toggled, this, &MainWindow::refreshAutoSendPayload);
+        connect(addLineBreakCheckBox, &QCheckBox::toggled, this, &MainWindow::refreshAutoSendPayload);
+        connect(addCarriageReturnCheckBox, &QCheckBox::toggled, this, &MainWindow::refreshAutoSendPayload);
+#ifndef __EMSCRIPTEN__
+        connect(sendScheduler, &SendScheduler::failed, this, &MainWindow::onAutoSendFailed);
+        sendScheduler->setLatencyMeter(&latencyMeter);
+#endif
+        
+        setupFileSendUI(sendWidget, sendLayout);
     }
-}
-
-void MainWindow::on_commandList_itemDoubleClicked(QListWidgetItem *item)
-{
-    if (!item) return;
     
-    QString text = item->text();
-    int separatorPos = text.indexOf('|');
-    if (separatorPos > 0) {
-        QString command = text.mid(separatorPos + 1).trimmed();
-        ui->sendText->setPlainText(command);
-    }
+#ifndef __EMSCRIPTEN__
+    setupTransportUI();
+    setupBridgeUI();
+    refreshExtraPortLists();
+#endif
+#ifdef HAVE_VIRTUAL_PORT
+    setupSimulatorUI();
+#endif
+    setupExportUI();
 }
 
-void MainWindow::addCommand()
+void MainWindow::setupFileSendUI(QWidget *parent, QVBoxLayout *layout)
 {
-    QString currentText = ui->sendText->toPlainText();
-    if (currentText.isEmpty()) return;
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
     
-    int cmdNum = commandListWidget->count() + 1;
-    QString cmdName = QString("CMD_%1").arg(cmdNum);
-    QString cmdItem = QString("%1 | %2").arg(cmdName).arg(currentText);
+    QHBoxLayout *fileSendLayout = new QHBoxLayout();
     
-    commandListWidget->addItem(cmdItem);
-}
-
-void MainWindow::deleteCommand()
-{
-    QListWidgetItem *item = commandListWidget->currentItem();
-    if (item) {
-        delete item;
-    }
+    fileSendButton = new QPushButton(trans["file_send"], parent);
+    
+    // Raw streams the file as is; the others wait for a receiving program
+    fileProtocolLabel = new QLabel(trans["file_protocol"], parent);
+    fileProtocolCombo = new QComboBox(parent);
+    fileProtocolCombo->addItem(trans["file_protocol_raw"]);
+#ifdef __EMSCRIPTEN__
+    // The transfer protocols need a worker thread
+    fileProtocolLabel->setVisible(false);
+    fileProtocolCombo->setVisible(false);
+#else
+    fileProtocolCombo->addItems({"XMODEM", "XMODEM-1K", "YMODEM", "ZMODEM"});
+#endif
+    
+    fileChunkLabel = new QLabel(trans["file_chunk"], parent);
+    fileChunkSpinBox = new QSpinBox(parent);
+    fileChunkSpinBox->setRange(1, 65536);
+    fileChunkSpinBox->setValue(1024);
+    fileChunkSpinBox->setSuffix(" B");
+    
+    fileChunkDelayLabel = new QLabel(trans["file_chunk_delay"], parent);
+    fileChunkDelaySpinBox = new QSpinBox(parent);
+    fileChunkDelaySpinBox->setRange(0, 10000);
+    fileChunkDelaySpinBox->setSuffix(" ms");
+    
+    // A non-zero line delay also splits chunks at line ends
+    fileLineDelayLabel = new QLabel(trans["file_line_delay"], parent);
+    fileLineDelaySpinBox = new QSpinBox(parent);
+    fileLineDelaySpinBox->setRange(0, 10000);
+    fileLineDelaySpinBox->setSuffix(" ms");
+    
+    flowControlCheckBox = new QCheckBox(trans["flow_rts_cts"], parent);
+#ifdef __EMSCRIPTEN__
+    // Web Serial ports are opened without flow control
+    flowControlCheckBox->setVisible(false);
+#endif
+    
+    txLimitLabel = new QLabel(trans["tx_limit"], parent);
+    txLimitSpinBox = new QSpinBox(parent);
+    txLimitSpinBox->setRange(1, 16384);
+    txLimitSpinBox->setValue(int(txQueue->highWaterMark() / 1024));
+    txLimitSpinBox->setSuffix(" KB");
+    
+    fileSendProgressBar = new QProgressBar(parent);
+    fileSendProgressBar->setRange(0, 1000);
+    fileSendProgressBar->setTextVisible(false);
+    fileSendProgressBar->setMaximumWidth(150);
+    fileSendProgressBar->hide();
+    fileSendStatusLabel = new QLabel(parent);
+    
+    fileSendLayout->addWidget(fileSendButton);
+    fileSendLayout->addWidget(fileProtocolLabel);
+    fileSendLayout->addWidget(fileProtocolCombo);
+    fileSendLayout->addWidget(fileChunkLabel);
+    fileSendLayout->addWidget(fileChunkSpinBox);
+    fileSendLayout->addWidget(fileChunkDelayLabel);
+    fileSendLayout->addWidget(fileChunkDelaySpinBox);
+    fileSendLayout->addWidget(fileLineDelayLabel);
+    fileSendLayout->addWidget(fileLineDelaySpinBox);
+    fileSendLayout->addWidget(flowControlCheckBox);
+    fileSendLayout->addWidget(txLimitLabel);
+    fileSendLayout->addWidget(txLimitSpinBox);
+    fileSendLayout->addWidget(fileSendProgressBar);
+    fileSendLayout->addWidget(fileSendStatusLabel);
+    fileSendLayout->addStretch();
+    
+    layout->insertLayout(layout->count() - 1, fileSendLayout);
+    
+    connect(fileSendButton, &QPushButton::clicked, this, &MainWindow::sendFile);
+    connect(fileSender, &FileSender::finished, this, &MainWindow::onFileSendFinished);
+#ifndef __EMSCRIPTEN__
+    connect(fileTransfer, &FileTransfer::finished, this, &MainWindow::onFileTransferFinished);
+#endif
+    connect(flowControlCheckBox, &QCheckBox::toggled, this, &MainWindow::applyFlowControl);
+    connect(txLimitSpinBox, SIGNAL(valueChanged(int)), this, SLOT(applyTransmitLimit()));
+}
+
+void MainWindow::sendFile()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    // The same button cancels a running transfer
+    if (fileSender->isSending()) {
+        fileSender->cancel();
+        return;
+    }
+#ifndef __EMSCRIPTEN__
+    if (fileTransfer->isRunning()) {
+        fileTransfer->cancel();
+        return;
+    }
+#endif
+    
+    if (!transport->isOpen()) {
+        QMessageBox::warning(this, trans["warning"], trans["open_port_first"]);
+        return;
+    }
+#ifndef __EMSCRIPTEN__
+    // The transfer protocols run on a thread that writes to the handle
+    QSerialPort::Handle handle = QSerialPort::Handle();
+    if (fileProtocolCombo->currentIndex() > 0 && !nativePortHandle(&handle)) {
+        return;
+    }
+#endif
+    
+    QString fileName = QFileDialog::getOpenFileName(this, trans["file_send"]);
+    if (fileName.isEmpty()) {
+        return;
+    }
+    
+    fileSendButton->setText(trans["file_send_cancel"]);
+    fileSendProgressBar->setValue(0);
+    fileSendProgressBar->show();
+    fileSendStatusLabel->clear();
+    
+    QString error;
+#ifndef __EMSCRIPTEN__
+    if (fileProtocolCombo->currentIndex() > 0) {
+        const FileTransfer::Protocol protocol = FileTransfer::Protocol(fileProtocolCombo->currentIndex() - 1);
+        if (!fileTransfer->startTransfer(handle, protocol, fileName,
+                                         transport->config().lineBytesPerSecond(), &error)) {
+            onFileTransferFinished(false, error);
+        }
+        return;
+    }
+#endif
+    if (!fileSender->start(fileName, fileChunkSpinBox->value(), fileChunkDelaySpinBox->value(),
+                           fileLineDelaySpinBox->value(), &error)) {
+        onFileSendFinished(false, error);
+    }
+}
+
+void MainWindow::onFileSendFinished(bool ok, const QString &error)
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    fileSendButton->setText(trans["file_send"]);
+    fileSendProgressBar->hide();
+    if (ok) {
+        fileSendStatusLabel->setText(QString("%1 bytes  %2 KB/s")
+                                     .arg(fileSender->totalBytes())
+                                     .arg(fileSender->throughput() / 1024.0, 0, 'f', 1));
+    } else {
+        fileSendStatusLabel->clear();
+        // Cancelled transfers finish without an error
+        if (!error.isEmpty()) {
+            QMessageBox::critical(this, trans["error"], trans["file_send_failed"] + "\n" + error);
+        }
+    }
+}
+
+#ifndef __EMSCRIPTEN__
+void MainWindow::onFileTransferFinished(bool ok, const QString &error)
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    fileSendButton->setText(trans["file_send"]);
+    fileSendProgressBar->hide();
+    if (ok) {
+        fileSendStatusLabel->setText(QString("%1 bytes  %2 KB/s  %3% of line rate  Retries=%4")
+                                     .arg(fileTransfer->totalBytes())
+                                     .arg(fileTransfer->throughput() / 1024.0, 0, 'f', 1)
+                                     .arg(fileTransfer->efficiency() * 100.0, 0, 'f', 0)
+                                     .arg(fileTransfer->retries()));
+    } else {
+        fileSendStatusLabel->clear();
+        if (!error.isEmpty()) {
+            QMessageBox::critical(this, trans["error"], trans["file_send_failed"] + "\n" + error);
+        }
+    }
+}
+
+bool MainWindow::nativePortHandle(QSerialPort::Handle *handle)
+{
+    if (transport->nativeHandle(handle)) {
+        return true;
+    }
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    QMessageBox::warning(this, trans["warning"], trans["transport_serial_only"]);
+    return false;
+}
+#endif
+
+void MainWindow::applyTransmitLimit()
+{
+    txQueue->setHighWaterMark(qint64(txLimitSpinBox->value()) * 1024);
+}
+
+void MainWindow::onTransmitFailed(const QString &error)
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    QMessageBox::critical(this, trans["error"], trans["tx_failed"] + "\n" + error);
+}
+
+void MainWindow::applyFlowControl()
+{
+    // With RTS/CTS the driver holds data back and bytesWritten() slows
+    // down, which is what paces the file sender
+    transport->setHardwareFlowControl(flowControlCheckBox->isChecked());
+}
+
+void MainWindow::setupExportUI()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    actionExportPlot = new QAction(trans["export_plot"], this);
+    ui->menuFile->insertAction(ui->actionExit, actionExportPlot);
+    ui->menuFile->insertSeparator(ui->actionExit);
+    connect(actionExportPlot, &QAction::triggered, this, &MainWindow::exportPlotData);
+    
+    actionCompressHistory = new QAction(trans["compress_history"], this);
+    actionCompressHistory->setCheckable(true);
+    ui->menuView->addSeparator();
+    ui->menuView->addAction(actionCompressHistory);
+    connect(actionCompressHistory, &QAction::toggled, this, &MainWindow::setCompressedHistory);
+    
+    actionSpillHistory = new QAction(trans["spill_history"], this);
+    actionSpillHistory->setCheckable(true);
+    ui->menuView->addAction(actionSpillHistory);
+    connect(actionSpillHistory, &QAction::toggled, this, &MainWindow::setSpilledHistory);
+#ifdef __EMSCRIPTEN__
+    // File mappings are not available in the browser
+    actionSpillHistory->setVisible(false);
+#else
+    // Reopen what the last session spilled, e.g. after a crash
+    QSettings settings(settingsFileName(), QSettings::IniFormat);
+    actionSpillHistory->setChecked(settings.value("history/spill", false).toBool());
+#endif
+    
+    // Only visible while an export is running
+    exportProgressBar = new QProgressBar(this);
+    exportProgressBar->setRange(0, 100);
+    exportProgressBar->setMaximumWidth(150);
+    exportProgressBar->hide();
+    ui->statusbar->addPermanentWidget(exportProgressBar);
+}
+
+void MainWindow::setCompressedHistory(bool enabled)
+{
+    channelStore.setCompression(enabled);
+    updateStoreRetention();
+}
+
+void MainWindow::setSpilledHistory(bool enabled)
+{
+#ifndef __EMSCRIPTEN__
+    QSettings settings(settingsFileName(), QSettings::IniFormat);
+    settings.setValue("history/spill", enabled);
+#endif
+    
+    // Retention goes up first so reopened segments are not trimmed away
+    updateStoreRetention();
+    if (!enabled) {
+        channelStore.setSpillDirectory(QString());
+        return;
+    }
+    
+    const QString path = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+                         + "/plot-history";
+    if (!channelStore.setSpillDirectory(path)) {
+        QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+        QMessageBox::critical(this, trans["error"], trans["spill_failed"] + "\n" + path);
+        // Unchecking stores the setting as off
+        actionSpillHistory->setChecked(false);
+        return;
+    }
+    
+    // Show whatever an earlier session left behind
+    plotWidget->dataAppended();
+}
+
+void MainWindow::updateStoreRetention()
+{
+    // The spectrum reads its window straight from the store
+    qint64 samples = qMax(maxDataPoints, spectrumWidget->fftSize());
+    if (xyEnableCheckBox->isChecked()) {
+        samples = qMax<qint64>(samples, xyDepthSpinBox->value());
+    }
+    if (channelStore.compression()) {
+        samples = qMax(samples, kCompressedHistorySamples);
+    }
+    if (actionSpillHistory && actionSpillHistory->isChecked()) {
+        samples = qMax(samples, kSpilledHistorySamples);
+    }
+    channelStore.setRetention(samples);
+}
+
+void MainWindow::exportPlotData()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    if (exportThread) {
+        QMessageBox::information(this, trans["menu_file"], trans["export_busy"]);
+        return;
+    }
+    
+    QString selectedFilter;
+    QString fileName = QFileDialog::getSaveFileName(this,
+        trans["export_plot"],
+        "",
+        trans["export_files"],
+        &selectedFilter);
+    
+    if (fileName.isEmpty()) {
+        return;
+    }
+    
+    PlotExporter::Format format = PlotExporter::Csv;
+    if (fileName.endsWith(".sdc", Qt::CaseInsensitive) || selectedFilter.contains("*.sdc")) {
+        format = PlotExporter::BinaryColumnar;
+    }
+    
+    QSharedPointer<ExportSource> source(new ChannelStoreExportSource(channelStore));
+    PlotExporter *exporter = new PlotExporter(fileName, format, source);
+    
+    exportProgressBar->setValue(0);
+    exportProgressBar->show();
+    connect(exporter, &PlotExporter::progress, exportProgressBar, &QProgressBar::setValue);
+    connect(exporter, &PlotExporter::finished, this, &MainWindow::onExportFinished);
+    
+#ifdef __EMSCRIPTEN__
+    // No worker threads in the WebAssembly build
+    exporter->run();
+    exporter->deleteLater();
+#else
+    exportThread = new QThread(this);
+    exporter->moveToThread(exportThread);
+    connect(exportThread.data(), &QThread::started, exporter, &PlotExporter::run);
+    connect(exporter, &PlotExporter::finished, exportThread.data(), &QThread::quit);
+    connect(exportThread.data(), &QThread::finished, exporter, &QObject::deleteLater);
+    connect(exportThread.data(), &QThread::finished, exportThread.data(), &QObject::deleteLater);
+    plotExporter = exporter;
+    exportThread->start();
+#endif
+}
+
+void MainWindow::onExportFinished(bool ok, const QString &fileName)
+{
+    Q_UNUSED(fileName);
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    exportProgressBar->hide();
+    if (ok) {
+        QMessageBox::information(this, trans["menu_file"], trans["export_success"]);
+    } else {
+        QMessageBox::critical(this, trans["error"], trans["export_failed"]);
+    }
+}
+
+void MainWindow::setupTriggerUI(QWidget *parent, QVBoxLayout *layout)
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    triggerGroup = new QGroupBox(trans["trigger"], parent);
+    QHBoxLayout *triggerLayout = new QHBoxLayout(triggerGroup);
+    triggerLayout->setContentsMargins(8, 4, 8, 4);
+    
+    triggerModeCombo = new QComboBox(triggerGroup);
+    triggerModeCombo->addItems({trans["trigger_off"], trans["trigger_normal"], trans["trigger_single"]});
+    
+    triggerChannelLabel = new QLabel(trans["trigger_channel"], triggerGroup);
+    triggerChannelSpinBox = new QSpinBox(triggerGroup);
+    triggerChannelSpinBox->setRange(1, 6);
+    
+    triggerEdgeCombo = new QComboBox(triggerGroup);
+    triggerEdgeCombo->addItems({trans["trigger_rising"], trans["trigger_falling"]});
+    
+    triggerLevelLabel = new QLabel(trans["trigger_level"], triggerGroup);
+    triggerLevelSpinBox = new QDoubleSpinBox(triggerGroup);
+    triggerLevelSpinBox->setRange(-1e9, 1e9);
+    triggerLevelSpinBox->setDecimals(3);
+    
+    // Window depth and holdoff are counted in samples of the trigger channel
+    triggerPreLabel = new QLabel(trans["trigger_pre"], triggerGroup);
+    triggerPreSpinBox = new QSpinBox(triggerGroup);
+    triggerPreSpinBox->setRange(0, 100000);
+    triggerPreSpinBox->setValue(100);
+    
+    triggerPostLabel = new QLabel(trans["trigger_post"], triggerGroup);
+    triggerPostSpinBox = new QSpinBox(triggerGroup);
+    triggerPostSpinBox->setRange(0, 100000);
+    triggerPostSpinBox->setValue(100);
+    
+    triggerHoldoffLabel = new QLabel(trans["trigger_holdoff"], triggerGroup);
+    triggerHoldoffSpinBox = new QSpinBox(triggerGroup);
+    triggerHoldoffSpinBox->setRange(0, 1000000);
+    
+    triggerArmButton = new QPushButton(trans["trigger_arm"], triggerGroup);
+    
+    triggerLayout->addWidget(triggerModeCombo);
+    triggerLayout->addWidget(triggerChannelLabel);
+    triggerLayout->addWidget(triggerChannelSpinBox);
+    triggerLayout->addWidget(triggerEdgeCombo);
+    triggerLayout->addWidget(triggerLevelLabel);
+    triggerLayout->addWidget(triggerLevelSpinBox);
+    triggerLayout->addWidget(triggerPreLabel);
+    triggerLayout->addWidget(triggerPreSpinBox);
+    triggerLayout->addWidget(triggerPostLabel);
+    triggerLayout->addWidget(triggerPostSpinBox);
+    triggerLayout->addWidget(triggerHoldoffLabel);
+    triggerLayout->addWidget(triggerHoldoffSpinBox);
+    triggerLayout->addWidget(triggerArmButton);
+    triggerLayout->addStretch();
+    
+    layout->addWidget(triggerGroup);
+    
+    connect(triggerModeCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(applyTriggerSettings()));
+    connect(triggerEdgeCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(applyTriggerSettings()));
+    connect(triggerChannelSpinBox, SIGNAL(valueChanged(int)), this, SLOT(applyTriggerSettings()));
+    connect(triggerLevelSpinBox, SIGNAL(valueChanged(double)), this, SLOT(applyTriggerSettings()));
+    connect(triggerPreSpinBox, SIGNAL(valueChanged(int)), this, SLOT(applyTriggerSettings()));
+    connect(triggerPostSpinBox, SIGNAL(valueChanged(int)), this, SLOT(applyTriggerSettings()));
+    connect(triggerHoldoffSpinBox, SIGNAL(valueChanged(int)), this, SLOT(applyTriggerSettings()));
+    connect(triggerArmButton, &QPushButton::clicked, this, &MainWindow::armTrigger);
+    
+    applyTriggerSettings();
+}
+
+void MainWindow::applyTriggerSettings()
+{
+    triggerDetector.setSourceChannel(triggerChannelSpinBox->value() - 1);
+    triggerDetector.setEdge(static_cast<TriggerDetector::Edge>(triggerEdgeCombo->currentIndex()));
+    triggerDetector.setLevel(triggerLevelSpinBox->value());
+    triggerDetector.setHoldoff(triggerHoldoffSpinBox->value());
+    triggerDetector.setDepth(triggerPreSpinBox->value(), triggerPostSpinBox->value());
+    
+    // Changing any setting re-arms, like on a bench scope
+    TriggerDetector::Mode mode = static_cast<TriggerDetector::Mode>(triggerModeCombo->currentIndex());
+    triggerDetector.setMode(mode);
+    
+    if (mode == TriggerDetector::Off) {
+        plotWidget->releaseCapture();
+    }
+    triggerArmButton->setEnabled(mode != TriggerDetector::Off);
+}
+
+void MainWindow::armTrigger()
+{
+    triggerDetector.arm();
+}
+
+void MainWindow::setupDerivedUI(QWidget *parent, QVBoxLayout *layout)
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    derivedGroup = new QGroupBox(trans["derived_channels"], parent);
+    QHBoxLayout *derivedLayout = new QHBoxLayout(derivedGroup);
+    derivedLayout->setContentsMargins(8, 4, 8, 4);
+    
+    derivedEdit = new QLineEdit(derivedGroup);
+    derivedEdit->setPlaceholderText("ch1*ch2; (ch3-ch4)/2; abs(ch5); movavg(ch1, 50)");
+    derivedApplyButton = new QPushButton(trans["derived_apply"], derivedGroup);
+    
+    derivedLayout->addWidget(derivedEdit, 1);
+    derivedLayout->addWidget(derivedApplyButton);
+    layout->addWidget(derivedGroup);
+    
+    // Rows are evaluated in batches; a short timer bounds the added latency
+    batchTimer->setSingleShot(true);
+    batchTimer->setInterval(kBatchFlushMs);
+    connect(batchTimer, &QTimer::timeout, this, &MainWindow::flushBatchedChannels);
+    connect(derivedApplyButton, &QPushButton::clicked, this, &MainWindow::applyDerivedChannels);
+    connect(derivedEdit, &QLineEdit::returnPressed, this, &MainWindow::applyDerivedChannels);
+}
+
+void MainWindow::applyDerivedChannels()
+{
+    // Buffered rows belong to the current layout
+    flushBatchedChannels();
+    
+    QStringList errors;
+    if (!derivedChannels.setExpressions(derivedEdit->text().split(';'), &errors)) {
+        QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+        QMessageBox::warning(this, trans["warning"], trans["derived_error"] + "\n\n" + errors.join("\n"));
+        return;
+    }
+    
+    // Derived history restarts whenever the expressions change, and the
+    // filtered channels behind them move
+    rebuildVirtualChannels(kParsedChannels);
+}
+
+void MainWindow::setupFilterUI(QWidget *parent, QVBoxLayout *layout)
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    filterGroup = new QGroupBox(trans["filter_channels"], parent);
+    QHBoxLayout *filterLayout = new QHBoxLayout(filterGroup);
+    filterLayout->setContentsMargins(8, 4, 8, 4);
+    
+    filterChannelLabel = new QLabel(trans["filter_channel"], filterGroup);
+    filterChannelSpinBox = new QSpinBox(filterGroup);
+    filterChannelSpinBox->setRange(1, FilterStage::Channels);
+    
+    filterTypeCombo = new QComboBox(filterGroup);
+    filterTypeCombo->addItems({trans["filter_off"], trans["filter_ma"], trans["filter_ema"],
+                               trans["filter_lowpass"], trans["filter_highpass"],
+                               trans["filter_bandpass"], trans["filter_fir"]});
+    
+    // Length in samples, smoothing factor, or cutoff as a fraction of the
+    // sample rate, depending on the filter type
+    filterParamLabel = new QLabel(filterGroup);
+    filterParamSpinBox = new QDoubleSpinBox(filterGroup);
+    filterParamSpinBox->setDecimals(4);
+    
+    filterTapsEdit = new QLineEdit(filterGroup);
+    filterTapsEdit->setPlaceholderText("0.25 0.5 0.25");
+    
+    filterApplyButton = new QPushButton(trans["filter_apply"], filterGroup);
+    
+    filterLayout->addWidget(filterChannelLabel);
+    filterLayout->addWidget(filterChannelSpinBox);
+    filterLayout->addWidget(filterTypeCombo);
+    filterLayout->addWidget(filterParamLabel);
+    filterLayout->addWidget(filterParamSpinBox);
+    filterLayout->addWidget(filterTapsEdit, 1);
+    filterLayout->addWidget(filterApplyButton);
+    layout->addWidget(filterGroup);
+    
+    updateFilterControls();
+    
+    connect(filterTypeCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(updateFilterControls()));
+    connect(filterApplyButton, &QPushButton::clicked, this, &MainWindow::applyChannelFilter);
+    connect(filterTapsEdit, &QLineEdit::returnPressed, this, &MainWindow::applyChannelFilter);
+}
+
+void MainWindow::updateFilterControls()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    // Combo rows follow ChannelFilter::Type
+    const ChannelFilter::Type type = static_cast<ChannelFilter::Type>(filterTypeCombo->currentIndex());
+    filterParamSpinBox->blockSignals(true);
+    switch (type) {
+    case ChannelFilter::MovingAverage:
+        filterParamLabel->setText(trans["filter_length"]);
+        filterParamSpinBox->setDecimals(0);
+        filterParamSpinBox->setRange(1, 100000);
+        filterParamSpinBox->setSingleStep(1);
+        break;
+    case ChannelFilter::ExponentialAverage:
+        filterParamLabel->setText(trans["filter_alpha"]);
+        filterParamSpinBox->setDecimals(4);
+        filterParamSpinBox->setRange(0.0001, 1.0);
+        filterParamSpinBox->setSingleStep(0.01);
+        break;
+    case ChannelFilter::LowPass:
+    case ChannelFilter::HighPass:
+    case ChannelFilter::BandPass:
+        filterParamLabel->setText(trans["filter_cutoff"]);
+        filterParamSpinBox->setDecimals(4);
+        filterParamSpinBox->setRange(0.0001, 0.4999);
+        filterParamSpinBox->setSingleStep(0.01);
+        break;
+    default:
+        filterParamLabel->setText(trans["filter_taps"]);
+        break;
+    }
+    filterParamSpinBox->blockSignals(false);
+    
+    const bool hasParam = type != ChannelFilter::None && type != ChannelFilter::Fir;
+    filterParamLabel->setVisible(hasParam || type == ChannelFilter::Fir);
+    filterParamSpinBox->setVisible(hasParam);
+    filterTapsEdit->setVisible(type == ChannelFilter::Fir);
+}
+
+void MainWindow::applyChannelFilter()
+{
+    const int channel = filterChannelSpinBox->value() - 1;
+    const double param = filterParamSpinBox->value();
+    ChannelFilter filter;
+    
+    switch (static_cast<ChannelFilter::Type>(filterTypeCombo->currentIndex())) {
+    case ChannelFilter::MovingAverage:
+        filter = ChannelFilter::movingAverage(qRound(param));
+        break;
+    case ChannelFilter::ExponentialAverage:
+        filter = ChannelFilter::exponential(param);
+        break;
+    case ChannelFilter::LowPass:
+        filter = ChannelFilter::biquad(ChannelFilter::LowPass, param, kButterworthQ);
+        break;
+    case ChannelFilter::HighPass:
+        filter = ChannelFilter::biquad(ChannelFilter::HighPass, param, kButterworthQ);
+        break;
+    case ChannelFilter::BandPass:
+        filter = ChannelFilter::biquad(ChannelFilter::BandPass, param, 1.0);
+        break;
+    case ChannelFilter::Fir: {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        QStringList parts = filterTapsEdit->text().split(QRegularExpression("[,;\\s]+"), Qt::SkipEmptyParts);
+#else
+        QStringList parts = filterTapsEdit->text().split(QRegularExpression("[,;\\s]+"), QString::SkipEmptyParts);
+#endif
+        QVector<double> taps;
+        for (const QString &part : parts) {
+            bool ok;
+            double tap = part.toDouble(&ok);
+            if (!ok) {
+                taps.clear();
+                break;
+            }
+            taps.append(tap);
+        }
+        if (taps.isEmpty()) {
+            QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+            QMessageBox::warning(this, trans["warning"], trans["filter_error"]);
+            return;
+        }
+        filter = ChannelFilter::fir(taps);
+        break;
+    }
+    default:
+        break;
+    }
+    
+    flushBatchedChannels();
+    filterStage.setFilter(channel, filter);
+    
+    // Only the filtered channels are rebuilt; derived history is kept
+    rebuildVirtualChannels(kParsedChannels + derivedChannels.count());
+}
+
+void MainWindow::rebuildVirtualChannels(int firstChanged)
+{
+    // Store layout: parsed channels, then derived, then one filtered copy
+    // per parsed channel with an active filter
+    for (int i = firstChanged; i < channelStore.channelCount(); ++i) {
+        channelStore.clearChannel(i);
+    }
+    
+    int total = kParsedChannels + derivedChannels.count();
+    filterTargets = QVector<int>(FilterStage::Channels, -1);
+    for (int c = 0; c < FilterStage::Channels; ++c) {
+        if (filterStage.isActive(c)) {
+            filterTargets[c] = total++;
+        }
+    }
+    
+    channelStore.setChannelCount(total);
+    plotWidget->setChannelCount(total);
+    xyXSpinBox->setMaximum(total);
+    xyYSpinBox->setMaximum(total);
+    for (int i = 0; i < derivedChannels.count(); ++i) {
+        channelStore.setChannelName(kParsedChannels + i, derivedChannels.source(i));
+        plotWidget->setChannelName(kParsedChannels + i, derivedChannels.source(i));
+    }
+    for (int c = 0; c < FilterStage::Channels; ++c) {
+        if (filterTargets[c] >= 0) {
+            const QString name = channelStore.channelName(c) + " " + filterStage.filter(c).description();
+            channelStore.setChannelName(filterTargets[c], name);
+            plotWidget->setChannelName(filterTargets[c], name);
+        }
+    }
+    plotWidget->dataAppended();
+}
+
+void MainWindow::setupXYUI(QWidget *parent, QVBoxLayout *layout)
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    xyGroup = new QGroupBox(trans["xy_plot"], parent);
+    QHBoxLayout *xyLayout = new QHBoxLayout(xyGroup);
+    xyLayout->setContentsMargins(8, 4, 8, 4);
+    
+    xyEnableCheckBox = new QCheckBox(trans["xy_enable"], xyGroup);
+    
+    xyXLabel = new QLabel(trans["xy_x"], xyGroup);
+    xyXSpinBox = new QSpinBox(xyGroup);
+    xyXSpinBox->setRange(1, kParsedChannels);
+    xyXSpinBox->setValue(1);
+    
+    xyYLabel = new QLabel(trans["xy_y"], xyGroup);
+    xyYSpinBox = new QSpinBox(xyGroup);
+    xyYSpinBox->setRange(1, kParsedChannels);
+    xyYSpinBox->setValue(2);
+    
+    xyPairingCombo = new QComboBox(xyGroup);
+    xyPairingCombo->addItems({trans["xy_by_index"], trans["xy_by_time"]});
+    
+    xyConnectCheckBox = new QCheckBox(trans["xy_connect"], xyGroup);
+    xyConnectCheckBox->setChecked(true);
+    
+    // Pairs beyond the pixel budget are drawn as a density map, so this
+    // can go far past the time plot's window
+    xyDepthLabel = new QLabel(trans["xy_depth"], xyGroup);
+    xyDepthSpinBox = new QSpinBox(xyGroup);
+    xyDepthSpinBox->setRange(2, 10000000);
+    xyDepthSpinBox->setSingleStep(1000);
+    xyDepthSpinBox->setValue(10000);
+    
+    xyLayout->addWidget(xyEnableCheckBox);
+    xyLayout->addWidget(xyXLabel);
+    xyLayout->addWidget(xyXSpinBox);
+    xyLayout->addWidget(xyYLabel);
+    xyLayout->addWidget(xyYSpinBox);
+    xyLayout->addWidget(xyPairingCombo);
+    xyLayout->addWidget(xyConnectCheckBox);
+    xyLayout->addWidget(xyDepthLabel);
+    xyLayout->addWidget(xyDepthSpinBox);
+    xyLayout->addStretch();
+    layout->addWidget(xyGroup);
+    
+    connect(xyEnableCheckBox, &QCheckBox::toggled, this, &MainWindow::applyXYSettings);
+    connect(xyXSpinBox, SIGNAL(valueChanged(int)), this, SLOT(applyXYSettings()));
+    connect(xyYSpinBox, SIGNAL(valueChanged(int)), this, SLOT(applyXYSettings()));
+    connect(xyPairingCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(applyXYSettings()));
+    connect(xyConnectCheckBox, &QCheckBox::toggled, this, &MainWindow::applyXYSettings);
+    connect(xyDepthSpinBox, SIGNAL(valueChanged(int)), this, SLOT(applyXYSettings()));
+}
+
+void MainWindow::applyXYSettings()
+{
+    // The store has to retain the XY depth before the plot asks for it
+    updateStoreRetention();
+    plotWidget->setXYMode(xyEnableCheckBox->isChecked(),
+                          xyXSpinBox->value() - 1, xyYSpinBox->value() - 1,
+                          static_cast<PlotWidget::Pairing>(xyPairingCombo->currentIndex()),
+                          xyConnectCheckBox->isChecked(), xyDepthSpinBox->value());
+}
+
+void MainWindow::flushBatchedChannels()
+{
+    PipelineMetrics::StageTimer timer(&pipelineMetrics, PipelineSnapshot::PlotIngest);
+    batchTimer->stop();
+    bool appended = false;
+    if (derivedChannels.pendingRows() > 0) {
+        derivedChannels.flush(&channelStore, kParsedChannels);
+        appended = true;
+    }
+    if (filterStage.hasPending()) {
+        filterStage.flush(&channelStore, filterTargets);
+        appended = true;
+    }
+    if (appended) {
+        plotWidget->dataAppended();
+    }
+}
+
+QWidget *MainWindow::setupSpectrumTab()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    QWidget *spectrumTab = new QWidget(this);
+    QVBoxLayout *spectrumLayout = new QVBoxLayout(spectrumTab);
+    spectrumLayout->setContentsMargins(0, 0, 0, 0);
+    
+    QHBoxLayout *controlsLayout = new QHBoxLayout();
+    controlsLayout->setContentsMargins(8, 4, 8, 4);
+    
+    spectrumWindowLabel = new QLabel(trans["spectrum_window"], spectrumTab);
+    spectrumWindowCombo = new QComboBox(spectrumTab);
+    spectrumWindowCombo->addItems({trans["window_hann"], trans["window_hamming"], trans["window_blackman"]});
+    
+    spectrumSizeLabel = new QLabel(trans["spectrum_size"], spectrumTab);
+    spectrumSizeCombo = new QComboBox(spectrumTab);
+    for (int size = Fft::MinSize; size <= Fft::MaxSize; size *= 2) {
+        spectrumSizeCombo->addItem(QString::number(size), size);
+    }
+    spectrumSizeCombo->setCurrentText("1024");
+    
+    // 0 Hz means unknown rate, the axis then shows cycles per sample
+    spectrumRateLabel = new QLabel(trans["spectrum_rate"], spectrumTab);
+    spectrumRateSpinBox = new QDoubleSpinBox(spectrumTab);
+    spectrumRateSpinBox->setRange(0.0, 10000000.0);
+    spectrumRateSpinBox->setDecimals(1);
+    spectrumRateSpinBox->setSuffix(" Hz");
+    
+    controlsLayout->addWidget(spectrumWindowLabel);
+    controlsLayout->addWidget(spectrumWindowCombo);
+    controlsLayout->addWidget(spectrumSizeLabel);
+    controlsLayout->addWidget(spectrumSizeCombo);
+    controlsLayout->addWidget(spectrumRateLabel);
+    controlsLayout->addWidget(spectrumRateSpinBox);
+    
+    for (int i = 0; i < 6; ++i) {
+        QCheckBox *check = new QCheckBox(QString("Ch%1").arg(i + 1), spectrumTab);
+        check->setChecked(i == 0);
+        controlsLayout->addWidget(check);
+        spectrumChannelChecks.append(check);
+        connect(check, SIGNAL(toggled(bool)), this, SLOT(applySpectrumSettings()));
+    }
+    controlsLayout->addStretch();
+    
+    spectrumWidget = new SpectrumWidget(spectrumTab);
+    spectrumWidget->setChannelStore(&channelStore);
+    
+    spectrumLayout->addLayout(controlsLayout);
+    spectrumLayout->addWidget(spectrumWidget, 1);
+    
+    connect(spectrumWindowCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(applySpectrumSettings()));
+    connect(spectrumSizeCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(applySpectrumSettings()));
+    connect(spectrumRateSpinBox, SIGNAL(valueChanged(double)), this, SLOT(applySpectrumSettings()));
+    
+    applySpectrumSettings();
+    return spectrumTab;
+}
+
+QWidget *MainWindow::setupHistogramTab()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    QWidget *histogramTab = new QWidget(this);
+    QVBoxLayout *histogramLayout = new QVBoxLayout(histogramTab);
+    histogramLayout->setContentsMargins(0, 0, 0, 0);
+    
+    QHBoxLayout *controlsLayout = new QHBoxLayout();
+    controlsLayout->setContentsMargins(8, 4, 8, 4);
+    
+    histogramBinsLabel = new QLabel(trans["histogram_bins"], histogramTab);
+    histogramBinsSpinBox = new QSpinBox(histogramTab);
+    histogramBinsSpinBox->setRange(2, 1000);
+    histogramBinsSpinBox->setValue(50);
+    
+    // Samples per channel the histogram covers; older ones are evicted
+    histogramWindowLabel = new QLabel(trans["histogram_window"], histogramTab);
+    histogramWindowSpinBox = new QSpinBox(histogramTab);
+    histogramWindowSpinBox->setRange(10, 10000000);
+    histogramWindowSpinBox->setSingleStep(1000);
+    histogramWindowSpinBox->setValue(10000);
+    
+    histogramRangeCombo = new QComboBox(histogramTab);
+    histogramRangeCombo->addItems({trans["histogram_auto"], trans["histogram_fixed"]});
+    
+    histogramMinSpinBox = new QDoubleSpinBox(histogramTab);
+    histogramMinSpinBox->setRange(-1e9, 1e9);
+    histogramMinSpinBox->setDecimals(3);
+    histogramMinSpinBox->setValue(-1.0);
+    histogramMaxSpinBox = new QDoubleSpinBox(histogramTab);
+    histogramMaxSpinBox->setRange(-1e9, 1e9);
+    histogramMaxSpinBox->setDecimals(3);
+    histogramMaxSpinBox->setValue(1.0);
+    
+    histogramApplyButton = new QPushButton(trans["histogram_apply"], histogramTab);
+    
+    controlsLayout->addWidget(histogramBinsLabel);
+    controlsLayout->addWidget(histogramBinsSpinBox);
+    controlsLayout->addWidget(histogramWindowLabel);
+    controlsLayout->addWidget(histogramWindowSpinBox);
+    controlsLayout->addWidget(histogramRangeCombo);
+    controlsLayout->addWidget(histogramMinSpinBox);
+    controlsLayout->addWidget(histogramMaxSpinBox);
+    controlsLayout->addWidget(histogramApplyButton);
+    
+    histogramWidget = new HistogramWidget(histogramTab);
+    
+    for (int i = 0; i < 6; ++i) {
+        QCheckBox *check = new QCheckBox(QString("Ch%1").arg(i + 1), histogramTab);
+        check->setChecked(i == 0);
+        controlsLayout->addWidget(check);
+        histogramChannelChecks.append(check);
+        connect(check, &QCheckBox::toggled, this, [this, i](bool checked) {
+            histogramWidget->setChannelEnabled(i, checked);
+        });
+    }
+    controlsLayout->addStretch();
+    
+    histogramLayout->addLayout(controlsLayout);
+    histogramLayout->addWidget(histogramWidget, 1);
+    
+    // Bins, window and range rebuild the histograms, so they wait for Apply
+    connect(histogramApplyButton, &QPushButton::clicked, this, &MainWindow::applyHistogramSettings);
+    connect(histogramRangeCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(applyHistogramSettings()));
+    
+    applyHistogramSettings();
+    return histogramTab;
+}
+
+QWidget *MainWindow::setupLatencyTab()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    QWidget *latencyTab = new QWidget(this);
+    QVBoxLayout *latencyLayout = new QVBoxLayout(latencyTab);
+    latencyLayout->setContentsMargins(0, 0, 0, 0);
+    
+    QHBoxLayout *controlsLayout = new QHBoxLayout();
+    controlsLayout->setContentsMargins(8, 4, 8, 4);
+    
+    latencyEnableCheckBox = new QCheckBox(trans["latency_enable"], latencyTab);
+    
+    // What closes a measurement: any reply, a line end or a pattern
+    latencyModeCombo = new QComboBox(latencyTab);
+    latencyModeCombo->addItems({trans["latency_any"], trans["latency_line"], trans["latency_pattern"]});
+    latencyPatternEdit = new QLineEdit(latencyTab);
+    latencyPatternEdit->setPlaceholderText("OK\\r\\n");
+    
+    // Sends left unanswered this long stop waiting
+    latencyTimeoutLabel = new QLabel(trans["latency_timeout"], latencyTab);
+    latencyTimeoutSpinBox = new QSpinBox(latencyTab);
+    latencyTimeoutSpinBox->setRange(0, 600000);
+    latencyTimeoutSpinBox->setValue(1000);
+    latencyTimeoutSpinBox->setSuffix(" ms");
+    
+    latencyClearButton = new QPushButton(trans["latency_clear"], latencyTab);
+    latencyExportButton = new QPushButton(trans["latency_export"], latencyTab);
+    
+    controlsLayout->addWidget(latencyEnableCheckBox);
+    controlsLayout->addWidget(latencyModeCombo);
+    controlsLayout->addWidget(latencyPatternEdit);
+    controlsLayout->addWidget(latencyTimeoutLabel);
+    controlsLayout->addWidget(latencyTimeoutSpinBox);
+    controlsLayout->addWidget(latencyClearButton);
+    controlsLayout->addWidget(latencyExportButton);
+    controlsLayout->addStretch();
+    
+    latencyWidget = new LatencyWidget(&latencyMeter, latencyTab);
+    
+    latencyLayout->addLayout(controlsLayout);
+    latencyLayout->addWidget(latencyWidget, 1);
+    
+    connect(latencyEnableCheckBox, &QCheckBox::toggled, this, [this](bool checked) {
+        latencyMeter.setEnabled(checked);
+    });
+    connect(latencyModeCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(applyLatencySettings()));
+    connect(latencyPatternEdit, &QLineEdit::editingFinished, this, &MainWindow::applyLatencySettings);
+    connect(latencyTimeoutSpinBox, SIGNAL(valueChanged(int)), this, SLOT(applyLatencySettings()));
+    connect(latencyClearButton, &QPushButton::clicked, this, [this]() {
+        latencyMeter.clear();
+    });
+    connect(latencyExportButton, &QPushButton::clicked, this, &MainWindow::exportLatencySamples);
+    
+    applyLatencySettings();
+    return latencyTab;
+}
+
+void MainWindow::applyLatencySettings()
+{
+    const int modeIndex = latencyModeCombo->currentIndex();
+    latencyPatternEdit->setEnabled(modeIndex == 2);
+    
+    LatencyMeter::Mode mode = LatencyMeter::Pattern;
+    QByteArray pattern;
+    if (modeIndex == 0) {
+        mode = LatencyMeter::AnyBytes;
+    } else if (modeIndex == 1) {
+        pattern = "\n";
+    } else {
+        // The common escapes, so line endings can be part of the pattern
+        pattern = latencyPatternEdit->text().toUtf8();
+        pattern.replace("\\r", "\r").replace("\\n", "\n").replace("\\t", "\t");
+    }
+    latencyMeter.configure(mode, pattern, latencyTimeoutSpinBox->value());
+}
+
+void MainWindow::exportLatencySamples()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    QString fileName = QFileDialog::getSaveFileName(this, trans["latency_export"], "",
+                                                    "CSV Files (*.csv)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QMessageBox::critical(this, trans["error"], trans["export_failed"]);
+        return;
+    }
+    
+    const QVector<qint64> samples = latencyMeter.samples();
+    QTextStream out(&file);
+    out << "sample,rtt_us\n";
+    for (int i = 0; i < samples.size(); ++i) {
+        out << i << ',' << QString::number(samples[i] / 1000.0, 'f', 3) << '\n';
+    }
+    out.flush();
+    if (file.error() != QFile::NoError) {
+        QMessageBox::critical(this, trans["error"], trans["export_failed"]);
+    }
+}
+
+QWidget *MainWindow::setupMetricsTab()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    metricsTimer = new QTimer(this);
+    metricsTimer->setInterval(kMetricsIntervalMs);
+    
+    QWidget *metricsTab = new QWidget(this);
+    QVBoxLayout *metricsLayout = new QVBoxLayout(metricsTab);
+    
+    QHBoxLayout *controlsLayout = new QHBoxLayout();
+    metricsResetButton = new QPushButton(trans["metrics_reset"], metricsTab);
+    controlsLayout->addWidget(metricsResetButton);
+    controlsLayout->addStretch();
+    
+    // Rates, then stages, then queues; the trend covers the last minute
+    metricsTable = new QTableWidget(kMetricRowCount, 4, metricsTab);
+    metricsTable->setHorizontalHeaderLabels({trans["metrics_col_metric"], trans["metrics_col_current"],
+                                             trans["metrics_col_peak"], trans["metrics_col_trend"]});
+    metricsTable->horizontalHeader()->setStretchLastSection(true);
+    metricsTable->verticalHeader()->hide();
+    metricsTable->setSelectionMode(QAbstractItemView::NoSelection);
+    metricsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    for (int row = 0; row < kMetricRowCount; ++row) {
+        metricsTable->setItem(row, 0, new QTableWidgetItem(trans[kMetricRowKeys[row]]));
+        metricsTable->setItem(row, 1, new QTableWidgetItem());
+        metricsTable->setItem(row, 2, new QTableWidgetItem());
+        SparklineWidget *sparkline = new SparklineWidget(metricsTable);
+        metricsTable->setCellWidget(row, 3, sparkline);
+        metricsSparklines.append(sparkline);
+    }
+    metricsTable->setColumnWidth(0, 160);
+    metricsTable->setColumnWidth(1, 220);
+    metricsTable->setColumnWidth(2, 220);
+    
+    metricsLayout->addLayout(controlsLayout);
+    metricsLayout->addWidget(metricsTable, 1);
+    
+    // Paint is timed by the plot itself
+    plotWidget->setMetrics(&pipelineMetrics);
+    
+    connect(metricsTimer, &QTimer::timeout, this, &MainWindow::updateMetrics);
+    connect(metricsResetButton, &QPushButton::clicked, this, [this]() {
+        pipelineMetrics.resetPeaks();
+        updateMetrics();
+    });
+    metricsTimer->start();
+    return metricsTab;
+}
+
+void MainWindow::updateMetrics()
+{
+    pipelineMetrics.setQueueDepth(PipelineSnapshot::RxBacklog,
+                                  transport->isOpen() ? transport->bytesAvailable() : 0);
+    pipelineMetrics.setQueueDepth(PipelineSnapshot::TxQueued, txQueue->queuedBytes());
+    pipelineMetrics.setQueueDepth(PipelineSnapshot::TxInFlight, txQueue->inFlightBytes());
+    pipelineMetrics.setQueueDepth(PipelineSnapshot::BatchRows, derivedChannels.pendingRows());
+    pipelineMetrics.snapshot(LatencyMeter::clockNs());
+    
+    // Peaks and history are kept regardless; the table only while shown
+    if (!metricsTable->isVisible()) {
+        return;
+    }
+    
+    const PipelineSnapshot &now = pipelineMetrics.last();
+    const PipelineSnapshot &peak = pipelineMetrics.peak();
+    const QVector<PipelineSnapshot> history = pipelineMetrics.history();
+    QVector<double> trend(history.size());
+    
+    int row = 0;
+    auto showRow = [&](const QString &current, const QString &highest, auto value) {
+        metricsTable->item(row, 1)->setText(current);
+        metricsTable->item(row, 2)->setText(highest);
+        for (int i = 0; i < history.size(); ++i) {
+            trend[i] = value(history[i]);
+        }
+        metricsSparklines[row]->setValues(trend);
+        ++row;
+    };
+    auto rate = [](double perSecond, const char *unit) {
+        return QString("%1 %2/s").arg(perSecond, 0, 'f', 0).arg(unit);
+    };
+    
+    showRow(rate(now.rxBytesPerSecond, "B"), rate(peak.rxBytesPerSecond, "B"),
+            [](const PipelineSnapshot &s) { return s.rxBytesPerSecond; });
+    showRow(rate(now.rxLinesPerSecond, "lines"), rate(peak.rxLinesPerSecond, "lines"),
+            [](const PipelineSnapshot &s) { return s.rxLinesPerSecond; });
+    showRow(rate(now.txBytesPerSecond, "B"), rate(peak.txBytesPerSecond, "B"),
+            [](const PipelineSnapshot &s) { return s.txBytesPerSecond; });
+    showRow(rate(now.txLinesPerSecond, "lines"), rate(peak.txLinesPerSecond, "lines"),
+            [](const PipelineSnapshot &s) { return s.txLinesPerSecond; });
+    for (int stage = 0; stage < PipelineSnapshot::StageCount; ++stage) {
+        showRow(QString("%1 us x %2/s  %3% busy")
+                .arg(now.stageMeanUs[stage], 0, 'f', 1)
+                .arg(now.stageCallsPerSecond[stage], 0, 'f', 0)
+                .arg(now.stageLoad[stage] * 100.0, 0, 'f', 1),
+                QString("%1 us  %2% busy")
+                .arg(peak.stageMeanUs[stage], 0, 'f', 1)
+                .arg(peak.stageLoad[stage] * 100.0, 0, 'f', 1),
+                [stage](const PipelineSnapshot &s) { return s.stageMeanUs[stage]; });
+    }
+    for (int queue = 0; queue < PipelineSnapshot::QueueCount; ++queue) {
+        showRow(QString::number(now.queueDepth[queue]), QString::number(peak.queueDepth[queue]),
+                [queue](const PipelineSnapshot &s) { return double(s.queueDepth[queue]); });
+    }
+}
+
+#ifndef __EMSCRIPTEN__
+QWidget *MainWindow::setupBertTab()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    bertTester = new BertTester(this);
+    bertTimer = new QTimer(this);
+    bertTimer->setInterval(1000);
+    
+    QWidget *bertTab = new QWidget(this);
+    QVBoxLayout *bertLayout = new QVBoxLayout(bertTab);
+    
+    QHBoxLayout *controlsLayout = new QHBoxLayout();
+    
+    bertPatternLabel = new QLabel(trans["bert_pattern"], bertTab);
+    bertPatternCombo = new QComboBox(bertTab);
+    bertPatternCombo->addItems({"PRBS-7", "PRBS-15", "PRBS-23", "PRBS-31", trans["bert_counter"]});
+    bertPatternCombo->setCurrentIndex(BertPattern::Prbs15);
+    
+    bertStartButton = new QPushButton(trans["bert_start"], bertTab);
+    bertExportButton = new QPushButton(trans["bert_export"], bertTab);
+    
+    controlsLayout->addWidget(bertPatternLabel);
+    controlsLayout->addWidget(bertPatternCombo);
+    controlsLayout->addWidget(bertStartButton);
+    controlsLayout->addWidget(bertExportButton);
+    controlsLayout->addStretch();
+    
+    bertSummaryLabel = new QLabel(trans["bert_hint"], bertTab);
+    bertSummaryLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    
+    // One line per second of the test
+    bertLog = new QPlainTextEdit(bertTab);
+    bertLog->setReadOnly(true);
+    bertLog->setMaximumBlockCount(86400);
+    bertLog->setFont(QFont("Consolas", 9));
+    
+    bertLayout->addLayout(controlsLayout);
+    bertLayout->addWidget(bertSummaryLabel);
+    bertLayout->addWidget(bertLog, 1);
+    
+    connect(bertStartButton, &QPushButton::clicked, this, &MainWindow::toggleBertTest);
+    connect(bertExportButton, &QPushButton::clicked, this, &MainWindow::exportBertLog);
+    connect(bertTimer, &QTimer::timeout, this, &MainWindow::updateBertStats);
+    connect(bertTester, &BertTester::failed, this, &MainWindow::onBertFailed);
+    
+    return bertTab;
+}
+
+void MainWindow::toggleBertTest()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    // The same button stops a running test
+    if (bertTimer->isActive()) {
+        stopBertTest();
+        return;
+    }
+    
+    if (!transport->isOpen()) {
+        QMessageBox::warning(this, trans["warning"], trans["open_port_first"]);
+        return;
+    }
+    QSerialPort::Handle handle;
+    if (!nativePortHandle(&handle)) {
+        return;
+    }
+    
+    bertLog->clear();
+    bertHistory.clear();
+    bertLast = BertSnapshot();
+    bertSummaryLabel->clear();
+    bertPatternCombo->setEnabled(false);
+    bertStartButton->setText(trans["bert_stop"]);
+    bertTester->startTest(handle,
+                          BertPattern::Type(bertPatternCombo->currentIndex()),
+                          transport->config().lineBytesPerSecond());
+    bertTimer->start();
+}
+
+void MainWindow::stopBertTest()
+{
+    // The timer runs for as long as a test is on, including one whose
+    // thread already ended on a write error
+    if (!bertTimer->isActive()) {
+        return;
+    }
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    bertTester->stopTest();
+    bertTimer->stop();
+    // The partial last second still counts
+    updateBertStats();
+    bertPatternCombo->setEnabled(true);
+    bertStartButton->setText(trans["bert_start"]);
+}
+
+void MainWindow::updateBertStats()
+{
+    const BertSnapshot s = bertTester->snapshot();
+    bertHistory.append(s);
+    
+    const BertCounts &c = s.counts;
+    const double ber = c.checkedBytes > 0 ? double(c.bitErrors) / (c.checkedBytes * 8.0) : 0.0;
+    const double byteErrorRate = c.checkedBytes > 0 ? double(c.byteErrors) / c.checkedBytes : 0.0;
+    
+    QString latency = "--";
+    if (s.latencyCount > 0) {
+        latency = QString("%1/%2/%3 ms")
+                  .arg(s.latencyMinUs / 1000.0, 0, 'f', 2)
+                  .arg(s.latencyAvgUs / 1000.0, 0, 'f', 2)
+                  .arg(s.latencyMaxUs / 1000.0, 0, 'f', 2);
+    }
+    bertLog->appendPlainText(
+        QString("%1 s  TX %2 KB/s  RX %3 KB/s  Errors %4 B / %5 bit  Slips %6  Latency min/avg/max %7  %8")
+        .arg(bertHistory.size())
+        .arg((s.txBytes - bertLast.txBytes) / 1024.0, 0, 'f', 1)
+        .arg((s.rxBytes - bertLast.rxBytes) / 1024.0, 0, 'f', 1)
+        .arg(c.byteErrors - bertLast.counts.byteErrors)
+        .arg(c.bitErrors - bertLast.counts.bitErrors)
+        .arg(c.slips - bertLast.counts.slips)
+        .arg(latency)
+        .arg(s.synced ? "Locked" : "No lock"));
+    
+    bertSummaryLabel->setText(
+        QString("Checked=%1 bytes  BER=%2  Byte errors=%3 (%4)  Bit errors=%5  Slips=%6  Unlocked=%7 bytes")
+        .arg(c.checkedBytes)
+        .arg(ber, 0, 'e', 2)
+        .arg(c.byteErrors)
+        .arg(byteErrorRate, 0, 'e', 2)
+        .arg(c.bitErrors)
+        .arg(c.slips)
+        .arg(c.unsyncedBytes));
+    
+    bertLast = s;
+}
+
+void MainWindow::onBertFailed(const QString &error)
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    stopBertTest();
+    QMessageBox::critical(this, trans["error"], trans["bert_failed"] + "\n" + error);
+}
+
+void MainWindow::exportBertLog()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    QString fileName = QFileDialog::getSaveFileName(this, trans["bert_export"], "",
+                                                    "CSV Files (*.csv)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QMessageBox::critical(this, trans["error"], trans["export_failed"]);
+        return;
+    }
+    
+    // Counts are running totals; latency covers each second on its own
+    QTextStream out(&file);
+    out << "second,tx_bytes,rx_bytes,checked_bytes,byte_errors,bit_errors,slips,unlocked_bytes,"
+           "latency_min_us,latency_avg_us,latency_max_us\n";
+    for (int i = 0; i < bertHistory.size(); ++i) {
+        const BertSnapshot &s = bertHistory[i];
+        out << (i + 1) << ',' << s.txBytes << ',' << s.rxBytes << ','
+            << s.counts.checkedBytes << ',' << s.counts.byteErrors << ','
+            << s.counts.bitErrors << ',' << s.counts.slips << ',' << s.counts.unsyncedBytes << ',';
+        if (s.latencyCount > 0) {
+            out << QString::number(s.latencyMinUs, 'f', 1) << ','
+                << QString::number(s.latencyAvgUs, 'f', 1) << ','
+                << QString::number(s.latencyMaxUs, 'f', 1);
+        } else {
+            out << ",,";
+        }
+        out << '\n';
+    }
+    out.flush();
+    if (file.error() != QFile::NoError) {
+        QMessageBox::critical(this, trans["error"], trans["export_failed"]);
+    }
+}
+
+QWidget *MainWindow::setupSessionsTab()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    portSessions.fill(nullptr, kMaxPortSessions);
+    sessionLastRxBytes.fill(0, kMaxPortSessions);
+    sessionStore.setChannelCount(kMaxPortSessions);
+    sessionStore.setRetention(maxDataPoints);
+    sessionEpochNs = LatencyMeter::clockNs();
+    sessionTimer = new QTimer(this);
+    sessionTimer->setInterval(100);
+    
+    QWidget *sessionsTab = new QWidget(this);
+    QVBoxLayout *sessionsLayout = new QVBoxLayout(sessionsTab);
+    
+    QHBoxLayout *controlsLayout = new QHBoxLayout();
+    
+    sessionPortLabel = new QLabel(trans["port"], sessionsTab);
+    sessionPortCombo = new QComboBox(sessionsTab);
+    sessionPortCombo->setMinimumWidth(160);
+    sessionBaudLabel = new QLabel(trans["baud_rate"], sessionsTab);
+    sessionBaudCombo = new QComboBox(sessionsTab);
+    sessionBaudCombo->addItems({"9600", "19200", "38400", "57600", "115200", "230400", "460800", "921600"});
+    sessionBaudCombo->setCurrentText("115200");
+    
+    sessionAddButton = new QPushButton(trans["session_add"], sessionsTab);
+    sessionRemoveButton = new QPushButton(trans["session_remove"], sessionsTab);
+    sessionClearButton = new QPushButton(trans["session_clear"], sessionsTab);
+    
+    controlsLayout->addWidget(sessionPortLabel);
+    controlsLayout->addWidget(sessionPortCombo);
+    controlsLayout->addWidget(sessionBaudLabel);
+    controlsLayout->addWidget(sessionBaudCombo);
+    controlsLayout->addWidget(sessionAddButton);
+    controlsLayout->addWidget(sessionRemoveButton);
+    controlsLayout->addWidget(sessionClearButton);
+    controlsLayout->addStretch();
+    
+    // One row per session, refreshed twice a second
+    sessionTable = new QTableWidget(0, 6, sessionsTab);
+    sessionTable->setHorizontalHeaderLabels({trans["session_col_port"], trans["session_col_status"],
+                                             trans["session_col_rx_bytes"], trans["session_col_lines"],
+                                             trans["session_col_values"], trans["session_col_rx_rate"]});
+    sessionTable->horizontalHeader()->setStretchLastSection(true);
+    sessionTable->verticalHeader()->hide();
+    sessionTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    sessionTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    sessionTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    sessionTable->setMaximumHeight(160);
+    
+    QSplitter *sessionSplitter = new QSplitter(Qt::Vertical, sessionsTab);
+    
+    // First number of each line, one channel per session
+    sessionPlotWidget = new PlotWidget(sessionSplitter);
+    sessionPlotWidget->setMinimumHeight(150);
+    sessionPlotWidget->setMaxDataPoints(maxDataPoints);
+    sessionPlotWidget->setChannelStore(&sessionStore);
+    sessionPlotWidget->setChannelCount(kMaxPortSessions);
+    for (int i = 0; i < kMaxPortSessions; ++i) {
+        sessionPlotWidget->setChannelVisible(i, false);
+    }
+    sessionPlotWidget->setPlotTexts(trans["session_plot_title"], trans["plot_value"],
+                                    trans["plot_points"], trans["plot_waiting"]);
+    
+    // Lines of all sessions in time order
+    sessionEventView = new QPlainTextEdit(sessionSplitter);
+    sessionEventView->setReadOnly(true);
+    sessionEventView->setMaximumBlockCount(5000);
+    sessionEventView->setFont(QFont("Consolas", 9));
+    
+    sessionSplitter->addWidget(sessionPlotWidget);
+    sessionSplitter->addWidget(sessionEventView);
+    
+    sessionsLayout->addLayout(controlsLayout);
+    sessionsLayout->addWidget(sessionTable);
+    sessionsLayout->addWidget(sessionSplitter, 1);
+    
+    connect(sessionAddButton, &QPushButton::clicked, this, &MainWindow::addPortSession);
+    connect(sessionRemoveButton, &QPushButton::clicked, this, &MainWindow::removePortSession);
+    connect(sessionClearButton, &QPushButton::clicked, this, [this]() {
+        sessionEventView->clear();
+        sessionStore.clear();
+        sessionPlotWidget->clearData();
+        sessionEpochNs = LatencyMeter::clockNs();
+    });
+    connect(sessionTimer, &QTimer::timeout, this, &MainWindow::updatePortSessions);
+    
+    return sessionsTab;
+}
+
+void MainWindow::refreshExtraPortLists()
+{
+    // Port combos of the sessions tab and the bridge, keeping the selection
+    const QList<QSerialPortInfo> ports = QSerialPortInfo::availablePorts();
+    for (QComboBox *combo : {sessionPortCombo, bridgePortCombo}) {
+        const QString current = combo->currentData().toString();
+        combo->clear();
+        for (const QSerialPortInfo &info : ports) {
+            combo->addItem(info.portName() + " - " + info.description(), info.portName());
+        }
+        const int index = combo->findData(current);
+        if (index >= 0) {
+            combo->setCurrentIndex(index);
+        }
+    }
+}
+
+void MainWindow::addPortSession()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    const QString portName = sessionPortCombo->currentData().toString();
+    if (portName.isEmpty()) {
+        QMessageBox::warning(this, trans["warning"], trans["session_no_port"]);
+        return;
+    }
+    const int id = portSessions.indexOf(nullptr);
+    if (id < 0) {
+        QMessageBox::warning(this, trans["warning"], trans["session_limit"]);
+        return;
+    }
+    
+    PortSessionConfig config;
+    config.portName = portName;
+    config.baudRate = sessionBaudCombo->currentText().toInt();
+    
+    // A fresh generation per session, so lines a removed session left in the
+    // reorder window are not taken for this one's
+    const int generation = sessionNames.size();
+    PortSession *session = new PortSession(id, generation, config, &sessionEventLog, this);
+    portSessions[id] = session;
+    sessionNames.append(portName);
+    sessionLastRxBytes[id] = 0;
+    
+    sessionStore.clearChannel(id);
+    sessionStore.setChannelName(id, portName);
+    sessionPlotWidget->setChannelName(id, portName);
+    sessionPlotWidget->setChannelVisible(id, true);
+    
+    const int row = sessionTable->rowCount();
+    sessionTable->insertRow(row);
+    for (int column = 0; column < sessionTable->columnCount(); ++column) {
+        sessionTable->setItem(row, column, new QTableWidgetItem());
+    }
+    sessionTable->item(row, 0)->setText(portName);
+    sessionTable->item(row, 0)->setData(Qt::UserRole, id);
+    sessionTable->item(row, 1)->setText(trans["session_opening"]);
+    
+    session->start();
+    if (!sessionTimer->isActive()) {
+        sessionRateClock.start();
+        sessionTimer->start();
+    }
+}
+
+void MainWindow::removePortSession()
+{
+    const int row = sessionTable->currentRow();
+    if (row < 0) {
+        return;
+    }
+    const int id = sessionTable->item(row, 0)->data(Qt::UserRole).toInt();
+    
+    // Lines it already posted still show; its channel stays until reused
+    PortSession *session = portSessions[id];
+    session->stopSession();
+    delete session;
+    portSessions[id] = nullptr;
+    
+    sessionTable->removeRow(row);
+    sessionPlotWidget->setChannelVisible(id, false);
+}
+
+void MainWindow::stopPortSessions()
+{
+    for (int i = 0; i < portSessions.size(); ++i) {
+        if (portSessions[i]) {
+            portSessions[i]->stopSession();
+            delete portSessions[i];
+            portSessions[i] = nullptr;
+        }
+    }
+    if (sessionTimer) {
+        sessionTimer->stop();
+    }
+}
+
+void MainWindow::updatePortSessions()
+{
+    const QVector<SessionEvent> events = sessionEventLog.takeReady(LatencyMeter::clockNs());
+    if (!events.isEmpty()) {
+        QString text;
+        bool plotted = false;
+        for (const SessionEvent &event : events) {
+            if (!text.isEmpty()) {
+                text += '\n';
+            }
+            text += QString("[+%1 s] %2  %3")
+                    .arg((event.ns - sessionEpochNs) / 1e9, 0, 'f', 6)
+                    .arg(sessionNames[event.generation], -8)
+                    .arg(QString::fromUtf8(event.line));
+            const PortSession *session = portSessions[event.session];
+            if (!event.values.isEmpty() && session && session->generation() == event.generation) {
+                sessionStore.append(event.session, event.ns / 1000000, event.values.first());
+                plotted = true;
+            }
+        }
+        sessionEventView->appendPlainText(text);
+        if (plotted) {
+            sessionPlotWidget->dataAppended();
+        }
+    }
+    
+    const qint64 elapsedMs = sessionRateClock.elapsed();
+    if (elapsedMs < 500) {
+        return;
+    }
+    sessionRateClock.restart();
+    
+    for (int row = 0; row < sessionTable->rowCount(); ++row) {
+        const int id = sessionTable->item(row, 0)->data(Qt::UserRole).toInt();
+        const PortSession *session = portSessions[id];
+        const PortSessionStats s = session->stats();
+        
+        QString status = trans["session_open"];
+        if (!s.error.isEmpty()) {
+            status = s.error;
+        } else if (!s.open) {
+            status = session->isRunning() ? trans["session_opening"] : trans["session_closed"];
+        }
+        sessionTable->item(row, 1)->setText(status);
+        sessionTable->item(row, 2)->setText(QString::number(s.rxBytes));
+        sessionTable->item(row, 3)->setText(QString::number(s.lines));
+        sessionTable->item(row, 4)->setText(QString::number(s.values));
+        sessionTable->item(row, 5)->setText(
+            QString::number((s.rxBytes - sessionLastRxBytes[id]) * 1000 / elapsedMs));
+        sessionLastRxBytes[id] = s.rxBytes;
+    }
+}
+
+void MainWindow::addPortSettingsRow(QLabel *label, QLayout *fields)
+{
+    // Appended below the port settings; on Android the designer grid has
+    // been replaced by a column of rows
+    QLayout *layout = ui->groupBox->layout();
+    if (QGridLayout *grid = qobject_cast<QGridLayout *>(layout)) {
+        const int row = grid->rowCount();
+        grid->addWidget(label, row, 0);
+        grid->addLayout(fields, row, 1, 1, grid->columnCount() - 1);
+    } else if (QBoxLayout *box = qobject_cast<QBoxLayout *>(layout)) {
+        QHBoxLayout *row = new QHBoxLayout();
+        row->addWidget(label);
+        row->addLayout(fields, 1);
+        box->addLayout(row);
+    }
+}
+
+void MainWindow::setupTransportUI()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    // Used by the network links picked in the port list
+    addressLabel = new QLabel(trans["address"], ui->groupBox);
+    addressEdit = new QLineEdit(ui->groupBox);
+    addressEdit->setPlaceholderText("host:port");
+    
+    QHBoxLayout *addressLayout = new QHBoxLayout();
+    addressLayout->addWidget(addressEdit);
+    addPortSettingsRow(addressLabel, addressLayout);
+    
+    connect(ui->portCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(updateAddressEdit()));
+    updateAddressEdit();
+}
+
+void MainWindow::updateAddressEdit()
+{
+    const TransportConfig::Kind kind = transportConfig().kind;
+    const bool network = kind != TransportConfig::Serial;
+    addressEdit->setEnabled(network && ui->portCombo->isEnabled());
+    if (network && addressEdit->text().isEmpty()) {
+        // A local ser2net port for clients, any interface for the others
+        addressEdit->setText(kind == TransportConfig::TcpClient ? QString("localhost:2000")
+                                                                : QString(":2000"));
+    }
+}
+
+void MainWindow::setupBridgeUI()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    portBridge = new PortBridge(this);
+    bridgeTimer = new QTimer(this);
+    bridgeTimer->setInterval(20);
+    bridgeLastDirection = -1;
+    
+    // The main port is the host side; this one goes to the device
+    bridgePortLabel = new QLabel(trans["bridge_to"], ui->groupBox);
+    bridgePortCombo = new QComboBox(ui->groupBox);
+    bridgeButton = new QPushButton(trans["bridge_start"], ui->groupBox);
+    
+    QHBoxLayout *bridgeLayout = new QHBoxLayout();
+    bridgeLayout->addWidget(bridgePortCombo, 1);
+    bridgeLayout->addWidget(bridgeButton);
+    addPortSettingsRow(bridgePortLabel, bridgeLayout);
+    
+    connect(bridgeButton, &QPushButton::clicked, this, &MainWindow::toggleBridge);
+    connect(bridgeTimer, &QTimer::timeout, this, &MainWindow::drainBridgeTap);
+    connect(portBridge, &PortBridge::failed, this, &MainWindow::onBridgeFailed);
+}
+
+PortSessionConfig MainWindow::mainPortConfig() const
+{
+    const TransportConfig main = transportConfig();
+    PortSessionConfig config;
+    config.portName = main.portName;
+    config.baudRate = main.baudRate;
+    config.dataBits = QSerialPort::DataBits(main.dataBits);
+    if (main.stopBits == TransportConfig::OneAndHalfStop) {
+        config.stopBits = QSerialPort::OneAndHalfStop;
+    } else if (main.stopBits == TransportConfig::TwoStop) {
+        config.stopBits = QSerialPort::TwoStop;
+    }
+    if (main.parity == TransportConfig::OddParity) {
+        config.parity = QSerialPort::OddParity;
+    } else if (main.parity == TransportConfig::EvenParity) {
+        config.parity = QSerialPort::EvenParity;
+    }
+    if (main.hardwareFlowControl) {
+        config.flowControl = QSerialPort::HardwareControl;
+    }
+    return config;
+}
+
+void MainWindow::toggleBridge()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    // The same button stops a running bridge
+    if (bridgeTimer->isActive()) {
+        stopBridge();
+        return;
+    }
+    
+    // The bridge opens both ports on its own thread
+    if (transport->isOpen()) {
+        QMessageBox::warning(this, trans["warning"], trans["bridge_close_port"]);
+        return;
+    }
+    if (transportConfig().kind != TransportConfig::Serial) {
+        QMessageBox::warning(this, trans["warning"], trans["transport_serial_only"]);
+        return;
+    }
+    const PortSessionConfig host = mainPortConfig();
+    PortSessionConfig device = host;
+    device.portName = bridgePortCombo->currentData().toString();
+    if (device.portName.isEmpty() || device.portName == host.portName) {
+        QMessageBox::warning(this, trans["warning"], trans["bridge_no_port"]);
+        return;
+    }
+    
+    rxBytes = 0;
+    txBytes = 0;
+    bridgeLastDirection = -1;
+    bridgePartialLines[0].clear();
+    bridgePartialLines[1].clear();
+    statusLabel->setToolTip(QString());
+    portBridge->startBridge(host, device);
+    bridgeTimer->start();
+    
+    bridgeButton->setText(trans["bridge_stop"]);
+    statusLabel->setText(trans["status_connected"] + host.portName + " <-> " + device.portName);
+    ui->openButton->setEnabled(false);
+    ui->portCombo->setEnabled(false);
+    ui->baudRateCombo->setEnabled(false);
+    ui->dataBitsCombo->setEnabled(false);
+    ui->stopBitsCombo->setEnabled(false);
+    ui->parityCombo->setEnabled(false);
+    bridgePortCombo->setEnabled(false);
+}
+
+void MainWindow::stopBridge()
+{
+    if (!bridgeTimer->isActive()) {
+        return;
+    }
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    portBridge->stopBridge();
+    bridgeTimer->stop();
+    // Show what was forwarded last
+    drainBridgeTap();
+    
+    bridgeButton->setText(trans["bridge_start"]);
+    statusLabel->setText(trans["status_disconnected"]);
+    ui->openButton->setEnabled(true);
+    ui->portCombo->setEnabled(true);
+    ui->baudRateCombo->setEnabled(true);
+    ui->dataBitsCombo->setEnabled(true);
+    ui->stopBitsCombo->setEnabled(true);
+    ui->parityCombo->setEnabled(true);
+    bridgePortCombo->setEnabled(true);
+}
+
+void MainWindow::drainBridgeTap()
+{
+    const QVector<PortBridge::TapChunk> chunks = portBridge->takeTapped();
+    const bool timestamps = ui->timestampCheck->isChecked();
+    
+    // Consecutive chunks of one direction are shown as one
+    int i = 0;
+    while (i < chunks.size()) {
+        const PortBridge::Direction direction = chunks[i].direction;
+        QByteArray data;
+        for (; i < chunks.size() && chunks[i].direction == direction; ++i) {
+            data += chunks[i].data;
+        }
+        const qint64 lines = PipelineMetrics::countLines(data.constData(), data.size());
+        if (direction == PortBridge::HostToDevice) {
+            txBytes += data.size();
+            pipelineMetrics.addTransmitted(data.size(), lines);
+        } else {
+            rxBytes += data.size();
+            pipelineMetrics.addReceived(data.size(), lines);
+        }
+        
+        // Both directions are parsed and plotted like received data
+        parseReceivedData(data, &bridgePartialLines[direction]);
+        
+        PipelineMetrics::StageTimer timer(&pipelineMetrics, PipelineSnapshot::Decode);
+        const QString mark = direction == PortBridge::HostToDevice ? "[H>D] " : "[D>H] ";
+        QString text = receiveDisplayText(data);
+        if (timestamps || bridgeLastDirection < 0) {
+            text = mark + text;
+        } else if (direction != bridgeLastDirection) {
+            text = "\n" + mark + text;
+        }
+        bridgeLastDirection = direction;
+        appendReceiveText(text);
+    }
+    
+    const qint64 dropped = portBridge->tapDropped();
+    if (dropped > 0) {
+        statusLabel->setToolTip(QString("Display skipped %1 bytes to keep forwarding").arg(dropped));
+    }
+}
+
+void MainWindow::onBridgeFailed(const QString &error)
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    stopBridge();
+    QMessageBox::critical(this, trans["error"], trans["bridge_failed"] + "\n" + error);
+}
+#endif
+
+#ifdef HAVE_VIRTUAL_PORT
+void MainWindow::setupSimulatorUI()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    deviceSimulator = new DeviceSimulator(this);
+    
+    // Takes effect on the next open of the virtual port, or right away
+    // while it is open
+    simulatorLabel = new QLabel(trans["simulator"], ui->groupBox);
+    simulatorPatternCombo = new QComboBox(ui->groupBox);
+    simulatorPatternCombo->addItems({trans["sim_csv"], trans["sim_frames"], trans["sim_bursts"]});
+    
+    simulatorRateSpinBox = new QDoubleSpinBox(ui->groupBox);
+    simulatorRateSpinBox->setRange(0, 1000000);
+    simulatorRateSpinBox->setDecimals(1);
+    simulatorRateSpinBox->setValue(100);
+    simulatorRateSpinBox->setSuffix(" /s");
+    simulatorRateSpinBox->setToolTip(trans["sim_rate_tip"]);
+    
+    simulatorChannelsSpinBox = new QSpinBox(ui->groupBox);
+    simulatorChannelsSpinBox->setRange(1, 16);
+    simulatorChannelsSpinBox->setValue(4);
+    simulatorChannelsSpinBox->setSuffix(" ch");
+    simulatorChannelsSpinBox->setToolTip(trans["sim_channels_tip"]);
+    
+    simulatorBurstSpinBox = new QSpinBox(ui->groupBox);
+    simulatorBurstSpinBox->setRange(1, 10000);
+    simulatorBurstSpinBox->setValue(50);
+    simulatorBurstSpinBox->setPrefix("x ");
+    simulatorBurstSpinBox->setToolTip(trans["sim_burst_tip"]);
+    
+    simulatorEchoCheckBox = new QCheckBox(trans["sim_echo"], ui->groupBox);
+    simulatorStatsLabel = new QLabel(ui->groupBox);
+    
+    QHBoxLayout *simulatorLayout = new QHBoxLayout();
+    simulatorLayout->addWidget(simulatorPatternCombo);
+    simulatorLayout->addWidget(simulatorRateSpinBox);
+    simulatorLayout->addWidget(simulatorChannelsSpinBox);
+    simulatorLayout->addWidget(simulatorBurstSpinBox);
+    simulatorLayout->addWidget(simulatorEchoCheckBox);
+    simulatorLayout->addWidget(simulatorStatsLabel);
+    simulatorLayout->addStretch();
+    
+    addPortSettingsRow(simulatorLabel, simulatorLayout);
+    
+    connect(simulatorPatternCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(applySimulatorSettings()));
+    connect(simulatorRateSpinBox, SIGNAL(valueChanged(double)), this, SLOT(applySimulatorSettings()));
+    connect(simulatorChannelsSpinBox, SIGNAL(valueChanged(int)), this, SLOT(applySimulatorSettings()));
+    connect(simulatorBurstSpinBox, SIGNAL(valueChanged(int)), this, SLOT(applySimulatorSettings()));
+    connect(simulatorEchoCheckBox, &QCheckBox::toggled, this, &MainWindow::applySimulatorSettings);
+}
+
+SimulatorConfig MainWindow::simulatorConfig() const
+{
+    SimulatorConfig config;
+    config.pattern = SimulatorConfig::Pattern(simulatorPatternCombo->currentIndex());
+    config.rate = simulatorRateSpinBox->value();
+    config.channels = simulatorChannelsSpinBox->value();
+    config.burstSize = simulatorBurstSpinBox->value();
+    config.echo = simulatorEchoCheckBox->isChecked();
+    return config;
+}
+
+void MainWindow::applySimulatorSettings()
+{
+    if (deviceSimulator->isRunning()) {
+        deviceSimulator->setConfig(simulatorConfig());
+    }
+}
+#endif
+
+void MainWindow::applyHistogramSettings()
+{
+    const bool autoRange = histogramRangeCombo->currentIndex() == 0;
+    histogramMinSpinBox->setEnabled(!autoRange);
+    histogramMaxSpinBox->setEnabled(!autoRange);
+    histogramWidget->configure(histogramBinsSpinBox->value(), histogramWindowSpinBox->value(),
+                               autoRange, histogramMinSpinBox->value(), histogramMaxSpinBox->value());
+}
+
+void MainWindow::applySpectrumSettings()
+{
+    spectrumWidget->setWindow(static_cast<Fft::Window>(spectrumWindowCombo->currentIndex()));
+    spectrumWidget->setFftSize(spectrumSizeCombo->currentData().toInt());
+    updateStoreRetention();
+    spectrumWidget->setSampleRate(spectrumRateSpinBox->value());
+    for (int i = 0; i < spectrumChannelChecks.size(); ++i) {
+        spectrumWidget->setChannelEnabled(i, spectrumChannelChecks[i]->isChecked());
+    }
+}
+
+void MainWindow::on_autoSendTimer_timeout()
+{
+    // A full queue skips the tick rather than piling up more data
+    if (transport->isOpen() && txQueue->enqueue(encodeSendText())) {
+        markCommandSent();
+    }
+}
+
+void MainWindow::on_commandList_itemDoubleClicked(QListWidgetItem *item)
+{
+    if (!item) return;
+    
+    // Back into the send box for editing
+    const CommandEntry &entry = commandEntries[commandListWidget->row(item)];
+    ui->hexSendCheck->setChecked(entry.hex);
+    ui->sendText->setPlainText(entry.text);
+}
+
+void MainWindow::addCommand()
+{
+    QString currentText = ui->sendText->toPlainText();
+    if (currentText.isEmpty()) return;
+    
+    // Encoded with the send settings in effect now
+    int cmdNum = commandListWidget->count() + 1;
+    appendCommand(CommandEntry(QString("CMD_%1").arg(cmdNum), currentText,
+                               ui->hexSendCheck->isChecked(), sendLineEnding()));
+}
+
+void MainWindow::deleteCommand()
+{
+    int row = commandListWidget->currentRow();
+    if (row >= 0) {
+        delete commandListWidget->takeItem(row);
+        commandEntries.remove(row);
+        // Later rows moved up onto lower hotkeys
+        for (int i = row; i < commandListWidget->count(); ++i) {
+            commandListWidget->item(i)->setToolTip(commandHotkeyTip(i));
+        }
+    }
+}
+
+void MainWindow::appendCommand(const CommandEntry &entry)
+{
+    commandEntries.append(entry);
+    QListWidgetItem *item = new QListWidgetItem(entry.displayText());
+    item->setToolTip(commandHotkeyTip(commandEntries.size() - 1));
+    commandListWidget->addItem(item);
+}
+
+void MainWindow::sendCommand(int row)
+{
+    if (row < 0 || row >= commandEntries.size()) {
+        return;
+    }
+    if (!transport->isOpen()) {
+        QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+        QMessageBox::warning(this, trans["warning"], trans["open_port_first"]);
+        return;
+    }
+    
+    // Straight from the cache; nothing is parsed per send
+    const QByteArray &payload = commandEntries[row].payload;
+    if (!payload.isEmpty() && txQueue->enqueue(payload)) {
+        markCommandSent();
+    }
+}
+
+#ifndef __EMSCRIPTEN__
+void MainWindow::runScript()
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    
+    // The same button stops a running script
+    if (scriptExecutor->isRunning()) {
+        scriptExecutor->stopScript();
+        return;
+    }
+    
+    if (!transport->isOpen()) {
+        QMessageBox::warning(this, trans["warning"], trans["open_port_first"]);
+        return;
+    }
+    QSerialPort::Handle handle;
+    if (!nativePortHandle(&handle)) {
+        return;
+    }
+    
+    CommandScript script;
+    QString error;
+    if (!script.parse(scriptEdit->toPlainText(), &error)) {
+        QMessageBox::critical(this, trans["error"], trans["script_failed"] + "\n" + error);
+        return;
+    }
+    
+    scriptStatusLabel->clear();
+    scriptRunButton->setText(trans["script_stop"]);
+    scriptExecutor->startScript(handle, script.steps());
 }
 
-void MainWindow::parseReceivedData(const QByteArray &data)
+void MainWindow::onScriptFinished(bool ok, const QString &error)
 {
-    // Try to parse data as numeric values for plotting
-    QString dataStr = QString::fromUtf8(data).trimmed();
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
     
-    // Check if data contains "plotter" keyword or numeric values
-    if (dataStr.contains("plotter", Qt::CaseInsensitive) || 
-        dataStr.contains(QRegularExpression("[0-9\\-\\.]+"))) {
+    scriptRunButton->setText(trans["script_run"]);
+    if (ok) {
+        scriptStatusLabel->setText(trans["script_done"]);
+    } else if (!error.isEmpty()) {
+        scriptStatusLabel->setText(error);
+    } else {
+        scriptStatusLabel->clear();
+    }
+}
+#endif
+
+void MainWindow::parseReceivedData(const QByteArray &data, QByteArray *partial)
+{
+    // One row per line; a line split across reads is completed from
+    // partial, and one that never ends is parsed once it grows too long
+    int start = 0;
+    while (start < data.size()) {
+        const int end = data.indexOf('\n', start);
+        if (end < 0 && partial->size() + data.size() - start < kMaxPlotLineBytes) {
+            partial->append(data.constData() + start, data.size() - start);
+            break;
+        }
+        const int stop = end < 0 ? qMin(data.size(), start + kMaxPlotLineBytes - partial->size()) : end;
+        partial->append(data.constData() + start, stop - start);
+        start = end < 0 ? stop : end + 1;
+        
+        parsePlotLine(*partial);
+        partial->clear();
+    }
+}
+
+void MainWindow::parsePlotLine(const QByteArray &line)
+{
+    QVector<double> row;
+    {
+        PipelineMetrics::StageTimer timer(&pipelineMetrics, PipelineSnapshot::Parse);
+        
+        // Try to parse data as numeric values for plotting
+        QString dataStr = QString::fromUtf8(line).trimmed();
+        
+        // Check if data contains "plotter" keyword or numeric values
+        if (!dataStr.contains("plotter", Qt::CaseInsensitive) &&
+            !dataStr.contains(QRegularExpression("[0-9\\-\\.]+"))) {
+            return;
+        }
         
         // Remove "plotter" keyword if present
         dataStr.remove("plotter", Qt::CaseInsensitive);
@@ -1060,83 +3597,154 @@ void MainWindow::parseReceivedData(const QByteArray &data)
         QStringList parts = dataStr.split(QRegularExpression("[,\\s]+"), QString::SkipEmptyParts);
 #endif
         
-        qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
-        int channelIndex = 0;
-        
-        QString plotInfo;
-        
         for (const QString &part : parts) {
             bool ok;
             double value = part.toDouble(&ok);
-            
-            if (ok && channelIndex < 6) {
-                // Add to plot widget
-                plotWidget->addDataPoint(channelIndex, value);
-                
-                // Store in data structure
-                if (channelIndex < plotData.size()) {
-                    DataPoint point;
-                    point.timestamp = timestamp;
-                    point.value = value;
-                    
-                    plotData[channelIndex].append(point);
-                    
-                    // Limit data points
-                    if (plotData[channelIndex].size() > maxDataPoints) {
-                        plotData[channelIndex].removeFirst();
-                    }
-                }
-                
-                plotInfo += QString("Ch%1: %2  ").arg(channelIndex + 1).arg(value, 0, 'f', 4);
-                channelIndex++;
+            if (ok && row.size() < kParsedChannels) {
+                row.append(value);
             }
         }
+    }
+    if (row.isEmpty()) {
+        return;
+    }
+    
+    {
+        PipelineMetrics::StageTimer timer(&pipelineMetrics, PipelineSnapshot::PlotIngest);
+        
+        qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+        for (int channelIndex = 0; channelIndex < row.size(); ++channelIndex) {
+            const double value = row[channelIndex];
+            // Stored once; plot, spectrum and export read the store
+            channelStore.append(channelIndex, timestamp, value);
+            if (filterStage.isActive(channelIndex)) {
+                filterStage.append(channelIndex, timestamp, value);
+            }
+            
+            channelStats[channelIndex].add(value);
+            histogramWidget->addSample(channelIndex, value);
+        }
+        
+        plotWidget->dataAppended();
+        
+        // Streaming trigger sees each row once; freeze the plot on capture
+        if (triggerDetector.processRow(row)) {
+            plotWidget->showCapture(triggerDetector.capture(),
+                                    triggerDetector.captureTriggerIndex(),
+                                    triggerDetector.level());
+        }
+        statsDirty = true;
         
-        if (!plotInfo.isEmpty()) {
-            updatePlotDisplay();
+        if (derivedChannels.count() > 0) {
+            derivedChannels.appendRow(timestamp, row);
         }
     }
+    // Timed as plot ingest on its own
+    if (derivedChannels.isFull() || filterStage.isFull()) {
+        flushBatchedChannels();
+    } else if (!batchTimer->isActive() &&
+               (derivedChannels.pendingRows() > 0 || filterStage.hasPending())) {
+        batchTimer->start();
+    }
 }
 
 void MainWindow::updatePlotDisplay()
 {
+    // Rates are refreshed every tick so they fall to zero once data stops
+    const qint64 now = statsClock.elapsed();
+    bool refresh = statsDirty;
+    for (int i = 0; i < channelStats.size(); ++i) {
+        double previousRate = channelStats[i].rate();
+        channelStats[i].updateRate(now);
+        if (channelStats[i].rate() != previousRate) {
+            refresh = true;
+        }
+    }
+    
+    if (!refresh) {
+        return;
+    }
+    statsDirty = false;
+    
     QString plotText;
     
-    for (int i = 0; i < plotData.size(); ++i) {
-        if (plotData[i].isEmpty()) continue;
+    for (int i = 0; i < channelStats.size(); ++i) {
+        const ChannelStatistics &stats = channelStats[i];
+        if (stats.count() == 0) continue;
         
         plotText += QString("Graph %1: ").arg(i + 1);
-        
-        // Show statistics
-        double sum = 0;
-        double minVal = plotData[i].first().value;
-        double maxVal = plotData[i].first().value;
-        
-        for (const DataPoint &point : plotData[i]) {
-            sum += point.value;
-            if (point.value < minVal) minVal = point.value;
-            if (point.value > maxVal) maxVal = point.value;
-        }
-        
-        double avg = sum / plotData[i].size();
-        double lastVal = plotData[i].last().value;
-        
-        plotText += QString("Last=%1  Avg=%2  Min=%3  Max=%4  Points=%5\n")
-                    .arg(lastVal, 0, 'f', 4)
-                    .arg(avg, 0, 'f', 4)
-                    .arg(minVal, 0, 'f', 4)
-                    .arg(maxVal, 0, 'f', 4)
-                    .arg(plotData[i].size());
+        plotText += QString("Last=%1  Avg=%2  Std=%3  Min=%4  Max=%5  ")
+                    .arg(stats.last(), 0, 'f', 4)
+                    .arg(stats.mean(), 0, 'f', 4)
+                    .arg(stats.stddev(), 0, 'f', 4)
+                    .arg(stats.min(), 0, 'f', 4)
+                    .arg(stats.max(), 0, 'f', 4);
+        plotText += QString("P50=%1  P95=%2  P99=%3  Rate=%4/s  Points=%5\n")
+                    .arg(stats.p50(), 0, 'f', 4)
+                    .arg(stats.p95(), 0, 'f', 4)
+                    .arg(stats.p99(), 0, 'f', 4)
+                    .arg(stats.rate(), 0, 'f', 1)
+                    .arg(stats.count());
     }
     
     plotterTextEdit->setPlainText(plotText);
 }
 
-void MainWindow::on_autoSendInterval_changed(int value)
+void MainWindow::updateAutoSend()
+{
+    const bool enabled = autoSendCheckBox && autoSendCheckBox->isChecked();
+#ifndef __EMSCRIPTEN__
+    // The scheduler needs the open port's handle, so it runs only while
+    // auto-send is checked and a serial port is open
+    QSerialPort::Handle handle;
+    if (enabled && transport->nativeHandle(&handle)) {
+        autoSendTimer->stop();
+        if (!sendScheduler->isSending()) {
+            sendScheduler->startSending(handle, encodeSendText(),
+                                        qint64(autoSendIntervalSpinBox->value() * 1e6));
+        }
+        return;
+    }
+    sendScheduler->stopSending();
+    if (autoSendJitterLabel) {
+        autoSendJitterLabel->clear();
+    }
+#endif
+    // Links without a handle, and the WebAssembly build, which has no
+    // threads, go through the queue on a timer that re-encodes each tick
+    if (enabled) {
+        autoSendTimer->start(qRound(autoSendIntervalSpinBox->value()));
+    } else {
+        autoSendTimer->stop();
+    }
+}
+
+void MainWindow::refreshAutoSendPayload()
+{
+#ifndef __EMSCRIPTEN__
+    if (sendScheduler->isSending()) {
+        sendScheduler->setPayload(encodeSendText());
+    }
+#endif
+}
+
+void MainWindow::onAutoSendFailed(const QString &error)
+{
+    QMap<QString, QString> trans = Translations::getTranslations(currentLanguage);
+    autoSendCheckBox->setChecked(false);
+    QMessageBox::warning(this, trans["warning"], trans["auto_send"] + ": " + error);
+}
+
+void MainWindow::on_autoSendInterval_changed(double value)
 {
-    if (autoSendCheckBox && autoSendCheckBox->isChecked()) {
-        autoSendTimer->setInterval(value);
+    if (autoSendTimer->isActive()) {
+        autoSendTimer->setInterval(qRound(value));
+    }
+#ifndef __EMSCRIPTEN__
+    if (sendScheduler->isSending()) {
+        sendScheduler->setPeriod(qint64(value * 1e6));
     }
+#endif
 }
 
 void MainWindow::loadStyleSheet()
@@ -3,11 +3,9 @@
 
 #include <QMainWindow>
 
-// Use WebSerialPort for WebAssembly, QSerialPort for native platforms
-#ifdef __EMSCRIPTEN__
-#include "webserialport.h"
-#else
-#include <QSerialPort>
+// Serial, Web Serial and network links all run through a Transport
+#include "transport.h"
+#ifndef __EMSCRIPTEN__
 #include <QSerialPortInfo>
 #endif
 
@@ -20,12 +18,49 @@
 #include <QCheckBox>
 #include <QTabWidget>
 #include <QTextEdit>
+#include <QPlainTextEdit>
+#include <QShortcut>
 #include <QVector>
 #include <QDateTime>
 #include <QDockWidget>
 #include <QPushButton>
 #include <QStyledItemDelegate>
 #include <QPainter>
+#include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QGroupBox>
+#include <QLineEdit>
+
+#include <QElapsedTimer>
+#include <QProgressBar>
+#include <QPointer>
+#include <QThread>
+
+#include "triggerdetector.h"
+#include "channelstats.h"
+#include "channelstore.h"
+#include "derivedchannels.h"
+#include "channelfilter.h"
+#include "transmitqueue.h"
+#include "filesender.h"
+#include "commandentry.h"
+#include "latencywidget.h"
+#include "pipelinemetrics.h"
+#ifndef __EMSCRIPTEN__
+#include "sendscheduler.h"
+#include "scriptexecutor.h"
+#include "filetransfer.h"
+#include "berttester.h"
+#include "portsession.h"
+#include "sessioneventlog.h"
+#include "portbridge.h"
+#endif
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID) && !defined(__EMSCRIPTEN__)
+// Pseudo-terminal port fed by a simulated device, on desktop Linux
+#define HAVE_VIRTUAL_PORT
+#include "virtualport.h"
+#include "devicesimulator.h"
+#endif
 
 // Simple delegate for single-line ComboBox items with custom height
 class ComboBoxItemDelegate : public QStyledItemDelegate
@@ -121,17 +156,17 @@ public:
 
 // Forward declaration
 class PlotWidget;
+class SpectrumWidget;
+class HistogramWidget;
+class PlotExporter;
+class QVBoxLayout;
+class QTableWidget;
+class SparklineWidget;
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
-// Data point structure for plotting
-struct DataPoint {
-    qint64 timestamp;
-    double value;
-};
-
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -147,6 +182,10 @@ private slots:
     void on_clearReceiveButton_clicked();
     void on_clearSendButton_clicked();
     void readData();
+    void onTransportError(const QString &error);
+#ifndef __EMSCRIPTEN__
+    void updateAddressEdit();
+#endif
     void updateStatus();
     
     // Menu actions
@@ -166,18 +205,71 @@ private slots:
     // Advanced features
     void on_autoSendTimer_timeout();
     void on_commandList_itemDoubleClicked(QListWidgetItem *item);
-    void on_autoSendInterval_changed(int value);
+    void on_autoSendInterval_changed(double value);
+    void refreshAutoSendPayload();
+    void onAutoSendFailed(const QString &error);
+    void sendFile();
+    void onFileSendFinished(bool ok, const QString &error);
+#ifndef __EMSCRIPTEN__
+    void onFileTransferFinished(bool ok, const QString &error);
+#endif
+    void onTransmitFailed(const QString &error);
+    void applyFlowControl();
+    void applyTransmitLimit();
+#ifndef __EMSCRIPTEN__
+    void runScript();
+    void onScriptFinished(bool ok, const QString &error);
+#endif
     void addCommand();
     void deleteCommand();
-    void parseReceivedData(const QByteArray &data);
+    void parseReceivedData(const QByteArray &data, QByteArray *partial);
+    void applyTriggerSettings();
+    void armTrigger();
+    void applyDerivedChannels();
+    void applyChannelFilter();
+    void updateFilterControls();
+    void flushBatchedChannels();
+    void applyXYSettings();
+    void applySpectrumSettings();
+    void applyHistogramSettings();
+    void applyLatencySettings();
+    void exportLatencySamples();
+    void updateMetrics();
+#ifndef __EMSCRIPTEN__
+    void toggleBertTest();
+    void updateBertStats();
+    void onBertFailed(const QString &error);
+    void exportBertLog();
+    void addPortSession();
+    void removePortSession();
+    void updatePortSessions();
+    void toggleBridge();
+    void drainBridgeTap();
+    void onBridgeFailed(const QString &error);
+#endif
+#ifdef HAVE_VIRTUAL_PORT
+    void applySimulatorSettings();
+#endif
+    void exportPlotData();
+    void onExportFinished(bool ok, const QString &fileName);
+    void setCompressedHistory(bool enabled);
+    void setSpilledHistory(bool enabled);
 
 private:
     Ui::MainWindow *ui;
     
-#ifdef __EMSCRIPTEN__
-    WebSerialPort *serialPort;
-#else
-    QSerialPort *serialPort;
+    // Replaced when a port of another kind is opened
+    Transport *transport;
+    // All writes through the port go through here
+    TransmitQueue *txQueue;
+    // Received data is read into this in chunks, reused for every read
+    QByteArray readBuffer;
+    // Received text after the last line end, parsed once the line completes
+    QByteArray plotPartialLine;
+#ifndef __EMSCRIPTEN__
+    // host:port for network ports
+    QLabel *addressLabel;
+    QLineEdit *addressEdit;
 #endif
     
     QTimer *statusTimer;
@@ -197,27 +289,271 @@ private:
     // Advanced features
     QTimer *autoSendTimer;
     QListWidget *commandListWidget;
-    QSpinBox *autoSendIntervalSpinBox;
+    QDoubleSpinBox *autoSendIntervalSpinBox;  // Period in ms
     QCheckBox *autoSendCheckBox;
+#ifndef __EMSCRIPTEN__
+    // Auto-send runs on its own thread where threads are available
+    SendScheduler *sendScheduler;
+    QLabel *autoSendJitterLabel;
+#endif
+    
+    // Streaming file send
+    FileSender *fileSender;
+    QPushButton *fileSendButton;
+    QLabel *fileChunkLabel;
+    QSpinBox *fileChunkSpinBox;
+    QLabel *fileChunkDelayLabel;
+    QSpinBox *fileChunkDelaySpinBox;
+    QLabel *fileLineDelayLabel;
+    QSpinBox *fileLineDelaySpinBox;
+    QCheckBox *flowControlCheckBox;
+    QLabel *txLimitLabel;
+    QSpinBox *txLimitSpinBox;   // Transmit queue high-water mark in KB
+    QProgressBar *fileSendProgressBar;
+    QLabel *fileSendStatusLabel;
+    QLabel *fileProtocolLabel;
+    QComboBox *fileProtocolCombo;   // Raw, then the FileTransfer protocols
+#ifndef __EMSCRIPTEN__
+    FileTransfer *fileTransfer;
+#endif
     QCheckBox *addLineBreakCheckBox;
     QCheckBox *addCarriageReturnCheckBox;
     QTabWidget *mainTabWidget;
     QTextEdit *plotterTextEdit;
     PlotWidget *plotWidget;  // Real-time plot widget
     QDockWidget *commandDock;  // Command list dock widget
+#ifndef __EMSCRIPTEN__
+    // Command sequences run on their own thread
+    ScriptExecutor *scriptExecutor;
+    QLabel *scriptLabel;
+    QPlainTextEdit *scriptEdit;
+    QPushButton *scriptRunButton;
+    QLabel *scriptStatusLabel;
+#endif
     QPushButton *addCmdBtn;    // Add command button
     QPushButton *delCmdBtn;    // Delete command button
+    QPushButton *sendCmdBtn;   // Send selected command button
+    QVector<CommandEntry> commandEntries;  // One per command list row
     
-    // Data plotting
-    QVector<QVector<DataPoint>> plotData;  // Multiple channels
+    // Data plotting: the store owns every sample, widgets and exports
+    // read views of it
+    ChannelStore channelStore;
     int maxDataPoints;
+    QAction *actionCompressHistory;
+    QAction *actionSpillHistory;
+    
+    // Triggered capture
+    TriggerDetector triggerDetector;
+    QGroupBox *triggerGroup;
+    QComboBox *triggerModeCombo;
+    QSpinBox *triggerChannelSpinBox;
+    QComboBox *triggerEdgeCombo;
+    QDoubleSpinBox *triggerLevelSpinBox;
+    QSpinBox *triggerPreSpinBox;
+    QSpinBox *triggerPostSpinBox;
+    QSpinBox *triggerHoldoffSpinBox;
+    QPushButton *triggerArmButton;
+    QLabel *triggerChannelLabel;
+    QLabel *triggerLevelLabel;
+    QLabel *triggerPreLabel;
+    QLabel *triggerPostLabel;
+    QLabel *triggerHoldoffLabel;
+    
+    // Derived channels, appended to the store after the parsed ones
+    DerivedChannels derivedChannels;
+    QTimer *batchTimer;
+    QGroupBox *derivedGroup;
+    QLineEdit *derivedEdit;
+    QPushButton *derivedApplyButton;
+    
+    // Filtered copies of parsed channels, stored after the derived ones
+    FilterStage filterStage;
+    QVector<int> filterTargets;
+    QGroupBox *filterGroup;
+    QLabel *filterChannelLabel;
+    QSpinBox *filterChannelSpinBox;
+    QComboBox *filterTypeCombo;
+    QLabel *filterParamLabel;
+    QDoubleSpinBox *filterParamSpinBox;
+    QLineEdit *filterTapsEdit;
+    QPushButton *filterApplyButton;
+    
+    // XY plot of one channel against another
+    QGroupBox *xyGroup;
+    QCheckBox *xyEnableCheckBox;
+    QLabel *xyXLabel;
+    QSpinBox *xyXSpinBox;
+    QLabel *xyYLabel;
+    QSpinBox *xyYSpinBox;
+    QComboBox *xyPairingCombo;
+    QCheckBox *xyConnectCheckBox;
+    QLabel *xyDepthLabel;
+    QSpinBox *xyDepthSpinBox;
+    
+    // Spectrum analyzer
+    SpectrumWidget *spectrumWidget;
+    QComboBox *spectrumWindowCombo;
+    QComboBox *spectrumSizeCombo;
+    QDoubleSpinBox *spectrumRateSpinBox;
+    QLabel *spectrumWindowLabel;
+    QLabel *spectrumSizeLabel;
+    QLabel *spectrumRateLabel;
+    QVector<QCheckBox*> spectrumChannelChecks;
+    
+    // Sliding-window histograms, fed sample by sample
+    HistogramWidget *histogramWidget;
+    QLabel *histogramBinsLabel;
+    QSpinBox *histogramBinsSpinBox;
+    QLabel *histogramWindowLabel;
+    QSpinBox *histogramWindowSpinBox;
+    QComboBox *histogramRangeCombo;
+    QDoubleSpinBox *histogramMinSpinBox;
+    QDoubleSpinBox *histogramMaxSpinBox;
+    QPushButton *histogramApplyButton;
+    QVector<QCheckBox*> histogramChannelChecks;
+    
+    // Request/response round trips of everything sent
+    LatencyMeter latencyMeter;
+    LatencyWidget *latencyWidget;
+    QCheckBox *latencyEnableCheckBox;
+    QComboBox *latencyModeCombo;
+    QLineEdit *latencyPatternEdit;
+    QLabel *latencyTimeoutLabel;
+    QSpinBox *latencyTimeoutSpinBox;
+    QPushButton *latencyClearButton;
+    QPushButton *latencyExportButton;
+    
+    // Rates, stage times and queue depths of the pipeline. Always counted
+    // and snapshotted; the table is refreshed only while it is shown.
+    PipelineMetrics pipelineMetrics;
+    QTimer *metricsTimer;
+    QTableWidget *metricsTable;
+    QVector<SparklineWidget*> metricsSparklines;   // One per table row
+    QPushButton *metricsResetButton;
+    
+#ifndef __EMSCRIPTEN__
+    // Loopback bit error rate test, logged once a second
+    BertTester *bertTester;
+    QTimer *bertTimer;
+    QLabel *bertPatternLabel;
+    QComboBox *bertPatternCombo;
+    QPushButton *bertStartButton;
+    QPushButton *bertExportButton;
+    QLabel *bertSummaryLabel;
+    QPlainTextEdit *bertLog;
+    BertSnapshot bertLast;
+    QVector<BertSnapshot> bertHistory;
+    
+    // Extra ports watched next to the main one, each read on its own
+    // thread; their lines merge into one time-ordered view and plot
+    SessionEventLog sessionEventLog;
+    QVector<PortSession*> portSessions;     // Indexed by session id, null when free
+    QStringList sessionNames;               // Indexed by session generation
+    QVector<qint64> sessionLastRxBytes;
+    ChannelStore sessionStore;              // One channel per session id
+    PlotWidget *sessionPlotWidget;
+    QTableWidget *sessionTable;
+    QPlainTextEdit *sessionEventView;
+    QLabel *sessionPortLabel;
+    QComboBox *sessionPortCombo;
+    QLabel *sessionBaudLabel;
+    QComboBox *sessionBaudCombo;
+    QPushButton *sessionAddButton;
+    QPushButton *sessionRemoveButton;
+    QPushButton *sessionClearButton;
+    QTimer *sessionTimer;
+    QElapsedTimer sessionRateClock;
+    qint64 sessionEpochNs;
+    
+    // Forwarding between the main port (host side) and a second port
+    // (device side); the tap feeds the receive display and plots
+    PortBridge *portBridge;
+    QTimer *bridgeTimer;
+    QLabel *bridgePortLabel;
+    QComboBox *bridgePortCombo;
+    QPushButton *bridgeButton;
+    int bridgeLastDirection;
+    QByteArray bridgePartialLines[2];   // Per PortBridge::Direction
+#endif
+    
+#ifdef HAVE_VIRTUAL_PORT
+    // Opened in place of a real port when the virtual one is picked
+    VirtualPort virtualPort;
+    DeviceSimulator *deviceSimulator;
+    QLabel *simulatorLabel;
+    QComboBox *simulatorPatternCombo;
+    QDoubleSpinBox *simulatorRateSpinBox;
+    QSpinBox *simulatorChannelsSpinBox;
+    QSpinBox *simulatorBurstSpinBox;
+    QCheckBox *simulatorEchoCheckBox;
+    QLabel *simulatorStatsLabel;
+#endif
+    
+    // Online per-channel statistics, shown on a timer
+    QVector<ChannelStatistics> channelStats;
+    QTimer *statsTimer;
+    QElapsedTimer statsClock;
+    bool statsDirty;
+    
+    // Background export of plot channels
+    QAction *actionExportPlot;
+    QProgressBar *exportProgressBar;
+    QPointer<QThread> exportThread;
+    QPointer<PlotExporter> plotExporter;
     
     void initUI();
     void refreshPortList();
+#ifndef __EMSCRIPTEN__
+    void addPortSettingsRow(QLabel *label, QLayout *fields);
+    void setupTransportUI();
+#endif
+    TransportConfig transportConfig() const;
+    void setTransport(TransportConfig::Kind kind);
+    void closePort();
+    void processReceivedData(const QByteArray &data);
+    void parsePlotLine(const QByteArray &line);
     void appendReceiveText(const QString &text);
+    QString receiveDisplayText(const QByteArray &data) const;
     void switchLanguage(const QString &language);
     void retranslateUI();
     void setupAdvancedUI();
+    void setupTriggerUI(QWidget *parent, QVBoxLayout *layout);
+    void setupDerivedUI(QWidget *parent, QVBoxLayout *layout);
+    void setupFilterUI(QWidget *parent, QVBoxLayout *layout);
+    void setupXYUI(QWidget *parent, QVBoxLayout *layout);
+    void rebuildVirtualChannels(int firstChanged);
+    QWidget *setupSpectrumTab();
+    QWidget *setupHistogramTab();
+    QWidget *setupLatencyTab();
+    QWidget *setupMetricsTab();
+#ifndef __EMSCRIPTEN__
+    QWidget *setupBertTab();
+    void stopBertTest();
+    QWidget *setupSessionsTab();
+    void refreshExtraPortLists();
+    void stopPortSessions();
+    void setupBridgeUI();
+    void stopBridge();
+    PortSessionConfig mainPortConfig() const;
+#endif
+#ifdef HAVE_VIRTUAL_PORT
+    void setupSimulatorUI();
+    SimulatorConfig simulatorConfig() const;
+#endif
+    void markCommandSent();
+    void setupExportUI();
+    void updateStoreRetention();
+    QByteArray encodeSendText() const;
+    QByteArray sendLineEnding() const;
+    void appendCommand(const CommandEntry &entry);
+    void sendCommand(int row);
+    void updateAutoSend();
+    void setupFileSendUI(QWidget *parent, QVBoxLayout *layout);
+#ifndef __EMSCRIPTEN__
+    // The open port's handle for worker threads; warns and returns false
+    // when the open port has none
+    bool nativePortHandle(QSerialPort::Handle *handle);
+#endif
     void updatePlotDisplay();
     void loadStyleSheet();
 };
@@ -0,0 +1,111 @@
+#include "nativeportwriter.h"
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// A write that cannot complete within this is treated as a dead port
+const int kWriteTimeoutMs = 1000;
+
+} // namespace
+
+NativePortWriter::NativePortWriter()
+    : handle(QSerialPort::Handle())
+    , writeEvent(nullptr)
+{
+}
+
+NativePortWriter::~NativePortWriter()
+{
+    end();
+}
+
+void NativePortWriter::begin(QSerialPort::Handle portHandle)
+{
+    end();
+    handle = portHandle;
+#ifdef Q_OS_WIN
+    timeBeginPeriod(1);
+    writeEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+#endif
+}
+
+void NativePortWriter::end()
+{
+#ifdef Q_OS_WIN
+    if (writeEvent) {
+        CloseHandle(writeEvent);
+        writeEvent = nullptr;
+        timeEndPeriod(1);
+    }
+#endif
+}
+
+bool NativePortWriter::write(const QByteArray &data, QString *error)
+{
+    return write(data.constData(), data.size(), error);
+}
+
+bool NativePortWriter::write(const char *data, qint64 size, QString *error)
+{
+#ifdef Q_OS_WIN
+    // QSerialPort opens the handle for overlapped I/O
+    OVERLAPPED overlapped;
+    ZeroMemory(&overlapped, sizeof(overlapped));
+    overlapped.hEvent = writeEvent;
+    DWORD written = 0;
+    if (!WriteFile(handle, data, DWORD(size), nullptr, &overlapped) &&
+        GetLastError() != ERROR_IO_PENDING) {
+        *error = qt_error_string();
+        return false;
+    }
+    if (WaitForSingleObject(writeEvent, kWriteTimeoutMs) != WAIT_OBJECT_0) {
+        CancelIoEx(handle, &overlapped);
+        GetOverlappedResult(handle, &overlapped, &written, TRUE);
+        *error = QString("Write timed out");
+        return false;
+    }
+    if (!GetOverlappedResult(handle, &overlapped, &written, FALSE) || written != DWORD(size)) {
+        *error = qt_error_string();
+        return false;
+    }
+    return true;
+#else
+    // The descriptor is non-blocking; wait for room when the driver's
+    // buffer is full
+    const char *p = data;
+    qint64 left = size;
+    while (left > 0) {
+        const ssize_t n = ::write(handle, p, size_t(left));
+        if (n > 0) {
+            p += n;
+            left -= n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            pollfd pfd;
+            pfd.fd = handle;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            const int ready = ::poll(&pfd, 1, kWriteTimeoutMs);
+            if (ready > 0 || (ready < 0 && errno == EINTR)) {
+                continue;
+            }
+            *error = ready == 0 ? QString("Write timed out") : qt_error_string(errno);
+            return false;
+        }
+        *error = qt_error_string(errno);
+        return false;
+    }
+    return true;
+#endif
+}
@@ -0,0 +1,33 @@
+#ifndef NATIVEPORTWRITER_H
+#define NATIVEPORTWRITER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QSerialPort>
+
+// Writes to an open port's native handle from a worker thread. QSerialPort
+// may only be used from the thread it lives in, so threads that need tight
+// timing write through the handle while QSerialPort keeps reading on the
+// GUI thread. begin() and end() bracket use on the writing thread; on
+// Windows they also raise the timer resolution for that stretch.
+class NativePortWriter
+{
+public:
+    NativePortWriter();
+    ~NativePortWriter();
+
+    void begin(QSerialPort::Handle handle);
+    void end();
+    // Blocks until everything is written or the port stops accepting data
+    bool write(const QByteArray &data, QString *error);
+    bool write(const char *data, qint64 size, QString *error);
+
+private:
+    QSerialPort::Handle handle;
+    void *writeEvent;   // Overlapped write completion event on Windows
+
+    NativePortWriter(const NativePortWriter &);
+    NativePortWriter &operator=(const NativePortWriter &);
+};
+
+#endif // NATIVEPORTWRITER_H
@@ -0,0 +1,161 @@
+#include "pipelinemetrics.h"
+#include "latencymeter.h"
+#include <cstring>
+
+PipelineSnapshot::PipelineSnapshot()
+    : rxBytesPerSecond(0.0)
+    , rxLinesPerSecond(0.0)
+    , txBytesPerSecond(0.0)
+    , txLinesPerSecond(0.0)
+{
+    for (int i = 0; i < StageCount; ++i) {
+        stageMeanUs[i] = 0.0;
+        stageLoad[i] = 0.0;
+        stageCallsPerSecond[i] = 0.0;
+    }
+    for (int i = 0; i < QueueCount; ++i) {
+        queueDepth[i] = 0;
+    }
+}
+
+PipelineMetrics::StageTimer::StageTimer(PipelineMetrics *metrics, PipelineSnapshot::Stage stage)
+    : metrics(metrics)
+    , stage(stage)
+    , startNs(metrics ? LatencyMeter::clockNs() : 0)
+{
+}
+
+PipelineMetrics::StageTimer::~StageTimer()
+{
+    if (metrics) {
+        metrics->addStageTime(stage, LatencyMeter::clockNs() - startNs);
+    }
+}
+
+PipelineMetrics::PipelineMetrics()
+    : lastNs(0)
+    , lastRxBytes(0)
+    , lastRxLines(0)
+    , lastTxBytes(0)
+    , lastTxLines(0)
+    , ringHead(0)
+{
+    for (int i = 0; i < PipelineSnapshot::StageCount; ++i) {
+        lastStageNs[i] = 0;
+        lastStageCalls[i] = 0;
+    }
+    ring.reserve(HistorySize);
+}
+
+void PipelineMetrics::addReceived(qint64 bytes, qint64 lines)
+{
+    rxBytes.fetchAndAddRelaxed(bytes);
+    rxLines.fetchAndAddRelaxed(lines);
+}
+
+void PipelineMetrics::addTransmitted(qint64 bytes, qint64 lines)
+{
+    txBytes.fetchAndAddRelaxed(bytes);
+    txLines.fetchAndAddRelaxed(lines);
+}
+
+void PipelineMetrics::addStageTime(PipelineSnapshot::Stage stage, qint64 ns)
+{
+    stageNs[stage].fetchAndAddRelaxed(ns);
+    stageCalls[stage].fetchAndAddRelaxed(1);
+}
+
+void PipelineMetrics::setQueueDepth(PipelineSnapshot::Queue queue, qint64 depth)
+{
+    queueDepth[queue].storeRelease(depth);
+}
+
+qint64 PipelineMetrics::countLines(const char *data, qint64 size)
+{
+    qint64 lines = 0;
+    const char *end = data + size;
+    while (const void *found = std::memchr(data, '\n', size_t(end - data))) {
+        ++lines;
+        data = static_cast<const char *>(found) + 1;
+    }
+    return lines;
+}
+
+void PipelineMetrics::snapshot(qint64 nowNs)
+{
+    const qint64 rxBytesNow = rxBytes.loadAcquire();
+    const qint64 rxLinesNow = rxLines.loadAcquire();
+    const qint64 txBytesNow = txBytes.loadAcquire();
+    const qint64 txLinesNow = txLines.loadAcquire();
+    qint64 stageNsNow[PipelineSnapshot::StageCount];
+    qint64 stageCallsNow[PipelineSnapshot::StageCount];
+    for (int i = 0; i < PipelineSnapshot::StageCount; ++i) {
+        stageNsNow[i] = stageNs[i].loadAcquire();
+        stageCallsNow[i] = stageCalls[i].loadAcquire();
+    }
+
+    if (lastNs > 0 && nowNs > lastNs) {
+        const double seconds = (nowNs - lastNs) * 1e-9;
+        PipelineSnapshot s;
+        s.rxBytesPerSecond = (rxBytesNow - lastRxBytes) / seconds;
+        s.rxLinesPerSecond = (rxLinesNow - lastRxLines) / seconds;
+        s.txBytesPerSecond = (txBytesNow - lastTxBytes) / seconds;
+        s.txLinesPerSecond = (txLinesNow - lastTxLines) / seconds;
+        for (int i = 0; i < PipelineSnapshot::StageCount; ++i) {
+            const qint64 ns = stageNsNow[i] - lastStageNs[i];
+            const qint64 calls = stageCallsNow[i] - lastStageCalls[i];
+            s.stageMeanUs[i] = calls > 0 ? ns * 1e-3 / calls : 0.0;
+            s.stageLoad[i] = ns * 1e-9 / seconds;
+            s.stageCallsPerSecond[i] = calls / seconds;
+        }
+        for (int i = 0; i < PipelineSnapshot::QueueCount; ++i) {
+            s.queueDepth[i] = queueDepth[i].loadAcquire();
+        }
+
+        current = s;
+        peaks.rxBytesPerSecond = qMax(peaks.rxBytesPerSecond, s.rxBytesPerSecond);
+        peaks.rxLinesPerSecond = qMax(peaks.rxLinesPerSecond, s.rxLinesPerSecond);
+        peaks.txBytesPerSecond = qMax(peaks.txBytesPerSecond, s.txBytesPerSecond);
+        peaks.txLinesPerSecond = qMax(peaks.txLinesPerSecond, s.txLinesPerSecond);
+        for (int i = 0; i < PipelineSnapshot::StageCount; ++i) {
+            peaks.stageMeanUs[i] = qMax(peaks.stageMeanUs[i], s.stageMeanUs[i]);
+            peaks.stageLoad[i] = qMax(peaks.stageLoad[i], s.stageLoad[i]);
+            peaks.stageCallsPerSecond[i] = qMax(peaks.stageCallsPerSecond[i], s.stageCallsPerSecond[i]);
+        }
+        for (int i = 0; i < PipelineSnapshot::QueueCount; ++i) {
+            peaks.queueDepth[i] = qMax(peaks.queueDepth[i], s.queueDepth[i]);
+        }
+
+        if (ring.size() < HistorySize) {
+            ring.append(s);
+        } else {
+            ring[ringHead] = s;
+            ringHead = (ringHead + 1) % HistorySize;
+        }
+    }
+
+    lastNs = nowNs;
+    lastRxBytes = rxBytesNow;
+    lastRxLines = rxLinesNow;
+    lastTxBytes = txBytesNow;
+    lastTxLines = txLinesNow;
+    for (int i = 0; i < PipelineSnapshot::StageCount; ++i) {
+        lastStageNs[i] = stageNsNow[i];
+        lastStageCalls[i] = stageCallsNow[i];
+    }
+}
+
+void PipelineMetrics::resetPeaks()
+{
+    peaks = current;
+}
+
+QVector<PipelineSnapshot> PipelineMetrics::history() const
+{
+    QVector<PipelineSnapshot> ordered;
+    ordered.reserve(ring.size());
+    for (int i = 0; i < ring.size(); ++i) {
+        ordered.append(ring[(ringHead + i) % ring.size()]);
+    }
+    return ordered;
+}
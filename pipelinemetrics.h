@@ -0,0 +1,105 @@
+#ifndef PIPELINEMETRICS_H
+#define PIPELINEMETRICS_H
+
+#include <QAtomicInteger>
+#include <QVector>
+
+// Rates, stage times and queue depths over one snapshot interval
+struct PipelineSnapshot {
+    enum Stage {
+        Read,           // Taking received bytes from the transport
+        Decode,         // Bytes to display text and into the receive view
+        Parse,          // Text to numbers for the plots
+        PlotIngest,     // Numbers into the channel store, stats and batches
+        Paint,          // Compositing the plot on screen
+        StageCount
+    };
+    enum Queue {
+        RxBacklog,      // Received bytes not read yet
+        TxQueued,       // Held by TransmitQueue
+        TxInFlight,     // Handed to the transport, not confirmed
+        BatchRows,      // Rows waiting for derived and filtered channels
+        QueueCount
+    };
+
+    double rxBytesPerSecond;
+    double rxLinesPerSecond;
+    double txBytesPerSecond;
+    double txLinesPerSecond;
+    double stageMeanUs[StageCount];     // Per call
+    double stageLoad[StageCount];       // Share of the interval spent there
+    double stageCallsPerSecond[StageCount];
+    qint64 queueDepth[QueueCount];
+
+    PipelineSnapshot();
+};
+
+// Counters the receive and transmit pipeline adds to as data moves
+// through it, read back as snapshots for the metrics view. Adding is a
+// relaxed atomic add, so any thread may count and the counting can stay
+// on permanently; snapshot() turns the totals since the previous call into
+// rates and mean stage times, and keeps the peaks and a short history for
+// sparklines.
+class PipelineMetrics
+{
+public:
+    static const int HistorySize = 120;
+
+    // Adds the time from construction to destruction to a stage
+    class StageTimer
+    {
+    public:
+        StageTimer(PipelineMetrics *metrics, PipelineSnapshot::Stage stage);
+        ~StageTimer();
+
+    private:
+        PipelineMetrics *metrics;
+        PipelineSnapshot::Stage stage;
+        qint64 startNs;
+    };
+
+    PipelineMetrics();
+
+    void addReceived(qint64 bytes, qint64 lines);
+    void addTransmitted(qint64 bytes, qint64 lines);
+    void addStageTime(PipelineSnapshot::Stage stage, qint64 ns);
+    void setQueueDepth(PipelineSnapshot::Queue queue, qint64 depth);
+
+    // Line ends in data, for the line rates
+    static qint64 countLines(const char *data, qint64 size);
+
+    // Closes the interval ending at nowNs; the first call only starts one.
+    // Snapshots are taken from one thread.
+    void snapshot(qint64 nowNs);
+    const PipelineSnapshot &last() const { return current; }
+    // Highest value of every field since construction or resetPeaks()
+    const PipelineSnapshot &peak() const { return peaks; }
+    void resetPeaks();
+    // Oldest first, one per snapshot, at most HistorySize
+    QVector<PipelineSnapshot> history() const;
+
+private:
+    QAtomicInteger<qint64> rxBytes;
+    QAtomicInteger<qint64> rxLines;
+    QAtomicInteger<qint64> txBytes;
+    QAtomicInteger<qint64> txLines;
+    QAtomicInteger<qint64> stageNs[PipelineSnapshot::StageCount];
+    QAtomicInteger<qint64> stageCalls[PipelineSnapshot::StageCount];
+    QAtomicInteger<qint64> queueDepth[PipelineSnapshot::QueueCount];
+
+    // Totals at the previous snapshot
+    qint64 lastNs;
+    qint64 lastRxBytes;
+    qint64 lastRxLines;
+    qint64 lastTxBytes;
+    qint64 lastTxLines;
+    qint64 lastStageNs[PipelineSnapshot::StageCount];
+    qint64 lastStageCalls[PipelineSnapshot::StageCount];
+
+    PipelineSnapshot current;
+    PipelineSnapshot peaks;
+    QVector<PipelineSnapshot> ring;
+    int ringHead;           // Next slot to write once the ring is full
+};
+
+#endif // PIPELINEMETRICS_H
@@ -0,0 +1,239 @@
+#include "plotexporter.h"
+#include <QFile>
+#include <QVector>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+// Rows (CSV) or samples per column (binary) handled per write
+const int kChunkSize = 65536;
+
+void appendLittleEndian(QByteArray &out, quint64 value)
+{
+    value = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void appendLittleEndian(QByteArray &out, quint32 value)
+{
+    value = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void appendLittleEndian(QByteArray &out, quint16 value)
+{
+    value = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// RFC 4180: fields holding a comma, quote or line break are quoted, with
+// quotes doubled
+QByteArray csvField(const QString &text)
+{
+    QByteArray field = text.toUtf8();
+    if (field.contains(',') || field.contains('"') || field.contains('\n') || field.contains('\r')) {
+        field.replace('"', "\"\"");
+        field = '"' + field + '"';
+    }
+    return field;
+}
+
+} // namespace
+
+PlotExporter::PlotExporter(const QString &fileName, Format format,
+                           const QSharedPointer<ExportSource> &source, QObject *parent)
+    : QObject(parent)
+    , fileName(fileName)
+    , format(format)
+    , source(source)
+    , cancelled(0)
+    , lastPercent(-1)
+{
+}
+
+void PlotExporter::cancel()
+{
+    cancelled.storeRelease(1);
+}
+
+void PlotExporter::run()
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        emit finished(false, fileName);
+        return;
+    }
+
+    bool ok = (format == Csv) ? writeCsv(&file) : writeBinary(&file);
+    file.close();
+
+    if (!ok) {
+        file.remove();
+    }
+    emit finished(ok, fileName);
+}
+
+void PlotExporter::reportProgress(qint64 done, qint64 total)
+{
+    int percent = total > 0 ? (int)(done * 100 / total) : 100;
+    if (percent != lastPercent) {
+        lastPercent = percent;
+        emit progress(percent);
+    }
+}
+
+bool PlotExporter::writeCsv(QIODevice *device)
+{
+    const int channels = source->channelCount();
+
+    QVector<qint64> counts(channels);
+    qint64 total = 0;
+    QByteArray header("index,timestamp_ms");
+    for (int ch = 0; ch < channels; ++ch) {
+        counts[ch] = source->sampleCount(ch);
+        total += counts[ch];
+        header += ',' + csvField(source->channelName(ch));
+    }
+    header += '\n';
+    if (device->write(header) != header.size()) {
+        return false;
+    }
+
+    // Channels are trimmed separately and may skip rows, so they are merged
+    // on timestamp rather than paired by index. Each row takes the next
+    // sample of every channel whose next sample has the row's timestamp;
+    // several samples in one millisecond make as many rows.
+    QVector<QVector<qint64>> timestamps(channels);
+    QVector<QVector<double>> values(channels);
+    QVector<qint64> windowStart(channels, 0);  // Sample index of the window's first entry
+    QVector<qint64> next(channels, 0);         // Next sample to write
+    QByteArray out;
+    qint64 row = 0;
+    qint64 done = 0;
+
+    // Window entry holding the next sample of ch, read ahead in chunks
+    auto head = [&](int ch) {
+        const qint64 offset = next[ch] - windowStart[ch];
+        if (offset < timestamps[ch].size()) {
+            return int(offset);
+        }
+        const int chunk = (int)qMin<qint64>(kChunkSize, counts[ch] - next[ch]);
+        timestamps[ch].resize(chunk);
+        values[ch].resize(chunk);
+        source->read(ch, next[ch], chunk, timestamps[ch].data(), values[ch].data());
+        windowStart[ch] = next[ch];
+        return 0;
+    };
+
+    for (;;) {
+        bool any = false;
+        qint64 timestamp = 0;
+        for (int ch = 0; ch < channels; ++ch) {
+            if (next[ch] < counts[ch]) {
+                const qint64 t = timestamps[ch][head(ch)];
+                if (!any || t < timestamp) {
+                    timestamp = t;
+                }
+                any = true;
+            }
+        }
+        if (!any) {
+            break;
+        }
+
+        out += QByteArray::number(row++);
+        out += ',';
+        out += QByteArray::number(timestamp);
+        for (int ch = 0; ch < channels; ++ch) {
+            out += ',';
+            if (next[ch] < counts[ch]) {
+                const int i = head(ch);
+                if (timestamps[ch][i] == timestamp) {
+                    out += QByteArray::number(values[ch][i], 'g', 15);
+                    ++next[ch];
+                    ++done;
+                }
+            }
+        }
+        out += '\n';
+
+        if (row % kChunkSize == 0) {
+            if (cancelled.loadAcquire() || device->write(out) != out.size()) {
+                return false;
+            }
+            out.clear();
+            reportProgress(done, total);
+        }
+    }
+
+    if (device->write(out) != out.size()) {
+        return false;
+    }
+    reportProgress(total, total);
+    return true;
+}
+
+bool PlotExporter::writeBinary(QIODevice *device)
+{
+    const int channels = source->channelCount();
+
+    QByteArray header("SDCB");
+    appendLittleEndian(header, quint32(1));
+    appendLittleEndian(header, quint32(channels));
+
+    qint64 total = 0;
+    for (int ch = 0; ch < channels; ++ch) {
+        QByteArray name = source->channelName(ch).toUtf8().left(0xFFFF);
+        qint64 count = source->sampleCount(ch);
+        appendLittleEndian(header, quint16(name.size()));
+        header += name;
+        appendLittleEndian(header, quint64(count));
+        total += 2 * count;
+    }
+    if (device->write(header) != header.size()) {
+        return false;
+    }
+
+    QVector<qint64> timestamps(kChunkSize);
+    QVector<double> values(kChunkSize);
+    QByteArray out;
+    out.reserve(kChunkSize * 8);
+    qint64 done = 0;
+
+    for (int ch = 0; ch < channels; ++ch) {
+        const qint64 count = source->sampleCount(ch);
+
+        // Two passes per channel keep each column contiguous on disk
+        for (int column = 0; column < 2; ++column) {
+            for (qint64 start = 0; start < count; start += kChunkSize) {
+                if (cancelled.loadAcquire()) {
+                    return false;
+                }
+
+                const int chunk = (int)qMin<qint64>(kChunkSize, count - start);
+                source->read(ch, start, chunk, timestamps.data(), values.data());
+
+                out.clear();
+                for (int i = 0; i < chunk; ++i) {
+                    quint64 bits;
+                    if (column == 0) {
+                        bits = quint64(timestamps[i]);
+                    } else {
+                        std::memcpy(&bits, &values[i], sizeof(bits));
+                    }
+                    appendLittleEndian(out, bits);
+                }
+
+                if (device->write(out) != out.size()) {
+                    return false;
+                }
+                done += chunk;
+                reportProgress(done, total);
+            }
+        }
+    }
+
+    reportProgress(total, total);
+    return true;
+}
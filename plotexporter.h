@@ -0,0 +1,69 @@
+#ifndef PLOTEXPORTER_H
+#define PLOTEXPORTER_H
+
+#include <QObject>
+#include <QString>
+#include <QAtomicInt>
+#include <QSharedPointer>
+
+class QIODevice;
+
+// Read-only column access for the exporter. Implementations must be safe to
+// call from the export thread while the GUI keeps receiving data, which in
+// practice means reading from a snapshot rather than the live containers.
+class ExportSource
+{
+public:
+    virtual ~ExportSource() {}
+
+    virtual int channelCount() const = 0;
+    virtual QString channelName(int channel) const = 0;
+    virtual qint64 sampleCount(int channel) const = 0;
+
+    // Copy samples [start, start + count) into the caller's buffers
+    virtual void read(int channel, qint64 start, int count,
+                      qint64 *timestamps, double *values) const = 0;
+};
+
+// Streams plot channels to disk on a background thread in fixed-size chunks.
+//
+// Binary columnar layout (all integers little-endian):
+//   "SDCB" | u32 version | u32 channelCount
+//   per channel: u16 nameLength | UTF-8 name | u64 sampleCount
+//   per channel: i64 timestamps[sampleCount] | f64 values[sampleCount]
+class PlotExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Format {
+        Csv,
+        BinaryColumnar
+    };
+
+    PlotExporter(const QString &fileName, Format format,
+                 const QSharedPointer<ExportSource> &source, QObject *parent = nullptr);
+
+    // Thread-safe; the export stops at the next chunk boundary
+    void cancel();
+
+public slots:
+    void run();
+
+signals:
+    void progress(int percent);
+    void finished(bool ok, const QString &fileName);
+
+private:
+    QString fileName;
+    Format format;
+    QSharedPointer<ExportSource> source;
+    QAtomicInt cancelled;
+    int lastPercent;
+
+    bool writeCsv(QIODevice *device);
+    bool writeBinary(QIODevice *device);
+    void reportProgress(qint64 done, qint64 total);
+};
+
+#endif // PLOTEXPORTER_H
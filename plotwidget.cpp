@@ -1,10 +1,336 @@
 #include "plotwidget.h"
+#include "pipelinemetrics.h"
 #include <QPaintEvent>
 #include <QFontMetrics>
+#include <QRunnable>
+#include <QPolygonF>
 #include <cmath>
 
+namespace {
+
+// Minimum time between two offscreen frames (~60 fps)
+const int kFrameIntervalMs = 16;
+// XY frames with more pairs than one per this many plot pixels are drawn
+// as a density grid rather than point by point
+const int kXYPixelsPerPoint = 8;
+
+QColor channelColor(int channel)
+{
+    static const QColor colors[] = {
+        QColor(255, 0, 0),      // Red
+        QColor(0, 0, 255),      // Blue
+        QColor(0, 128, 0),      // Green
+        QColor(255, 165, 0),    // Orange
+        QColor(128, 0, 128),    // Purple
+        QColor(0, 128, 128),    // Teal
+        QColor(139, 69, 19),    // Brown
+        QColor(255, 0, 255),    // Magenta
+        QColor(0, 0, 128),      // Navy
+        QColor(128, 128, 0)     // Olive
+    };
+    const int count = int(sizeof(colors) / sizeof(colors[0]));
+    return colors[channel % count];
+}
+
+QPointF dataToScreen(int index, double value, int totalPoints, const QSize &size,
+                     double minValue, double maxValue)
+{
+    const int leftMargin = 75;
+    const int rightMargin = 20;
+    const int topMargin = 40;
+    const int bottomMargin = 50;
+    
+    int plotWidth = size.width() - leftMargin - rightMargin;
+    int plotHeight = size.height() - topMargin - bottomMargin;
+    
+    double x = leftMargin + (double)index / (totalPoints - 1) * plotWidth;
+    double y = topMargin + plotHeight - ((value - minValue) / (maxValue - minValue)) * plotHeight;
+    
+    return QPointF(x, y);
+}
+
+// Draws one channel into a transparent, widget-sized image. Runs on a
+// worker thread, so it must only touch the arguments it is given.
+QImage renderChannelLayer(const ChannelView &view, const QColor &color,
+                          const QSize &size, qreal dpr, double minValue, double maxValue)
+{
+    QImage image(size * dpr, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(dpr);
+    image.fill(Qt::transparent);
+    
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    
+    // Non-finite samples (e.g. a derived channel warming up) break the line
+    const int total = (int)view.size();
+    QVector<QPolygonF> runs(1);
+    int index = 0;
+    view.forEachSpan([&](const qint64 *, const double *values, int count) {
+        for (int i = 0; i < count; ++i, ++index) {
+            if (!std::isfinite(values[i])) {
+                if (!runs.last().isEmpty()) {
+                    runs.append(QPolygonF());
+                }
+                continue;
+            }
+            runs.last().append(dataToScreen(index, values[i], total, size, minValue, maxValue));
+        }
+    });
+    
+    for (const QPolygonF &points : runs) {
+        // Draw shadow for depth effect
+        painter.setPen(QPen(color.darker(120), 3, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+        painter.setOpacity(0.3);
+        painter.drawPolyline(points.translated(2, 2));
+        
+        // Draw main line
+        painter.setOpacity(1.0);
+        painter.setPen(QPen(color, 2, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+        painter.drawPolyline(points);
+        
+        // Draw points
+        painter.setBrush(color);
+        for (int i = 0; i < points.size(); ++i) {
+            if (i % 5 == 0 || i == points.size() - 1) {  // Draw every 5th point and last point
+                painter.drawEllipse(points[i], 3, 3);
+            }
+        }
+    }
+    
+    return image;
+}
+
+// Plot area of the frame paintEvent() draws
+QRectF xyPlotArea(const QSize &size)
+{
+    return QRectF(60, 30, size.width() - 60 - 20, size.height() - 30 - 40);
+}
+
+void pairSamples(const ChannelView &xView, const ChannelView &yView, bool byTimestamp,
+                 QVector<double> *xs, QVector<double> *ys)
+{
+    if (!byTimestamp) {
+        // Line up the newest samples of both channels
+        const int count = (int)qMin(xView.size(), yView.size());
+        xs->resize(count);
+        ys->resize(count);
+        xView.read(xView.size() - count, count, nullptr, xs->data());
+        yView.read(yView.size() - count, count, nullptr, ys->data());
+        return;
+    }
+    
+    // Merge on timestamp: each Y sample takes the last X sample at or
+    // before it, Y samples older than any X sample are dropped
+    const int xCount = (int)xView.size();
+    const int yCount = (int)yView.size();
+    QVector<qint64> xTimes(xCount), yTimes(yCount);
+    QVector<double> xValues(xCount), yValues(yCount);
+    xView.read(0, xCount, xTimes.data(), xValues.data());
+    yView.read(0, yCount, yTimes.data(), yValues.data());
+    xs->reserve(yCount);
+    ys->reserve(yCount);
+    int i = -1;
+    for (int j = 0; j < yCount; ++j) {
+        while (i + 1 < xCount && xTimes[i + 1] <= yTimes[j]) {
+            ++i;
+        }
+        if (i >= 0) {
+            xs->append(xValues[i]);
+            ys->append(yValues[j]);
+        }
+    }
+}
+
+// Bounding box of the finite pairs plus a margin; false if there are none
+bool pairRange(const QVector<double> &xs, const QVector<double> &ys, QRectF *range)
+{
+    double xMin = 0.0, xMax = 0.0, yMin = 0.0, yMax = 0.0;
+    bool first = true;
+    for (int i = 0; i < xs.size(); ++i) {
+        if (!std::isfinite(xs[i]) || !std::isfinite(ys[i])) {
+            continue;
+        }
+        if (first) {
+            xMin = xMax = xs[i];
+            yMin = yMax = ys[i];
+            first = false;
+            continue;
+        }
+        xMin = qMin(xMin, xs[i]);
+        xMax = qMax(xMax, xs[i]);
+        yMin = qMin(yMin, ys[i]);
+        yMax = qMax(yMax, ys[i]);
+    }
+    if (first) {
+        return false;
+    }
+    
+    const double xSpan = qMax(xMax - xMin, 0.1);
+    const double ySpan = qMax(yMax - yMin, 0.1);
+    *range = QRectF(xMin - xSpan * 0.1, yMin - ySpan * 0.1, xSpan * 1.2, ySpan * 1.2);
+    return true;
+}
+
+// Draws yView against xView into a transparent, widget-sized image. Small
+// frames are drawn point by point; above the pixel budget pairs are binned
+// into a per-pixel count grid and shaded by log density, which costs one
+// pass over the pairs plus one over the plot area however many pairs
+// there are. Runs on a worker thread like renderChannelLayer().
+QImage renderXYLayer(const ChannelView &xView, const ChannelView &yView, bool byTimestamp,
+                     bool connectPoints, const QColor &color, const QSize &size, qreal dpr,
+                     QRectF *range, int *pairs)
+{
+    QImage image(size * dpr, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(dpr);
+    image.fill(Qt::transparent);
+    
+    QVector<double> xs, ys;
+    pairSamples(xView, yView, byTimestamp, &xs, &ys);
+    *pairs = xs.size();
+    const QRectF area = xyPlotArea(size);
+    if (!pairRange(xs, ys, range) || area.width() <= 0 || area.height() <= 0) {
+        return image;
+    }
+    
+    const qint64 budget = qint64(area.width() * area.height()) / kXYPixelsPerPoint;
+    if (xs.size() <= budget) {
+        const double sx = area.width() / range->width();
+        const double sy = area.height() / range->height();
+        QPolygonF points;
+        points.reserve(xs.size());
+        for (int i = 0; i < xs.size(); ++i) {
+            if (std::isfinite(xs[i]) && std::isfinite(ys[i])) {
+                points.append(QPointF(area.left() + (xs[i] - range->left()) * sx,
+                                      area.bottom() - (ys[i] - range->top()) * sy));
+            }
+        }
+        
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setClipRect(area);
+        if (connectPoints) {
+            painter.setPen(QPen(color, 1.5, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+            painter.drawPolyline(points);
+        } else {
+            painter.setPen(Qt::NoPen);
+            painter.setBrush(color);
+            for (int i = 0; i < points.size(); ++i) {
+                painter.drawEllipse(points[i], 2, 2);
+            }
+        }
+        return image;
+    }
+    
+    // Density grid at device resolution
+    const int left = qRound(area.left() * dpr);
+    const int top = qRound(area.top() * dpr);
+    const int w = qMin(int(area.width() * dpr), image.width() - left);
+    const int h = qMin(int(area.height() * dpr), image.height() - top);
+    if (w <= 0 || h <= 0) {
+        return image;
+    }
+    QVector<quint32> grid(w * h, 0);
+    const double gx = w / range->width();
+    const double gy = h / range->height();
+    quint32 peak = 0;
+    for (int i = 0; i < xs.size(); ++i) {
+        const double fx = (xs[i] - range->left()) * gx;
+        const double fy = (ys[i] - range->top()) * gy;
+        // Written so NaN fails the test too
+        if (!(fx >= 0.0 && fx < w && fy >= 0.0 && fy < h)) {
+            continue;
+        }
+        quint32 &cell = grid[(h - 1 - int(fy)) * w + int(fx)];
+        if (++cell > peak) {
+            peak = cell;
+        }
+    }
+    
+    const double scale = 1.0 / std::log1p(double(qMax<quint32>(peak, 1)));
+    for (int y = 0; y < h; ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(top + y)) + left;
+        const quint32 *counts = grid.constData() + y * w;
+        for (int x = 0; x < w; ++x) {
+            if (counts[x] == 0) {
+                continue;
+            }
+            const int alpha = 64 + int(191.0 * std::log1p(double(counts[x])) * scale);
+            line[x] = qPremultiply(qRgba(color.red(), color.green(), color.blue(), alpha));
+        }
+    }
+    return image;
+}
+
+class PlotLayerTask : public QRunnable
+{
+public:
+    PlotLayerTask(PlotWidget *widget, int generation, int channel,
+                  const ChannelView &view, const QColor &color,
+                  const QSize &size, qreal dpr, double minValue, double maxValue)
+        : widget(widget), generation(generation), channel(channel)
+        , view(view), color(color), size(size), dpr(dpr)
+        , minValue(minValue), maxValue(maxValue) {}
+    
+    void run() override
+    {
+        QImage image = renderChannelLayer(view, color, size, dpr, minValue, maxValue);
+        // Hand the finished layer back to the GUI thread
+        QMetaObject::invokeMethod(widget, "onLayerRendered", Qt::QueuedConnection,
+                                  Q_ARG(int, generation), Q_ARG(int, channel),
+                                  Q_ARG(QImage, image));
+    }
+    
+private:
+    PlotWidget *widget;
+    int generation;
+    int channel;
+    ChannelView view;  // Shares the store's chunks, no sample copies
+    QColor color;
+    QSize size;
+    qreal dpr;
+    double minValue;
+    double maxValue;
+};
+
+class XYLayerTask : public QRunnable
+{
+public:
+    XYLayerTask(PlotWidget *widget, int generation, const ChannelView &xView,
+                const ChannelView &yView, bool byTimestamp, bool connectPoints,
+                const QColor &color, const QSize &size, qreal dpr)
+        : widget(widget), generation(generation), xView(xView), yView(yView)
+        , byTimestamp(byTimestamp), connectPoints(connectPoints)
+        , color(color), size(size), dpr(dpr) {}
+    
+    void run() override
+    {
+        QRectF range;
+        int pairs = 0;
+        QImage image = renderXYLayer(xView, yView, byTimestamp, connectPoints,
+                                     color, size, dpr, &range, &pairs);
+        QMetaObject::invokeMethod(widget, "onXYRendered", Qt::QueuedConnection,
+                                  Q_ARG(int, generation), Q_ARG(QImage, image),
+                                  Q_ARG(QRectF, range), Q_ARG(int, pairs));
+    }
+    
+private:
+    PlotWidget *widget;
+    int generation;
+    ChannelView xView;
+    ChannelView yView;
+    bool byTimestamp;
+    bool connectPoints;
+    QColor color;
+    QSize size;
+    qreal dpr;
+};
+
+} // namespace
+
 PlotWidget::PlotWidget(QWidget *parent)
     : QWidget(parent)
+    , store(nullptr)
+    , metrics(nullptr)
     , maxDataPoints(1000)
     , minValue(-2.0)
     , maxValue(2.0)
@@ -14,64 +340,112 @@ PlotWidget::PlotWidget(QWidget *parent)
     , yAxisLabel("Value")
     , xAxisLabel("Number of points")
     , waitingMessage("Waiting for data...\nSend numeric values to plot")
+    , frozen(false)
+    , frozenTriggerIndex(-1)
+    , frozenLevel(0.0)
+    , renderTimer(new QTimer(this))
+    , renderGeneration(0)
+    , layersInFlight(0)
+    , renderDirty(false)
+    , layerMinValue(-2.0)
+    , layerMaxValue(2.0)
+    , xyMode(false)
+    , xyChannelX(0)
+    , xyChannelY(1)
+    , xyPairing(PairByIndex)
+    , xyConnect(true)
+    , xyDepth(1000)
+    , xyPairs(0)
 {
     setMinimumSize(400, 300);
     setBackgroundRole(QPalette::Base);
     setAutoFillBackground(true);
     
+    renderTimer->setSingleShot(true);
+    renderTimer->setInterval(kFrameIntervalMs);
+    connect(renderTimer, &QTimer::timeout, this, &PlotWidget::startLayerRender);
+    
     // Initialize 6 channels with different colors
-    QVector<QColor> colors;
-    colors << QColor(255, 0, 0)      // Red
-           << QColor(0, 0, 255)      // Blue
-           << QColor(0, 128, 0)      // Green
-           << QColor(255, 165, 0)    // Orange
-           << QColor(128, 0, 128)    // Purple
-           << QColor(0, 128, 128);   // Teal
-    
-    for (int i = 0; i < 6; ++i) {
-        PlotData data;
-        data.color = colors[i];
-        data.name = QString("Graph %1").arg(i + 1);
-        data.visible = true;
-        channels.append(data);
-    }
+    setChannelCount(6);
 }
 
-void PlotWidget::addDataPoint(int channel, double value)
+PlotWidget::~PlotWidget()
 {
-    if (channel < 0 || channel >= channels.size()) {
-        return;
-    }
-    
-    channels[channel].values.append(value);
-    
-    // Limit data points
-    if (channels[channel].values.size() > maxDataPoints) {
-        channels[channel].values.removeFirst();
-    }
-    
-    if (autoScale) {
-        updateMinMax();
+    // Workers post back to this object, so let them finish first
+    renderPool.clear();
+    renderPool.waitForDone();
+}
+
+void PlotWidget::setChannelStore(const ChannelStore *channelStore)
+{
+    store = channelStore;
+    scheduleRender();
+}
+
+void PlotWidget::setMetrics(PipelineMetrics *pipelineMetrics)
+{
+    metrics = pipelineMetrics;
+}
+
+void PlotWidget::dataAppended()
+{
+    // Rescaling and drawing happen once per frame, not per sample
+    if (!frozen) {
+        scheduleRender();
     }
-    
-    update();
 }
 
 void PlotWidget::clearData()
 {
-    for (int i = 0; i < channels.size(); ++i) {
-        channels[i].values.clear();
-    }
     minValue = -2.0;
     maxValue = 2.0;
+    frozen = false;
+    frozenViews.clear();
+    frozenTriggerIndex = -1;
+    
+    // Drop the current frame and anything still being rendered
+    ++renderGeneration;
+    layers.clear();
+    layerViews.clear();
+    layerMinValue = minValue;
+    layerMaxValue = maxValue;
+    xyLayer = QImage();
+    xyPairs = 0;
     update();
 }
 
+void PlotWidget::setChannelCount(int count)
+{
+    for (int i = channels.size(); i < count; ++i) {
+        PlotData data;
+        data.color = channelColor(i);
+        data.name = QString("Graph %1").arg(i + 1);
+        data.visible = true;
+        channels.append(data);
+    }
+    channels.resize(count);
+    
+    // Frozen captures only cover the parsed channels
+    frozenViews.resize(frozen ? count : 0);
+    ++renderGeneration;
+    layers.clear();
+    layerViews.clear();
+    scheduleRender();
+}
+
+void PlotWidget::setChannelName(int channel, const QString &name)
+{
+    if (channel >= 0 && channel < channels.size()) {
+        channels[channel].name = name;
+        update();
+    }
+}
+
 void PlotWidget::setChannelVisible(int channel, bool visible)
 {
     if (channel >= 0 && channel < channels.size()) {
         channels[channel].visible = visible;
-        update();
+        scheduleRender();
     }
 }
 
@@ -79,7 +453,7 @@ void PlotWidget::setChannelColor(int channel, const QColor &color)
 {
     if (channel >= 0 && channel < channels.size()) {
         channels[channel].color = color;
-        update();
+        scheduleRender();
     }
 }
 
@@ -88,24 +462,78 @@ void PlotWidget::setMaxDataPoints(int max)
     maxDataPoints = max;
 }
 
-void PlotWidget::updateMinMax()
+void PlotWidget::setXYMode(bool enabled, int xChannel, int yChannel, Pairing pairing,
+                           bool connectPoints, int depth)
+{
+    xyMode = enabled;
+    xyChannelX = xChannel;
+    xyChannelY = yChannel;
+    xyPairing = pairing;
+    xyConnect = connectPoints;
+    xyDepth = qMax(2, depth);
+    xyLayer = QImage();
+    xyPairs = 0;
+    scheduleRender();
+}
+
+void PlotWidget::showCapture(const QVector<QVector<double>> &capture, int triggerIndex, double level)
+{
+    frozen = true;
+    frozenViews = QVector<ChannelView>(channels.size());
+    for (int ch = 0; ch < capture.size() && ch < channels.size(); ++ch) {
+        frozenViews[ch] = ChannelView::fromValues(capture[ch]);
+    }
+    frozenTriggerIndex = triggerIndex;
+    frozenLevel = level;
+    scheduleRender();
+}
+
+void PlotWidget::releaseCapture()
+{
+    if (!frozen) {
+        return;
+    }
+    frozen = false;
+    frozenViews.clear();
+    frozenTriggerIndex = -1;
+    scheduleRender();
+}
+
+ChannelView PlotWidget::displayView(int channel) const
+{
+    if (frozen) {
+        return frozenViews[channel];
+    }
+    // Only the newest samples are plotted, whatever the store retains
+    if (store && channel < store->channelCount()) {
+        return store->tail(channel, xyMode ? xyDepth : maxDataPoints);
+    }
+    return ChannelView();
+}
+
+void PlotWidget::updateMinMax(const QVector<ChannelView> &views)
 {
     bool first = true;
     
     for (int i = 0; i < channels.size(); ++i) {
-        if (!channels[i].visible || channels[i].values.isEmpty()) {
+        if (!channels[i].visible || views[i].isEmpty()) {
             continue;
         }
         
-        for (double value : channels[i].values) {
-            if (first) {
-                minValue = maxValue = value;
-                first = false;
-            } else {
-                if (value < minValue) minValue = value;
-                if (value > maxValue) maxValue = value;
+        views[i].forEachSpan([&](const qint64 *, const double *values, int count) {
+            for (int j = 0; j < count; ++j) {
+                // Gaps do not count towards the range
+                if (!std::isfinite(values[j])) {
+                    continue;
+                }
+                if (first) {
+                    minValue = maxValue = values[j];
+                    first = false;
+                }
+                if (values[j] < minValue) minValue = values[j];
+                if (values[j] > maxValue) maxValue = values[j];
             }
-        }
+        });
     }
     
     // Add some margin
@@ -117,24 +545,155 @@ void PlotWidget::updateMinMax()
     }
 }
 
-QPointF PlotWidget::dataToScreen(int index, double value, int totalPoints)
+void PlotWidget::scheduleRender()
 {
-    const int leftMargin = 75;
-    const int rightMargin = 20;
-    const int topMargin = 40;
-    const int bottomMargin = 50;
+    if (!renderTimer->isActive()) {
+        renderTimer->start();
+    }
+}
+
+void PlotWidget::startLayerRender()
+{
+    // Only one frame in flight at a time; the next one starts when it lands
+    if (layersInFlight > 0) {
+        renderDirty = true;
+        return;
+    }
+    renderDirty = false;
     
-    int plotWidth = width() - leftMargin - rightMargin;
-    int plotHeight = height() - topMargin - bottomMargin;
+    if (xyMode) {
+        startXYRender();
+        return;
+    }
     
-    double x = leftMargin + (double)index / (totalPoints - 1) * plotWidth;
-    double y = topMargin + plotHeight - ((value - minValue) / (maxValue - minValue)) * plotHeight;
+    // Snapshot the frame's samples once; workers read these views directly
+    pendingViews = QVector<ChannelView>(channels.size());
+    for (int ch = 0; ch < channels.size(); ++ch) {
+        pendingViews[ch] = displayView(ch);
+    }
     
-    return QPointF(x, y);
+    if (autoScale) {
+        updateMinMax(pendingViews);
+    }
+    
+    ++renderGeneration;
+    pendingLayers = QVector<QImage>(channels.size());
+    
+    const QSize layerSize = size();
+    const qreal dpr = devicePixelRatioF();
+    
+    int jobs = 0;
+    for (int ch = 0; ch < channels.size(); ++ch) {
+        const ChannelView &view = pendingViews[ch];
+        if (!channels[ch].visible || view.size() < 2) {
+            continue;
+        }
+#ifdef __EMSCRIPTEN__
+        // No worker threads in the WebAssembly build, render inline
+        pendingLayers[ch] = renderChannelLayer(view, channels[ch].color,
+                                               layerSize, dpr, minValue, maxValue);
+#else
+        renderPool.start(new PlotLayerTask(this, renderGeneration, ch,
+                                           view, channels[ch].color,
+                                           layerSize, dpr, minValue, maxValue));
+        ++jobs;
+#endif
+    }
+    
+    layersInFlight = jobs;
+    if (jobs == 0) {
+        layers = pendingLayers;
+        layerViews = pendingViews;
+        layerMinValue = minValue;
+        layerMaxValue = maxValue;
+        update();
+    }
+}
+
+void PlotWidget::startXYRender()
+{
+    // Only the two paired channels are snapshotted
+    pendingViews = QVector<ChannelView>(channels.size());
+    const bool valid = xyChannelX >= 0 && xyChannelX < channels.size() &&
+                       xyChannelY >= 0 && xyChannelY < channels.size();
+    if (valid) {
+        pendingViews[xyChannelX] = displayView(xyChannelX);
+        pendingViews[xyChannelY] = displayView(xyChannelY);
+    }
+    
+    ++renderGeneration;
+    if (!valid || pendingViews[xyChannelX].isEmpty() || pendingViews[xyChannelY].isEmpty()) {
+        xyLayer = QImage();
+        xyPairs = 0;
+        layerViews = pendingViews;
+        update();
+        return;
+    }
+    
+    // Captures carry no timestamps, so they always pair by index
+    const bool byTimestamp = xyPairing == PairByTimestamp && !frozen;
+    layersInFlight = 1;
+#ifdef __EMSCRIPTEN__
+    QRectF range;
+    int pairs = 0;
+    QImage image = renderXYLayer(pendingViews[xyChannelX], pendingViews[xyChannelY],
+                                 byTimestamp, xyConnect, channels[xyChannelY].color,
+                                 size(), devicePixelRatioF(), &range, &pairs);
+    onXYRendered(renderGeneration, image, range, pairs);
+#else
+    renderPool.start(new XYLayerTask(this, renderGeneration,
+                                     pendingViews[xyChannelX], pendingViews[xyChannelY],
+                                     byTimestamp, xyConnect, channels[xyChannelY].color,
+                                     size(), devicePixelRatioF()));
+#endif
+}
+
+void PlotWidget::onXYRendered(int generation, const QImage &image, const QRectF &range, int pairs)
+{
+    --layersInFlight;
+    
+    if (generation == renderGeneration) {
+        xyLayer = image;
+        xyRange = range;
+        xyPairs = pairs;
+        layerViews = pendingViews;
+        update();
+    }
+    
+    if (renderDirty) {
+        scheduleRender();
+    }
+}
+
+void PlotWidget::onLayerRendered(int generation, int channel, const QImage &image)
+{
+    --layersInFlight;
+    
+    if (generation == renderGeneration && channel < pendingLayers.size()) {
+        pendingLayers[channel] = image;
+    }
+    
+    if (layersInFlight > 0) {
+        return;
+    }
+    
+    // Frame complete: swap it in as a whole so channels never tear
+    if (generation == renderGeneration) {
+        layers = pendingLayers;
+        layerViews = pendingViews;
+        layerMinValue = minValue;
+        layerMaxValue = maxValue;
+        update();
+    }
+    
+    if (renderDirty) {
+        scheduleRender();
+    }
 }
 
 void PlotWidget::paintEvent(QPaintEvent *event)
 {
+    PipelineMetrics::StageTimer timer(metrics, PipelineSnapshot::Paint);
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing);
     
@@ -168,7 +727,8 @@ void PlotWidget::paintEvent(QPaintEvent *event)
         painter.drawLine(leftMargin, y, leftMargin + plotWidth, y);
         
         // Y-axis labels with better formatting
-        double value = maxValue - (maxValue - minValue) * i / 4;
+        double value = xyMode ? xyRange.bottom() - xyRange.height() * i / 4
+                              : layerMaxValue - (layerMaxValue - layerMinValue) * i / 4;
         QString label = QString::number(value, 'f', 2);
         
         painter.setPen(QColor(44, 62, 80));
@@ -183,8 +743,15 @@ void PlotWidget::paintEvent(QPaintEvent *event)
         int x = leftMargin + i * plotWidth / 10;
         painter.drawLine(x, topMargin, x, topMargin + plotHeight);
         
-        // X-axis tick labels
-        if (maxPoints > 0 && i % 2 == 0) {
+        // X-axis tick labels: X channel values in XY mode
+        if (xyMode && xyPairs > 0 && i % 2 == 0) {
+            double value = xyRange.left() + xyRange.width() * i / 10;
+            painter.setPen(QColor(44, 62, 80));
+            painter.setFont(QFont("Microsoft YaHei UI", 8));
+            painter.drawText(x - 30, topMargin + plotHeight + 5, 60, 15,
+                           Qt::AlignCenter, QString::number(value, 'g', 4));
+            painter.setPen(QPen(QColor(220, 220, 220), 1, Qt::DotLine));
+        } else if (!xyMode && maxPoints > 0 && i % 2 == 0) {
             int pointNum = (maxPoints * i) / 10;
             painter.setPen(QColor(44, 62, 80));
             painter.setFont(QFont("Microsoft YaHei UI", 8));
@@ -206,11 +773,14 @@ void PlotWidget::paintEvent(QPaintEvent *event)
     painter.setFont(QFont("Microsoft YaHei UI", 11, QFont::Bold));
     painter.drawText(titleRect, Qt::AlignCenter, plotTitle);
     
+    // In XY mode the axes are named after the paired channels
+    const bool xyValid = xyMode && xyChannelX < channels.size() && xyChannelY < channels.size();
+    
     // Draw X-axis label - moved down to avoid overlap with border
     painter.setPen(QColor(44, 62, 80));
     painter.setFont(QFont("Microsoft YaHei UI", 9, QFont::Bold));
     painter.drawText(leftMargin, height() - 22, plotWidth, 20, 
-                     Qt::AlignCenter, xAxisLabel);
+                     Qt::AlignCenter, xyValid ? channels[xyChannelX].name : xAxisLabel);
     
     // Draw Y-axis label (rotated) - moved further left to avoid overlap
     painter.save();
@@ -218,16 +788,20 @@ void PlotWidget::paintEvent(QPaintEvent *event)
     painter.setFont(QFont("Microsoft YaHei UI", 9, QFont::Bold));
     painter.translate(12, topMargin + plotHeight / 2);
     painter.rotate(-90);
-    painter.drawText(-60, 0, 120, 20, Qt::AlignCenter, yAxisLabel);
+    painter.drawText(-60, 0, 120, 20, Qt::AlignCenter,
+                     xyValid ? channels[xyChannelY].name : yAxisLabel);
     painter.restore();
     
     // Find max data points across all channels
     maxPoints = 0;
-    for (int i = 0; i < channels.size(); ++i) {
-        if (channels[i].visible && channels[i].values.size() > maxPoints) {
-            maxPoints = channels[i].values.size();
+    for (int i = 0; i < layerViews.size() && i < channels.size(); ++i) {
+        if (channels[i].visible && layerViews[i].size() > maxPoints) {
+            maxPoints = (int)layerViews[i].size();
         }
     }
+    if (xyMode) {
+        maxPoints = xyPairs;
+    }
     
     if (maxPoints < 2) {
         // Draw "No Data" message
@@ -238,47 +812,47 @@ void PlotWidget::paintEvent(QPaintEvent *event)
         return;
     }
     
-    // Draw data lines with smooth curves
-    for (int ch = 0; ch < channels.size(); ++ch) {
-        if (!channels[ch].visible || channels[ch].values.size() < 2) {
-            continue;
-        }
-        
-        // Draw shadow for depth effect
-        painter.setPen(QPen(channels[ch].color.darker(120), 3, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
-        painter.setOpacity(0.3);
-        
-        QVector<QPointF> shadowPoints;
-        for (int i = 0; i < channels[ch].values.size(); ++i) {
-            QPointF p = dataToScreen(i, channels[ch].values[i], channels[ch].values.size());
-            shadowPoints.append(QPointF(p.x() + 2, p.y() + 2));
-        }
-        
-        for (int i = 0; i < shadowPoints.size() - 1; ++i) {
-            painter.drawLine(shadowPoints[i], shadowPoints[i + 1]);
+    if (xyMode) {
+        if (!xyLayer.isNull()) {
+            painter.drawImage(0, 0, xyLayer);
         }
         
-        // Draw main line
-        painter.setOpacity(1.0);
-        painter.setPen(QPen(channels[ch].color, 2, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
-        
-        QVector<QPointF> points;
-        for (int i = 0; i < channels[ch].values.size(); ++i) {
-            points.append(dataToScreen(i, channels[ch].values[i], channels[ch].values.size()));
+        if (xyValid) {
+            QString label = QString("X: %1  Y: %2  (%3)")
+                            .arg(channels[xyChannelX].name)
+                            .arg(channels[xyChannelY].name)
+                            .arg(xyPairs);
+            painter.setFont(QFont("Microsoft YaHei UI", 8, QFont::Bold));
+            QFontMetrics metrics(painter.font());
+            int legendWidth = metrics.boundingRect(label).width() + 30;
+            painter.setBrush(QColor(255, 255, 255, 230));
+            painter.setPen(QPen(QColor(189, 195, 199), 1));
+            painter.drawRoundedRect(leftMargin + 5, topMargin + 5, legendWidth, 22, 5, 5);
+            painter.fillRect(leftMargin + 10, topMargin + 10, 15, 12, channels[xyChannelY].color);
+            painter.setPen(QColor(44, 62, 80));
+            painter.drawText(leftMargin + 30, topMargin + 21, label);
         }
-        
-        // Draw lines
-        for (int i = 0; i < points.size() - 1; ++i) {
-            painter.drawLine(points[i], points[i + 1]);
+        return;
+    }
+    
+    // Composite the channel layers rendered offscreen
+    for (int ch = 0; ch < layers.size() && ch < channels.size(); ++ch) {
+        if (channels[ch].visible && !layers[ch].isNull()) {
+            painter.drawImage(0, 0, layers[ch]);
         }
-        
-        // Draw points
-        painter.setBrush(channels[ch].color);
-        for (int i = 0; i < points.size(); ++i) {
-            if (i % 5 == 0 || i == points.size() - 1) {  // Draw every 5th point and last point
-                painter.drawEllipse(points[i], 3, 3);
-            }
+    }
+    
+    // Mark trigger position and level on a frozen capture
+    if (frozen && frozenTriggerIndex >= 0 && frozenTriggerIndex < maxPoints) {
+        QPointF trigger = dataToScreen(frozenTriggerIndex, frozenLevel, maxPoints, size(),
+                                       layerMinValue, layerMaxValue);
+        painter.setPen(QPen(QColor(230, 126, 34), 1, Qt::DashLine));
+        painter.drawLine(QPointF(trigger.x(), topMargin), QPointF(trigger.x(), topMargin + plotHeight));
+        if (trigger.y() >= topMargin && trigger.y() <= topMargin + plotHeight) {
+            painter.drawLine(QPointF(leftMargin, trigger.y()), QPointF(leftMargin + plotWidth, trigger.y()));
         }
+        painter.setFont(QFont("Microsoft YaHei UI", 8, QFont::Bold));
+        painter.drawText(QPointF(trigger.x() + 4, topMargin + 12), "T");
     }
     
     // Draw legend with modern style
@@ -288,8 +862,8 @@ void PlotWidget::paintEvent(QPaintEvent *event)
     
     // Draw legend background
     int legendHeight = 0;
-    for (int i = 0; i < channels.size(); ++i) {
-        if (!channels[i].values.isEmpty()) {
+    for (int i = 0; i < layerViews.size() && i < channels.size(); ++i) {
+        if (!layerViews[i].isEmpty()) {
             legendHeight += legendSpacing;
         }
     }
@@ -303,8 +877,8 @@ void PlotWidget::paintEvent(QPaintEvent *event)
     painter.setFont(QFont("Microsoft YaHei UI", 8, QFont::Bold));
     
     int currentY = legendY;
-    for (int i = 0; i < channels.size(); ++i) {
-        if (channels[i].values.isEmpty()) {
+    for (int i = 0; i < layerViews.size() && i < channels.size(); ++i) {
+        if (layerViews[i].isEmpty()) {
             continue;
         }
         
@@ -316,7 +890,7 @@ void PlotWidget::paintEvent(QPaintEvent *event)
         // Draw label with last value
         QString label = QString("%1: %2")
                         .arg(channels[i].name)
-                        .arg(channels[i].values.last(), 0, 'f', 4);
+                        .arg(layerViews[i].value(layerViews[i].size() - 1), 0, 'f', 4);
         
         painter.setPen(QColor(44, 62, 80));
         painter.drawText(legendX + 20, currentY + 11, label);
@@ -328,7 +902,7 @@ void PlotWidget::paintEvent(QPaintEvent *event)
 void PlotWidget::resizeEvent(QResizeEvent *event)
 {
     QWidget::resizeEvent(event);
-    update();
+    scheduleRender();
 }
 
 void PlotWidget::setPlotTexts(const QString &title, const QString &yLabel, 
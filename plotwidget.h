@@ -6,9 +6,15 @@
 #include <QPainter>
 #include <QColor>
 #include <QDateTime>
+#include <QImage>
+#include <QThreadPool>
+#include <QTimer>
+#include "channelstore.h"
 
+class PipelineMetrics;
+
+// Display settings for one channel; the samples live in the ChannelStore
 struct PlotData {
-    QVector<double> values;
     QColor color;
     QString name;
     bool visible;
@@ -22,21 +28,51 @@ class PlotWidget : public QWidget
 
 public:
     explicit PlotWidget(QWidget *parent = nullptr);
+    ~PlotWidget();
     
-    void addDataPoint(int channel, double value);
+    // Samples are read from the store, which must outlive the widget
+    void setChannelStore(const ChannelStore *store);
+    void dataAppended();
     void clearData();
+    // Channels beyond the first six show derived series
+    void setChannelCount(int count);
+    int channelCount() const { return channels.size(); }
+    void setChannelName(int channel, const QString &name);
     void setChannelVisible(int channel, bool visible);
     void setChannelColor(int channel, const QColor &color);
     void setMaxDataPoints(int max);
     void setPlotTexts(const QString &title, const QString &yLabel, 
                      const QString &xLabel, const QString &waitingText);
     
+    // Freeze the view on a triggered capture window instead of live data
+    void showCapture(const QVector<QVector<double>> &capture, int triggerIndex, double level);
+    void releaseCapture();
+    bool isShowingCapture() const { return frozen; }
+    
+    // XY mode plots yChannel against xChannel over the newest depth
+    // samples. Samples pair up by position from the newest one, or by
+    // timestamp, each Y sample taking the latest X sample at or before it.
+    enum Pairing { PairByIndex, PairByTimestamp };
+    void setXYMode(bool enabled, int xChannel, int yChannel, Pairing pairing,
+                   bool connectPoints, int depth);
+    bool isXYMode() const { return xyMode; }
+    
+    // Paint time is added to the metrics' Paint stage; nullptr stops it
+    void setMetrics(PipelineMetrics *metrics);
+    
 protected:
     void paintEvent(QPaintEvent *event);
     void resizeEvent(QResizeEvent *event);
 
+private slots:
+    void startLayerRender();
+    void onLayerRendered(int generation, int channel, const QImage &image);
+    void onXYRendered(int generation, const QImage &image, const QRectF &range, int pairs);
+
 private:
     QVector<PlotData> channels;
+    const ChannelStore *store;
+    PipelineMetrics *metrics;
     int maxDataPoints;
     double minValue;
     double maxValue;
@@ -49,8 +85,41 @@ private:
     QString xAxisLabel;
     QString waitingMessage;
     
-    void updateMinMax();
-    QPointF dataToScreen(int index, double value, int totalPoints);
+    // Frozen trigger capture
+    bool frozen;
+    QVector<ChannelView> frozenViews;
+    int frozenTriggerIndex;
+    double frozenLevel;
+    
+    // Offscreen rendering: each visible channel is drawn into its own
+    // QImage on renderPool and composited by paintEvent()
+    QThreadPool renderPool;
+    QTimer *renderTimer;
+    QVector<QImage> layers;         // Last completed frame, one per channel
+    QVector<QImage> pendingLayers;  // Frame currently being rendered
+    QVector<ChannelView> layerViews;    // Samples the completed layers show
+    QVector<ChannelView> pendingViews;
+    int renderGeneration;
+    int layersInFlight;
+    bool renderDirty;
+    double layerMinValue;           // Y range the completed layers were drawn with
+    double layerMaxValue;
+    
+    // XY mode; rendered as a single layer
+    bool xyMode;
+    int xyChannelX;
+    int xyChannelY;
+    Pairing xyPairing;
+    bool xyConnect;
+    int xyDepth;
+    QImage xyLayer;
+    QRectF xyRange;                 // Data range xyLayer was drawn with
+    int xyPairs;
+    
+    void scheduleRender();
+    void startXYRender();
+    void updateMinMax(const QVector<ChannelView> &views);
+    ChannelView displayView(int channel) const;
 };
 
 #endif // PLOTWIDGET_H
@@ -0,0 +1,299 @@
+#include "portbridge.h"
+#include "latencymeter.h"
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Largest chunk read from a port at once
+const int kChunkBytes = 16384;
+// How often the forwarding loop checks for a stop request
+const int kPollMs = 50;
+// Tap ring size; a power of two
+const int kTapRingBytes = 4 * 1024 * 1024;
+
+struct TapHeader {
+    qint64 ns;
+    qint32 direction;
+    qint32 size;
+};
+
+bool openPort(QSerialPort &port, const PortSessionConfig &config, QString *error)
+{
+    port.setPortName(config.portName);
+    port.setBaudRate(config.baudRate);
+    port.setDataBits(config.dataBits);
+    port.setParity(config.parity);
+    port.setStopBits(config.stopBits);
+    port.setFlowControl(config.flowControl);
+    if (!port.open(QIODevice::ReadWrite)) {
+        *error = config.portName + ": " + port.errorString();
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+PortBridge::PortBridge(QObject *parent)
+    : QThread(parent)
+    , stopRequested(0)
+    , tapBuffer(nullptr)
+    , tapWritePos(0)
+    , tapReadPos(0)
+    , tapDroppedBytes(0)
+{
+}
+
+PortBridge::~PortBridge()
+{
+    stopBridge();
+}
+
+void PortBridge::startBridge(const PortSessionConfig &host, const PortSessionConfig &device)
+{
+    stopBridge();
+    hostConfig = host;
+    deviceConfig = device;
+    if (!tapBuffer) {
+        tapRing.resize(kTapRingBytes);
+        tapBuffer = tapRing.data();
+    }
+    tapWritePos.storeRelease(0);
+    tapReadPos.storeRelease(0);
+    tapDroppedBytes.storeRelease(0);
+    forwardedBytes[HostToDevice].storeRelease(0);
+    forwardedBytes[DeviceToHost].storeRelease(0);
+    stopRequested.storeRelease(0);
+    start(QThread::TimeCriticalPriority);
+}
+
+void PortBridge::stopBridge()
+{
+    stopRequested.storeRelease(1);
+    wait();
+}
+
+QVector<PortBridge::TapChunk> PortBridge::takeTapped()
+{
+    QVector<TapChunk> chunks;
+    qint64 read = tapReadPos.loadAcquire();
+    const qint64 write = tapWritePos.loadAcquire();
+    while (read < write) {
+        TapHeader header;
+        ringRead(read, &header, sizeof(header));
+        TapChunk chunk;
+        chunk.direction = Direction(header.direction);
+        chunk.ns = header.ns;
+        chunk.data.resize(header.size);
+        ringRead(read + sizeof(header), chunk.data.data(), header.size);
+        chunks.append(chunk);
+        read += sizeof(header) + header.size;
+    }
+    tapReadPos.storeRelease(read);
+    return chunks;
+}
+
+qint64 PortBridge::forwarded(Direction direction) const
+{
+    return forwardedBytes[direction].loadAcquire();
+}
+
+qint64 PortBridge::tapDropped() const
+{
+    return tapDroppedBytes.loadAcquire();
+}
+
+void PortBridge::run()
+{
+    // Created here so both ports belong to this thread. Nothing runs their
+    // event loop, so QSerialPort itself never reads from them.
+    QSerialPort host;
+    QSerialPort device;
+    QString error;
+    bool ok = openPort(host, hostConfig, &error) && openPort(device, deviceConfig, &error);
+    if (ok) {
+        ok = pump(host, device, &error);
+    }
+    host.close();
+    device.close();
+    if (!ok) {
+        emit failed(error);
+    }
+}
+
+bool PortBridge::pump(QSerialPort &host, QSerialPort &device, QString *error)
+{
+    // Indexed by direction: read from the source, write to the destination
+    const QSerialPort::Handle sources[2] = { host.handle(), device.handle() };
+    NativePortWriter writers[2];
+    writers[HostToDevice].begin(device.handle());
+    writers[DeviceToHost].begin(host.handle());
+    char buffers[2][kChunkBytes];
+    bool ok = true;
+
+#ifdef Q_OS_WIN
+    // QSerialPort started its own overlapped reads when it opened the
+    // ports; they were issued from this thread, so CancelIo ends them.
+    // Reads then return as soon as any byte is in, or after kPollMs.
+    COMMTIMEOUTS timeouts;
+    ZeroMemory(&timeouts, sizeof(timeouts));
+    timeouts.ReadIntervalTimeout = MAXDWORD;
+    timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+    timeouts.ReadTotalTimeoutConstant = kPollMs;
+    OVERLAPPED overlapped[2];
+    HANDLE events[2];
+    for (int i = 0; i < 2; ++i) {
+        CancelIo(sources[i]);
+        SetCommTimeouts(sources[i], &timeouts);
+        events[i] = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    }
+    bool pending[2] = { false, false };
+    for (int i = 0; i < 2 && ok; ++i) {
+        ZeroMemory(&overlapped[i], sizeof(overlapped[i]));
+        overlapped[i].hEvent = events[i];
+        if (!ReadFile(sources[i], buffers[i], kChunkBytes, nullptr, &overlapped[i]) &&
+            GetLastError() != ERROR_IO_PENDING) {
+            *error = qt_error_string();
+            ok = false;
+        }
+        pending[i] = ok;
+    }
+
+    while (ok && !stopRequested.loadAcquire()) {
+        const DWORD result = WaitForMultipleObjects(2, events, FALSE, kPollMs);
+        if (result == WAIT_TIMEOUT) {
+            continue;
+        }
+        if (result != WAIT_OBJECT_0 && result != WAIT_OBJECT_0 + 1) {
+            *error = qt_error_string();
+            ok = false;
+            break;
+        }
+        const int i = int(result - WAIT_OBJECT_0);
+        DWORD n = 0;
+        pending[i] = false;
+        if (!GetOverlappedResult(sources[i], &overlapped[i], &n, FALSE)) {
+            *error = qt_error_string();
+            ok = false;
+            break;
+        }
+        if (n > 0 && !forward(i, buffers[i], n, writers, error)) {
+            ok = false;
+            break;
+        }
+        ZeroMemory(&overlapped[i], sizeof(overlapped[i]));
+        overlapped[i].hEvent = events[i];
+        if (!ReadFile(sources[i], buffers[i], kChunkBytes, nullptr, &overlapped[i]) &&
+            GetLastError() != ERROR_IO_PENDING) {
+            *error = qt_error_string();
+            ok = false;
+            break;
+        }
+        pending[i] = true;
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        if (pending[i]) {
+            DWORD n = 0;
+            CancelIo(sources[i]);
+            GetOverlappedResult(sources[i], &overlapped[i], &n, TRUE);
+        }
+        CloseHandle(events[i]);
+    }
+#else
+    // The descriptors are non-blocking; wait on both at once
+    pollfd fds[2];
+    for (int i = 0; i < 2; ++i) {
+        fds[i].fd = sources[i];
+        fds[i].events = POLLIN;
+    }
+
+    while (ok && !stopRequested.loadAcquire()) {
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        const int ready = ::poll(fds, 2, kPollMs);
+        if (ready < 0 && errno != EINTR) {
+            *error = qt_error_string(errno);
+            ok = false;
+        }
+        for (int i = 0; i < 2 && ok && ready > 0; ++i) {
+            if (fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                // Unplugged
+                *error = (i == HostToDevice ? hostConfig : deviceConfig).portName
+                         + ": " + QString("Port closed");
+                ok = false;
+                break;
+            }
+            if (!(fds[i].revents & POLLIN)) {
+                continue;
+            }
+            const ssize_t n = ::read(fds[i].fd, buffers[i], kChunkBytes);
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                *error = qt_error_string(errno);
+                ok = false;
+            } else if (n > 0) {
+                ok = forward(i, buffers[i], n, writers, error);
+            }
+        }
+    }
+#endif
+
+    writers[HostToDevice].end();
+    writers[DeviceToHost].end();
+    return ok;
+}
+
+bool PortBridge::forward(int direction, const char *data, qint64 size, NativePortWriter *writers,
+                         QString *error)
+{
+    // Stamped on arrival; the tap copy waits until the bytes are on their way
+    const qint64 ns = LatencyMeter::clockNs();
+    if (!writers[direction].write(data, size, error)) {
+        return false;
+    }
+    forwardedBytes[direction].fetchAndAddRelaxed(size);
+    tap(direction, ns, data, int(size));
+    return true;
+}
+
+void PortBridge::tap(int direction, qint64 ns, const char *data, int size)
+{
+    const qint64 write = tapWritePos.loadAcquire();
+    const qint64 read = tapReadPos.loadAcquire();
+    const qint64 recordSize = qint64(sizeof(TapHeader)) + size;
+    if (write + recordSize - read > kTapRingBytes) {
+        tapDroppedBytes.fetchAndAddRelaxed(size);
+        return;
+    }
+    TapHeader header;
+    header.ns = ns;
+    header.direction = direction;
+    header.size = size;
+    ringWrite(write, &header, sizeof(header));
+    ringWrite(write + sizeof(header), data, size);
+    tapWritePos.storeRelease(write + recordSize);
+}
+
+void PortBridge::ringWrite(qint64 pos, const void *data, int size)
+{
+    const int offset = int(pos & (kTapRingBytes - 1));
+    const int first = qMin(size, kTapRingBytes - offset);
+    memcpy(tapBuffer + offset, data, size_t(first));
+    memcpy(tapBuffer, static_cast<const char *>(data) + first, size_t(size - first));
+}
+
+void PortBridge::ringRead(qint64 pos, void *data, int size) const
+{
+    const int offset = int(pos & (kTapRingBytes - 1));
+    const int first = qMin(size, kTapRingBytes - offset);
+    memcpy(data, tapBuffer + offset, size_t(first));
+    memcpy(static_cast<char *>(data) + first, tapBuffer, size_t(size - first));
+}
@@ -0,0 +1,74 @@
+#ifndef PORTBRIDGE_H
+#define PORTBRIDGE_H
+
+#include <QThread>
+#include <QByteArray>
+#include <QVector>
+#include <QAtomicInteger>
+
+#include "portsession.h"
+#include "nativeportwriter.h"
+
+// Forwards bytes between two ports in both directions, for sitting between
+// a host and a device. Both ports are opened on the bridge thread and served
+// through their native handles from fixed buffers, so forwarding allocates
+// nothing per chunk. Each forwarded chunk is then copied into a tap ring
+// that the GUI drains; when the GUI falls behind, the tap drops chunks
+// rather than holding the forwarding back.
+class PortBridge : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Direction { HostToDevice, DeviceToHost };
+
+    struct TapChunk {
+        Direction direction;
+        qint64 ns;          // LatencyMeter::clockNs() when read
+        QByteArray data;
+    };
+
+    explicit PortBridge(QObject *parent = nullptr);
+    ~PortBridge();
+
+    // Neither port may be open elsewhere; open errors come as failed()
+    void startBridge(const PortSessionConfig &host, const PortSessionConfig &device);
+    void stopBridge();
+
+    // Chunks forwarded since the previous call, in forwarding order. Call
+    // from the thread that starts the bridge.
+    QVector<TapChunk> takeTapped();
+
+    // Totals since startBridge()
+    qint64 forwarded(Direction direction) const;
+    qint64 tapDropped() const;
+
+signals:
+    void failed(const QString &error);
+
+protected:
+    void run() override;
+
+private:
+    PortSessionConfig hostConfig;
+    PortSessionConfig deviceConfig;
+    QAtomicInt stopRequested;
+
+    // Single-producer single-consumer ring of records: a header, then the
+    // chunk. Positions only grow; the ring index is position % size.
+    QByteArray tapRing;
+    char *tapBuffer;
+    QAtomicInteger<qint64> tapWritePos;
+    QAtomicInteger<qint64> tapReadPos;
+    QAtomicInteger<qint64> tapDroppedBytes;
+    QAtomicInteger<qint64> forwardedBytes[2];
+
+    bool pump(QSerialPort &host, QSerialPort &device, QString *error);
+    bool forward(int direction, const char *data, qint64 size, NativePortWriter *writers,
+                 QString *error);
+    void tap(int direction, qint64 ns, const char *data, int size);
+    void ringWrite(qint64 pos, const void *data, int size);
+    void ringRead(qint64 pos, void *data, int size) const;
+};
+
+#endif // PORTBRIDGE_H
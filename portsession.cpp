@@ -0,0 +1,144 @@
+#include "portsession.h"
+#include "latencymeter.h"
+#include <QMutexLocker>
+
+namespace {
+
+// A line growing past this without a line end is posted as it is
+const int kMaxLineBytes = 4096;
+// How often the read loop checks for a stop request
+const int kPollMs = 50;
+
+// Numbers separated by commas, semicolons or whitespace; anything that
+// does not parse, such as a "plotter" tag, is skipped
+QVector<double> parseValues(const QByteArray &line)
+{
+    QVector<double> values;
+    int start = 0;
+    for (int i = 0; i <= line.size(); ++i) {
+        const char c = i < line.size() ? line[i] : ' ';
+        if (c == ',' || c == ';' || c == ' ' || c == '\t') {
+            if (i > start) {
+                bool ok = false;
+                const double value = line.mid(start, i - start).toDouble(&ok);
+                if (ok) {
+                    values.append(value);
+                }
+            }
+            start = i + 1;
+        }
+    }
+    return values;
+}
+
+} // namespace
+
+PortSession::PortSession(int id, int generation, const PortSessionConfig &config,
+                         SessionEventLog *eventLog, QObject *parent)
+    : QThread(parent)
+    , sessionId(id)
+    , sessionGeneration(generation)
+    , settings(config)
+    , log(eventLog)
+    , stopRequested(0)
+{
+}
+
+PortSession::~PortSession()
+{
+    stopSession();
+}
+
+void PortSession::stopSession()
+{
+    stopRequested.storeRelease(1);
+    wait();
+}
+
+PortSessionStats PortSession::stats() const
+{
+    QMutexLocker lock(&mutex);
+    return current;
+}
+
+void PortSession::run()
+{
+    // Created here so the port belongs to this thread
+    QSerialPort port;
+    port.setPortName(settings.portName);
+    port.setBaudRate(settings.baudRate);
+    port.setDataBits(settings.dataBits);
+    port.setParity(settings.parity);
+    port.setStopBits(settings.stopBits);
+    port.setFlowControl(settings.flowControl);
+    if (!port.open(QIODevice::ReadOnly)) {
+        setError(port.errorString());
+        return;
+    }
+    {
+        QMutexLocker lock(&mutex);
+        current.open = true;
+        current.error.clear();
+    }
+
+    while (!stopRequested.loadAcquire()) {
+        if (port.waitForReadyRead(kPollMs)) {
+            consume(port.readAll(), LatencyMeter::clockNs());
+        } else if (port.error() == QSerialPort::ResourceError) {
+            // Unplugged
+            setError(port.errorString());
+            break;
+        } else {
+            port.clearError();
+        }
+    }
+    port.close();
+
+    QMutexLocker lock(&mutex);
+    current.open = false;
+}
+
+void PortSession::consume(const QByteArray &data, qint64 ns)
+{
+    qint64 lines = 0;
+    qint64 values = 0;
+    int start = 0;
+    while (start < data.size()) {
+        const int end = data.indexOf('\n', start);
+        if (end < 0 && partial.size() + data.size() - start < kMaxLineBytes) {
+            partial.append(data.constData() + start, data.size() - start);
+            break;
+        }
+        const int stop = end < 0 ? qMin(data.size(), start + kMaxLineBytes - partial.size()) : end;
+        partial.append(data.constData() + start, stop - start);
+        start = end < 0 ? stop : end + 1;
+
+        if (partial.endsWith('\r')) {
+            partial.chop(1);
+        }
+        if (partial.isEmpty()) {
+            continue;
+        }
+        SessionEvent event;
+        event.ns = ns;
+        event.session = sessionId;
+        event.generation = sessionGeneration;
+        event.line = partial;
+        event.values = parseValues(partial);
+        values += event.values.size();
+        ++lines;
+        log->append(event);
+        partial.clear();
+    }
+
+    QMutexLocker lock(&mutex);
+    current.rxBytes += data.size();
+    current.lines += lines;
+    current.values += values;
+}
+
+void PortSession::setError(const QString &error)
+{
+    QMutexLocker lock(&mutex);
+    current.error = error;
+}
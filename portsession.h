@@ -0,0 +1,81 @@
+#ifndef PORTSESSION_H
+#define PORTSESSION_H
+
+#include <QThread>
+#include <QByteArray>
+#include <QString>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QSerialPort>
+
+#include "sessioneventlog.h"
+
+struct PortSessionConfig {
+    QString portName;
+    qint32 baudRate;
+    QSerialPort::DataBits dataBits;
+    QSerialPort::Parity parity;
+    QSerialPort::StopBits stopBits;
+    QSerialPort::FlowControl flowControl;
+
+    PortSessionConfig()
+        : baudRate(115200), dataBits(QSerialPort::Data8)
+        , parity(QSerialPort::NoParity), stopBits(QSerialPort::OneStop)
+        , flowControl(QSerialPort::NoFlowControl) {}
+};
+
+struct PortSessionStats {
+    bool open;
+    QString error;
+    qint64 rxBytes;
+    qint64 lines;
+    qint64 values;
+
+    PortSessionStats() : open(false), rxBytes(0), lines(0), values(0) {}
+};
+
+// One extra port watched next to the main one. The port lives on the
+// session's own thread, which reads it, splits lines, parses numbers and
+// posts each line to the shared SessionEventLog, so a chatty device does
+// not cost the GUI thread or the other sessions anything.
+class PortSession : public QThread
+{
+    Q_OBJECT
+
+public:
+    PortSession(int id, int generation, const PortSessionConfig &config, SessionEventLog *log,
+                QObject *parent = nullptr);
+    ~PortSession();
+
+    int id() const { return sessionId; }
+    // Tells this session's events from those of an earlier one with the
+    // same id, which may still be held in the log's reorder window
+    int generation() const { return sessionGeneration; }
+    const PortSessionConfig &config() const { return settings; }
+
+    // Opening happens on the session thread; watch stats().open and error
+    void stopSession();
+
+    // Thread-safe
+    PortSessionStats stats() const;
+
+protected:
+    void run() override;
+
+private:
+    const int sessionId;
+    const int sessionGeneration;
+    const PortSessionConfig settings;
+    SessionEventLog *log;
+    QAtomicInt stopRequested;
+
+    QByteArray partial;     // Line received so far; session thread only
+
+    mutable QMutex mutex;
+    PortSessionStats current;
+
+    void consume(const QByteArray &data, qint64 ns);
+    void setError(const QString &error);
+};
+
+#endif // PORTSESSION_H
@@ -0,0 +1,191 @@
+#include "scriptexecutor.h"
+#include "streammatcher.h"
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+namespace {
+
+// Received data beyond this is dropped oldest first while no step waits
+const int kMaxReceivedBytes = 1024 * 1024;
+
+} // namespace
+
+ScriptExecutor::ScriptExecutor(QObject *parent)
+    : QThread(parent)
+    , handle(QSerialPort::Handle())
+    , line(0)
+    , bytesWritten(0)
+    , stopRequested(false)
+{
+}
+
+ScriptExecutor::~ScriptExecutor()
+{
+    stopScript();
+}
+
+void ScriptExecutor::startScript(QSerialPort::Handle portHandle, const QVector<ScriptStep> &program)
+{
+    stopScript();
+    handle = portHandle;
+    steps = program;
+    {
+        QMutexLocker lock(&mutex);
+        received.clear();
+        stopRequested = false;
+    }
+    start(QThread::TimeCriticalPriority);
+}
+
+void ScriptExecutor::stopScript()
+{
+    {
+        QMutexLocker lock(&mutex);
+        stopRequested = true;
+        wake.wakeAll();
+    }
+    wait();
+}
+
+void ScriptExecutor::feed(const QByteArray &data)
+{
+    QMutexLocker lock(&mutex);
+    received.append(data);
+    if (received.size() > kMaxReceivedBytes) {
+        received.remove(0, received.size() - kMaxReceivedBytes);
+    }
+    wake.wakeAll();
+}
+
+qint64 ScriptExecutor::takeBytesWritten()
+{
+    return bytesWritten.fetchAndStoreRelaxed(0);
+}
+
+void ScriptExecutor::run()
+{
+    writer.begin(handle);
+
+    // Jumps taken so far by each repeat step
+    QVector<int> repeats(steps.size(), 0);
+    QString error;
+    int pc = 0;
+
+    while (pc >= 0 && pc < steps.size()) {
+        const ScriptStep &step = steps[pc];
+        line.storeRelease(step.line);
+        int next = pc + 1;
+
+        switch (step.type) {
+        case ScriptStep::Send:
+            if (!writer.write(step.data, &error)) {
+                next = -1;
+                break;
+            }
+            bytesWritten.fetchAndAddRelaxed(step.data.size());
+            break;
+        case ScriptStep::Expect:
+            switch (waitFor(step.data, step.ms)) {
+            case Matched:
+                break;
+            case TimedOut:
+                if (step.target >= 0) {
+                    next = step.target;
+                } else {
+                    error = QString("Line %1: timed out waiting for \"%2\"")
+                            .arg(step.line).arg(QString::fromUtf8(step.data));
+                    next = -1;
+                }
+                break;
+            case Stopped:
+                next = -1;
+                break;
+            }
+            break;
+        case ScriptStep::Delay:
+            if (!pause(step.ms)) {
+                next = -1;
+            }
+            break;
+        case ScriptStep::Goto:
+            next = step.target;
+            break;
+        case ScriptStep::Repeat:
+            if (repeats[pc] < step.count) {
+                ++repeats[pc];
+                next = step.target;
+            } else {
+                // Ready for the next time the loop is entered
+                repeats[pc] = 0;
+            }
+            break;
+        case ScriptStep::Stop:
+            next = -1;
+            break;
+        }
+
+        QMutexLocker lock(&mutex);
+        if (stopRequested) {
+            break;
+        }
+        pc = next;
+    }
+
+    writer.end();
+    line.storeRelease(0);
+
+    bool stopped;
+    {
+        QMutexLocker lock(&mutex);
+        stopped = stopRequested;
+    }
+    emit finished(error.isEmpty() && !stopped, error);
+}
+
+ScriptExecutor::WaitResult ScriptExecutor::waitFor(const QByteArray &pattern, int timeoutMs)
+{
+    StreamMatcher matcher(pattern);
+    QElapsedTimer clock;
+    clock.start();
+
+    QMutexLocker lock(&mutex);
+    for (;;) {
+        if (stopRequested) {
+            return Stopped;
+        }
+        // Each byte is scanned once; a partial match carries over to the
+        // next chunk inside the matcher
+        if (!received.isEmpty() || pattern.isEmpty()) {
+            const int end = matcher.feed(received);
+            if (end >= 0) {
+                received.remove(0, end);
+                return Matched;
+            }
+            received.clear();
+        }
+        const qint64 remaining = timeoutMs - clock.elapsed();
+        if (remaining <= 0) {
+            return TimedOut;
+        }
+        wake.wait(&mutex, (unsigned long)remaining);
+    }
+}
+
+bool ScriptExecutor::pause(int ms)
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    QMutexLocker lock(&mutex);
+    for (;;) {
+        if (stopRequested) {
+            return false;
+        }
+        const qint64 remaining = ms - clock.elapsed();
+        if (remaining <= 0) {
+            return true;
+        }
+        // Woken early by received data or a stop request
+        wake.wait(&mutex, (unsigned long)remaining);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef SCRIPTEXECUTOR_H
+#define SCRIPTEXECUTOR_H
+
+#include <QThread>
+#include <QByteArray>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QVector>
+#include <QSerialPort>
+
+#include "commandscript.h"
+#include "nativeportwriter.h"
+
+// Runs a parsed command script on its own thread. Sends go straight to the
+// port's native handle and received data is handed over by feed(), where
+// the waiting step matches it incrementally, so a busy GUI thread does not
+// stretch the script's timing.
+class ScriptExecutor : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit ScriptExecutor(QObject *parent = nullptr);
+    ~ScriptExecutor();
+
+    // The port must stay open until stopScript() returns
+    void startScript(QSerialPort::Handle handle, const QVector<ScriptStep> &steps);
+    void stopScript();
+
+    // Thread-safe; pass every chunk read from the port while running
+    void feed(const QByteArray &data);
+
+    // Source line of the running step, 0 when idle
+    int currentLine() const { return line.loadAcquire(); }
+    // Bytes written since the previous call
+    qint64 takeBytesWritten();
+
+signals:
+    // ok is false with an empty error when the script was stopped
+    void finished(bool ok, const QString &error);
+
+protected:
+    void run() override;
+
+private:
+    enum WaitResult { Matched, TimedOut, Stopped };
+
+    QSerialPort::Handle handle;
+    NativePortWriter writer;
+    QVector<ScriptStep> steps;
+    QAtomicInt line;
+    QAtomicInteger<qint64> bytesWritten;
+
+    QMutex mutex;
+    QWaitCondition wake;
+    QByteArray received;    // Not yet matched against
+    bool stopRequested;
+
+    WaitResult waitFor(const QByteArray &pattern, int timeoutMs);
+    bool pause(int ms);
+};
+
+#endif // SCRIPTEXECUTOR_H
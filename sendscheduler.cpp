@@ -0,0 +1,185 @@
+#include "sendscheduler.h"
+#include "channelstats.h"
+#include "latencymeter.h"
+#include <QMutexLocker>
+#include <cmath>
+
+namespace {
+
+// The thread sleeps until this long before a deadline and spins the rest;
+// Windows sleeps are only accurate to about a millisecond even with the
+// timer resolution raised
+#ifdef Q_OS_WIN
+const qint64 kSpinMarginNs = 1500000;
+#else
+const qint64 kSpinMarginNs = 200000;
+#endif
+// Longest single sleep, so stopSending() is honoured promptly at long periods
+const qint64 kMaxSleepNs = 50000000;
+
+} // namespace
+
+SendScheduler::SendScheduler(QObject *parent)
+    : QThread(parent)
+    , handle(QSerialPort::Handle())
+    , latency(nullptr)
+    , stopRequested(0)
+    , bytesWritten(0)
+    , periodNs(1000000)
+    , restart(true)
+{
+}
+
+SendScheduler::~SendScheduler()
+{
+    stopSending();
+}
+
+void SendScheduler::startSending(QSerialPort::Handle portHandle, const QByteArray &data, qint64 period)
+{
+    stopSending();
+    handle = portHandle;
+    {
+        QMutexLocker lock(&mutex);
+        payload = data;
+        periodNs = qMax<qint64>(1, period);
+        restart = true;
+        stats = SendJitter();
+    }
+    stopRequested.storeRelease(0);
+    start(QThread::TimeCriticalPriority);
+}
+
+void SendScheduler::stopSending()
+{
+    stopRequested.storeRelease(1);
+    wait();
+}
+
+void SendScheduler::setPayload(const QByteArray &data)
+{
+    QMutexLocker lock(&mutex);
+    payload = data;
+}
+
+void SendScheduler::setPeriod(qint64 period)
+{
+    QMutexLocker lock(&mutex);
+    periodNs = qMax<qint64>(1, period);
+    restart = true;
+}
+
+SendJitter SendScheduler::jitter() const
+{
+    QMutexLocker lock(&mutex);
+    return stats;
+}
+
+qint64 SendScheduler::takeBytesWritten()
+{
+    return bytesWritten.fetchAndStoreRelaxed(0);
+}
+
+void SendScheduler::run()
+{
+    writer.begin(handle);
+
+    QElapsedTimer clock;
+    clock.start();
+
+    QByteArray data;
+    qint64 period = 1;
+    qint64 anchorNs = 0;
+    qint64 tick = 0;
+    qint64 lastSendNs = -1;
+
+    // Accumulated here and published under the lock after each send
+    SendJitter local;
+    qint64 intervals = 0;
+    double sumUs = 0.0;
+    P2Quantile p99(0.99);
+
+    while (!stopRequested.loadAcquire()) {
+        {
+            QMutexLocker lock(&mutex);
+            data = payload;
+            if (restart) {
+                restart = false;
+                period = periodNs;
+                anchorNs = clock.nsecsElapsed();
+                tick = 0;
+                lastSendNs = -1;
+                local = SendJitter();
+                intervals = 0;
+                sumUs = 0.0;
+                p99.reset();
+                stats = local;
+            }
+        }
+
+        // First send goes out immediately, then on the grid
+        if (!sleepUntilDeadline(clock, anchorNs + tick * period)) {
+            break;
+        }
+        const qint64 sentNs = clock.nsecsElapsed();
+
+        if (!data.isEmpty()) {
+            QString error;
+            if (latency) {
+                latency->markSent(LatencyMeter::clockNs());
+            }
+            if (!writer.write(data, &error)) {
+                emit failed(error);
+                break;
+            }
+            bytesWritten.fetchAndAddRelaxed(data.size());
+
+            if (lastSendNs >= 0) {
+                const double jitterUs = std::fabs(double(sentNs - lastSendNs - period)) / 1000.0;
+                if (intervals == 0 || jitterUs < local.minUs) local.minUs = jitterUs;
+                if (jitterUs > local.maxUs) local.maxUs = jitterUs;
+                sumUs += jitterUs;
+                p99.add(jitterUs);
+                local.avgUs = sumUs / ++intervals;
+                local.p99Us = p99.value();
+            }
+            lastSendNs = sentNs;
+            ++local.sent;
+        } else {
+            // Nothing to send breaks the interval chain
+            lastSendNs = -1;
+        }
+
+        // Deadlines already in the past are skipped rather than sent in a
+        // burst to catch up
+        ++tick;
+        const qint64 behind = (clock.nsecsElapsed() - anchorNs) / period - tick + 1;
+        if (behind > 0) {
+            local.missed += behind;
+            tick += behind;
+        }
+
+        QMutexLocker lock(&mutex);
+        if (!restart) {
+            stats = local;
+        }
+    }
+
+    writer.end();
+}
+
+bool SendScheduler::sleepUntilDeadline(const QElapsedTimer &clock, qint64 deadlineNs)
+{
+    qint64 remaining = deadlineNs - clock.nsecsElapsed();
+    while (remaining > kSpinMarginNs) {
+        if (stopRequested.loadAcquire()) {
+            return false;
+        }
+        QThread::usleep((unsigned long)(qMin(remaining - kSpinMarginNs, kMaxSleepNs) / 1000));
+        remaining = deadlineNs - clock.nsecsElapsed();
+    }
+    while (clock.nsecsElapsed() < deadlineNs) {
+        // Spin out the last stretch
+    }
+    return !stopRequested.loadAcquire();
+}
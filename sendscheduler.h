@@ -0,0 +1,81 @@
+#ifndef SENDSCHEDULER_H
+#define SENDSCHEDULER_H
+
+#include <QThread>
+#include <QByteArray>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QSerialPort>
+
+#include "nativeportwriter.h"
+
+class LatencyMeter;
+
+// Measured deviation of the actual send interval from the configured period
+struct SendJitter {
+    qint64 sent;
+    qint64 missed;      // Deadlines skipped because a send ran too late
+    double minUs;
+    double avgUs;
+    double maxUs;
+    double p99Us;
+
+    SendJitter() : sent(0), missed(0), minUs(0.0), avgUs(0.0), maxUs(0.0), p99Us(0.0) {}
+};
+
+// Auto-send from a dedicated thread. Deadlines sit on an absolute grid
+// (start + n * period) so lateness never accumulates into drift; the thread
+// sleeps until just before each deadline and spins the rest of the way for
+// sub-millisecond accuracy. The payload is encoded once by the caller and
+// written straight to the port's native handle, so a busy GUI thread does
+// not delay sends. Only writes go through the handle; QSerialPort keeps
+// reading on the GUI thread.
+class SendScheduler : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit SendScheduler(QObject *parent = nullptr);
+    ~SendScheduler();
+
+    // The port must stay open until stopSending() returns
+    void startSending(QSerialPort::Handle handle, const QByteArray &payload, qint64 periodNs);
+    void stopSending();
+    bool isSending() const { return isRunning(); }
+
+    // Thread-safe; an empty payload skips ticks. A new period restarts the
+    // grid and the statistics.
+    void setPayload(const QByteArray &payload);
+    void setPeriod(qint64 periodNs);
+    // Each send is marked on the meter; set before startSending()
+    void setLatencyMeter(LatencyMeter *meter) { latency = meter; }
+
+    SendJitter jitter() const;
+    // Bytes written since the previous call
+    qint64 takeBytesWritten();
+
+signals:
+    void failed(const QString &error);
+
+protected:
+    void run() override;
+
+private:
+    QSerialPort::Handle handle;
+    NativePortWriter writer;
+    LatencyMeter *latency;
+    QAtomicInt stopRequested;
+    QAtomicInteger<qint64> bytesWritten;
+
+    mutable QMutex mutex;
+    QByteArray payload;
+    qint64 periodNs;
+    bool restart;
+    SendJitter stats;
+
+    bool sleepUntilDeadline(const QElapsedTimer &clock, qint64 deadlineNs);
+};
+
+#endif // SENDSCHEDULER_H
@@ -0,0 +1,114 @@
+#include "serialtransport.h"
+
+SerialTransport::SerialTransport(QObject *parent)
+    : Transport(TransportConfig::Serial, parent)
+    , port(new QSerialPort(this))
+{
+    connect(port, &QSerialPort::readyRead, this, &Transport::readyRead);
+    connect(port, &QSerialPort::bytesWritten, this, &Transport::bytesWritten);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+    connect(port, &QSerialPort::errorOccurred, this, &SerialTransport::onError);
+#else
+    connect(port, SIGNAL(error(QSerialPort::SerialPortError)),
+            this, SLOT(onError(QSerialPort::SerialPortError)));
+#endif
+}
+
+bool SerialTransport::open(const TransportConfig &config)
+{
+    close();
+    settings = config;
+    settings.kind = TransportConfig::Serial;
+
+    port->setPortName(config.portName);
+    port->setBaudRate(config.baudRate);
+    switch (config.dataBits) {
+    case 5: port->setDataBits(QSerialPort::Data5); break;
+    case 6: port->setDataBits(QSerialPort::Data6); break;
+    case 7: port->setDataBits(QSerialPort::Data7); break;
+    default: port->setDataBits(QSerialPort::Data8); break;
+    }
+    switch (config.stopBits) {
+    case TransportConfig::OneAndHalfStop: port->setStopBits(QSerialPort::OneAndHalfStop); break;
+    case TransportConfig::TwoStop: port->setStopBits(QSerialPort::TwoStop); break;
+    default: port->setStopBits(QSerialPort::OneStop); break;
+    }
+    switch (config.parity) {
+    case TransportConfig::OddParity: port->setParity(QSerialPort::OddParity); break;
+    case TransportConfig::EvenParity: port->setParity(QSerialPort::EvenParity); break;
+    default: port->setParity(QSerialPort::NoParity); break;
+    }
+    port->setFlowControl(config.hardwareFlowControl ? QSerialPort::HardwareControl
+                                                    : QSerialPort::NoFlowControl);
+    return port->open(QIODevice::ReadWrite);
+}
+
+void SerialTransport::close()
+{
+    if (port->isOpen()) {
+        port->close();
+    }
+}
+
+bool SerialTransport::isOpen() const
+{
+    return port->isOpen();
+}
+
+QString SerialTransport::errorString() const
+{
+    return port->errorString();
+}
+
+qint64 SerialTransport::read(char *data, qint64 maxSize)
+{
+    return port->read(data, maxSize);
+}
+
+qint64 SerialTransport::bytesAvailable() const
+{
+    return port->bytesAvailable();
+}
+
+qint64 SerialTransport::write(const char *data, qint64 size)
+{
+    return port->write(data, size);
+}
+
+bool SerialTransport::clearOutput()
+{
+    return port->clear(QSerialPort::Output);
+}
+
+void SerialTransport::setHardwareFlowControl(bool enabled)
+{
+    Transport::setHardwareFlowControl(enabled);
+    if (port->isOpen()) {
+        port->setFlowControl(enabled ? QSerialPort::HardwareControl : QSerialPort::NoFlowControl);
+    }
+}
+
+bool SerialTransport::nativeHandle(QSerialPort::Handle *handle) const
+{
+    if (!port->isOpen()) {
+        return false;
+    }
+    *handle = port->handle();
+    return true;
+}
+
+void SerialTransport::onError(QSerialPort::SerialPortError error)
+{
+    // Open failures are reported by open(); timeouts are not failures
+    if (error == QSerialPort::NoError || error == QSerialPort::TimeoutError ||
+        error == QSerialPort::OpenError || error == QSerialPort::DeviceNotFoundError ||
+        error == QSerialPort::PermissionError) {
+        return;
+    }
+    const QString message = port->errorString();
+    // The device is gone; the port has to be closed before it can return
+    if (error == QSerialPort::ResourceError) {
+        port->close();
+    }
+    emit errorOccurred(message);
+}
@@ -0,0 +1,36 @@
+#ifndef SERIALTRANSPORT_H
+#define SERIALTRANSPORT_H
+
+#include "transport.h"
+#include <QSerialPort>
+
+// Native serial port, and the pty slave of a VirtualPort
+class SerialTransport : public Transport
+{
+    Q_OBJECT
+
+public:
+    explicit SerialTransport(QObject *parent = nullptr);
+
+    bool open(const TransportConfig &config) override;
+    void close() override;
+    bool isOpen() const override;
+    QString errorString() const override;
+
+    qint64 read(char *data, qint64 maxSize) override;
+    qint64 bytesAvailable() const override;
+
+    qint64 write(const char *data, qint64 size) override;
+    bool clearOutput() override;
+
+    void setHardwareFlowControl(bool enabled) override;
+    bool nativeHandle(QSerialPort::Handle *handle) const override;
+
+private slots:
+    void onError(QSerialPort::SerialPortError error);
+
+private:
+    QSerialPort *port;
+};
+
+#endif // SERIALTRANSPORT_H
@@ -0,0 +1,74 @@
+#include "sessioneventlog.h"
+#include <QMutexLocker>
+#include <algorithm>
+
+namespace {
+
+// Pending events beyond this are dropped oldest first
+const int kMaxPendingEvents = 200000;
+
+bool earlier(const SessionEvent &a, const SessionEvent &b)
+{
+    return a.ns < b.ns;
+}
+
+} // namespace
+
+SessionEventLog::SessionEventLog()
+    : droppedCount(0)
+{
+}
+
+void SessionEventLog::append(const SessionEvent &event)
+{
+    QMutexLocker lock(&mutex);
+    if (pending.size() >= kMaxPendingEvents) {
+        pending.remove(0, pending.size() / 4);
+        droppedCount += kMaxPendingEvents / 4;
+    }
+    pending.append(event);
+}
+
+QVector<SessionEvent> SessionEventLog::takeReady(qint64 nowNs)
+{
+    QVector<SessionEvent> events;
+    {
+        QMutexLocker lock(&mutex);
+        events.swap(pending);
+    }
+    if (events.isEmpty()) {
+        return events;
+    }
+
+    // Each session appends in its own time order, so this is a merge of a
+    // few sorted runs; a stable sort keeps equal stamps in arrival order
+    std::stable_sort(events.begin(), events.end(), earlier);
+
+    // Hold back what a slower session could still arrive ahead of
+    const qint64 cutoff = nowNs - ReorderWindowNs;
+    int ready = events.size();
+    while (ready > 0 && events[ready - 1].ns > cutoff) {
+        --ready;
+    }
+    if (ready < events.size()) {
+        QMutexLocker lock(&mutex);
+        QVector<SessionEvent> later = events.mid(ready);
+        later += pending;
+        pending.swap(later);
+        events.resize(ready);
+    }
+    return events;
+}
+
+void SessionEventLog::clear()
+{
+    QMutexLocker lock(&mutex);
+    pending.clear();
+    droppedCount = 0;
+}
+
+qint64 SessionEventLog::dropped() const
+{
+    QMutexLocker lock(&mutex);
+    return droppedCount;
+}
@@ -0,0 +1,46 @@
+#ifndef SESSIONEVENTLOG_H
+#define SESSIONEVENTLOG_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QMutex>
+
+// One received line of one port session, stamped on the shared
+// LatencyMeter::clockNs() clock so events from different ports compare
+struct SessionEvent {
+    qint64 ns;
+    int session;
+    int generation;             // PortSession::generation() of the poster
+    QByteArray line;
+    QVector<double> values;     // Numbers parsed from the line
+
+    SessionEvent() : ns(0), session(-1), generation(-1) {}
+};
+
+// Merges the events of all port sessions into one time-ordered stream.
+// Sessions append from their own threads; the GUI takes events once they
+// are older than a short reorder window, so an event stamped just before
+// another but appended just after still comes out in order.
+class SessionEventLog
+{
+public:
+    SessionEventLog();
+
+    // Thread-safe
+    void append(const SessionEvent &event);
+    // Events stamped before nowNs minus the reorder window, oldest first
+    QVector<SessionEvent> takeReady(qint64 nowNs);
+    void clear();
+
+    // Events dropped because the GUI fell too far behind
+    qint64 dropped() const;
+
+    static const qint64 ReorderWindowNs = 50 * 1000 * 1000;
+
+private:
+    mutable QMutex mutex;
+    QVector<SessionEvent> pending;
+    qint64 droppedCount;
+};
+
+#endif // SESSIONEVENTLOG_H
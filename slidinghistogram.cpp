@@ -0,0 +1,179 @@
+#include "slidinghistogram.h"
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Marks a ring slot whose sample was not counted (NaN, infinite, too far out)
+const qint64 kUncounted = std::numeric_limits<qint64>::min();
+// Fine grid step of an automatic range, relative to the first sample
+const double kAutoResolution = 1e-6;
+// Fine indices beyond this are not counted; keeps level shifts in range
+const double kMaxFineIndex = 4.0e18;
+
+// floor(value / 2^shift) for negative values too
+qint64 floorShift(qint64 value, int shift)
+{
+    return value >= 0 ? value >> shift : -((-value - 1) >> shift) - 1;
+}
+
+} // namespace
+
+SlidingHistogram::SlidingHistogram()
+    : below(0)
+    , above(0)
+    , position(0)
+    , filled(0)
+    , autoRange(true)
+    , anchored(false)
+    , origin(0.0)
+    , unit(1.0)
+    , level(0)
+    , start(0)
+{
+    configure(64, 10000, true, 0.0, 1.0);
+}
+
+void SlidingHistogram::configure(int bins, int window, bool automatic, double minimum, double maximum)
+{
+    counts = QVector<quint32>(qMax(2, bins), 0);
+    ring = QVector<qint64>(qMax(1, window), kUncounted);
+    autoRange = automatic || !(maximum > minimum);
+    origin = minimum;
+    unit = (maximum - minimum) / counts.size();
+    clear();
+}
+
+void SlidingHistogram::clear()
+{
+    counts.fill(0);
+    ring.fill(kUncounted);
+    below = 0;
+    above = 0;
+    position = 0;
+    filled = 0;
+    level = 0;
+    start = 0;
+    // A fixed range is anchored from the start; an automatic one on the
+    // first sample
+    anchored = !autoRange;
+}
+
+double SlidingHistogram::lower() const
+{
+    return origin + double(start) * binWidth();
+}
+
+double SlidingHistogram::binWidth() const
+{
+    return std::ldexp(unit, level);
+}
+
+void SlidingHistogram::add(double value)
+{
+    if (filled == ring.size()) {
+        tally(ring[position], -1);
+    } else {
+        ++filled;
+    }
+
+    const qint64 fine = fineIndex(value);
+    if (autoRange && fine != kUncounted) {
+        widen(fine);
+    }
+    tally(fine, 1);
+
+    ring[position] = fine;
+    if (++position == ring.size()) {
+        position = 0;
+    }
+}
+
+qint64 SlidingHistogram::fineIndex(double value)
+{
+    if (!std::isfinite(value)) {
+        return kUncounted;
+    }
+    if (!anchored) {
+        origin = value;
+        unit = qMax(std::fabs(value), 1.0) * kAutoResolution;
+        start = -counts.size() / 2;
+        anchored = true;
+    }
+    const double index = std::floor((value - origin) / unit);
+    if (!(std::fabs(index) < kMaxFineIndex)) {
+        return kUncounted;
+    }
+    return qint64(index);
+}
+
+qint64 SlidingHistogram::binIndex(qint64 fine) const
+{
+    return floorShift(fine, level) - start;
+}
+
+void SlidingHistogram::tally(qint64 fine, int delta)
+{
+    if (fine == kUncounted) {
+        return;
+    }
+    const qint64 bin = binIndex(fine);
+    if (bin < 0) {
+        below += delta;
+    } else if (bin >= counts.size()) {
+        above += delta;
+    } else {
+        counts[int(bin)] += delta;
+    }
+}
+
+void SlidingHistogram::widen(qint64 fine)
+{
+    const int bins = counts.size();
+    qint64 bin = binIndex(fine);
+    while (bin < 0 || bin >= bins) {
+        int first = -1, last = -1;
+        for (int i = 0; i < bins; ++i) {
+            if (counts[i] != 0) {
+                if (first < 0) first = i;
+                last = i;
+            }
+        }
+
+        const qint64 span = bin < 0 ? last - bin + 1 : bin - first + 1;
+        if (first >= 0 && span > bins) {
+            // Halve the resolution: bin pairs merge and the occupied bins
+            // take up at most half the span plus one
+            QVector<quint32> merged(bins, 0);
+            const qint64 mergedStart = floorShift(start, 1);
+            for (int i = first; i <= last; ++i) {
+                merged[int(floorShift(start + i, 1) - mergedStart)] += counts[i];
+            }
+            counts = merged;
+            start = mergedStart;
+            ++level;
+            bin = binIndex(fine);
+            continue;
+        }
+
+        // The occupied bins and the new one fit at this level: slide the
+        // bins over just far enough
+        qint64 shift;
+        if (first < 0) {
+            shift = bin - bins / 2;
+        } else if (bin < 0) {
+            shift = bin;
+        } else {
+            shift = bin - bins + 1;
+        }
+        QVector<quint32> moved(bins, 0);
+        if (first >= 0) {
+            for (int i = first; i <= last; ++i) {
+                moved[int(i - shift)] = counts[i];
+            }
+        }
+        counts = moved;
+        start += shift;
+        bin = binIndex(fine);
+    }
+}
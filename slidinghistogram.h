@@ -0,0 +1,62 @@
+#ifndef SLIDINGHISTOGRAM_H
+#define SLIDINGHISTOGRAM_H
+
+#include <QtGlobal>
+#include <QVector>
+
+// Histogram over the newest window samples of one channel. Each sample is
+// binned once on arrival and its bin index kept in a ring, so adding a
+// sample and evicting the oldest are both O(1) and nothing is rescanned.
+//
+// With a fixed range, samples outside [minimum, maximum) are counted as
+// underflow or overflow. With an automatic range, bins are indices on a
+// power-of-two grid anchored at the first sample; a sample outside the
+// current bins merges neighbouring bin pairs (O(bins), at most a few dozen
+// times over the life of the histogram) until it fits, so stored indices
+// stay valid. The automatic range only widens until configure() or clear().
+class SlidingHistogram
+{
+public:
+    SlidingHistogram();
+
+    void configure(int bins, int window, bool autoRange, double minimum, double maximum);
+    void add(double value);
+    void clear();
+
+    int binCount() const { return counts.size(); }
+    quint32 binValue(int bin) const { return counts[bin]; }
+    int windowSize() const { return ring.size(); }
+    int count() const { return filled; }       // Samples in the window
+    qint64 underflow() const { return below; }
+    qint64 overflow() const { return above; }
+    bool isAutoRange() const { return autoRange; }
+
+    // Range covered by the bins; empty until the first finite sample in
+    // automatic mode
+    bool hasRange() const { return anchored; }
+    double lower() const;
+    double binWidth() const;
+    double upper() const { return lower() + binWidth() * counts.size(); }
+
+private:
+    QVector<quint32> counts;
+    qint64 below;
+    qint64 above;
+    QVector<qint64> ring;   // Fine grid index of each sample in the window
+    int position;
+    int filled;
+
+    bool autoRange;
+    bool anchored;
+    double origin;          // Value at fine index 0
+    double unit;            // Fine grid step
+    int level;              // Bins are 2^level fine steps wide
+    qint64 start;           // Level index of the first bin
+
+    qint64 fineIndex(double value);
+    qint64 binIndex(qint64 fine) const;
+    void tally(qint64 fine, int delta);
+    void widen(qint64 fine);
+};
+
+#endif // SLIDINGHISTOGRAM_H
@@ -0,0 +1,54 @@
+#include "sparklinewidget.h"
+#include <QPainter>
+#include <QPolygonF>
+
+SparklineWidget::SparklineWidget(QWidget *parent)
+    : QWidget(parent)
+    , lineColor(52, 152, 219)
+{
+}
+
+void SparklineWidget::setValues(const QVector<double> &newValues)
+{
+    values = newValues;
+    update();
+}
+
+void SparklineWidget::setColor(const QColor &color)
+{
+    lineColor = color;
+    update();
+}
+
+QSize SparklineWidget::sizeHint() const
+{
+    return QSize(160, 24);
+}
+
+void SparklineWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    if (values.size() < 2) {
+        return;
+    }
+    double maxValue = 0.0;
+    for (double value : values) {
+        maxValue = qMax(maxValue, value);
+    }
+
+    const QRectF area = QRectF(rect()).adjusted(2, 3, -2, -3);
+    const double xStep = area.width() / (values.size() - 1);
+    QPolygonF line;
+    line.reserve(values.size());
+    for (int i = 0; i < values.size(); ++i) {
+        // A flat zero line sits on the bottom edge
+        const double level = maxValue > 0.0 ? values[i] / maxValue : 0.0;
+        line.append(QPointF(area.left() + i * xStep, area.bottom() - level * area.height()));
+    }
+
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(lineColor, 1.5));
+    painter.drawPolyline(line);
+}
@@ -0,0 +1,30 @@
+#ifndef SPARKLINEWIDGET_H
+#define SPARKLINEWIDGET_H
+
+#include <QWidget>
+#include <QVector>
+#include <QColor>
+
+// Small trend line for a table cell: the values oldest first, scaled from
+// zero to their maximum, without axes or labels
+class SparklineWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SparklineWidget(QWidget *parent = nullptr);
+
+    void setValues(const QVector<double> &values);
+    void setColor(const QColor &color);
+
+    QSize sizeHint() const;
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private:
+    QVector<double> values;
+    QColor lineColor;
+};
+
+#endif // SPARKLINEWIDGET_H
@@ -0,0 +1,399 @@
+#include "spectrumwidget.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QPolygonF>
+#include <QRunnable>
+#include <cmath>
+
+namespace {
+// Transforms are recomputed at most this often, and only for channels that
+// received new samples since the previous pass
+const int kRefreshIntervalMs = 100;
+// Vertical span of the plot in dB
+const double kDisplayRangeDb = 120.0;
+
+// Single-sided amplitude spectrum in dB of the newest fft.size() samples
+// of view, zero-padded in front while history is short. window is the
+// fft.size() point window of type.
+QVector<double> amplitudeSpectrum(const Fft &fft, Fft::Window type,
+                                  const QVector<double> &window, const ChannelView &view)
+{
+    const int n = fft.size();
+    const int available = (int)view.size();
+    const int pad = n - available;
+    QVector<double> re(n, 0.0);
+    QVector<double> im(n, 0.0);
+    double *r = re.data() + pad;
+
+    // Short history gets a whole window of its own length rather than the
+    // tail of the full one, which would taper one side only
+    const QVector<double> shortWindow = pad > 0 ? Fft::window(type, available) : QVector<double>();
+    const double *w = pad > 0 ? shortWindow.constData() : window.constData();
+
+    // Padding carries no signal, so only the window over real samples
+    // sets the amplitude scale
+    view.read(0, available, nullptr, r);
+    double windowSum = 0.0;
+    for (int i = 0; i < available; ++i) {
+        r[i] *= w[i];
+        windowSum += w[i];
+    }
+
+    fft.transform(re.data(), im.data());
+
+    const int bins = n / 2 + 1;
+    QVector<double> magnitude(bins);
+    const double scale = windowSum > 0.0 ? 2.0 / windowSum : 0.0;
+    for (int k = 0; k < bins; ++k) {
+        const double amplitude = std::sqrt(re[k] * re[k] + im[k] * im[k]) * scale;
+        magnitude[k] = 20.0 * std::log10(qMax(amplitude, 1e-12));
+    }
+    return magnitude;
+}
+
+class SpectrumTask : public QRunnable
+{
+public:
+    SpectrumTask(SpectrumWidget *widget, int generation, int channel, qint64 appended,
+                 const QSharedPointer<const Fft> &fft, Fft::Window type,
+                 const QVector<double> &window, const ChannelView &view)
+        : widget(widget), generation(generation), channel(channel), appended(appended)
+        , fft(fft), type(type), window(window), view(view) {}
+
+    void run() override
+    {
+        const QVector<double> magnitude = amplitudeSpectrum(*fft, type, window, view);
+        // Hand the spectrum back to the GUI thread
+        QMetaObject::invokeMethod(widget, "onTransformed", Qt::QueuedConnection,
+                                  Q_ARG(int, generation), Q_ARG(int, channel),
+                                  Q_ARG(qint64, appended),
+                                  Q_ARG(QVector<double>, magnitude));
+    }
+
+private:
+    SpectrumWidget *widget;
+    int generation;
+    int channel;
+    qint64 appended;
+    QSharedPointer<const Fft> fft;
+    Fft::Window type;
+    QVector<double> window;
+    ChannelView view;   // Shares the store's chunks, no sample copies
+};
+}
+
+SpectrumWidget::SpectrumWidget(QWidget *parent)
+    : QWidget(parent)
+    , store(nullptr)
+    , windowType(Fft::Hann)
+    , sampleRate(0.0)
+    , refreshTimer(new QTimer(this))
+    , transformGeneration(0)
+    , plotTitle("Spectrum")
+    , yAxisLabel("dB")
+    , xAxisLabel("Frequency")
+    , waitingMessage("Waiting for data...")
+{
+    setMinimumSize(400, 300);
+    setBackgroundRole(QPalette::Base);
+    setAutoFillBackground(true);
+
+    qRegisterMetaType<QVector<double> >("QVector<double>");
+
+    // Same channel colors as PlotWidget
+    QVector<QColor> colors;
+    colors << QColor(255, 0, 0)      // Red
+           << QColor(0, 0, 255)      // Blue
+           << QColor(0, 128, 0)      // Green
+           << QColor(255, 165, 0)    // Orange
+           << QColor(128, 0, 128)    // Purple
+           << QColor(0, 128, 128);   // Teal
+
+    for (int i = 0; i < 6; ++i) {
+        SpectrumChannel channel;
+        channel.color = colors[i];
+        channel.name = QString("Graph %1").arg(i + 1);
+        channel.enabled = (i == 0);
+        channels.append(channel);
+    }
+
+    rebuildPlan(1024);
+
+    connect(refreshTimer, &QTimer::timeout, this, &SpectrumWidget::recompute);
+    refreshTimer->start(kRefreshIntervalMs);
+}
+
+SpectrumWidget::~SpectrumWidget()
+{
+    // Workers post back to this object, so let them finish first
+    transformPool.clear();
+    transformPool.waitForDone();
+}
+
+void SpectrumWidget::setChannelStore(const ChannelStore *channelStore)
+{
+    store = channelStore;
+    invalidate();
+}
+
+void SpectrumWidget::clearData()
+{
+    invalidate();
+}
+
+void SpectrumWidget::setChannelEnabled(int channel, bool enabled)
+{
+    if (channel >= 0 && channel < channels.size()) {
+        channels[channel].enabled = enabled;
+        channels[channel].transformedCount = -1;
+        update();
+    }
+}
+
+void SpectrumWidget::setFftSize(int size)
+{
+    if (!Fft::isPowerOfTwo(size) || size < Fft::MinSize || size > Fft::MaxSize) {
+        return;
+    }
+    if (size != fft->size()) {
+        rebuildPlan(size);
+    }
+}
+
+void SpectrumWidget::setWindow(Fft::Window window)
+{
+    windowType = window;
+    rebuildPlan(fft->size());
+}
+
+void SpectrumWidget::setSampleRate(double hz)
+{
+    sampleRate = hz;
+    update();
+}
+
+void SpectrumWidget::rebuildPlan(int size)
+{
+    fft = QSharedPointer<const Fft>(new Fft(size));
+    windowCoefficients = Fft::window(windowType, size);
+    invalidate();
+}
+
+void SpectrumWidget::invalidate()
+{
+    // Force every channel to be transformed again on the next pass
+    ++transformGeneration;
+    for (int i = 0; i < channels.size(); ++i) {
+        channels[i].magnitude.clear();
+        channels[i].transformedCount = -1;
+        channels[i].transforming = false;
+    }
+    update();
+}
+
+void SpectrumWidget::recompute()
+{
+    // Pending samples are kept and picked up once the tab is shown again
+    if (!isVisible() || !store) {
+        return;
+    }
+
+    const int n = fft->size();
+    for (int ch = 0; ch < channels.size(); ++ch) {
+        SpectrumChannel &c = channels[ch];
+        if (!c.enabled || c.transforming || ch >= store->channelCount()) {
+            continue;
+        }
+        const qint64 appended = store->appendedCount(ch);
+        if (appended == c.transformedCount || store->size(ch) < 2) {
+            continue;
+        }
+
+        // The view pins the newest n samples while the store keeps appending
+        const ChannelView view = store->tail(ch, n);
+#ifdef __EMSCRIPTEN__
+        // No worker threads in the WebAssembly build, transform inline
+        onTransformed(transformGeneration, ch, appended,
+                      amplitudeSpectrum(*fft, windowType, windowCoefficients, view));
+#else
+        c.transforming = true;
+        transformPool.start(new SpectrumTask(this, transformGeneration, ch, appended,
+                                             fft, windowType, windowCoefficients, view));
+#endif
+    }
+}
+
+void SpectrumWidget::onTransformed(int generation, int channel, qint64 appended,
+                                   const QVector<double> &magnitude)
+{
+    if (generation != transformGeneration || channel >= channels.size()) {
+        return;
+    }
+    SpectrumChannel &c = channels[channel];
+    c.transforming = false;
+    c.magnitude = magnitude;
+    c.transformedCount = appended;
+    update();
+}
+
+void SpectrumWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    const int leftMargin = 60;
+    const int rightMargin = 20;
+    const int topMargin = 30;
+    const int bottomMargin = 40;
+
+    int plotWidth = width() - leftMargin - rightMargin;
+    int plotHeight = height() - topMargin - bottomMargin;
+
+    // Background and plot area, matching PlotWidget
+    QLinearGradient bgGradient(0, 0, 0, height());
+    bgGradient.setColorAt(0, QColor(250, 250, 250));
+    bgGradient.setColorAt(1, QColor(240, 240, 240));
+    painter.fillRect(rect(), bgGradient);
+    painter.fillRect(leftMargin, topMargin, plotWidth, plotHeight, Qt::white);
+    painter.setPen(QPen(QColor(52, 152, 219), 2));
+    painter.drawRect(leftMargin, topMargin, plotWidth, plotHeight);
+
+    // Vertical range follows the strongest bin of the enabled channels
+    double peakDb = -1e9;
+    bool hasData = false;
+    for (const SpectrumChannel &c : channels) {
+        if (!c.enabled) {
+            continue;
+        }
+        for (double db : c.magnitude) {
+            if (db > peakDb) peakDb = db;
+            hasData = true;
+        }
+    }
+    const double yMax = hasData ? std::ceil((peakDb + 5.0) / 10.0) * 10.0 : 0.0;
+    const double yMin = yMax - kDisplayRangeDb;
+    const double nyquist = sampleRate > 0.0 ? sampleRate / 2.0 : 0.5;
+
+    // Grid with labels
+    painter.setFont(QFont("Microsoft YaHei UI", 8));
+    for (int i = 0; i <= 6; ++i) {
+        int y = topMargin + i * plotHeight / 6;
+        painter.setPen(QPen(QColor(220, 220, 220), 1, Qt::DotLine));
+        painter.drawLine(leftMargin, y, leftMargin + plotWidth, y);
+
+        double value = yMax - kDisplayRangeDb * i / 6;
+        painter.setPen(QColor(44, 62, 80));
+        painter.drawText(QRect(8, y - 10, 47, 20), Qt::AlignRight | Qt::AlignVCenter,
+                         QString::number(value, 'f', 0));
+    }
+    for (int i = 0; i <= 10; ++i) {
+        int x = leftMargin + i * plotWidth / 10;
+        painter.setPen(QPen(QColor(220, 220, 220), 1, Qt::DotLine));
+        painter.drawLine(x, topMargin, x, topMargin + plotHeight);
+
+        if (i % 2 == 0) {
+            double freq = nyquist * i / 10;
+            painter.setPen(QColor(44, 62, 80));
+            painter.drawText(x - 30, topMargin + plotHeight + 5, 60, 15, Qt::AlignCenter,
+                             QString::number(freq, 'g', 4));
+        }
+    }
+
+    // Title and axis labels
+    painter.setPen(QColor(52, 152, 219));
+    painter.setFont(QFont("Microsoft YaHei UI", 11, QFont::Bold));
+    painter.drawText(QRect(leftMargin, 5, plotWidth, 20), Qt::AlignCenter,
+                     QString("%1  (N=%2)").arg(plotTitle).arg(fft->size()));
+
+    painter.setPen(QColor(44, 62, 80));
+    painter.setFont(QFont("Microsoft YaHei UI", 9, QFont::Bold));
+    QString xLabel = sampleRate > 0.0 ? xAxisLabel + " (Hz)" : xAxisLabel + " (cycles/sample)";
+    painter.drawText(leftMargin, height() - 22, plotWidth, 20, Qt::AlignCenter, xLabel);
+
+    painter.save();
+    painter.translate(12, topMargin + plotHeight / 2);
+    painter.rotate(-90);
+    painter.drawText(-60, 0, 120, 20, Qt::AlignCenter, yAxisLabel);
+    painter.restore();
+
+    if (!hasData) {
+        painter.setPen(QColor(149, 165, 166));
+        painter.setFont(QFont("Microsoft YaHei UI", 11, QFont::Bold));
+        painter.drawText(leftMargin, topMargin, plotWidth, plotHeight,
+                         Qt::AlignCenter, waitingMessage);
+        return;
+    }
+
+    painter.save();
+    painter.setClipRect(leftMargin, topMargin, plotWidth, plotHeight);
+
+    // Spectra, decimated to one max-hold point per pixel column
+    for (const SpectrumChannel &c : channels) {
+        if (!c.enabled || c.magnitude.size() < 2) {
+            continue;
+        }
+
+        const int bins = c.magnitude.size();
+        QPolygonF points;
+        int column = -1;
+        double columnMax = 0.0;
+        for (int k = 0; k < bins; ++k) {
+            int x = (int)((double)k / (bins - 1) * plotWidth);
+            if (x != column) {
+                if (column >= 0) {
+                    double y = topMargin + (yMax - columnMax) / kDisplayRangeDb * plotHeight;
+                    points.append(QPointF(leftMargin + column, y));
+                }
+                column = x;
+                columnMax = c.magnitude[k];
+            } else if (c.magnitude[k] > columnMax) {
+                columnMax = c.magnitude[k];
+            }
+        }
+        double y = topMargin + (yMax - columnMax) / kDisplayRangeDb * plotHeight;
+        points.append(QPointF(leftMargin + column, y));
+
+        painter.setPen(QPen(c.color, 1.5));
+        painter.drawPolyline(points);
+    }
+    painter.restore();
+
+    // Legend with the dominant frequency of each channel (DC excluded)
+    int legendX = leftMargin + 10;
+    int currentY = topMargin + 10;
+    painter.setFont(QFont("Microsoft YaHei UI", 8, QFont::Bold));
+    for (const SpectrumChannel &c : channels) {
+        if (!c.enabled || c.magnitude.size() < 3) {
+            continue;
+        }
+
+        int peakBin = 1;
+        for (int k = 2; k < c.magnitude.size(); ++k) {
+            if (c.magnitude[k] > c.magnitude[peakBin]) {
+                peakBin = k;
+            }
+        }
+        double peakFreq = nyquist * peakBin / (c.magnitude.size() - 1);
+
+        painter.fillRect(legendX, currentY, 15, 12, c.color);
+        painter.setPen(QColor(44, 62, 80));
+        painter.drawText(legendX + 20, currentY + 11,
+                         QString("%1: %2 @ %3 dB")
+                         .arg(c.name)
+                         .arg(peakFreq, 0, 'g', 5)
+                         .arg(c.magnitude[peakBin], 0, 'f', 1));
+        currentY += 22;
+    }
+}
+
+void SpectrumWidget::setPlotTexts(const QString &title, const QString &yLabel,
+                                  const QString &xLabel, const QString &waitingText)
+{
+    plotTitle = title;
+    yAxisLabel = yLabel;
+    xAxisLabel = xLabel;
+    waitingMessage = waitingText;
+    update();
+}
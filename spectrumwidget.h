@@ -0,0 +1,77 @@
+#ifndef SPECTRUMWIDGET_H
+#define SPECTRUMWIDGET_H
+
+#include <QWidget>
+#include <QVector>
+#include <QColor>
+#include <QTimer>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+#include "fft.h"
+#include "channelstore.h"
+
+struct SpectrumChannel {
+    qint64 transformedCount;    // Store appendedCount() at the last transform, -1 forces one
+    QVector<double> magnitude;  // dB per bin, size()/2 + 1 bins
+    QColor color;
+    QString name;
+    bool enabled;
+    bool transforming;          // A transform is running on the pool
+
+    SpectrumChannel() : transformedCount(-1), enabled(false), transforming(false) {}
+};
+
+class SpectrumWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SpectrumWidget(QWidget *parent = nullptr);
+    ~SpectrumWidget();
+
+    // Transforms read the newest fftSize() samples of each channel from the
+    // store, which must retain at least that many and outlive the widget
+    void setChannelStore(const ChannelStore *store);
+    void clearData();
+    void setChannelEnabled(int channel, bool enabled);
+    void setFftSize(int size);
+    int fftSize() const { return fft->size(); }
+    void setWindow(Fft::Window window);
+    void setSampleRate(double hz);  // 0 shows normalized frequency
+    void setPlotTexts(const QString &title, const QString &yLabel,
+                      const QString &xLabel, const QString &waitingText);
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private slots:
+    void recompute();
+    void onTransformed(int generation, int channel, qint64 appended,
+                       const QVector<double> &magnitude);
+
+private:
+    QVector<SpectrumChannel> channels;
+    const ChannelStore *store;
+    // Shared with running transforms, which keep a replaced plan alive
+    QSharedPointer<const Fft> fft;
+    Fft::Window windowType;
+    QVector<double> windowCoefficients;
+    double sampleRate;
+    QTimer *refreshTimer;
+
+    // Transforms run off the GUI thread; results from before the last
+    // invalidate() carry an old generation and are dropped
+    QThreadPool transformPool;
+    int transformGeneration;
+
+    QString plotTitle;
+    QString yAxisLabel;
+    QString xAxisLabel;
+    QString waitingMessage;
+
+    void rebuildPlan(int size);
+    void invalidate();
+};
+
+#endif // SPECTRUMWIDGET_H
@@ -0,0 +1,55 @@
+#include "streammatcher.h"
+
+StreamMatcher::StreamMatcher()
+    : matched(0)
+{
+}
+
+StreamMatcher::StreamMatcher(const QByteArray &pattern)
+    : matched(0)
+{
+    setPattern(pattern);
+}
+
+void StreamMatcher::setPattern(const QByteArray &pattern)
+{
+    needle = pattern;
+    matched = 0;
+
+    const int n = needle.size();
+    failure.fill(0, n);
+    int k = 0;
+    for (int i = 1; i < n; ++i) {
+        while (k > 0 && needle[i] != needle[k]) {
+            k = failure[k - 1];
+        }
+        if (needle[i] == needle[k]) {
+            ++k;
+        }
+        failure[i] = k;
+    }
+}
+
+int StreamMatcher::feed(const char *data, int size)
+{
+    const int n = needle.size();
+    if (n == 0) {
+        // An empty pattern matches before any data
+        return 0;
+    }
+
+    const char *p = needle.constData();
+    for (int i = 0; i < size; ++i) {
+        while (matched > 0 && data[i] != p[matched]) {
+            matched = failure[matched - 1];
+        }
+        if (data[i] == p[matched]) {
+            ++matched;
+        }
+        if (matched == n) {
+            matched = 0;
+            return i + 1;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,33 @@
+#ifndef STREAMMATCHER_H
+#define STREAMMATCHER_H
+
+#include <QByteArray>
+#include <QVector>
+
+// Finds a byte pattern in a stream that arrives in pieces. Uses
+// Knuth-Morris-Pratt, so every byte is looked at once however the stream
+// is split and no received data has to be kept around for rescanning.
+class StreamMatcher
+{
+public:
+    StreamMatcher();
+    explicit StreamMatcher(const QByteArray &pattern);
+
+    void setPattern(const QByteArray &pattern);
+    const QByteArray &pattern() const { return needle; }
+    // Forgets a partial match
+    void reset() { matched = 0; }
+
+    // Returns the number of bytes consumed up to and including the end of
+    // the first match, or -1 when data holds no complete match. The
+    // matcher is reset after a match.
+    int feed(const char *data, int size);
+    int feed(const QByteArray &data) { return feed(data.constData(), data.size()); }
+
+private:
+    QByteArray needle;
+    QVector<int> failure;   // Longest proper prefix that is also a suffix
+    int matched;
+};
+
+#endif // STREAMMATCHER_H
@@ -0,0 +1,147 @@
+#include "tcptransport.h"
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+namespace {
+
+const int kConnectTimeoutMs = 3000;
+
+} // namespace
+
+TcpTransport::TcpTransport(bool listen, QObject *parent)
+    : Transport(listen ? TransportConfig::TcpServer : TransportConfig::TcpClient, parent)
+    , server(listen ? new QTcpServer(this) : nullptr)
+{
+    if (server) {
+        connect(server, &QTcpServer::newConnection, this, &TcpTransport::onNewConnection);
+    }
+}
+
+bool TcpTransport::open(const TransportConfig &config)
+{
+    close();
+    settings = config;
+    settings.kind = kind();
+    lastError.clear();
+
+    if (server) {
+        const QHostAddress address = config.host.isEmpty() ? QHostAddress(QHostAddress::Any)
+                                                           : QHostAddress(config.host);
+        if (!server->listen(address, config.port)) {
+            lastError = server->errorString();
+            return false;
+        }
+        return true;
+    }
+
+    QTcpSocket *client = new QTcpSocket(this);
+    client->connectToHost(config.host, config.port);
+    if (!client->waitForConnected(kConnectTimeoutMs)) {
+        lastError = client->errorString();
+        delete client;
+        return false;
+    }
+    attachSocket(client);
+    return true;
+}
+
+void TcpTransport::close()
+{
+    if (socket) {
+        // Deleted later, as this may run from one of its own signals
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+        socket = nullptr;
+    }
+    if (server) {
+        server->close();
+    }
+}
+
+bool TcpTransport::isOpen() const
+{
+    return server ? server->isListening() : !socket.isNull();
+}
+
+QString TcpTransport::errorString() const
+{
+    return lastError;
+}
+
+qint64 TcpTransport::read(char *data, qint64 maxSize)
+{
+    return socket ? socket->read(data, maxSize) : 0;
+}
+
+qint64 TcpTransport::bytesAvailable() const
+{
+    return socket ? socket->bytesAvailable() : 0;
+}
+
+qint64 TcpTransport::write(const char *data, qint64 size)
+{
+    if (!socket) {
+        lastError = QString("No client connected");
+        return -1;
+    }
+    const qint64 written = socket->write(data, size);
+    if (written < 0) {
+        lastError = socket->errorString();
+    }
+    return written;
+}
+
+void TcpTransport::onNewConnection()
+{
+    while (QTcpSocket *client = server->nextPendingConnection()) {
+        if (socket) {
+            client->abort();
+            client->deleteLater();
+        } else {
+            attachSocket(client);
+        }
+    }
+}
+
+void TcpTransport::onDisconnected()
+{
+    if (!socket) {
+        return;
+    }
+    socket->deleteLater();
+    socket = nullptr;
+    // A server keeps listening for the next client; either way, data in
+    // flight will never be confirmed
+    lastError = server ? QString("Client disconnected") : QString("Connection closed by peer");
+    emit errorOccurred(lastError);
+}
+
+void TcpTransport::onSocketError()
+{
+    if (!socket || socket->error() == QAbstractSocket::RemoteHostClosedError) {
+        return;     // Reported by onDisconnected()
+    }
+    lastError = socket->errorString();
+    emit errorOccurred(lastError);
+}
+
+void TcpTransport::attachSocket(QTcpSocket *client)
+{
+    socket = client;
+    client->setParent(this);
+    // Small writes such as single commands go out at once
+    client->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(client, &QTcpSocket::readyRead, this, &Transport::readyRead);
+    connect(client, &QTcpSocket::bytesWritten, this, &Transport::bytesWritten);
+    connect(client, &QTcpSocket::disconnected, this, &TcpTransport::onDisconnected);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    connect(client, &QAbstractSocket::errorOccurred, this, &TcpTransport::onSocketError);
+#else
+    connect(client, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(onSocketError()));
+#endif
+    if (client->bytesAvailable() > 0) {
+        emit readyRead();
+    }
+}
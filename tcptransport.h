@@ -0,0 +1,44 @@
+#ifndef TCPTRANSPORT_H
+#define TCPTRANSPORT_H
+
+#include "transport.h"
+#include <QPointer>
+
+class QTcpServer;
+class QTcpSocket;
+
+// Raw TCP stream, as served by ser2net and most serial device servers. As
+// a client it connects to host:port; as a server it listens on port and
+// talks to one client at a time, turning away others until it leaves.
+class TcpTransport : public Transport
+{
+    Q_OBJECT
+
+public:
+    TcpTransport(bool listen, QObject *parent = nullptr);
+
+    bool open(const TransportConfig &config) override;
+    void close() override;
+    bool isOpen() const override;
+    QString errorString() const override;
+
+    qint64 read(char *data, qint64 maxSize) override;
+    qint64 bytesAvailable() const override;
+
+    // -1 while a server has no client
+    qint64 write(const char *data, qint64 size) override;
+
+private slots:
+    void onNewConnection();
+    void onDisconnected();
+    void onSocketError();
+
+private:
+    QTcpServer *server;         // Nullptr in client mode
+    QPointer<QTcpSocket> socket;
+    QString lastError;
+
+    void attachSocket(QTcpSocket *client);
+};
+
+#endif // TCPTRANSPORT_H
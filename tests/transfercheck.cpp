@@ -0,0 +1,667 @@
+// Loopback check for FileTransfer. Each case sends a file over a
+// VirtualPort with QSerialPort on the slave side, as the app does, while a
+// minimal XMODEM/YMODEM or ZMODEM receiver answers on the pty master. Exits
+// non-zero when any case fails.
+
+#include "filetransfer.h"
+#include "virtualport.h"
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QSerialPort>
+#include <QTemporaryFile>
+#include <QTimer>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+
+const char SOH = 0x01;
+const char STX = 0x02;
+const char EOT = 0x04;
+const char ACK = 0x06;
+const char NAK = 0x15;
+const char CAN = 0x18;
+const char CPMEOF = 0x1A;
+
+// ZMODEM framing, as in filetransfer.cpp
+const char ZPAD = '*';
+const char ZDLE = 0x18;
+const char ZBIN = 'A';
+const char ZHEX = 'B';
+const char ZBIN32 = 'C';
+const char ZCRCE = 'h';
+const char ZCRCQ = 'j';
+const char ZCRCW = 'k';
+
+enum ZFrameType {
+    ZRQINIT, ZRINIT, ZSINIT, ZACK, ZFILE, ZSKIP, ZNAK, ZABORT, ZFIN,
+    ZRPOS, ZDATA, ZEOF, ZFERR, ZCRC, ZCHALLENGE, ZCOMPL, ZCAN, ZFREECNT, ZCOMMAND
+};
+
+const quint8 CANFDX = 0x01;
+const quint8 CANFC32 = 0x20;
+
+// Longest a sender may take between blocks before the receiver gives up
+const int kBlockTimeoutMs = 15000;
+
+// Receiving end of one transfer, run on its own thread against the master
+class Receiver
+{
+public:
+    explicit Receiver(int fd) : declaredSize(-1), fd(fd) {}
+    virtual ~Receiver() {}
+
+    virtual void run() = 0;
+
+    QByteArray data;
+    QByteArray name;
+    qint64 declaredSize;
+    QString error;
+
+protected:
+    int fd;
+
+    void fail(const QString &message)
+    {
+        if (error.isEmpty()) {
+            error = message;
+        }
+    }
+
+    bool readByte(int *byte, int timeoutMs)
+    {
+        char c;
+        if (!readExact(&c, 1, timeoutMs)) {
+            return false;
+        }
+        *byte = quint8(c);
+        return true;
+    }
+
+    bool readExact(char *out, int size, int timeoutMs)
+    {
+        int done = 0;
+        while (done < size) {
+            pollfd p = { fd, POLLIN, 0 };
+            if (::poll(&p, 1, timeoutMs) <= 0) {
+                return false;
+            }
+            const ssize_t n = ::read(fd, out + done, size_t(size - done));
+            if (n > 0) {
+                done += int(n);
+            }
+        }
+        return true;
+    }
+
+    void send(char c)
+    {
+        send(QByteArray(1, c));
+    }
+
+    void send(const QByteArray &bytes)
+    {
+        int done = 0;
+        while (done < bytes.size()) {
+            pollfd p = { fd, POLLOUT, 0 };
+            ::poll(&p, 1, 1000);
+            const ssize_t n = ::write(fd, bytes.constData() + done, size_t(bytes.size() - done));
+            if (n > 0) {
+                done += int(n);
+            }
+        }
+    }
+};
+
+class BlockReceiver : public Receiver
+{
+public:
+    enum Mode {
+        Receive,            // Take the whole file
+        NakBlockOnce,       // Take the whole file, but NAK block 2 the first time
+        CancelAfterHeader,  // YMODEM: cancel instead of asking for data
+        SilentAfterHeader   // YMODEM: never ask for data
+    };
+
+    BlockReceiver(int fd, bool batch, Mode mode)
+        : Receiver(fd), batch(batch), mode(mode), nakSent(false) {}
+
+    void run() override
+    {
+        int header = startBlock();
+        if (batch) {
+            int number = 0;
+            QByteArray payload;
+            if (!readBlock(header, &number, &payload) || number != 0) {
+                fail("Bad file header block");
+                return;
+            }
+            name = payload.left(payload.indexOf('\0'));
+            const QByteArray info = payload.mid(name.size() + 1);
+            declaredSize = info.left(info.indexOf(' ')).toLongLong();
+            send(ACK);
+            if (mode == CancelAfterHeader) {
+                send(QByteArray(2, CAN));
+                return;
+            }
+            if (mode == SilentAfterHeader) {
+                return;
+            }
+            header = startBlock();
+        }
+
+        int expected = 1;
+        for (;;) {
+            if (header == EOT) {
+                send(ACK);
+                break;
+            }
+            int number = 0;
+            QByteArray payload;
+            if (!readBlock(header, &number, &payload) || number != (expected & 0xFF)) {
+                fail(QString("Bad block %1").arg(expected));
+                return;
+            }
+            if (mode == NakBlockOnce && expected == 2 && !nakSent) {
+                // As if it arrived damaged; the sender has to resend it
+                nakSent = true;
+                send(NAK);
+            } else {
+                data.append(payload);
+                ++expected;
+                send(ACK);
+            }
+            if (!readByte(&header, kBlockTimeoutMs)) {
+                fail("Sender stopped");
+                return;
+            }
+        }
+
+        if (batch) {
+            // The empty block 0 that ends the batch
+            int number = 0;
+            QByteArray payload;
+            if (!readBlock(startBlock(), &number, &payload) || number != 0 || payload[0] != '\0') {
+                fail("Batch not ended");
+                return;
+            }
+            send(ACK);
+        }
+    }
+
+private:
+    bool batch;
+    Mode mode;
+    bool nakSent;
+
+    // Asks for CRC blocks once a second until a block or EOT starts
+    int startBlock()
+    {
+        for (int attempt = 0; attempt < 30; ++attempt) {
+            send('C');
+            int byte = 0;
+            if (readByte(&byte, 1000) && (byte == SOH || byte == STX || byte == EOT)) {
+                return byte;
+            }
+        }
+        fail("Sender did not start");
+        return -1;
+    }
+
+    bool readBlock(int header, int *number, QByteArray *payload)
+    {
+        if (header != SOH && header != STX) {
+            return false;
+        }
+        const int size = header == STX ? 1024 : 128;
+        QByteArray block(size + 4, '\0');
+        if (!readExact(block.data(), block.size(), kBlockTimeoutMs)) {
+            return false;
+        }
+        const quint8 n = quint8(block[0]);
+        if (quint8(block[1]) != quint8(255 - n)) {
+            return false;
+        }
+        const quint16 crc = FileTransfer::crc16(block.constData() + 2, size);
+        if (quint8(block[size + 2]) != quint8(crc >> 8) || quint8(block[size + 3]) != quint8(crc)) {
+            return false;
+        }
+        *number = n;
+        *payload = block.mid(2, size);
+        return true;
+    }
+};
+
+// Answers a ZMODEM sender, asking for CRC-32 frames and a full duplex
+// stream, and checks the CRC of every header and subpacket. With rewind
+// set it sends one ZRPOS back to kRewindTo once data has passed
+// kRewindAfter, as a receiver does after a damaged subpacket, so the
+// sender has to go back in the middle of the stream.
+class ZmodemReceiver : public Receiver
+{
+public:
+    ZmodemReceiver(int fd, bool rewind)
+        : Receiver(fd), subpackets(0), rewind(rewind), rewound(false) {}
+
+    void run() override
+    {
+        const quint8 none[4] = { 0, 0, 0, 0 };
+        const quint8 options[4] = { 0, 0, 0, quint8(CANFDX | CANFC32) };
+        int type = -1;
+        quint32 position = 0;
+
+        while (type != ZRQINIT) {
+            if (!readHeader(&type, &position)) {
+                fail("Sender did not start");
+                return;
+            }
+        }
+        sendHexHeader(ZRINIT, options);
+
+        char end = 0;
+        QByteArray info;
+        if (!readHeader(&type, &position) || type != ZFILE || !readSubpacket(&info, &end)) {
+            fail("Bad file header");
+            return;
+        }
+        name = info.left(info.indexOf('\0'));
+        const QByteArray fileInfo = info.mid(name.size() + 1);
+        declaredSize = fileInfo.left(fileInfo.indexOf(' ')).toLongLong();
+        sendHexHeader(ZRPOS, none);
+
+        for (;;) {
+            if (!readHeader(&type, &position)) {
+                fail("Sender stopped");
+                return;
+            }
+            if (type == ZDATA) {
+                if (position != quint32(data.size())) {
+                    fail(QString("Data sent from %1, not %2").arg(position).arg(data.size()));
+                    return;
+                }
+                if (!readFrame()) {
+                    return;
+                }
+            } else if (type == ZEOF) {
+                // One sent before the sender saw our ZRPOS is stale
+                if (position == quint32(data.size())) {
+                    sendHexHeader(ZRINIT, options);
+                }
+            } else if (type == ZFIN) {
+                sendHexHeader(ZFIN, none);
+                // "OO" ends the session
+                int previous = 0;
+                int byte = 0;
+                while (previous != 'O' || byte != 'O') {
+                    previous = byte;
+                    if (!readByte(&byte, kBlockTimeoutMs)) {
+                        fail("Session not closed");
+                        return;
+                    }
+                }
+                return;
+            } else {
+                fail(QString("Unexpected header %1").arg(type));
+                return;
+            }
+        }
+    }
+
+    int subpackets;     // Data subpackets taken, each CRC-32 checked
+
+private:
+    static const int kRewindTo = 1024;
+    static const int kRewindAfter = 2048;
+
+    bool rewind;
+    bool rewound;
+
+    // Takes the subpackets of one ZDATA frame
+    bool readFrame()
+    {
+        for (;;) {
+            QByteArray payload;
+            char end = 0;
+            if (!readSubpacket(&payload, &end)) {
+                fail(QString("Bad subpacket at %1").arg(data.size()));
+                return false;
+            }
+            data.append(payload);
+            ++subpackets;
+            if (rewind && !rewound && data.size() >= kRewindAfter) {
+                // The rest of the frame is skipped looking for the next header
+                rewound = true;
+                data.truncate(kRewindTo);
+                sendHexHeader(ZRPOS, positionBytes(data.size()).constData());
+                return true;
+            }
+            if (end == ZCRCQ || end == ZCRCW) {
+                sendHexHeader(ZACK, positionBytes(data.size()).constData());
+            }
+            if (end == ZCRCE || end == ZCRCW) {
+                return true;
+            }
+        }
+    }
+
+    static QByteArray positionBytes(int position)
+    {
+        QByteArray p(4, '\0');
+        for (int i = 0; i < 4; ++i) {
+            p[i] = char(position >> (8 * i));
+        }
+        return p;
+    }
+
+    void sendHexHeader(int type, const void *p)
+    {
+        QByteArray raw(1, char(type));
+        raw.append(static_cast<const char *>(p), 4);
+        const quint16 crc = FileTransfer::crc16(raw.constData(), raw.size());
+        raw.append(char(crc >> 8));
+        raw.append(char(crc));
+        send(QByteArray("**") + ZDLE + ZHEX + raw.toHex() + "\r\x8a");
+    }
+
+    // Skips to the next header. Binary ones must be the CRC-32 kind asked
+    // for in ZRINIT; a damaged header of either kind fails the check.
+    bool readHeader(int *type, quint32 *position)
+    {
+        quint8 bytes[9];
+        int byte = 0;
+        for (;;) {
+            if (!readByte(&byte, kBlockTimeoutMs)) {
+                return false;
+            }
+            if (byte != ZPAD) {
+                continue;
+            }
+            while (byte == ZPAD) {
+                if (!readByte(&byte, kBlockTimeoutMs)) {
+                    return false;
+                }
+            }
+            if (byte != ZDLE) {
+                continue;
+            }
+            if (!readByte(&byte, kBlockTimeoutMs)) {
+                return false;
+            }
+            if (byte == ZHEX) {
+                char hex[14];
+                if (!readExact(hex, sizeof(hex), kBlockTimeoutMs)) {
+                    return false;
+                }
+                const QByteArray decoded = QByteArray::fromHex(QByteArray(hex, sizeof(hex)));
+                const char *raw = decoded.constData();
+                if (decoded.size() != 7
+                        || FileTransfer::crc16(raw, 5) != quint16(quint8(raw[5]) << 8 | quint8(raw[6]))) {
+                    fail("Bad hex header");
+                    return false;
+                }
+                std::memcpy(bytes, raw, 5);
+                break;
+            }
+            if (byte == ZBIN) {
+                fail("CRC-16 binary header");
+                return false;
+            }
+            if (byte != ZBIN32) {
+                // A '*' in skipped data
+                continue;
+            }
+            for (int n = 0; n < 9; ++n) {
+                char end = 0;
+                int value = 0;
+                if (!readEscaped(&value, &end) || end) {
+                    return false;
+                }
+                bytes[n] = quint8(value);
+            }
+            const quint32 crc = quint32(bytes[5]) | quint32(bytes[6]) << 8
+                                | quint32(bytes[7]) << 16 | quint32(bytes[8]) << 24;
+            if (FileTransfer::crc32(reinterpret_cast<const char *>(bytes), 5) != crc) {
+                fail("Bad CRC-32 header");
+                return false;
+            }
+            break;
+        }
+        *type = bytes[0];
+        *position = quint32(bytes[1]) | quint32(bytes[2]) << 8
+                    | quint32(bytes[3]) << 16 | quint32(bytes[4]) << 24;
+        return true;
+    }
+
+    // Data up to the ZDLE frame end, then its CRC-32, which covers the
+    // data and the frame end character
+    bool readSubpacket(QByteArray *payload, char *end)
+    {
+        int byte = 0;
+        for (;;) {
+            if (!readEscaped(&byte, end)) {
+                return false;
+            }
+            if (*end) {
+                break;
+            }
+            payload->append(char(byte));
+        }
+        quint32 crc = 0;
+        for (int i = 0; i < 4; ++i) {
+            char notEnd = 0;
+            if (!readEscaped(&byte, &notEnd) || notEnd) {
+                return false;
+            }
+            crc |= quint32(byte) << (8 * i);
+        }
+        return crc == FileTransfer::crc32(end, 1, FileTransfer::crc32(payload->constData(), payload->size()));
+    }
+
+    // One unescaped byte, or in *end the frame end character after ZDLE
+    bool readEscaped(int *byte, char *end)
+    {
+        *end = 0;
+        for (;;) {
+            if (!readByte(byte, kBlockTimeoutMs)) {
+                return false;
+            }
+            // XON/XOFF are escaped in data, so bare ones are flow control
+            if ((*byte & 0x7F) == 0x11 || (*byte & 0x7F) == 0x13) {
+                continue;
+            }
+            if (*byte != quint8(ZDLE)) {
+                return true;
+            }
+            if (!readByte(byte, kBlockTimeoutMs)) {
+                return false;
+            }
+            if (*byte >= ZCRCE && *byte <= ZCRCW) {
+                *end = char(*byte);
+            } else if (*byte == 'l') {
+                *byte = 0x7F;
+            } else if (*byte == 'm') {
+                *byte = 0xFF;
+            } else if ((*byte & 0x60) == 0x40) {
+                *byte ^= 0x40;
+            } else {
+                return false;
+            }
+            return true;
+        }
+    }
+};
+
+struct Result {
+    bool ok;
+    QString error;
+    int retries;
+};
+
+Result sendFile(FileTransfer::Protocol protocol, const QString &fileName,
+                Receiver *receiver, VirtualPort *port)
+{
+    Result result = { false, QString(), 0 };
+
+    // Leftovers from the previous case, e.g. the CANs of an aborted one
+    char scratch[4096];
+    while (::read(port->masterHandle(), scratch, sizeof(scratch)) > 0) {
+    }
+
+    QSerialPort serial(port->slavePath());
+    if (!serial.open(QIODevice::ReadWrite)) {
+        result.error = serial.errorString();
+        return result;
+    }
+
+    FileTransfer transfer;
+    QEventLoop loop;
+    QObject::connect(&serial, &QSerialPort::readyRead, &loop, [&]() {
+        transfer.feed(serial.readAll());
+    });
+    QObject::connect(&transfer, &FileTransfer::finished, &loop,
+                     [&](bool ok, const QString &error) {
+        result.ok = ok;
+        result.error = error;
+        loop.quit();
+    });
+    QTimer::singleShot(60000, &loop, [&]() {
+        result.error = "Check timed out";
+        loop.quit();
+    });
+
+    std::thread receiving([&]() { receiver->run(); });
+    QString error;
+    if (transfer.startTransfer(serial.handle(), protocol, fileName, 11520.0, &error)) {
+        loop.exec();
+    } else {
+        result.error = error;
+    }
+    transfer.cancel();
+    receiving.join();
+    result.retries = transfer.retries();
+    return result;
+}
+
+bool check(const char *name, bool passed, const QString &detail)
+{
+    std::printf("%s %s%s%s\n", passed ? "PASS" : "FAIL", name,
+                detail.isEmpty() ? "" : ": ", qPrintable(detail));
+    return passed;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    VirtualPort port;
+    QString error;
+    if (!port.open(&error)) {
+        std::printf("FAIL virtual port: %s\n", qPrintable(error));
+        return 1;
+    }
+
+    // Not a multiple of either block size, so the short tail is exercised;
+    // the last byte is not CPMEOF so padding can be told apart
+    QTemporaryFile file;
+    QByteArray content(5000, '\0');
+    quint32 state = 12345;
+    for (int i = 0; i < content.size(); ++i) {
+        state = state * 1103515245u + 12345u;
+        content[i] = char(state >> 24);
+    }
+    content[content.size() - 1] = 'x';
+    if (!file.open() || file.write(content) != content.size() || !file.flush()) {
+        std::printf("FAIL temporary file: %s\n", qPrintable(file.errorString()));
+        return 1;
+    }
+    const QString fileName = file.fileName();
+
+    bool passed = true;
+
+    struct BlockCase {
+        const char *name;
+        FileTransfer::Protocol protocol;
+    };
+    const BlockCase cases[] = {
+        { "XMODEM", FileTransfer::Xmodem },
+        { "XMODEM-1K", FileTransfer::Xmodem1K },
+        { "YMODEM", FileTransfer::Ymodem },
+    };
+    for (const BlockCase &c : cases) {
+        const bool batch = c.protocol == FileTransfer::Ymodem;
+        BlockReceiver receiver(port.masterHandle(), batch, BlockReceiver::Receive);
+        const Result result = sendFile(c.protocol, fileName, &receiver, &port);
+
+        // XMODEM pads the last block with CPMEOF; YMODEM sends the size
+        bool intact = receiver.data.left(content.size()) == content;
+        if (batch) {
+            intact = intact && receiver.declaredSize == content.size()
+                     && receiver.name == QFileInfo(fileName).fileName().toUtf8();
+        } else {
+            for (int i = content.size(); i < receiver.data.size(); ++i) {
+                intact = intact && receiver.data[i] == CPMEOF;
+            }
+        }
+        passed &= check(c.name, result.ok && receiver.error.isEmpty() && intact,
+                        !result.error.isEmpty() ? result.error : receiver.error);
+    }
+
+    // A block the receiver NAKs must be sent again, and only once
+    {
+        BlockReceiver receiver(port.masterHandle(), false, BlockReceiver::NakBlockOnce);
+        const Result result = sendFile(FileTransfer::Xmodem, fileName, &receiver, &port);
+        const bool intact = receiver.data.left(content.size()) == content;
+        passed &= check("XMODEM block NAKed once",
+                        result.ok && receiver.error.isEmpty() && intact && result.retries == 1,
+                        !result.error.isEmpty() ? result.error
+                        : !receiver.error.isEmpty() ? receiver.error
+                        : QString("%1 retries").arg(result.retries));
+    }
+
+    // ZMODEM streams CRC-32 subpackets; a ZRPOS in the middle of the stream
+    // must send it back to the asked position
+    struct ZmodemCase {
+        const char *name;
+        bool rewind;
+    };
+    const ZmodemCase zmodemCases[] = {
+        { "ZMODEM", false },
+        { "ZMODEM rewound by ZRPOS", true },
+    };
+    for (const ZmodemCase &c : zmodemCases) {
+        ZmodemReceiver receiver(port.masterHandle(), c.rewind);
+        const Result result = sendFile(FileTransfer::Zmodem, fileName, &receiver, &port);
+        const bool intact = receiver.data == content && receiver.declaredSize == content.size()
+                            && receiver.name == QFileInfo(fileName).fileName().toUtf8();
+        passed &= check(c.name,
+                        result.ok && receiver.error.isEmpty() && intact && receiver.subpackets > 0
+                        && result.retries == (c.rewind ? 1 : 0),
+                        !result.error.isEmpty() ? result.error
+                        : !receiver.error.isEmpty() ? receiver.error
+                        : QString("%1 retries").arg(result.retries));
+    }
+
+    // A receiver that gives up after the file header must fail the transfer
+    {
+        BlockReceiver receiver(port.masterHandle(), true, BlockReceiver::CancelAfterHeader);
+        const Result result = sendFile(FileTransfer::Ymodem, fileName, &receiver, &port);
+        passed &= check("YMODEM cancelled after header",
+                        !result.ok && result.error == "Cancelled by receiver", result.error);
+    }
+    {
+        BlockReceiver receiver(port.masterHandle(), true, BlockReceiver::SilentAfterHeader);
+        const Result result = sendFile(FileTransfer::Ymodem, fileName, &receiver, &port);
+        passed &= check("YMODEM silent after header",
+                        !result.ok && result.error == "Receiver did not ask for file data",
+                        result.error);
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+#include "transmitqueue.h"
+#include "transport.h"
+
+namespace {
+
+// Most data handed to the port at once. The port buffers what it is given,
+// so a small window keeps clear() effective and the queue the only backlog.
+const qint64 kWindowBytes = 4096;
+const qint64 kDefaultHighWaterBytes = 64 * 1024;
+
+} // namespace
+
+TransmitQueue::TransmitQueue(Transport *port, QObject *parent)
+    : QObject(parent)
+    , port(nullptr)
+    , headOffset(0)
+    , highWater(kDefaultHighWaterBytes)
+    , queued(0)
+    , inFlight(0)
+    , unreported(0)
+    , unreportedLines(0)
+{
+    setTransport(port);
+}
+
+void TransmitQueue::setTransport(Transport *port)
+{
+    if (this->port) {
+        this->port->disconnect(this);
+    }
+    this->port = port;
+    connect(port, &Transport::bytesWritten, this, &TransmitQueue::onPortBytesWritten);
+    // A failed write or lost link never confirms, so nothing is in flight
+    // anymore
+    connect(port, &Transport::errorOccurred, this, [this](const QString &error) {
+        if (inFlight > 0) {
+            reset();
+            emit failed(error);
+        }
+    });
+}
+
+void TransmitQueue::setHighWaterMark(qint64 bytes)
+{
+    highWater = qMax<qint64>(1, bytes);
+}
+
+bool TransmitQueue::enqueue(const QByteArray &data)
+{
+    if (data.isEmpty()) {
+        return true;
+    }
+    if (isFull()) {
+        return false;
+    }
+    pending.enqueue(data);
+    queued += data.size();
+    writeToPort();
+    return true;
+}
+
+void TransmitQueue::clear()
+{
+    pending.clear();
+    headOffset = 0;
+    queued = 0;
+    // Bytes the link discards will never be confirmed
+    if (port->clearOutput()) {
+        inFlight = 0;
+    }
+}
+
+void TransmitQueue::reset()
+{
+    pending.clear();
+    headOffset = 0;
+    queued = 0;
+    inFlight = 0;
+}
+
+qint64 TransmitQueue::takeBytesWritten()
+{
+    const qint64 bytes = unreported;
+    unreported = 0;
+    return bytes;
+}
+
+qint64 TransmitQueue::takeLinesWritten()
+{
+    const qint64 lines = unreportedLines;
+    unreportedLines = 0;
+    return lines;
+}
+
+void TransmitQueue::onPortBytesWritten(qint64 bytes)
+{
+    // Stale confirmations for data dropped by clear() are ignored
+    bytes = qMin(bytes, inFlight);
+    if (bytes <= 0) {
+        return;
+    }
+    inFlight -= bytes;
+    unreported += bytes;
+    writeToPort();
+    emit bytesWritten(bytes);
+}
+
+void TransmitQueue::writeToPort()
+{
+    if (!port->isOpen()) {
+        return;
+    }
+
+    while (!pending.isEmpty() && inFlight < kWindowBytes) {
+        if (inFlight > 0 && !port->acceptsQueuedWrites()) {
+            break;
+        }
+        // Coalesce small writes up to the window
+        QByteArray chunk;
+        while (!pending.isEmpty() && inFlight + chunk.size() < kWindowBytes) {
+            const QByteArray &head = pending.head();
+            const int take = int(qMin<qint64>(head.size() - headOffset,
+                                              kWindowBytes - inFlight - chunk.size()));
+            if (headOffset == 0 && take == head.size() && chunk.isEmpty()) {
+                chunk = head;   // Shares the data
+            } else {
+                chunk.append(head.constData() + headOffset, take);
+            }
+            headOffset += take;
+            if (headOffset == head.size()) {
+                pending.dequeue();
+                headOffset = 0;
+            }
+        }
+
+        if (port->write(chunk.constData(), chunk.size()) != chunk.size()) {
+            const QString error = port->errorString();
+            reset();
+            emit failed(error);
+            return;
+        }
+        queued -= chunk.size();
+        inFlight += chunk.size();
+        unreportedLines += chunk.count('\n');
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef TRANSMITQUEUE_H
+#define TRANSMITQUEUE_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QQueue>
+
+class Transport;
+
+// Every write to the link goes through here. Data moves through
+// three stages: queued (held here), in flight (handed to the port) and
+// written (confirmed by the port's bytesWritten()). Only a small window is
+// ever in flight, so clear() takes effect at once, and enqueue() refuses
+// new data while the backlog is at the high-water mark, so a slow device
+// cannot make memory grow without bound.
+class TransmitQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TransmitQueue(Transport *port, QObject *parent = nullptr);
+
+    // Follows a new link; call reset() first
+    void setTransport(Transport *port);
+
+    void setHighWaterMark(qint64 bytes);
+    qint64 highWaterMark() const { return highWater; }
+
+    // Accepts data while the backlog is below the high-water mark; the
+    // last accepted write may take it past the mark
+    bool enqueue(const QByteArray &data);
+    bool isFull() const { return pendingBytes() >= highWater; }
+    // Drops queued data and, where the port allows, data in flight
+    void clear();
+    // Forgets everything; call when the port closes
+    void reset();
+
+    qint64 queuedBytes() const { return queued; }
+    qint64 inFlightBytes() const { return inFlight; }
+    qint64 pendingBytes() const { return queued + inFlight; }
+    // Bytes confirmed since the previous call, for the TX counter
+    qint64 takeBytesWritten();
+    // Line ends handed to the port since the previous call, for the TX
+    // line rate
+    qint64 takeLinesWritten();
+
+signals:
+    // Emitted after each confirmation, once more data has been handed on
+    void bytesWritten(qint64 bytes);
+    void failed(const QString &error);
+
+private slots:
+    void onPortBytesWritten(qint64 bytes);
+
+private:
+    Transport *port;
+    QQueue<QByteArray> pending;
+    int headOffset;         // Bytes of pending.head() already in flight
+    qint64 highWater;
+    qint64 queued;
+    qint64 inFlight;
+    qint64 unreported;
+    qint64 unreportedLines;
+
+    void writeToPort();
+};
+
+#endif // TRANSMITQUEUE_H
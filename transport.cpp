@@ -0,0 +1,105 @@
+#include "transport.h"
+
+#ifdef __EMSCRIPTEN__
+#include "webserialtransport.h"
+#else
+#include "serialtransport.h"
+#include "tcptransport.h"
+#include "udptransport.h"
+#endif
+
+TransportConfig::TransportConfig()
+#ifdef __EMSCRIPTEN__
+    : kind(WebSerial)
+#else
+    : kind(Serial)
+#endif
+    , baudRate(115200)
+    , dataBits(8)
+    , parity(NoParity)
+    , stopBits(OneStop)
+    , hardwareFlowControl(false)
+    , port(0)
+{
+}
+
+bool TransportConfig::setAddress(const QString &address)
+{
+    const QString text = address.trimmed();
+    const int colon = text.lastIndexOf(':');
+    bool ok = false;
+    const uint number = text.mid(colon + 1).toUInt(&ok);
+    if (!ok || number == 0 || number > 65535) {
+        return false;
+    }
+    host = colon > 0 ? text.left(colon) : QString();
+    port = quint16(number);
+    return true;
+}
+
+QString TransportConfig::displayName() const
+{
+    switch (kind) {
+    case TcpClient:
+        return QString("tcp://%1:%2").arg(host).arg(port);
+    case TcpServer:
+        return QString("tcp://%1:%2 (listening)").arg(host.isEmpty() ? QString("*") : host).arg(port);
+    case Udp:
+        return host.isEmpty() ? QString("udp://*:%1").arg(port)
+                              : QString("udp://%1:%2").arg(host).arg(port);
+    default:
+        return portName;
+    }
+}
+
+double TransportConfig::lineBytesPerSecond() const
+{
+    if (kind != Serial && kind != WebSerial) {
+        return 0.0;
+    }
+    // Start bit, data bits, parity and stop bits on the wire per byte
+    double bits = 1 + dataBits;
+    if (parity != NoParity) {
+        bits += 1;
+    }
+    switch (stopBits) {
+    case OneAndHalfStop:
+        bits += 1.5;
+        break;
+    case TwoStop:
+        bits += 2;
+        break;
+    default:
+        bits += 1;
+        break;
+    }
+    return baudRate / bits;
+}
+
+Transport::Transport(TransportConfig::Kind kind, QObject *parent)
+    : QObject(parent)
+    , linkKind(kind)
+{
+    settings.kind = kind;
+}
+
+Transport *Transport::create(TransportConfig::Kind kind, QObject *parent)
+{
+    switch (kind) {
+#ifdef __EMSCRIPTEN__
+    case TransportConfig::WebSerial:
+        return new WebSerialTransport(parent);
+#else
+    case TransportConfig::Serial:
+        return new SerialTransport(parent);
+    case TransportConfig::TcpClient:
+        return new TcpTransport(false, parent);
+    case TransportConfig::TcpServer:
+        return new TcpTransport(true, parent);
+    case TransportConfig::Udp:
+        return new UdpTransport(parent);
+#endif
+    default:
+        return nullptr;
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <QObject>
+#include <QString>
+#ifndef __EMSCRIPTEN__
+#include <QSerialPort>
+#endif
+
+// Settings for every kind of link. Serial settings are ignored by network
+// links, and the address by serial ones.
+struct TransportConfig {
+    enum Kind {
+        Serial,         // QSerialPort, including the pty virtual port
+        WebSerial,      // Browser Web Serial API
+        TcpClient,      // Connects to host:port, e.g. a ser2net port
+        TcpServer,      // Listens on port and serves one client at a time
+        Udp             // Sends to host:port, or answers the last sender
+    };
+    enum Parity { NoParity, OddParity, EvenParity };
+    enum StopBits { OneStop, OneAndHalfStop, TwoStop };
+
+    Kind kind;
+    QString portName;
+    qint32 baudRate;
+    int dataBits;
+    Parity parity;
+    StopBits stopBits;
+    bool hardwareFlowControl;
+    QString host;       // Empty listens on all interfaces
+    quint16 port;
+
+    TransportConfig();
+
+    // "host:port", ":port" or "port"; false without a valid port number
+    bool setAddress(const QString &address);
+    QString displayName() const;
+    // Bytes per second the line carries, counting start, parity and stop
+    // bits; 0 for network links
+    double lineBytesPerSecond() const;
+};
+
+// A link the receive and transmit pipeline runs over. Received data is
+// announced by readyRead() and copied out in chunks into the caller's
+// buffer. Writes are taken at once and confirmed by bytesWritten() as the
+// link sends them, which is what paces TransmitQueue.
+class Transport : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Nullptr when this build has no such link
+    static Transport *create(TransportConfig::Kind kind, QObject *parent = nullptr);
+
+    TransportConfig::Kind kind() const { return linkKind; }
+    // Settings of the last open()
+    const TransportConfig &config() const { return settings; }
+
+    virtual bool open(const TransportConfig &config) = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+    virtual QString errorString() const = 0;
+
+    // Copies up to maxSize received bytes into data; 0 when none are left
+    virtual qint64 read(char *data, qint64 maxSize) = 0;
+    virtual qint64 bytesAvailable() const = 0;
+
+    // Returns the bytes taken, or -1 on error
+    virtual qint64 write(const char *data, qint64 size) = 0;
+    // False when a write must be confirmed before the next one is made
+    virtual bool acceptsQueuedWrites() const { return true; }
+    // Drops data taken but not yet sent. False when the link cannot, in
+    // which case that data is still sent and confirmed.
+    virtual bool clearOutput() { return false; }
+
+    virtual void setHardwareFlowControl(bool enabled) { settings.hardwareFlowControl = enabled; }
+
+#ifndef __EMSCRIPTEN__
+    // Handle for worker threads that write around the event loop; only
+    // serial links have one
+    virtual bool nativeHandle(QSerialPort::Handle *handle) const
+    {
+        Q_UNUSED(handle);
+        return false;
+    }
+#endif
+
+signals:
+    void readyRead();
+    void bytesWritten(qint64 bytes);
+    void errorOccurred(const QString &error);
+
+protected:
+    Transport(TransportConfig::Kind kind, QObject *parent);
+
+    TransportConfig settings;
+
+private:
+    const TransportConfig::Kind linkKind;
+};
+
+#endif // TRANSPORT_H
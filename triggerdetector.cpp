@@ -0,0 +1,168 @@
+#include "triggerdetector.h"
+#include <QtGlobal>
+
+TriggerDetector::TriggerDetector(int channelCount)
+    : m_mode(Off)
+    , m_state(Idle)
+    , m_edge(Rising)
+    , m_sourceChannel(0)
+    , m_level(0.0)
+    , m_holdoff(0)
+    , m_preSamples(100)
+    , m_postSamples(100)
+    , m_previousValue(0.0)
+    , m_hasPrevious(false)
+    , m_sourceSamplesSinceArm(0)
+    , m_samplesSinceTrigger(0)
+    , m_postRemaining(0)
+    , m_captureTriggerIndex(-1)
+{
+    m_rings.resize(channelCount);
+    resetRings();
+}
+
+void TriggerDetector::setMode(Mode mode)
+{
+    m_mode = mode;
+    if (m_mode == Off) {
+        m_state = Idle;
+    } else {
+        arm();
+    }
+}
+
+void TriggerDetector::setSourceChannel(int channel)
+{
+    if (channel >= 0 && channel < m_rings.size()) {
+        m_sourceChannel = channel;
+        m_hasPrevious = false;
+    }
+}
+
+void TriggerDetector::setEdge(Edge edge)
+{
+    m_edge = edge;
+}
+
+void TriggerDetector::setLevel(double level)
+{
+    m_level = level;
+}
+
+void TriggerDetector::setHoldoff(int samples)
+{
+    m_holdoff = qMax(0, samples);
+}
+
+void TriggerDetector::setDepth(int preSamples, int postSamples)
+{
+    m_preSamples = qMax(0, preSamples);
+    m_postSamples = qMax(0, postSamples);
+    resetRings();
+    if (m_mode != Off) {
+        arm();
+    }
+}
+
+void TriggerDetector::arm()
+{
+    if (m_mode == Off) {
+        return;
+    }
+
+    resetRings();
+    m_hasPrevious = false;
+    m_sourceSamplesSinceArm = 0;
+    m_samplesSinceTrigger = m_holdoff;  // No holdoff pending after arming
+    m_postRemaining = 0;
+    m_state = Armed;
+}
+
+void TriggerDetector::resetRings()
+{
+    const int capacity = m_preSamples + m_postSamples + 1;
+    for (int i = 0; i < m_rings.size(); ++i) {
+        m_rings[i].data.resize(capacity);
+        m_rings[i].head = 0;
+        m_rings[i].count = 0;
+    }
+}
+
+bool TriggerDetector::processRow(const QVector<double> &row)
+{
+    if (m_state == Idle) {
+        return false;
+    }
+
+    // Keep the rolling pre/post window for every channel
+    const int channels = qMin(row.size(), m_rings.size());
+    for (int ch = 0; ch < channels; ++ch) {
+        Ring &ring = m_rings[ch];
+        const int capacity = ring.data.size();
+        ring.data[ring.head] = row[ch];
+        ring.head = (ring.head + 1) % capacity;
+        if (ring.count < capacity) {
+            ++ring.count;
+        }
+    }
+
+    if (m_sourceChannel >= row.size()) {
+        return false;
+    }
+
+    const double value = row[m_sourceChannel];
+    ++m_sourceSamplesSinceArm;
+    ++m_samplesSinceTrigger;
+
+    if (m_state == Armed) {
+        bool crossed = false;
+        if (m_hasPrevious) {
+            if (m_edge == Rising) {
+                crossed = m_previousValue < m_level && value >= m_level;
+            } else {
+                crossed = m_previousValue > m_level && value <= m_level;
+            }
+        }
+
+        // Only fire once the pre-trigger window is full and holdoff expired
+        if (crossed && m_sourceSamplesSinceArm > m_preSamples &&
+            m_samplesSinceTrigger >= m_holdoff) {
+            m_samplesSinceTrigger = 0;
+            m_postRemaining = m_postSamples;
+            m_state = Collecting;
+        }
+    } else if (m_state == Collecting) {
+        --m_postRemaining;
+    }
+
+    m_previousValue = value;
+    m_hasPrevious = true;
+
+    if (m_state == Collecting && m_postRemaining <= 0) {
+        finishCapture();
+        return true;
+    }
+
+    return false;
+}
+
+void TriggerDetector::finishCapture()
+{
+    m_capture.resize(m_rings.size());
+    for (int ch = 0; ch < m_rings.size(); ++ch) {
+        const Ring &ring = m_rings[ch];
+        const int capacity = ring.data.size();
+        QVector<double> &out = m_capture[ch];
+        out.resize(ring.count);
+
+        // Unroll the ring, oldest sample first
+        int index = (ring.head - ring.count + capacity) % capacity;
+        for (int i = 0; i < ring.count; ++i) {
+            out[i] = ring.data[index];
+            index = (index + 1) % capacity;
+        }
+    }
+
+    m_captureTriggerIndex = m_rings[m_sourceChannel].count - 1 - m_postSamples;
+    m_state = (m_mode == Single) ? Idle : Armed;
+}
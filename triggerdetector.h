@@ -0,0 +1,85 @@
+#ifndef TRIGGERDETECTOR_H
+#define TRIGGERDETECTOR_H
+
+#include <QVector>
+
+// Streaming oscilloscope-style trigger. Sits on the ingest path in front of
+// PlotWidget and sees every parsed row exactly once; it keeps only the
+// pre/post window in small ring buffers and never rescans plot history.
+class TriggerDetector
+{
+public:
+    enum Mode {
+        Off = 0,
+        Normal = 1,   // Re-arm automatically after each capture
+        Single = 2    // Stop after the first capture until armed again
+    };
+
+    enum Edge {
+        Rising = 0,
+        Falling = 1
+    };
+
+    enum State {
+        Idle,         // Off, or single shot already captured
+        Armed,        // Waiting for the trigger condition
+        Collecting    // Triggered, filling the post-trigger window
+    };
+
+    explicit TriggerDetector(int channelCount = 6);
+
+    void setMode(Mode mode);
+    void setSourceChannel(int channel);
+    void setEdge(Edge edge);
+    void setLevel(double level);
+    void setHoldoff(int samples);
+    void setDepth(int preSamples, int postSamples);
+
+    Mode mode() const { return m_mode; }
+    State state() const { return m_state; }
+    double level() const { return m_level; }
+
+    // Restart acquisition with the current settings
+    void arm();
+
+    // Feed one parsed row (value per channel). Returns true when the row
+    // completed a capture window, which is then available via capture().
+    bool processRow(const QVector<double> &row);
+
+    // Captured window per channel, oldest sample first
+    const QVector<QVector<double>> &capture() const { return m_capture; }
+    int captureTriggerIndex() const { return m_captureTriggerIndex; }
+
+private:
+    struct Ring {
+        QVector<double> data;
+        int head;   // Next write position
+        int count;
+
+        Ring() : head(0), count(0) {}
+    };
+
+    Mode m_mode;
+    State m_state;
+    Edge m_edge;
+    int m_sourceChannel;
+    double m_level;
+    int m_holdoff;
+    int m_preSamples;
+    int m_postSamples;
+
+    QVector<Ring> m_rings;
+    double m_previousValue;
+    bool m_hasPrevious;
+    qint64 m_sourceSamplesSinceArm;
+    qint64 m_samplesSinceTrigger;
+    int m_postRemaining;
+
+    QVector<QVector<double>> m_capture;
+    int m_captureTriggerIndex;
+
+    void resetRings();
+    void finishCapture();
+};
+
+#endif // TRIGGERDETECTOR_H
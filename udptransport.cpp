@@ -0,0 +1,144 @@
+#include "udptransport.h"
+#include <QHostInfo>
+#include <QTimer>
+#include <QUdpSocket>
+#include <cstring>
+
+namespace {
+
+// Payload that fits an Ethernet frame without fragmentation
+const qint64 kMaxDatagramBytes = 1472;
+
+} // namespace
+
+UdpTransport::UdpTransport(QObject *parent)
+    : Transport(TransportConfig::Udp, parent)
+    , socket(new QUdpSocket(this))
+    , peerPort(0)
+    , spillOffset(0)
+{
+    connect(socket, &QUdpSocket::readyRead, this, &Transport::readyRead);
+}
+
+bool UdpTransport::open(const TransportConfig &config)
+{
+    close();
+    settings = config;
+    settings.kind = TransportConfig::Udp;
+    lastError.clear();
+
+    bool bound;
+    if (config.host.isEmpty()) {
+        bound = socket->bind(QHostAddress::Any, config.port);
+    } else {
+        peer = QHostAddress(config.host);
+        if (peer.isNull()) {
+            const QList<QHostAddress> addresses = QHostInfo::fromName(config.host).addresses();
+            if (!addresses.isEmpty()) {
+                peer = addresses.first();
+            }
+        }
+        if (peer.isNull()) {
+            lastError = QString("Host not found: %1").arg(config.host);
+            return false;
+        }
+        peerPort = config.port;
+        bound = socket->bind(peer.protocol() == QAbstractSocket::IPv6Protocol
+                                 ? QHostAddress::AnyIPv6 : QHostAddress::AnyIPv4, 0);
+    }
+    if (!bound) {
+        lastError = socket->errorString();
+        return false;
+    }
+    return true;
+}
+
+void UdpTransport::close()
+{
+    socket->close();
+    peer.clear();
+    peerPort = 0;
+    spill.clear();
+    spillOffset = 0;
+}
+
+bool UdpTransport::isOpen() const
+{
+    return socket->state() == QAbstractSocket::BoundState;
+}
+
+QString UdpTransport::errorString() const
+{
+    return lastError;
+}
+
+qint64 UdpTransport::read(char *data, qint64 maxSize)
+{
+    qint64 total = 0;
+    if (spillOffset < spill.size()) {
+        const qint64 take = qMin<qint64>(maxSize, spill.size() - spillOffset);
+        std::memcpy(data, spill.constData() + spillOffset, size_t(take));
+        spillOffset += int(take);
+        total = take;
+    }
+
+    while (total < maxSize && socket->hasPendingDatagrams()) {
+        const qint64 size = socket->pendingDatagramSize();
+        QHostAddress sender;
+        quint16 senderPort = 0;
+        qint64 n;
+        if (size <= maxSize - total) {
+            n = socket->readDatagram(data + total, maxSize - total, &sender, &senderPort);
+        } else {
+            // Kept whole, as the rest of a datagram cannot be read later
+            spill.resize(int(qMax<qint64>(size, 0)));
+            n = socket->readDatagram(spill.data(), spill.size(), &sender, &senderPort);
+            const qint64 take = qBound<qint64>(0, n, maxSize - total);
+            std::memcpy(data + total, spill.constData(), size_t(take));
+            spill.resize(int(qMax<qint64>(n, 0)));
+            spillOffset = int(take);
+            n = take;
+        }
+        if (n < 0) {
+            break;
+        }
+        total += n;
+        if (settings.host.isEmpty() && senderPort != 0) {
+            peer = sender;
+            peerPort = senderPort;
+        }
+        if (spillOffset < spill.size()) {
+            break;
+        }
+    }
+    return total;
+}
+
+qint64 UdpTransport::bytesAvailable() const
+{
+    qint64 available = spill.size() - spillOffset;
+    if (socket->hasPendingDatagrams()) {
+        available += qMax<qint64>(socket->pendingDatagramSize(), 0);
+    }
+    return available;
+}
+
+qint64 UdpTransport::write(const char *data, qint64 size)
+{
+    if (peerPort == 0) {
+        lastError = QString("No peer to send to yet");
+        return -1;
+    }
+    for (qint64 offset = 0; offset < size; offset += kMaxDatagramBytes) {
+        const qint64 length = qMin(kMaxDatagramBytes, size - offset);
+        if (socket->writeDatagram(data + offset, length, peer, peerPort) != length) {
+            lastError = socket->errorString();
+            return -1;
+        }
+    }
+    // Datagrams leave at once; confirm from the event loop like a stream
+    QTimer::singleShot(0, this, [this, size]() {
+        emit bytesWritten(size);
+    });
+    return size;
+}
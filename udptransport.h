@@ -0,0 +1,40 @@
+#ifndef UDPTRANSPORT_H
+#define UDPTRANSPORT_H
+
+#include "transport.h"
+#include <QByteArray>
+#include <QHostAddress>
+
+class QUdpSocket;
+
+// Datagrams as a byte stream. With a host the transport sends to
+// host:port from an ephemeral port; without one it binds port and replies
+// to whoever sent the last datagram. Datagram boundaries are not kept.
+class UdpTransport : public Transport
+{
+    Q_OBJECT
+
+public:
+    explicit UdpTransport(QObject *parent = nullptr);
+
+    bool open(const TransportConfig &config) override;
+    void close() override;
+    bool isOpen() const override;
+    QString errorString() const override;
+
+    qint64 read(char *data, qint64 maxSize) override;
+    qint64 bytesAvailable() const override;
+
+    // Split into datagrams and sent at once; -1 while no peer is known
+    qint64 write(const char *data, qint64 size) override;
+
+private:
+    QUdpSocket *socket;
+    QHostAddress peer;
+    quint16 peerPort;
+    QByteArray spill;       // Rest of a datagram larger than the last read
+    int spillOffset;
+    QString lastError;
+};
+
+#endif // UDPTRANSPORT_H
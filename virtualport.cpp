@@ -0,0 +1,62 @@
+#include "virtualport.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+VirtualPort::VirtualPort()
+    : master(-1)
+    , slave(-1)
+{
+}
+
+VirtualPort::~VirtualPort()
+{
+    close();
+}
+
+bool VirtualPort::open(QString *error)
+{
+    close();
+
+    master = ::posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    char name[128];
+    if (master < 0 || ::grantpt(master) != 0 || ::unlockpt(master) != 0 ||
+        ::ptsname_r(master, name, sizeof(name)) != 0) {
+        *error = qt_error_string(errno);
+        close();
+        return false;
+    }
+
+    slave = ::open(name, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (slave < 0) {
+        *error = qt_error_string(errno);
+        close();
+        return false;
+    }
+    // Raw until QSerialPort applies its own settings, so nothing is echoed
+    // or held back for a line end
+    termios settings;
+    if (::tcgetattr(slave, &settings) == 0) {
+        ::cfmakeraw(&settings);
+        ::tcsetattr(slave, TCSANOW, &settings);
+    }
+
+    path = QString::fromLocal8Bit(name);
+    return true;
+}
+
+void VirtualPort::close()
+{
+    if (slave >= 0) {
+        ::close(slave);
+        slave = -1;
+    }
+    if (master >= 0) {
+        ::close(master);
+        master = -1;
+    }
+    path.clear();
+}
@@ -0,0 +1,33 @@
+#ifndef VIRTUALPORT_H
+#define VIRTUALPORT_H
+
+#include <QString>
+
+// Pseudo-terminal pair standing in for a serial port. The slave side is an
+// ordinary tty (/dev/pts/N) that QSerialPort opens like any device; the
+// master side is where a simulated device reads and writes. The slave is
+// also held open here, so the master never sees a hangup while the app
+// has the port closed.
+class VirtualPort
+{
+public:
+    VirtualPort();
+    ~VirtualPort();
+
+    bool open(QString *error);
+    void close();
+    bool isOpen() const { return master >= 0; }
+
+    int masterHandle() const { return master; }
+    QString slavePath() const { return path; }
+
+private:
+    int master;
+    int slave;
+    QString path;
+
+    VirtualPort(const VirtualPort &);
+    VirtualPort &operator=(const VirtualPort &);
+};
+
+#endif // VIRTUALPORT_H
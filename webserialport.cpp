@@ -1,5 +1,6 @@
 #include "webserialport.h"
 #include <QDebug>
+#include <cstring>
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
@@ -87,10 +88,13 @@ EM_JS(void, js_writeSerialPort, (const char* data, int length), {
         
         writer.write(dataCopy)
             .then(() => {
-                console.log('Data written:', dataCopy.length, 'bytes');
+                Module.ccall('webserial_onWritten_c', 'void', ['number'], [dataCopy.length]);
             })
             .catch(error => {
                 console.error('Write error:', error);
+                const errorPtr = allocateUTF8(error.toString());
+                Module.ccall('webserial_onError_c', 'void', ['number'], [errorPtr]);
+                _free(errorPtr);
             })
             .finally(() => {
                 writer.releaseLock();
@@ -122,6 +126,12 @@ void webserial_onDataReceived(const char* data, int length) {
     }
 }
 
+void webserial_onWritten(int length) {
+    if (g_webSerialPort) {
+        emit g_webSerialPort->bytesWritten(length);
+    }
+}
+
 // Export for JavaScript
 extern "C" {
     EMSCRIPTEN_KEEPALIVE
@@ -138,6 +148,11 @@ extern "C" {
     void webserial_onDataReceived_c(const char* data, int length) {
         webserial_onDataReceived(data, length);
     }
+
+    EMSCRIPTEN_KEEPALIVE
+    void webserial_onWritten_c(int length) {
+        webserial_onWritten(length);
+    }
 }
 #endif // __EMSCRIPTEN__
 
@@ -230,6 +245,14 @@ QByteArray WebSerialPort::readAll()
     return data;
 }
 
+qint64 WebSerialPort::read(char *data, qint64 maxSize)
+{
+    const int size = int(qMin<qint64>(maxSize, m_readBuffer.size()));
+    std::memcpy(data, m_readBuffer.constData(), size_t(size));
+    m_readBuffer.remove(0, size);
+    return size;
+}
+
 QString WebSerialPort::errorString() const
 {
     return m_errorString;
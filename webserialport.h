@@ -58,18 +58,26 @@ public:
     QString portName() const { return m_portName; }
 
     void setBaudRate(int baudRate);
+    int baudRate() const { return m_baudRate; }
     void setDataBits(DataBits dataBits);
     void setStopBits(StopBits stopBits);
     void setParity(Parity parity);
     void setFlowControl(FlowControl flowControl) { Q_UNUSED(flowControl); }
 
+    // Returns the bytes accepted; bytesWritten() follows once the browser
+    // has handed them to the device. Web Serial allows a single write in
+    // flight, so wait for bytesWritten() before the next one.
     qint64 write(const QByteArray &data);
     QByteArray readAll();
+    // Moves up to maxSize received bytes into data
+    qint64 read(char *data, qint64 maxSize);
+    qint64 bytesAvailable() const { return m_readBuffer.size(); }
 
     QString errorString() const;
 
 signals:
     void readyRead();
+    void bytesWritten(qint64 bytes);
     void errorOccurred(const QString &error);
 
 private:
@@ -90,6 +98,7 @@ private:
     friend void webserial_onOpened();
     friend void webserial_onError(const char* error);
     friend void webserial_onDataReceived(const char* data, int length);
+    friend void webserial_onWritten(int length);
 };
 
 
@@ -97,5 +106,6 @@ private:
 void webserial_onOpened();
 void webserial_onError(const char* error);
 void webserial_onDataReceived(const char* data, int length);
+void webserial_onWritten(int length);
 
 #endif // WEBSERIALPORT_H
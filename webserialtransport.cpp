@@ -0,0 +1,68 @@
+#include "webserialtransport.h"
+
+WebSerialTransport::WebSerialTransport(QObject *parent)
+    : Transport(TransportConfig::WebSerial, parent)
+    , port(new WebSerialPort(this))
+{
+    connect(port, &WebSerialPort::readyRead, this, &Transport::readyRead);
+    connect(port, &WebSerialPort::bytesWritten, this, &Transport::bytesWritten);
+    connect(port, &WebSerialPort::errorOccurred, this, &Transport::errorOccurred);
+}
+
+bool WebSerialTransport::open(const TransportConfig &config)
+{
+    close();
+    settings = config;
+    settings.kind = TransportConfig::WebSerial;
+
+    port->setPortName(config.portName);
+    port->setBaudRate(config.baudRate);
+    switch (config.dataBits) {
+    case 5: port->setDataBits(WebSerialPort::Data5); break;
+    case 6: port->setDataBits(WebSerialPort::Data6); break;
+    case 7: port->setDataBits(WebSerialPort::Data7); break;
+    default: port->setDataBits(WebSerialPort::Data8); break;
+    }
+    // Web Serial has no 1.5 stop bits
+    port->setStopBits(config.stopBits == TransportConfig::TwoStop ? WebSerialPort::TwoStop
+                                                                  : WebSerialPort::OneStop);
+    switch (config.parity) {
+    case TransportConfig::OddParity: port->setParity(WebSerialPort::OddParity); break;
+    case TransportConfig::EvenParity: port->setParity(WebSerialPort::EvenParity); break;
+    default: port->setParity(WebSerialPort::NoParity); break;
+    }
+    port->setFlowControl(WebSerialPort::NoFlowControl);
+    return port->open(QIODevice::ReadWrite);
+}
+
+void WebSerialTransport::close()
+{
+    if (port->isOpen()) {
+        port->close();
+    }
+}
+
+bool WebSerialTransport::isOpen() const
+{
+    return port->isOpen();
+}
+
+QString WebSerialTransport::errorString() const
+{
+    return port->errorString();
+}
+
+qint64 WebSerialTransport::read(char *data, qint64 maxSize)
+{
+    return port->read(data, maxSize);
+}
+
+qint64 WebSerialTransport::bytesAvailable() const
+{
+    return port->bytesAvailable();
+}
+
+qint64 WebSerialTransport::write(const char *data, qint64 size)
+{
+    return port->write(QByteArray::fromRawData(data, int(size)));
+}
@@ -0,0 +1,31 @@
+#ifndef WEBSERIALTRANSPORT_H
+#define WEBSERIALTRANSPORT_H
+
+#include "transport.h"
+#include "webserialport.h"
+
+// Browser serial port through the Web Serial API
+class WebSerialTransport : public Transport
+{
+    Q_OBJECT
+
+public:
+    explicit WebSerialTransport(QObject *parent = nullptr);
+
+    bool open(const TransportConfig &config) override;
+    void close() override;
+    bool isOpen() const override;
+    QString errorString() const override;
+
+    qint64 read(char *data, qint64 maxSize) override;
+    qint64 bytesAvailable() const override;
+
+    qint64 write(const char *data, qint64 size) override;
+    // The browser allows a single write in flight
+    bool acceptsQueuedWrites() const override { return false; }
+
+private:
+    WebSerialPort *port;
+};
+
+#endif // WEBSERIALTRANSPORT_H